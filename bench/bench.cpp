@@ -0,0 +1,170 @@
+#include <bench.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+
+namespace
+{
+  std::atomic< uint64_t > allocations{0};
+}  // namespace
+
+// count every heap allocation the benchmarks make, the data path should be
+// doing close to none per packet
+void*
+operator new(size_t sz)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(sz ? sz : 1);
+  if(ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void*
+operator new[](size_t sz)
+{
+  return operator new(sz);
+}
+
+void*
+operator new(size_t sz, const std::nothrow_t&) noexcept
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(sz ? sz : 1);
+}
+
+void*
+operator new[](size_t sz, const std::nothrow_t& tag) noexcept
+{
+  return operator new(sz, tag);
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace llarp
+{
+  namespace bench
+  {
+    std::vector< Benchmark >&
+    Registry()
+    {
+      static std::vector< Benchmark > benchmarks;
+      return benchmarks;
+    }
+
+    Register::Register(const char* name, Func func)
+    {
+      Registry().emplace_back(Benchmark{name, std::move(func)});
+    }
+
+    static uint64_t
+    ReadClock(clockid_t clock)
+    {
+      timespec ts;
+      clock_gettime(clock, &ts);
+      return (uint64_t(ts.tv_sec) * 1000000000UL) + uint64_t(ts.tv_nsec);
+    }
+
+    uint64_t
+    NowNs()
+    {
+      return ReadClock(CLOCK_MONOTONIC);
+    }
+
+    uint64_t
+    CpuNs()
+    {
+      return ReadClock(CLOCK_PROCESS_CPUTIME_ID);
+    }
+
+    uint64_t
+    Allocations()
+    {
+      return allocations.load(std::memory_order_relaxed);
+    }
+
+    Measure::Measure(Result& result)
+        : m_Result(result)
+        , m_Wall(NowNs())
+        , m_Cpu(CpuNs())
+        , m_Allocs(Allocations())
+    {
+    }
+
+    void
+    Measure::Stop()
+    {
+      m_Result.wallNs = NowNs() - m_Wall;
+      m_Result.cpuNs  = CpuNs() - m_Cpu;
+      m_Result.allocs = Allocations() - m_Allocs;
+    }
+
+    uint64_t
+    Percentile(std::vector< uint64_t >& samples, double p)
+    {
+      if(samples.empty())
+        return 0;
+      std::sort(samples.begin(), samples.end());
+      const size_t idx = std::min(samples.size() - 1,
+                                  size_t(p * double(samples.size() - 1)));
+      return samples[idx];
+    }
+
+    void
+    PrintHeader(std::ostream& out)
+    {
+      out << std::left << std::setw(24) << "benchmark" << std::right
+          << std::setw(12) << "pkt/s" << std::setw(10) << "MiB/s"
+          << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+          << std::setw(10) << "p999 us" << std::setw(12) << "cpu ns/hop"
+          << std::setw(12) << "allocs/pkt" << std::endl;
+    }
+
+    void
+    Print(std::ostream& out, Result& result)
+    {
+      const double secs    = double(result.wallNs) / 1e9;
+      const double packets = double(std::max(result.packets, uint64_t(1)));
+      const double hops    = double(std::max(result.hops, uint64_t(1)));
+      auto us              = [&](double p) -> double {
+        return double(Percentile(result.latencyNs, p)) / 1e3;
+      };
+      out << std::left << std::setw(24) << result.name << std::right
+          << std::fixed << std::setprecision(0) << std::setw(12)
+          << (secs > 0 ? double(result.packets) / secs : 0)
+          << std::setprecision(1) << std::setw(10)
+          << (secs > 0 ? double(result.bytes) / secs / (1024 * 1024) : 0)
+          << std::setw(10) << us(0.5) << std::setw(10) << us(0.99)
+          << std::setw(10) << us(0.999) << std::setprecision(0)
+          << std::setw(12) << double(result.cpuNs) / packets / hops
+          << std::setprecision(2) << std::setw(12)
+          << double(result.allocs) / packets << std::endl;
+    }
+  }  // namespace bench
+}  // namespace llarp
@@ -0,0 +1,103 @@
+#ifndef LLARP_BENCH_HPP
+#define LLARP_BENCH_HPP
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// knobs shared by every benchmark
+    struct Options
+    {
+      /// payload size in bytes
+      size_t size = 1024;
+      /// packets to push through
+      uint64_t packets = 100000;
+      /// onion layers for the benchmarks that take a path length
+      size_t hops = 4;
+      /// routing table size for the dht benchmarks
+      size_t dhtNodes = 10000;
+    };
+
+    /// what one benchmark run measured
+    struct Result
+    {
+      std::string name;
+      /// packets processed
+      uint64_t packets = 0;
+      /// payload bytes processed
+      uint64_t bytes = 0;
+      /// hops each packet went through, cpu is reported per packet per hop
+      uint64_t hops = 1;
+      uint64_t wallNs = 0;
+      uint64_t cpuNs  = 0;
+      /// heap allocations made while measuring
+      uint64_t allocs = 0;
+      /// per packet latency samples in ns, may be empty
+      std::vector< uint64_t > latencyNs;
+    };
+
+    /// benchmark body, fills in the result and returns false on failure
+    using Func = std::function< bool(const Options&, Result&) >;
+
+    struct Benchmark
+    {
+      std::string name;
+      Func func;
+    };
+
+    std::vector< Benchmark >&
+    Registry();
+
+    /// adds a benchmark to the registry at static init time
+    struct Register
+    {
+      Register(const char* name, Func func);
+    };
+
+    /// monotonic clock in ns
+    uint64_t
+    NowNs();
+
+    /// cpu time used by every thread in the process in ns
+    uint64_t
+    CpuNs();
+
+    /// heap allocations made so far by this process
+    uint64_t
+    Allocations();
+
+    /// records wall time, cpu time and allocations between construction and
+    /// Stop() into a result
+    struct Measure
+    {
+      explicit Measure(Result& result);
+
+      void
+      Stop();
+
+     private:
+      Result& m_Result;
+      uint64_t m_Wall;
+      uint64_t m_Cpu;
+      uint64_t m_Allocs;
+    };
+
+    /// p in [0, 1], sorts samples
+    uint64_t
+    Percentile(std::vector< uint64_t >& samples, double p);
+
+    void
+    PrintHeader(std::ostream& out);
+
+    void
+    Print(std::ostream& out, Result& result);
+  }  // namespace bench
+}  // namespace llarp
+
+#endif
@@ -0,0 +1,126 @@
+#include <bench.hpp>
+
+#include <net/checksum.hpp>
+#include <net/ip.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// keeps the results alive so nothing gets optimized out
+    static volatile uint16_t sink;
+
+    /// the word at a time loop ip.cpp used to carry, to compare against
+    static uint16_t
+    ReferenceChecksum(const byte_t* buf, size_t sz)
+    {
+      uint32_t sum = 0;
+      while(sz > 1)
+      {
+        sum += *(const uint16_t*)buf;
+        sz -= sizeof(uint16_t);
+        buf += sizeof(uint16_t);
+      }
+      if(sz != 0)
+      {
+        uint16_t x = 0;
+
+        *(byte_t*)&x = *(const byte_t*)buf;
+        sum += x;
+      }
+      sum = (sum & 0xFFff) + (sum >> 16);
+      sum += sum >> 16;
+      return uint16_t((~sum) & 0xFFff);
+    }
+
+    template < typename Sum >
+    static bool
+    RunChecksum(const Options& opts, Result& result, Sum sum)
+    {
+      std::vector< byte_t > payload(opts.size);
+      for(size_t idx = 0; idx < payload.size(); ++idx)
+        payload[idx] = idx * 31;
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        // touch the data so every round sums something different
+        ++payload[result.packets % payload.size()];
+        sink = sum(payload.data(), payload.size());
+        ++result.packets;
+        result.bytes += opts.size;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    static bool
+    ChecksumReference(const Options& opts, Result& result)
+    {
+      return RunChecksum(opts, result, &ReferenceChecksum);
+    }
+
+    template < net::ChecksumKernel Kernel >
+    static bool
+    ChecksumWith(const Options& opts, Result& result)
+    {
+      // nothing to measure on this cpu
+      if(!net::ChecksumKernelSupported(Kernel))
+        return true;
+      return RunChecksum(opts, result, [](const byte_t* buf, size_t sz) {
+        return net::ipchksum(Kernel, buf, sz).n;
+      });
+    }
+
+    /// packets coming out of the network rewritten to the tun addresses,
+    /// one at a time or as a batch
+    template < bool Batched >
+    static bool
+    Rewrite(const Options& opts, Result& result)
+    {
+      static constexpr size_t BatchSize = 64;
+      const size_t sz =
+          std::min(std::max(opts.size, size_t(28)), net::IPPacket::MaxSize);
+      std::vector< byte_t > buf(sz);
+      for(size_t idx = 0; idx < sz; ++idx)
+        buf[idx] = idx * 13;
+      buf[0] = 0x45;
+      buf[6] = buf[7] = 0;
+      buf[9] = IPPROTO_UDP;
+      std::vector< net::IPPacket > pkts(BatchSize);
+      for(auto& pkt : pkts)
+        pkt.Load(llarp_buffer_t(buf));
+      const huint32_t addrs[2] = {huint32_t{0x0a000001},
+                                  huint32_t{0xac100001}};
+      Measure measure(result);
+      for(size_t round = 0; result.packets < opts.packets; ++round)
+      {
+        const huint32_t src = addrs[round % 2];
+        const huint32_t dst = addrs[(round + 1) % 2];
+        if(Batched)
+          net::IPPacket::UpdateIPv4PacketsOnDst(pkts.data(), pkts.size(),
+                                                  src, dst);
+        else
+          for(auto& pkt : pkts)
+            pkt.UpdateIPv4PacketOnDst(src, dst);
+        result.packets += pkts.size();
+        result.bytes += pkts.size() * sz;
+      }
+      measure.Stop();
+      sink = pkts[0].Header()->check;
+      return true;
+    }
+
+    static Register chksumReference("chksum.reference", ChecksumReference);
+    static Register chksumScalar(
+        "chksum.scalar", ChecksumWith< net::ChecksumKernel::Scalar >);
+    static Register chksumSSE2("chksum.sse2",
+                               ChecksumWith< net::ChecksumKernel::SSE2 >);
+    static Register chksumAVX2("chksum.avx2",
+                               ChecksumWith< net::ChecksumKernel::AVX2 >);
+    static Register rewriteSingle("rewrite.single", Rewrite< false >);
+    static Register rewriteBatch("rewrite.batch", Rewrite< true >);
+  }  // namespace bench
+}  // namespace llarp
@@ -0,0 +1,110 @@
+#include <bench.hpp>
+
+#include <dht/bucket.hpp>
+#include <dht/node.hpp>
+
+#include <random>
+#include <set>
+#include <vector>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// peers handed back for an exploratory lookup
+    static constexpr size_t NearPeers = 4;
+
+    /// keeps the results alive so nothing gets optimized out
+    static volatile size_t sink;
+
+    /// a full table and the keys to look up in it
+    struct DHTBench
+    {
+      explicit DHTBench(const Options& opts)
+          : rng(opts.dhtNodes), nodes(us, [this]() { return rng(); })
+      {
+        us.Randomize();
+        for(size_t idx = 0; idx < opts.dhtNodes; ++idx)
+        {
+          dht::RCNode node;
+          node.ID.Randomize();
+          nodes.PutNode(node);
+        }
+        targets.resize(1024);
+        for(auto& target : targets)
+          target.Randomize();
+      }
+
+      /// what Bucket did before it walked the trie, one pass over the table
+      /// per peer wanted
+      bool
+      ScanNearExcluding(const dht::Key_t& target,
+                        std::set< dht::Key_t >& result, size_t N,
+                        std::set< dht::Key_t > exclude) const
+      {
+        while(N--)
+        {
+          dht::Key_t mindist;
+          mindist.Fill(0xff);
+          dht::Key_t peer;
+          bool found = false;
+          for(const auto& item : nodes.nodes)
+          {
+            if(exclude.count(item.first))
+              continue;
+            auto curDist = item.first ^ target;
+            if(curDist < mindist)
+            {
+              mindist = curDist;
+              peer    = item.first;
+              found   = true;
+            }
+          }
+          if(!found)
+            return false;
+          exclude.insert(peer);
+          result.insert(peer);
+        }
+        return true;
+      }
+
+      std::mt19937_64 rng;
+      dht::Key_t us;
+      dht::Bucket< dht::RCNode > nodes;
+      std::vector< dht::Key_t > targets;
+    };
+
+    /// closest peers to a target skipping us and the requester, the query
+    /// behind every exploratory and relayed router lookup
+    template < bool Scan >
+    static bool
+    NearExcluding(const Options& opts, Result& result)
+    {
+      if(opts.dhtNodes <= NearPeers)
+        return false;
+      DHTBench bench(opts);
+      const std::set< dht::Key_t > exclude{
+          bench.us, bench.nodes.nodes.begin()->first};
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        const auto& target =
+            bench.targets[result.packets % bench.targets.size()];
+        std::set< dht::Key_t > found;
+        const bool ok = Scan
+            ? bench.ScanNearExcluding(target, found, NearPeers, exclude)
+            : bench.nodes.GetManyNearExcluding(target, found, NearPeers,
+                                               exclude);
+        if(!ok)
+          return false;
+        sink = found.size();
+        ++result.packets;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    static Register dhtNearScan("dht.near.scan", NearExcluding< true >);
+    static Register dhtNearTrie("dht.near.trie", NearExcluding< false >);
+  }  // namespace bench
+}  // namespace llarp
@@ -0,0 +1,75 @@
+#include <bench.hpp>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <service/Identity.hpp>
+#include <service/protocol.hpp>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// hidden service frame, sealed by the sender and opened by the
+    /// receiver for every packet sent to a .loki address
+    struct FrameBench
+    {
+      explicit FrameBench(const Options& opts)
+      {
+        ident.RegenerateKeys(&crypto);
+        key.Randomize();
+        msg.proto = service::eProtocolTraffic;
+        msg.payload.resize(opts.size);
+        crypto.randbytes(msg.payload.data(), msg.payload.size());
+        msg.sender = ident.pub;
+        msg.tag.Randomize();
+        frame.T = msg.tag;
+        frame.N.Randomize();
+      }
+
+      bool
+      Seal()
+      {
+        return frame.EncryptAndSign(&crypto, msg, key, ident);
+      }
+
+      bool
+      Open()
+      {
+        service::ProtocolMessage out;
+        return frame.Verify(&crypto, ident.pub)
+            && frame.DecryptPayloadInto(&crypto, key, out);
+      }
+
+      sodium::CryptoLibSodium crypto;
+      service::Identity ident;
+      SharedSecret key;
+      service::ProtocolMessage msg;
+      service::ProtocolFrame frame;
+    };
+
+    template < bool (FrameBench::*Op)() >
+    static bool
+    RunFrame(const Options& opts, Result& result)
+    {
+      FrameBench bench(opts);
+      // opening needs something sealed
+      if(!bench.Seal())
+        return false;
+      result.latencyNs.reserve(opts.packets);
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        const uint64_t started = NowNs();
+        if(!(bench.*Op)())
+          return false;
+        result.latencyNs.push_back(NowNs() - started);
+        ++result.packets;
+        result.bytes += opts.size;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    static Register frameSeal("frame.seal", RunFrame< &FrameBench::Seal >);
+    static Register frameOpen("frame.open", RunFrame< &FrameBench::Open >);
+  }  // namespace bench
+}  // namespace llarp
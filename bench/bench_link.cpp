@@ -0,0 +1,254 @@
+#include <bench.hpp>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <ev/ev.h>
+#include <messages/link_intro.hpp>
+#include <util/logic.hpp>
+#include <utp/utp.hpp>
+
+#include <cstring>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// one end of a loopback link
+    struct LinkNode
+    {
+      explicit LinkNode(Crypto* c) : crypto(c)
+      {
+        crypto->identity_keygen(signingKey);
+        crypto->encryption_keygen(encryptionKey);
+        rc.pubkey = signingKey.toPublic();
+        rc.enckey = encryptionKey.toPublic();
+      }
+
+      static std::string
+      LoopBack()
+      {
+#if defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) \
+    || (__APPLE__ && __MACH__)
+        return "lo0";
+#else
+        return "lo";
+#endif
+      }
+
+      bool
+      Start(Logic* logic, llarp_ev_loop_ptr loop, uint16_t port)
+      {
+        if(!link->Configure(loop, LoopBack(), AF_INET, port))
+          return false;
+        if(!link->GenEphemeralKeys())
+          return false;
+        rc.addrs.emplace_back();
+        if(!link->GetOurAddressInfo(rc.addrs[0]))
+          return false;
+        if(!rc.Sign(crypto, signingKey))
+          return false;
+        return link->Start(logic);
+      }
+
+      /// handle the link intro, returns false if buf is not one
+      bool
+      HandleLIM(ILinkSession* s, const llarp_buffer_t& buf)
+      {
+        LinkIntroMessage lim;
+        llarp_buffer_t copy(buf.base, buf.sz);
+        if(!lim.BDecode(&copy))
+          return false;
+        gotLIM = s->GotLIM(&lim);
+        return gotLIM;
+      }
+
+      std::unique_ptr< ILinkLayer >
+      MakeUTP(LinkMessageHandler handler, SessionEstablishedHandler est,
+              SessionClosedHandler closed)
+      {
+        return utp::NewServer(
+            crypto, encryptionKey, [&]() -> const RouterContact& { return rc; },
+            handler, est, [](RouterContact, RouterContact) { return true; },
+            [&](Signature& sig, const llarp_buffer_t& buf) -> bool {
+              return crypto->sign(sig, signingKey, buf);
+            },
+            [](ILinkSession*) {}, closed);
+      }
+
+      Crypto* crypto;
+      SecretKey signingKey;
+      SecretKey encryptionKey;
+      RouterContact rc;
+      std::unique_ptr< ILinkLayer > link;
+      bool gotLIM = false;
+    };
+
+    /// alice streams timestamped messages to bob over utp on loopback, bob
+    /// records how long each one took to arrive
+    struct LinkBench
+    {
+      static constexpr uint16_t AlicePort = 5100;
+      static constexpr uint16_t BobPort   = 5200;
+      /// give up after this long
+      static constexpr llarp_time_t Timeout = 60 * 1000;
+      /// messages sent but not yet received, keeps the numbers about the
+      /// link and not about how deep a queue we can build. utp sessions
+      /// currently stall with much more than this in flight on loopback.
+      static constexpr uint64_t Window = 32;
+
+      LinkBench(const Options& o, Result& r)
+          : opts(o)
+          , result(r)
+          , alice(&crypto)
+          , bob(&crypto)
+          , loop(llarp_make_ev_loop())
+          , logic(std::make_unique< Logic >())
+          , payload(std::max(o.size, sizeof(uint64_t)))
+      {
+      }
+
+      bool
+      Run()
+      {
+        const bool ignoreBogons     = RouterContact::IgnoreBogons;
+        RouterContact::IgnoreBogons = true;
+
+        alice.link = alice.MakeUTP(
+            [&](ILinkSession* s, const llarp_buffer_t& buf) -> bool {
+              return alice.gotLIM || alice.HandleLIM(s, buf);
+            },
+            [&](ILinkSession* s) -> bool {
+              session = s;
+              logic->queue_func([&]() { Pump(); });
+              return true;
+            },
+            [&](RouterID) { Closed(); });
+        bob.link = bob.MakeUTP(
+            [&](ILinkSession* s, const llarp_buffer_t& buf) -> bool {
+              if(!bob.gotLIM)
+                return bob.HandleLIM(s, buf);
+              return Received(buf);
+            },
+            [](ILinkSession*) -> bool { return true; }, [&](RouterID) {});
+
+        bool ok = alice.Start(logic.get(), loop, AlicePort)
+            && bob.Start(logic.get(), loop, BobPort)
+            && alice.link->TryEstablishTo(bob.rc);
+        if(ok)
+        {
+          logic->call_later({Timeout, this, &OnTimeout});
+          llarp_ev_loop_run_single_process(loop, logic->thread, logic.get());
+          ok = received == opts.packets;
+        }
+        Finish();
+        RouterContact::IgnoreBogons = ignoreBogons;
+        return ok;
+      }
+
+      /// send until the session pushes back, then try again shortly
+      void
+      Pump()
+      {
+        if(session == nullptr)
+          return;
+        if(sent == 0)
+          measure = std::make_unique< Measure >(result);
+        while(sent < opts.packets && sent - received < Window)
+        {
+          const uint64_t now = NowNs();
+          std::memcpy(payload.data(), &now, sizeof(now));
+          if(!session->SendMessageBuffer(llarp_buffer_t(payload)))
+            break;
+          ++sent;
+        }
+        session->Pump();
+        if(sent < opts.packets)
+          logic->call_later({1, this, &OnPump});
+      }
+
+      /// alice's session went away, nothing more will arrive
+      void
+      Closed()
+      {
+        session = nullptr;
+        // called from inside the link's tick, stop once it has unwound
+        logic->queue_func([&]() { Finish(); });
+      }
+
+      /// stop the links while the loop still owns their sockets, then the
+      /// loop
+      void
+      Finish()
+      {
+        if(finished)
+          return;
+        finished = true;
+        alice.link->Stop();
+        bob.link->Stop();
+        llarp_ev_loop_stop(loop.get());
+      }
+
+      bool
+      Received(const llarp_buffer_t& buf)
+      {
+        if(buf.sz < sizeof(uint64_t))
+          return false;
+        uint64_t sentAt;
+        std::memcpy(&sentAt, buf.base, sizeof(sentAt));
+        result.latencyNs.push_back(NowNs() - sentAt);
+        result.bytes += buf.sz;
+        if(++received == opts.packets)
+        {
+          measure->Stop();
+          result.packets = received;
+          logic->queue_func([&]() { Finish(); });
+        }
+        return true;
+      }
+
+      static void
+      OnPump(void* user, uint64_t, uint64_t left)
+      {
+        if(left)
+          return;
+        static_cast< LinkBench* >(user)->Pump();
+      }
+
+      static void
+      OnTimeout(void* user, uint64_t, uint64_t left)
+      {
+        if(left)
+          return;
+        static_cast< LinkBench* >(user)->Finish();
+      }
+
+      const Options& opts;
+      Result& result;
+      sodium::CryptoLibSodium crypto;
+      LinkNode alice;
+      LinkNode bob;
+      llarp_ev_loop_ptr loop;
+      std::unique_ptr< Logic > logic;
+      std::vector< byte_t > payload;
+      std::unique_ptr< Measure > measure;
+      ILinkSession* session = nullptr;
+      uint64_t sent         = 0;
+      uint64_t received     = 0;
+      bool finished         = false;
+    };
+
+    constexpr uint16_t LinkBench::AlicePort;
+    constexpr uint16_t LinkBench::BobPort;
+    constexpr llarp_time_t LinkBench::Timeout;
+    constexpr uint64_t LinkBench::Window;
+
+    static bool
+    LinkUTP(const Options& opts, Result& result)
+    {
+      result.latencyNs.reserve(opts.packets);
+      LinkBench bench(opts, result);
+      return bench.Run();
+    }
+
+    static Register linkUTP("link.utp", LinkUTP);
+  }  // namespace bench
+}  // namespace llarp
@@ -0,0 +1,132 @@
+#include <bench.hpp>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <crypto/types.hpp>
+#include <util/packet_buffer.hpp>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// packets the benchmarks cycle through
+    static constexpr size_t Batch = 64;
+
+    static std::vector< PacketBuffer >
+    MakePackets(Crypto* crypto, size_t num, size_t size)
+    {
+      std::vector< PacketBuffer > pkts;
+      for(size_t idx = 0; idx < num; ++idx)
+      {
+        pkts.emplace_back(PacketBuffer::Alloc(size));
+        if(pkts.back().IsEmpty())
+          return {};
+        crypto->randbytes(pkts.back().data(), size);
+      }
+      return pkts;
+    }
+
+    /// what the path owner does for every packet, all layers in one pass.
+    /// Path hands the onion one packet per call
+    static bool
+    OnionPath(const Options& opts, Result& result)
+    {
+      sodium::CryptoLibSodium crypto;
+      const size_t hops = std::max(opts.hops, size_t(1));
+      std::vector< SharedSecret > keys(hops);
+      for(auto& key : keys)
+        key.Randomize();
+      std::vector< TunnelNonce > nonces(hops);
+      for(auto& nonce : nonces)
+        nonce.Randomize();
+      auto pkts = MakePackets(&crypto, Batch, opts.size);
+      if(pkts.empty())
+        return false;
+
+      result.hops = hops;
+      result.latencyNs.reserve(opts.packets);
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        const uint64_t started = NowNs();
+        if(!crypto.xchacha20_onion(&pkts[result.packets % Batch], 1,
+                                   keys.data(), nonces.data(), hops))
+          return false;
+        result.latencyNs.push_back(NowNs() - started);
+        ++result.packets;
+        result.bytes += opts.size;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    /// the path owner's onion one layer at a time, to compare with
+    /// onion.path
+    static bool
+    OnionLayers(const Options& opts, Result& result)
+    {
+      sodium::CryptoLibSodium crypto;
+      const size_t hops = std::max(opts.hops, size_t(1));
+      std::vector< SharedSecret > keys(hops);
+      for(auto& key : keys)
+        key.Randomize();
+      std::vector< TunnelNonce > nonces(hops);
+      for(auto& nonce : nonces)
+        nonce.Randomize();
+      auto pkts = MakePackets(&crypto, Batch, opts.size);
+      if(pkts.empty())
+        return false;
+
+      result.hops = hops;
+      result.latencyNs.reserve(opts.packets);
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        const uint64_t started = NowNs();
+        const llarp_buffer_t buf(pkts[result.packets % Batch]);
+        for(size_t idx = 0; idx < hops; ++idx)
+        {
+          if(!crypto.xchacha20(buf, keys[idx], nonces[idx]))
+            return false;
+        }
+        result.latencyNs.push_back(NowNs() - started);
+        ++result.packets;
+        result.bytes += opts.size;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    /// what a transit hop does for every packet, one layer at a time
+    static bool
+    OnionTransit(const Options& opts, Result& result)
+    {
+      sodium::CryptoLibSodium crypto;
+      SharedSecret key;
+      key.Randomize();
+      TunnelNonce nonce;
+      nonce.Randomize();
+      auto pkts = MakePackets(&crypto, Batch, opts.size);
+      if(pkts.empty())
+        return false;
+
+      result.latencyNs.reserve(opts.packets);
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        const uint64_t started = NowNs();
+        if(!crypto.xchacha20(llarp_buffer_t(pkts[result.packets % Batch]),
+                             key, nonce))
+          return false;
+        result.latencyNs.push_back(NowNs() - started);
+        ++result.packets;
+        result.bytes += opts.size;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    static Register onionPath("onion.path", OnionPath);
+    static Register onionLayers("onion.layers", OnionLayers);
+    static Register onionTransit("onion.transit", OnionTransit);
+  }  // namespace bench
+}  // namespace llarp
@@ -0,0 +1,101 @@
+#include <bench.hpp>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <messages/relay.hpp>
+#include <util/bencode.hpp>
+
+namespace llarp
+{
+  namespace bench
+  {
+    /// decode a relay message off the wire the way the link message parser
+    /// does, skipping the message type
+    static bool
+    DecodeRelay(RelayUpstreamMessage& msg, llarp_buffer_t* buf)
+    {
+      dict_reader r;
+      r.user   = &msg;
+      r.on_key = [](dict_reader* reader, llarp_buffer_t* key) -> bool {
+        if(key == nullptr)
+          return true;
+        if(*key == "a")
+        {
+          llarp_buffer_t strbuf;
+          return bencode_read_string(reader->buffer, &strbuf);
+        }
+        auto* self = static_cast< RelayUpstreamMessage* >(reader->user);
+        return self->DecodeKey(*key, reader->buffer);
+      };
+      return bencode_read_dict(buf, &r);
+    }
+
+    static bool
+    EncodeRelay(const RelayUpstreamMessage& msg,
+                std::array< byte_t, MAX_LINK_MSG_SIZE >& wire, size_t& sz)
+    {
+      llarp_buffer_t buf(wire);
+      if(!msg.BEncode(&buf))
+        return false;
+      sz = buf.cur - buf.base;
+      return true;
+    }
+
+    /// one packet going upstream through a chain of transit hops, each hop
+    /// decodes the relay message, peels its layer and encodes it for the
+    /// next hop like TransitHop::HandleUpstream does
+    static bool
+    RelayUpstream(const Options& opts, Result& result)
+    {
+      sodium::CryptoLibSodium crypto;
+      const size_t hops = std::max(opts.hops, size_t(1));
+      std::vector< SharedSecret > keys(hops);
+      std::vector< TunnelNonce > nonceXOR(hops);
+      for(size_t idx = 0; idx < hops; ++idx)
+      {
+        keys[idx].Randomize();
+        nonceXOR[idx].Randomize();
+      }
+      std::vector< byte_t > payload(opts.size);
+      crypto.randbytes(payload.data(), payload.size());
+      std::array< byte_t, MAX_LINK_MSG_SIZE > wire;
+
+      result.hops = hops;
+      result.latencyNs.reserve(opts.packets);
+      Measure measure(result);
+      while(result.packets < opts.packets)
+      {
+        const uint64_t started = NowNs();
+        size_t sz              = 0;
+        {
+          RelayUpstreamMessage msg;
+          msg.pathid.Randomize();
+          msg.Y.Randomize();
+          msg.X = PacketBuffer::Copy(llarp_buffer_t(payload));
+          if(msg.X.IsEmpty() || !EncodeRelay(msg, wire, sz))
+            return false;
+        }
+        for(size_t idx = 0; idx < hops; ++idx)
+        {
+          RelayUpstreamMessage in;
+          llarp_buffer_t buf(wire.data(), sz);
+          if(!DecodeRelay(in, &buf))
+            return false;
+          crypto.xchacha20(llarp_buffer_t(in.X), keys[idx], in.Y);
+          RelayUpstreamMessage out;
+          out.pathid = in.pathid;
+          out.Y      = in.Y ^ nonceXOR[idx];
+          out.X      = in.X;
+          if(!EncodeRelay(out, wire, sz))
+            return false;
+        }
+        result.latencyNs.push_back(NowNs() - started);
+        ++result.packets;
+        result.bytes += opts.size;
+      }
+      measure.Stop();
+      return true;
+    }
+
+    static Register relayUpstream("relay.upstream", RelayUpstream);
+  }  // namespace bench
+}  // namespace llarp
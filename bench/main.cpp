@@ -0,0 +1,78 @@
+#include <bench.hpp>
+
+#include <util/logger.hpp>
+
+#include <cxxopts.hpp>
+
+#include <iostream>
+
+int
+main(int argc, char *argv[])
+{
+  cxxopts::Options options("lokinet-bench",
+                           "measures the lokinet relay data path, run with "
+                           "--list to see what is measured");
+  // clang-format off
+  options.add_options()
+    ("h,help", "help", cxxopts::value< bool >())
+    ("l,list", "list benchmarks", cxxopts::value< bool >())
+    ("f,filter", "only run benchmarks whose name contains this",
+     cxxopts::value< std::string >()->default_value(""))
+    ("s,size", "payload size in bytes",
+     cxxopts::value< size_t >()->default_value("1024"))
+    ("n,packets", "packets per benchmark",
+     cxxopts::value< uint64_t >()->default_value("100000"))
+    ("hops", "path length",
+     cxxopts::value< size_t >()->default_value("4"))
+    ("dht-nodes", "dht routing table size",
+     cxxopts::value< size_t >()->default_value("10000"));
+  // clang-format on
+
+  llarp::bench::Options opts;
+  std::string filter;
+  try
+  {
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+      std::cout << options.help() << std::endl;
+      return 0;
+    }
+    if(result.count("list"))
+    {
+      for(const auto &bench : llarp::bench::Registry())
+        std::cout << bench.name << std::endl;
+      return 0;
+    }
+    filter        = result["filter"].as< std::string >();
+    opts.size     = result["size"].as< size_t >();
+    opts.packets  = result["packets"].as< uint64_t >();
+    opts.hops     = result["hops"].as< size_t >();
+    opts.dhtNodes = result["dht-nodes"].as< size_t >();
+  }
+  catch(const cxxopts::OptionException &ex)
+  {
+    std::cerr << ex.what() << std::endl << options.help() << std::endl;
+    return 1;
+  }
+
+  llarp::SetLogLevel(llarp::eLogWarn);
+
+  int failed = 0;
+  llarp::bench::PrintHeader(std::cout);
+  for(const auto &bench : llarp::bench::Registry())
+  {
+    if(bench.name.find(filter) == std::string::npos)
+      continue;
+    llarp::bench::Result result;
+    result.name = bench.name;
+    if(!bench.func(opts, result))
+    {
+      std::cout << bench.name << " failed" << std::endl;
+      ++failed;
+      continue;
+    }
+    llarp::bench::Print(std::cout, result);
+  }
+  return failed;
+}
@@ -0,0 +1,87 @@
+#include <crypto/crypto_libsodium.hpp>
+#include <nodedb.hpp>
+#include <util/logger.hpp>
+
+#include <cxxopts.hpp>
+
+#include <iostream>
+
+int
+main(int argc, char *argv[])
+{
+  cxxopts::Options options("lokinet-nodedb",
+                           "moves a lokinet network database from a netdb "
+                           "directory into a single file and looks after it");
+  // clang-format off
+  options.add_options()
+    ("h,help", "help", cxxopts::value< bool >())
+    ("i,import", "import every RC in this netdb directory",
+     cxxopts::value< std::string >())
+    ("c,compact", "drop replaced and removed RCs from the file",
+     cxxopts::value< bool >())
+    ("l,list", "list the RCs in the file", cxxopts::value< bool >())
+    ("file", "nodedb file", cxxopts::value< std::string >());
+  // clang-format on
+  options.parse_positional("file");
+
+  std::string file;
+  std::string importDir;
+  bool compact = false;
+  bool list    = false;
+  try
+  {
+    auto result = options.parse(argc, argv);
+    if(result.count("help") || !result.count("file"))
+    {
+      std::cout << options.help() << std::endl;
+      return result.count("help") ? 0 : 1;
+    }
+    file = result["file"].as< std::string >();
+    if(result.count("import"))
+      importDir = result["import"].as< std::string >();
+    compact = result.count("compact") > 0;
+    list    = result.count("list") > 0;
+  }
+  catch(const cxxopts::OptionException &ex)
+  {
+    std::cerr << ex.what() << std::endl << options.help() << std::endl;
+    return 1;
+  }
+
+  llarp::SetLogLevel(llarp::eLogWarn);
+
+  llarp::sodium::CryptoLibSodium crypto;
+  // nothing here needs the disk thread, everything runs inline
+  llarp_nodedb nodedb(&crypto, nullptr);
+  if(nodedb.load_file(file.c_str()) < 0)
+  {
+    std::cerr << "cannot open " << file << std::endl;
+    return 1;
+  }
+  if(!importDir.empty())
+  {
+    ssize_t imported = nodedb.import_dir(importDir.c_str());
+    if(imported < 0)
+    {
+      std::cerr << "cannot read " << importDir << std::endl;
+      return 1;
+    }
+    std::cout << "imported " << imported << " RCs from " << importDir
+              << std::endl;
+  }
+  if(compact && !nodedb.store->Compact())
+  {
+    std::cerr << "failed to compact " << file << std::endl;
+    return 1;
+  }
+  if(list)
+  {
+    nodedb.store->ForEach([](const llarp::RouterID &pk) -> bool {
+      std::cout << pk << std::endl;
+      return true;
+    });
+  }
+  std::cout << file << ": " << nodedb.num_loaded() << " RCs, "
+            << nodedb.store->Wasted() << " bytes wasted" << std::endl;
+  return 0;
+}
@@ -62,6 +62,7 @@ namespace llarp
     std::unique_ptr< llarp_nodedb > nodedb;
     llarp_ev_loop_ptr mainloop;
     std::string nodedb_dir;
+    std::string nodedb_file;
 
     bool
     LoadConfig(const std::string &fname);
@@ -72,6 +73,9 @@ namespace llarp
     int
     LoadDatabase();
 
+    int
+    LoadDatabaseFile();
+
     int
     IterateDatabase(llarp_nodedb_iter &i);
 
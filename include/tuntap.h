@@ -103,6 +103,8 @@ typedef struct in6_addr t_tun_in6_addr;
 #define TUNTAP_MODE_ETHERNET 0x0001
 #define TUNTAP_MODE_TUNNEL 0x0002
 #define TUNTAP_MODE_PERSIST 0x0004
+/* linux only, lets more queues be attached with tuntap_open_queue */
+#define TUNTAP_MODE_MULTIQUEUE 0x0008
 
 #define TUNTAP_LOG_NONE 0x0000
 #define TUNTAP_LOG_DEBUG 0x0001
@@ -212,6 +214,12 @@ extern "C"
   tuntap_set_nonblocking(struct device *dev, int);
   TUNTAP_EXPORT int
   tuntap_set_debug(struct device *dev, int);
+#if defined Linux
+  /* open another queue on a device started with TUNTAP_MODE_MULTIQUEUE,
+   * returns its fd or -1 */
+  TUNTAP_EXPORT int
+  tuntap_open_queue(struct device *dev);
+#endif
 
   /* Logging functions */
   TUNTAP_EXPORT void
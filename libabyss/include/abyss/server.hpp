@@ -30,6 +30,17 @@ namespace abyss
       virtual absl::optional< Response >
       HandleJSONRPC(Method_t method, const Params& params) = 0;
 
+      /// body and content type sent back for a GET
+      struct Document
+      {
+        std::string contentType;
+        std::string body;
+      };
+
+      /// serve a GET of path, nothing means 404. none by default.
+      virtual absl::optional< Document >
+      HandleGET(const std::string& path);
+
       virtual ~IRPCHandler();
 
       bool
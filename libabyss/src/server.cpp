@@ -125,6 +125,17 @@ namespace abyss
       bool
       FeedBody(const char* buf, size_t sz)
       {
+        if(Header.Method == "GET")
+        {
+          auto doc = handler->HandleGET(Header.Path);
+          if(!doc)
+          {
+            return WriteResponseSimple(404, "Not Found", "text/plain",
+                                       "nope");
+          }
+          return WriteResponseSimple(200, "OK", doc->contentType.c_str(),
+                                     doc->body.c_str());
+        }
         if(Header.Method != "POST")
         {
           return WriteResponseSimple(405, "Method Not Allowed", "text/plain",
@@ -319,6 +330,12 @@ namespace abyss
       delete m_Impl;
     }
 
+    absl::optional< IRPCHandler::Document >
+    IRPCHandler::HandleGET(const std::string&)
+    {
+      return {};
+    }
+
     bool
     IRPCHandler::ShouldClose(llarp_time_t now) const
     {
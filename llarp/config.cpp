@@ -180,6 +180,14 @@ llarp_generic_ensure_config(std::ofstream &f, std::string basepath)
   f << "# uncomment following line to set router nickname to 'lokinet'"
     << std::endl;
   f << "# nickname=lokinet" << std::endl;
+  f << std::endl;
+  f << "# uncomment following line to read and write up to 32 udp packets "
+       "per syscall"
+    << std::endl;
+  f << "# udp-batch-size=32" << std::endl;
+  f << "# uncomment following line to read inbound link traffic on 4 threads"
+    << std::endl;
+  f << "# link-threads=4" << std::endl;
   f << std::endl << std::endl;
 
   // logging
@@ -190,6 +198,9 @@ llarp_generic_ensure_config(std::ofstream &f, std::string basepath)
   f << "#file=/path/to/logfile" << std::endl;
   f << "# uncomment for syslog logging" << std::endl;
   f << "#type=syslog" << std::endl;
+  f << "# uncomment to format and write log lines on a background thread"
+    << std::endl;
+  f << "#async=true" << std::endl;
 
   // metrics
   f << "[metrics]" << std::endl;
@@ -242,6 +253,11 @@ llarp_generic_ensure_config(std::ofstream &f, std::string basepath)
   f << "[netdb]" << std::endl;
   f << "# directory for network database skiplist storage" << std::endl;
   f << "dir=" << basepath << "netdb" << std::endl;
+  f << "# keep the network database in one memory mapped file instead, "
+       "anything"
+    << std::endl;
+  f << "# in dir is imported into it the first time" << std::endl;
+  f << "#file=" << basepath << "netdb.db" << std::endl;
   f << std::endl << std::endl;
 
   f << "# bootstrap settings" << std::endl;
@@ -270,6 +286,8 @@ llarp_ensure_router_config(std::ofstream &f, std::string basepath)
   f << "profiles=" << basepath << "profiles.dat" << std::endl;
   f << "ifaddr=10.105.0.1/16" << std::endl;
   f << "ifname=lokitun0" << std::endl;
+  f << "# linux only, service tun io on this many threads" << std::endl;
+  f << "# tun-queues=1" << std::endl;
   f << "enabled=true" << std::endl;
   f << "exit=false" << std::endl;
   f << "# exit-blacklist=tcp:25" << std::endl;
@@ -316,6 +334,12 @@ llarp_ensure_client_config(std::ofstream &f, std::string basepath)
                      "interface this snap owns"
                   << std::endl;
       clientini_f << "ifname=snapp-tun0" << std::endl;
+      clientini_f << "# linux only, service tun io on this many threads"
+                  << std::endl;
+      clientini_f << "# tun-queues=1" << std::endl;
+      clientini_f << "# mtu of the network interface, up to 4096"
+                  << std::endl;
+      clientini_f << "# tun-mtu=1500" << std::endl;
     }
     else
     {
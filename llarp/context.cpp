@@ -124,6 +124,10 @@ namespace llarp
       {
         nodedb_dir = val;
       }
+      if(!strcmp(key, "file"))
+      {
+        nodedb_file = val;
+      }
     }
   }
 
@@ -206,7 +210,11 @@ __        ___    ____  _   _ ___ _   _  ____
   {
     crypto = std::make_unique< sodium::CryptoLibSodium >();
     nodedb =
-        std::make_unique< llarp_nodedb >(crypto.get(), router->diskworker());
+        std::make_unique< llarp_nodedb >(crypto.get(), router->diskworker(),
+                                         router->threadpool());
+
+    if(!nodedb_file.empty())
+      return LoadDatabaseFile();
 
     if(!llarp_nodedb::ensure_dir(nodedb_dir.c_str()))
     {
@@ -226,6 +234,28 @@ __        ___    ____  _   _ ___ _   _  ____
     return 1;
   }
 
+  int
+  Context::LoadDatabaseFile()
+  {
+    ssize_t loaded = nodedb->load_file(nodedb_file.c_str());
+    if(loaded < 0)
+    {
+      llarp::LogError("cannot open nodedb file ", nodedb_file);
+      return 0;
+    }
+    std::error_code ec;
+    if(loaded == 0 && !nodedb_dir.empty() && fs::exists(nodedb_dir, ec))
+    {
+      // first run with the file, bring over what we had
+      loaded = nodedb->import_dir(nodedb_dir.c_str());
+      llarp::LogInfo("imported ", loaded, " RCs from [", nodedb_dir,
+                     "] into ", nodedb_file);
+    }
+    llarp::LogInfo("nodedb file ", nodedb_file, " has ", nodedb->num_loaded(),
+                   " RCs");
+    return 1;
+  }
+
   int
   Context::IterateDatabase(llarp_nodedb_iter &i)
   {
@@ -19,6 +19,8 @@
 
 namespace llarp
 {
+  struct PacketBuffer;
+
   /// PKE(result, publickey, secretkey, nonce)
   using path_dh_func = std::function< bool(
       SharedSecret &, const PubKey &, const SecretKey &, const TunnelNonce &) >;
@@ -46,6 +48,13 @@ namespace llarp
     xchacha20_alt(const llarp_buffer_t &, const llarp_buffer_t &,
                   const SharedSecret &, const byte_t *) = 0;
 
+    /// xchacha symmetric cipher over onion layers, puts every packet through
+    /// all layers in one call, packet j gets layer i with keys[i] and
+    /// nonces[j * layers + i]
+    virtual bool
+    xchacha20_onion(PacketBuffer *pkts, size_t num, const SharedSecret *keys,
+                    const TunnelNonce *nonces, size_t layers) = 0;
+
     /// path dh creator's side
     virtual bool
     dh_client(SharedSecret &, const PubKey &, const SecretKey &,
@@ -1,10 +1,13 @@
 #include <crypto/crypto_libsodium.hpp>
+#include <crypto/xchacha20_multi.hpp>
 #include <sodium/crypto_generichash.h>
 #include <sodium/crypto_sign.h>
 #include <sodium/crypto_scalarmult.h>
 #include <sodium/crypto_stream_xchacha20.h>
 #include <util/mem.hpp>
+#include <util/packet_buffer.hpp>
 
+#include <array>
 #include <assert.h>
 
 extern "C"
@@ -109,6 +112,33 @@ namespace llarp
           == 0;
     }
 
+    bool
+    CryptoLibSodium::xchacha20_onion(PacketBuffer *pkts, size_t num,
+                                     const SharedSecret *keys,
+                                     const TunnelNonce *nonces, size_t layers)
+    {
+      // every layer of every packet is its own keystream, the kernel runs
+      // them side by side and xors all layers of a packet in one pass
+      std::array< XChaCha20Stream, 64 > streams;
+      size_t n = 0;
+      for(size_t j = 0; j < num; ++j)
+      {
+        for(size_t i = 0; i < layers; ++i)
+        {
+          streams[n++] = {pkts[j].data(), pkts[j].size(), keys[i].data(),
+                          nonces[j * layers + i].data()};
+          if(n == streams.size())
+          {
+            xchacha20_multi_xor(streams.data(), n);
+            n = 0;
+          }
+        }
+      }
+      if(n)
+        xchacha20_multi_xor(streams.data(), n);
+      return true;
+    }
+
     bool
     CryptoLibSodium::dh_client(llarp::SharedSecret &shared, const PubKey &pk,
                                const SecretKey &sk, const TunnelNonce &n)
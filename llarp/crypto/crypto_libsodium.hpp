@@ -25,6 +25,11 @@ namespace llarp
       xchacha20_alt(const llarp_buffer_t &, const llarp_buffer_t &,
                     const SharedSecret &, const byte_t *) override;
 
+      /// xchacha symmetric cipher over onion layers
+      bool
+      xchacha20_onion(PacketBuffer *pkts, size_t num, const SharedSecret *keys,
+                      const TunnelNonce *nonces, size_t layers) override;
+
       /// path dh creator's side
       bool
       dh_client(SharedSecret &, const PubKey &, const SecretKey &,
@@ -145,6 +145,15 @@ namespace llarp
       context = user;
       llarp_threadpool_queue_job(worker, {this, &Decrypt});
     }
+
+    /// decrypt on the calling thread, for when we are already in a worker
+    void
+    DecryptNow(const EncryptedFrame& frame, User* user)
+    {
+      target  = frame;
+      context = user;
+      Decrypt(this);
+    }
   };
 }  // namespace llarp
 
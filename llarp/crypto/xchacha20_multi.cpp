@@ -0,0 +1,250 @@
+#include <crypto/xchacha20_multi.hpp>
+
+#include <util/endian.hpp>
+
+#include <sodium/core.h>
+#include <sodium/runtime.h>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LLARP_MB_INLINE inline __attribute__((always_inline))
+#define LLARP_MB_VECTORS 1
+#if defined(__x86_64__) || defined(__i386__)
+#define LLARP_MB_AVX2 1
+#endif
+#else
+#define LLARP_MB_INLINE inline
+#endif
+
+namespace llarp
+{
+  namespace
+  {
+    constexpr uint32_t Sigma[4] = {0x61707865, 0x3320646e, 0x79622d32,
+                                   0x6b206574};
+
+    constexpr size_t BlockSize = 64;
+
+    LLARP_MB_INLINE uint32_t
+    load32(const byte_t *p)
+    {
+      uint32_t w;
+      memcpy(&w, p, sizeof(w));
+      return le32toh(w);
+    }
+
+    LLARP_MB_INLINE void
+    store32(byte_t *p, uint32_t w)
+    {
+      w = htole32(w);
+      memcpy(p, &w, sizeof(w));
+    }
+
+    template < int N, typename V >
+    LLARP_MB_INLINE void
+    rotl(V &v)
+    {
+      v = (v << N) | (v >> (32 - N));
+    }
+
+    template < typename V >
+    LLARP_MB_INLINE void
+    quarter(V &a, V &b, V &c, V &d)
+    {
+      a += b;
+      d ^= a;
+      rotl< 16 >(d);
+      c += d;
+      b ^= c;
+      rotl< 12 >(b);
+      a += b;
+      d ^= a;
+      rotl< 8 >(d);
+      c += d;
+      b ^= c;
+      rotl< 7 >(b);
+    }
+
+    template < typename V >
+    LLARP_MB_INLINE void
+    rounds(V *x)
+    {
+      for(int i = 0; i < 10; ++i)
+      {
+        quarter(x[0], x[4], x[8], x[12]);
+        quarter(x[1], x[5], x[9], x[13]);
+        quarter(x[2], x[6], x[10], x[14]);
+        quarter(x[3], x[7], x[11], x[15]);
+        quarter(x[0], x[5], x[10], x[15]);
+        quarter(x[1], x[6], x[11], x[12]);
+        quarter(x[2], x[7], x[8], x[13]);
+        quarter(x[3], x[4], x[9], x[14]);
+      }
+    }
+
+    /// one stream per lane, n <= lanes, idle lanes repeat the last stream
+    template < typename V >
+    LLARP_MB_INLINE void
+    xor_group(const XChaCha20Stream *s, size_t n)
+    {
+      constexpr size_t Lanes = sizeof(V) / sizeof(uint32_t);
+      // lane major scratch, words go in and out of the vectors through here
+      uint32_t words[16][Lanes];
+      V in[16], x[16];
+
+      for(size_t j = 0; j < Lanes; ++j)
+      {
+        const XChaCha20Stream &st = s[std::min(j, n - 1)];
+        for(size_t i = 0; i < 4; ++i)
+          words[i][j] = Sigma[i];
+        for(size_t i = 0; i < 8; ++i)
+          words[4 + i][j] = load32(st.key + 4 * i);
+        for(size_t i = 0; i < 4; ++i)
+          words[12 + i][j] = load32(st.nonce + 4 * i);
+      }
+      for(size_t i = 0; i < 16; ++i)
+        memcpy(&x[i], words[i], sizeof(V));
+
+      // hchacha20 over the first 16 bytes of the nonce gives the subkey
+      rounds(x);
+      for(size_t i = 0; i < 4; ++i)
+      {
+        memcpy(&in[i], words[i], sizeof(V));
+        in[4 + i] = x[i];
+        in[8 + i] = x[12 + i];
+      }
+      // then chacha20 with a 64 bit block counter and the last 8 bytes
+      for(size_t j = 0; j < Lanes; ++j)
+      {
+        const XChaCha20Stream &st = s[std::min(j, n - 1)];
+        words[12][j]              = 0;
+        words[13][j]              = 0;
+        words[14][j]              = load32(st.nonce + 16);
+        words[15][j]              = load32(st.nonce + 20);
+      }
+      for(size_t i = 12; i < 16; ++i)
+        memcpy(&in[i], words[i], sizeof(V));
+
+      size_t maxsz = 0;
+      for(size_t j = 0; j < n; ++j)
+        maxsz = std::max(maxsz, s[j].sz);
+
+      for(size_t off = 0; off < maxsz; off += BlockSize)
+      {
+        for(size_t i = 0; i < 16; ++i)
+          x[i] = in[i];
+        rounds(x);
+        for(size_t i = 0; i < 16; ++i)
+        {
+          x[i] += in[i];
+          memcpy(words[i], &x[i], sizeof(V));
+        }
+        for(size_t j = 0; j < n; ++j)
+        {
+          if(off >= s[j].sz)
+            continue;
+          byte_t *p        = s[j].buf + off;
+          const size_t len = std::min(BlockSize, s[j].sz - off);
+          if(len == BlockSize)
+          {
+            for(size_t i = 0; i < 16; ++i)
+              store32(p + 4 * i, load32(p + 4 * i) ^ words[i][j]);
+          }
+          else
+          {
+            byte_t ks[BlockSize];
+            for(size_t i = 0; i < 16; ++i)
+              store32(ks + 4 * i, words[i][j]);
+            for(size_t b = 0; b < len; ++b)
+              p[b] ^= ks[b];
+          }
+        }
+        // link messages are far too small for the low word to wrap
+        in[12] += 1;
+      }
+    }
+
+    template < typename V >
+    LLARP_MB_INLINE void
+    xor_all(const XChaCha20Stream *s, size_t n)
+    {
+      constexpr size_t Lanes = sizeof(V) / sizeof(uint32_t);
+      while(n)
+      {
+        const size_t num = std::min(n, Lanes);
+        xor_group< V >(s, num);
+        s += num;
+        n -= num;
+      }
+    }
+
+#ifdef LLARP_MB_VECTORS
+    /// sse2 on x86, neon on arm, whatever the compiler can do elsewhere
+    typedef uint32_t v4u __attribute__((vector_size(16)));
+
+    void
+    xor_vec128(const XChaCha20Stream *s, size_t n)
+    {
+      xor_all< v4u >(s, n);
+    }
+#else
+    void
+    xor_scalar(const XChaCha20Stream *s, size_t n)
+    {
+      xor_all< uint32_t >(s, n);
+    }
+#endif
+
+#ifdef LLARP_MB_AVX2
+    typedef uint32_t v8u __attribute__((vector_size(32)));
+
+    __attribute__((target("avx2"))) void
+    xor_avx2(const XChaCha20Stream *s, size_t n)
+    {
+      xor_all< v8u >(s, n);
+    }
+#endif
+
+    struct Kernel
+    {
+      void (*func)(const XChaCha20Stream *, size_t);
+      const char *name;
+    };
+
+    Kernel
+    PickKernel()
+    {
+#ifdef LLARP_MB_AVX2
+      // sodium_init fills in the cpu features, does nothing if already done
+      if(sodium_init() != -1 && sodium_runtime_has_avx2())
+        return {&xor_avx2, "avx2"};
+#endif
+#ifdef LLARP_MB_VECTORS
+      return {&xor_vec128, "vec128"};
+#else
+      return {&xor_scalar, "scalar"};
+#endif
+    }
+
+    const Kernel &
+    GetKernel()
+    {
+      static const Kernel kernel = PickKernel();
+      return kernel;
+    }
+  }  // namespace
+
+  void
+  xchacha20_multi_xor(const XChaCha20Stream *streams, size_t num)
+  {
+    GetKernel().func(streams, num);
+  }
+
+  const char *
+  xchacha20_multi_kernel()
+  {
+    return GetKernel().name;
+  }
+}  // namespace llarp
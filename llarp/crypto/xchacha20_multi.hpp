@@ -0,0 +1,35 @@
+#ifndef LLARP_CRYPTO_XCHACHA20_MULTI_HPP
+#define LLARP_CRYPTO_XCHACHA20_MULTI_HPP
+
+#include <util/types.hpp>
+
+#include <stddef.h>
+
+namespace llarp
+{
+  /// one xchacha20 keystream to xor into a buffer
+  struct XChaCha20Stream
+  {
+    byte_t *buf;
+    size_t sz;
+    /// 32 bytes
+    const byte_t *key;
+    /// 24 bytes
+    const byte_t *nonce;
+  };
+
+  /// xor every stream into its buffer, same output as
+  /// crypto_stream_xchacha20_xor on each of them
+  ///
+  /// streams are computed side by side in simd lanes, several streams may
+  /// point at the same buffer and then all of them are applied, which is how
+  /// onion layers are done in one pass
+  void
+  xchacha20_multi_xor(const XChaCha20Stream *streams, size_t num);
+
+  /// name of the kernel picked for this cpu
+  const char *
+  xchacha20_multi_kernel();
+}  // namespace llarp
+
+#endif
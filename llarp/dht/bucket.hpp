@@ -5,6 +5,8 @@
 #include <dht/key.hpp>
 #include <util/status.hpp>
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <set>
 #include <vector>
@@ -13,7 +15,30 @@ namespace llarp
 {
   namespace dht
   {
+    /// secondary index a bucket keeps in step with its nodes, for buckets
+    /// that are only ever searched by key
     template < typename Val_t >
+    struct NoIndex
+    {
+      void
+      Put(const Val_t&)
+      {
+      }
+
+      void
+      Del(const Val_t&)
+      {
+      }
+
+      void
+      Clear()
+      {
+      }
+    };
+
+    /// nodes must only be changed through PutNode, DelNode, ExpireNodes and
+    /// Clear so that index keeps up with them
+    template < typename Val_t, typename Index_t = NoIndex< Val_t > >
     struct Bucket
     {
       using BucketStorage_t = std::map< Key_t, Val_t, XorMetric >;
@@ -75,18 +100,13 @@ namespace llarp
       bool
       FindClosest(const Key_t& target, Key_t& result) const
       {
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for(const auto& item : nodes)
-        {
-          auto curDist = item.first ^ target;
-          if(curDist < mindist)
-          {
-            mindist = curDist;
-            result  = item.first;
-          }
-        }
-        return nodes.size() > 0;
+        bool found = false;
+        VisitClosest(target, [&](const Key_t& key) {
+          result = key;
+          found  = true;
+          return false;
+        });
+        return found;
       }
 
       bool
@@ -124,53 +144,45 @@ namespace llarp
       FindCloseExcluding(const Key_t& target, Key_t& result,
                          const std::set< Key_t >& exclude) const
       {
-        Key_t maxdist;
-        maxdist.Fill(0xff);
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for(const auto& item : nodes)
-        {
-          if(exclude.count(item.first))
-          {
-            continue;
-          }
-
-          auto curDist = item.first ^ target;
-          if(curDist < mindist)
-          {
-            mindist = curDist;
-            result  = item.first;
-          }
-        }
-        return mindist < maxdist;
+        bool found = false;
+        VisitClosest(target, [&](const Key_t& key) {
+          if(exclude.count(key))
+            return true;
+          result = key;
+          found  = true;
+          return false;
+        });
+        return found;
       }
 
       bool
       GetManyNearExcluding(const Key_t& target, std::set< Key_t >& result,
                            size_t N, const std::set< Key_t >& exclude) const
       {
-        std::set< Key_t > s(exclude.begin(), exclude.end());
-
-        Key_t peer;
-        while(N--)
-        {
-          if(!FindCloseExcluding(target, peer, s))
-          {
-            return false;
-          }
-          s.insert(peer);
-          result.insert(peer);
-        }
-        return true;
+        if(N == 0)
+          return true;
+        VisitClosest(target, [&](const Key_t& key) {
+          if(exclude.count(key) == 0 && result.insert(key).second)
+            --N;
+          return N > 0;
+        });
+        return N == 0;
       }
 
       void
       PutNode(const Val_t& val)
       {
         auto itr = nodes.find(val.ID);
-        if(itr == nodes.end() || itr->second < val)
+        if(itr == nodes.end())
         {
-          nodes[val.ID] = val;
+          nodes.emplace(val.ID, val);
+          index.Put(val);
+        }
+        else if(itr->second < val)
+        {
+          index.Del(itr->second);
+          itr->second = val;
+          index.Put(val);
         }
       }
 
@@ -180,10 +192,29 @@ namespace llarp
         auto itr = nodes.find(key);
         if(itr != nodes.end())
         {
+          index.Del(itr->second);
           nodes.erase(itr);
         }
       }
 
+      /// drop every node expired(const Val_t&) is true for
+      template < typename Expired >
+      void
+      ExpireNodes(Expired expired)
+      {
+        auto itr = nodes.begin();
+        while(itr != nodes.end())
+        {
+          if(expired(itr->second))
+          {
+            index.Del(itr->second);
+            itr = nodes.erase(itr);
+          }
+          else
+            ++itr;
+        }
+      }
+
       bool
       HasNode(const Key_t& key) const
       {
@@ -194,10 +225,70 @@ namespace llarp
       Clear()
       {
         nodes.clear();
+        index.Clear();
       }
 
       BucketStorage_t nodes;
       Random_t random;
+      Index_t index;
+
+     private:
+      using Iter_t = typename BucketStorage_t::const_iterator;
+
+      /// call visit(const Key_t&) on nodes from closest to target outwards
+      /// until it returns false
+      ///
+      /// nodes are sorted by distance to us, which is the order of key ^ us,
+      /// so they are the leaves of a binary trie over key ^ us in order and
+      /// every subtree is a contiguous range of the map. closeness to target
+      /// is closeness to target ^ us in that trie, so walking down it taking
+      /// the side target ^ us would take first hands out the nodes in
+      /// distance order. each step splits a range where its first and last
+      /// key part ways, costing one lower_bound, so getting n nodes takes
+      /// O((log size + n) log size) instead of n passes over the table.
+      template < typename Visit >
+      void
+      VisitClosest(const Key_t& target, Visit visit) const
+      {
+        if(nodes.empty())
+          return;
+        const Key_t& us = nodes.key_comp().us;
+        Walk(target ^ us, nodes.begin(), nodes.end(), visit);
+      }
+
+      /// walk [lo, hi), a non empty subtree of the trie, toward target which
+      /// is already xored with us. returns false once visit has had enough
+      template < typename Visit >
+      bool
+      Walk(const Key_t& target, Iter_t lo, Iter_t hi, Visit& visit) const
+      {
+        Iter_t last = std::prev(hi);
+        if(lo == last)
+          return visit(lo->first);
+        const Key_t& us    = nodes.key_comp().us;
+        const Key_t first  = lo->first ^ us;
+        const size_t split = CommonPrefixBits(first, last->first ^ us);
+        // the smallest key in the right hand subtree
+        Key_t right = first;
+        const size_t byte = split / 8;
+        right[byte]       = (right[byte] | (0x80 >> (split % 8)))
+            & ~(0x7f >> (split % 8));
+        std::fill(right.begin() + byte + 1, right.end(), 0);
+        const Iter_t mid = nodes.lower_bound(right ^ us);
+        if(target[byte] & (0x80 >> (split % 8)))
+          return Walk(target, mid, hi, visit) && Walk(target, lo, mid, visit);
+        return Walk(target, lo, mid, visit) && Walk(target, mid, hi, visit);
+      }
+
+      /// how many leading bits a and b share, they must differ
+      static size_t
+      CommonPrefixBits(const Key_t& a, const Key_t& b)
+      {
+        size_t idx = 0;
+        while(a[idx] == b[idx])
+          ++idx;
+        return idx * 8 + __builtin_clz(uint32_t(a[idx] ^ b[idx])) - 24;
+      }
     };
   }  // namespace dht
 }  // namespace llarp
@@ -169,9 +169,9 @@ namespace llarp
       std::unique_ptr< Bucket< RCNode > > nodes;
 
       // for introduction sets
-      std::unique_ptr< Bucket< ISNode > > _services;
+      std::unique_ptr< Bucket< ISNode, TagIndex > > _services;
 
-      Bucket< ISNode >*
+      Bucket< ISNode, TagIndex >*
       services() override
       {
         return _services.get();
@@ -350,19 +350,13 @@ namespace llarp
       if(ctx->_services)
       {
         // expire intro sets
-        auto now    = ctx->Now();
-        auto& nodes = ctx->_services->nodes;
-        auto itr    = nodes.begin();
-        while(itr != nodes.end())
-        {
-          if(itr->second.introset.IsExpired(now))
-          {
-            llarp::LogDebug("introset expired ", itr->second.introset.A.Addr());
-            itr = nodes.erase(itr);
-          }
-          else
-            ++itr;
-        }
+        auto now = ctx->Now();
+        ctx->_services->ExpireNodes([now](const ISNode& node) -> bool {
+          if(!node.introset.IsExpired(now))
+            return false;
+          llarp::LogDebug("introset expired ", node.introset.A.Addr());
+          return true;
+        });
       }
       ctx->ScheduleCleanupTimer();
     }
@@ -373,44 +367,17 @@ namespace llarp
         const std::set< service::IntroSet >& exclude)
     {
       std::set< service::IntroSet > found;
-      auto& nodes = _services->nodes;
-      if(nodes.size() == 0)
-      {
+      if(max == 0)
         return found;
-      }
-      auto itr = nodes.begin();
-      // start at random middle point
-      auto start = llarp::randint() % nodes.size();
-      std::advance(itr, start);
-      auto end            = itr;
-      std::string tagname = tag.ToString();
-      while(itr != nodes.end())
-      {
-        if(itr->second.introset.topic.ToString() == tagname)
-        {
-          if(exclude.count(itr->second.introset) == 0)
-          {
-            found.insert(itr->second.introset);
-            if(found.size() == max)
-              return found;
-          }
-        }
-        ++itr;
-      }
-      itr = nodes.begin();
-      while(itr != end)
-      {
-        if(itr->second.introset.topic.ToString() == tagname)
-        {
-          if(exclude.count(itr->second.introset) == 0)
-          {
-            found.insert(itr->second.introset);
-            if(found.size() == max)
-              return found;
-          }
-        }
-        ++itr;
-      }
+      const auto& nodes = _services->nodes;
+      const auto& index = _services->index;
+      // start at a random one of those carrying the tag
+      index.VisitFrom(tag, llarp::randint(), [&](const Key_t& key) -> bool {
+        auto itr = nodes.find(key);
+        if(itr != nodes.end() && exclude.count(itr->second.introset) == 0)
+          found.insert(itr->second.introset);
+        return found.size() < max;
+      });
       return found;
     }
 
@@ -510,7 +477,8 @@ namespace llarp
       router    = r;
       ourKey    = us;
       nodes     = std::make_unique< Bucket< RCNode > >(ourKey, llarp::randint);
-      _services = std::make_unique< Bucket< ISNode > >(ourKey, llarp::randint);
+      _services = std::make_unique< Bucket< ISNode, TagIndex > >(
+          ourKey, llarp::randint);
       llarp::LogDebug("initialize dht with key ", ourKey);
       // start exploring
 
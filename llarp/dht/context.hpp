@@ -7,6 +7,7 @@
 #include <dht/message.hpp>
 #include <dht/messages/findintro.hpp>
 #include <dht/node.hpp>
+#include <dht/tagindex.hpp>
 #include <dht/tx.hpp>
 #include <dht/txholder.hpp>
 #include <dht/txowner.hpp>
@@ -165,7 +166,7 @@ namespace llarp
       virtual const PendingExploreLookups&
       pendingExploreLookups() const = 0;
 
-      virtual Bucket< ISNode >*
+      virtual Bucket< ISNode, TagIndex >*
       services() = 0;
 
       virtual bool&
@@ -3,6 +3,7 @@
 
 #include <path/path.hpp>
 #include <router/abstractrouter.hpp>
+#include <util/logic.hpp>
 
 namespace llarp
 {
@@ -109,9 +110,23 @@ namespace llarp
       if(dht.pendingRouterLookups().HasPendingLookupFrom(owner))
       {
         if(R.size() == 0)
+        {
           dht.pendingRouterLookups().NotFound(owner, K);
-        else
-          dht.pendingRouterLookups().Found(owner, R[0].pubkey, R);
+          return true;
+        }
+        // check the signatures together on the workers, the lookup then
+        // finds them in the verify cache when it validates them in logic
+        auto router       = dht.GetRouter();
+        auto logic        = router->logic();
+        const RouterID pk = R[0].pubkey;
+        VerifyRouterContacts(
+            router->crypto(), router->threadpool(), R, router->Now(),
+            [ctx, logic, owner, pk](std::vector< RouterContact > rcs,
+                                    std::vector< uint8_t >) {
+              logic->queue_func([ctx, owner, pk, rcs]() {
+                ctx->impl->pendingRouterLookups().Found(owner, pk, rcs);
+              });
+            });
         return true;
       }
       llarp::LogWarn("Unwarranted GRM from ", From, " txid=", txid);
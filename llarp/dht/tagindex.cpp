@@ -0,0 +1,53 @@
+#include <dht/tagindex.hpp>
+
+namespace llarp
+{
+  namespace dht
+  {
+    void
+    TagIndex::Put(const ISNode& node)
+    {
+      if(m_Position.count(node.ID))
+        return;
+      auto& keys = m_Tagged[node.introset.topic];
+      m_Position.emplace(node.ID, keys.size());
+      keys.push_back(node.ID);
+    }
+
+    void
+    TagIndex::Del(const ISNode& node)
+    {
+      auto pos = m_Position.find(node.ID);
+      if(pos == m_Position.end())
+        return;
+      auto itr = m_Tagged.find(node.introset.topic);
+      if(itr == m_Tagged.end())
+        return;
+      auto& keys = itr->second;
+      // fill the gap with the last one
+      if(pos->second + 1 != keys.size())
+      {
+        keys[pos->second]       = keys.back();
+        m_Position[keys.back()] = pos->second;
+      }
+      keys.pop_back();
+      m_Position.erase(pos);
+      if(keys.empty())
+        m_Tagged.erase(itr);
+    }
+
+    void
+    TagIndex::Clear()
+    {
+      m_Tagged.clear();
+      m_Position.clear();
+    }
+
+    size_t
+    TagIndex::Count(const service::Tag& tag) const
+    {
+      auto itr = m_Tagged.find(tag);
+      return itr == m_Tagged.end() ? 0 : itr->second.size();
+    }
+  }  // namespace dht
+}  // namespace llarp
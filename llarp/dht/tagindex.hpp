@@ -0,0 +1,61 @@
+#ifndef LLARP_DHT_TAGINDEX_HPP
+#define LLARP_DHT_TAGINDEX_HPP
+
+#include <dht/key.hpp>
+#include <dht/node.hpp>
+#include <service/tag.hpp>
+
+#include <map>
+#include <vector>
+
+namespace llarp
+{
+  namespace dht
+  {
+    /// the introsets we store grouped by the tag they carry, kept by the
+    /// services bucket so a tag lookup only touches the introsets that match
+    struct TagIndex
+    {
+      void
+      Put(const ISNode& node);
+
+      void
+      Del(const ISNode& node);
+
+      void
+      Clear();
+
+      /// how many stored introsets carry tag
+      size_t
+      Count(const service::Tag& tag) const;
+
+      /// call visit(const Key_t&) on the introsets carrying tag until it
+      /// returns false, starting from the one at offset start and wrapping
+      /// around, so a random start gives a random sample
+      template < typename Visit >
+      void
+      VisitFrom(const service::Tag& tag, uint64_t start, Visit visit) const
+      {
+        auto itr = m_Tagged.find(tag);
+        if(itr == m_Tagged.end())
+          return;
+        const auto& keys = itr->second;
+        const size_t sz  = keys.size();
+        for(size_t idx = 0; idx < sz; ++idx)
+        {
+          if(!visit(keys[(start + idx) % sz]))
+            return;
+        }
+      }
+
+     private:
+      /// tag -> addresses of the introsets carrying it, unordered so they
+      /// can be swapped out in O(1)
+      std::map< service::Tag, std::vector< Key_t > > m_Tagged;
+      /// address -> where it sits in its tag's list
+      std::map< Key_t, size_t > m_Position;
+    };
+  }  // namespace dht
+}  // namespace llarp
+
+#endif
@@ -0,0 +1,114 @@
+#include <dns/cache.hpp>
+
+#include <dns/dns.hpp>
+#include <dns/view.hpp>
+#include <util/endian.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace llarp
+{
+  namespace dns
+  {
+    constexpr size_t Cache::DefaultCapacity;
+    constexpr RR_TTL_t Cache::MaxTTL;
+    constexpr RR_TTL_t Cache::MaxNegativeTTL;
+    constexpr RR_TTL_t Cache::DefaultNegativeTTL;
+    constexpr llarp_time_t Cache::StaleFor;
+    constexpr RR_TTL_t Cache::StaleTTL;
+
+    Cache::Key
+    Cache::Key::From(const Question& question)
+    {
+      Key k{question.qname, question.qtype, question.qclass};
+      std::transform(k.qname.begin(), k.qname.end(), k.qname.begin(),
+                     [](unsigned char ch) { return std::tolower(ch); });
+      return k;
+    }
+
+    bool
+    Cache::Key::Assign(const QuestionView& question)
+    {
+      qtype  = question.qtype;
+      qclass = question.qclass;
+      return question.name.ToString(qname);
+    }
+
+    Cache::Cache(size_t capacity) : m_Entries(capacity)
+    {
+    }
+
+    bool
+    Cache::Get(const Key& key, MsgID_t id, llarp_time_t now, bool stale,
+               std::vector< byte_t >& reply)
+    {
+      Entry* entry = m_Entries.Get(key);
+      if(entry == nullptr)
+        return false;
+      const bool expired = now >= entry->expires;
+      if(expired && now >= entry->expires + StaleFor)
+      {
+        m_Entries.Erase(key);
+        return false;
+      }
+      if(expired && !stale)
+        return false;
+
+      reply = entry->reply;
+      htobe16buf(reply.data(), id);
+      const RR_TTL_t elapsed = (now - entry->stored) / 1000;
+      byte_t* pkt            = reply.data();
+      MessageView view;
+      view.Parse(pkt, reply.size());
+      view.ForEachRecord([&](const RecordView& rr) {
+        // the ttl of an edns record holds flags instead
+        if(rr.type == qTypeOPT)
+          return;
+        RR_TTL_t ttl = rr.ttl;
+        if(expired)
+          ttl = StaleTTL;
+        else
+          ttl = ttl > elapsed ? ttl - elapsed : 0;
+        htobe32buf(pkt + rr.ttlOffset, ttl);
+      });
+      return true;
+    }
+
+    bool
+    Cache::Put(const Key& key, const llarp_buffer_t& buf, llarp_time_t now)
+    {
+      MessageView view;
+      if(!view.Parse(buf))
+        return false;
+      const MessageHeader& hdr = view.Header();
+      if(hdr.fields & flags_TC)
+        return false;
+      const Fields_t rcode = hdr.fields & 0x0f;
+      if(rcode != flags_RCODENoError && rcode != flags_RCODENameError)
+        return false;
+      // no such name, or no records of that type for it
+      const bool negative = rcode == flags_RCODENameError || hdr.an_count == 0;
+
+      RR_TTL_t ttl = negative ? DefaultNegativeTTL : MaxTTL;
+      view.ForEachRecord([&](const RecordView& rr) {
+        if(rr.type == qTypeOPT)
+          return;
+        if(!negative)
+          ttl = std::min(ttl, rr.ttl);
+        // rfc 2308, negative replies live as long as the soa minimum
+        else if(rr.type == qTypeSOA && rr.rdlen >= 20)
+          ttl = std::min(
+              {rr.ttl, bufbe32toh(rr.rdata + rr.rdlen - 4), MaxNegativeTTL});
+      });
+      if(ttl == 0)
+        return false;
+      Entry entry;
+      entry.reply.assign(buf.base, buf.base + buf.sz);
+      entry.stored  = now;
+      entry.expires = now + llarp_time_t(ttl) * 1000;
+      m_Entries.Put(key, std::move(entry));
+      return true;
+    }
+  }  // namespace dns
+}  // namespace llarp
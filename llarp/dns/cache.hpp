@@ -0,0 +1,101 @@
+#ifndef LLARP_DNS_CACHE_HPP
+#define LLARP_DNS_CACHE_HPP
+
+#include <dns/message.hpp>
+#include <util/lru_cache.hpp>
+#include <util/types.hpp>
+
+#include <string>
+#include <vector>
+
+namespace llarp
+{
+  namespace dns
+  {
+    struct QuestionView;
+
+    /// wire format replies by question, kept for as long as their records
+    /// allow and a while after that to fall back on when nobody answers.
+    /// replies are kept as they came in, so compressed names and edns
+    /// records survive. not thread safe.
+    class Cache
+    {
+     public:
+      static constexpr size_t DefaultCapacity = 4096;
+      /// longest any reply is kept fresh, in seconds
+      static constexpr RR_TTL_t MaxTTL = 86400;
+      /// longest a negative reply is kept fresh, in seconds
+      static constexpr RR_TTL_t MaxNegativeTTL = 300;
+      /// how long a negative reply without an soa record is kept, in seconds
+      static constexpr RR_TTL_t DefaultNegativeTTL = 5;
+      /// how long past expiry a reply is still served if nobody answers
+      static constexpr llarp_time_t StaleFor = 60 * 60 * 1000;
+      /// ttl given to the records of a stale reply, as in rfc 8767
+      static constexpr RR_TTL_t StaleTTL = 30;
+
+      struct Key
+      {
+        std::string qname;
+        QType_t qtype;
+        QClass_t qclass;
+
+        /// names compare case insensitively
+        static Key
+        From(const Question& question);
+
+        /// set from a question in a packet, reusing the storage of qname
+        bool
+        Assign(const QuestionView& question);
+
+        bool
+        operator==(const Key& other) const
+        {
+          return qtype == other.qtype && qclass == other.qclass
+              && qname == other.qname;
+        }
+
+        struct Hash
+        {
+          size_t
+          operator()(const Key& k) const noexcept
+          {
+            return std::hash< std::string >()(k.qname)
+                ^ (size_t(k.qtype) << 16) ^ k.qclass;
+          }
+        };
+      };
+
+      explicit Cache(size_t capacity = DefaultCapacity);
+
+      /// copy the reply to key into reply with its id set to id and its
+      /// ttls counted down. stale allows replies that expired no longer
+      /// than StaleFor ago. false on a miss.
+      bool
+      Get(const Key& key, MsgID_t id, llarp_time_t now, bool stale,
+          std::vector< byte_t >& reply);
+
+      /// remember reply to key, false if it is not something to cache such
+      /// as a server failure, a truncated reply or a zero ttl
+      bool
+      Put(const Key& key, const llarp_buffer_t& reply, llarp_time_t now);
+
+      size_t
+      Size() const
+      {
+        return m_Entries.Size();
+      }
+
+     private:
+      struct Entry
+      {
+        std::vector< byte_t > reply;
+        llarp_time_t stored;
+        llarp_time_t expires;
+      };
+
+      util::LRUCache< Key, Entry, Key::Hash > m_Entries;
+    };
+  }  // namespace dns
+}  // namespace llarp
+
+#endif
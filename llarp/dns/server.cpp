@@ -1,6 +1,8 @@
 #include <dns/server.hpp>
 
 #include <crypto/crypto.hpp>
+#include <util/endian.hpp>
+#include <util/metrics.hpp>
 
 #include <array>
 
@@ -8,12 +10,15 @@ namespace llarp
 {
   namespace dns
   {
+    constexpr llarp_time_t Proxy::UpstreamTimeout;
+    constexpr llarp_time_t Proxy::HookedTimeout;
+
     Proxy::Proxy(llarp_ev_loop_ptr loop, IQueryHandler* h)
         : m_Loop(std::move(loop)), m_QueryHandler(h)
     {
       m_Client.user     = this;
       m_Server.user     = this;
-      m_Client.tick     = nullptr;
+      m_Client.tick     = &HandleTick;
       m_Server.tick     = nullptr;
       m_Client.recvfrom = &HandleUDPRecv_client;
       m_Server.recvfrom = &HandleUDPRecv_server;
@@ -61,99 +66,232 @@ namespace llarp
     }
 
     void
-    Proxy::HandleTick(llarp_udp_io*)
+    Proxy::HandleTick(llarp_udp_io* u)
     {
+      Proxy* self = static_cast< Proxy* >(u->user);
+      self->Tick(llarp_ev_loop_time_now_ms(self->m_Loop));
     }
 
     void
-    Proxy::SendMessageTo(llarp::Addr to, Message msg)
+    Proxy::Tick(llarp_time_t now)
     {
-      std::array< byte_t, 1500 > tmp = {{0}};
-      llarp_buffer_t buf(tmp);
-      if(msg.Encode(&buf))
+      util::Lock lock(&m_Access);
+      std::vector< Cache::Key > expired;
+      for(const auto& item : m_Pending)
       {
-        buf.sz  = buf.cur - buf.base;
-        buf.cur = buf.base;
-        llarp_ev_udp_sendto(&m_Server, to, buf);
+        const llarp_time_t timeout =
+            item.second.forwarded ? UpstreamTimeout : HookedTimeout;
+        if(now - item.second.sent >= timeout)
+          expired.emplace_back(item.first);
+      }
+      for(const auto& key : expired)
+        FailPending(key, now);
+    }
+
+    void
+    Proxy::FailPending(const Cache::Key& key, llarp_time_t now)
+    {
+      auto itr = m_Pending.find(key);
+      if(itr == m_Pending.end())
+        return;
+      const Pending& pending = itr->second;
+      if(pending.forwarded)
+        m_Forwarded.erase(pending.upstream);
+      for(const auto& asker : pending.askers)
+      {
+        if(pending.forwarded
+           && m_Cache.Get(key, asker.txid, now, true, m_SendBuf))
+        {
+          METRICS_DYNAMIC_INCREMENT("dns.cache", "stale");
+          llarp_ev_udp_sendto(&m_Server, asker.from, llarp_buffer_t(m_SendBuf));
+          continue;
+        }
+        MessageView query;
+        if(query.Parse(pending.query.data(), pending.query.size()))
+          SendServFail(asker.from, query, asker.txid);
       }
+      m_Pending.erase(itr);
+    }
+
+    void
+    Proxy::HandleReply(const Cache::Key& key, const llarp_buffer_t& reply,
+                       bool upstream)
+    {
+      if(reply.sz < MessageHeader::Size)
+        return;
+      const llarp_time_t now = llarp_ev_loop_time_now_ms(m_Loop);
+      util::Lock lock(&m_Access);
+      if(upstream && m_Cache.Put(key, reply, now))
+        METRICS_DYNAMIC_INT_UPDATE("dns.cache", "size", m_Cache.Size());
+      auto itr = m_Pending.find(key);
+      if(itr == m_Pending.end())
+        return;
+      m_SendBuf.assign(reply.base, reply.base + reply.sz);
+      for(const auto& asker : itr->second.askers)
+      {
+        htobe16buf(m_SendBuf.data(), asker.txid);
+        llarp_ev_udp_sendto(&m_Server, asker.from, llarp_buffer_t(m_SendBuf));
+      }
+      m_Pending.erase(itr);
+    }
+
+    void
+    Proxy::SendServFail(llarp::Addr to, const MessageView& query, MsgID_t id)
+    {
+      std::array< byte_t, 512 > tmp;
+      llarp_buffer_t buf(tmp);
+      if(WriteServFail(query, id, buf))
+        llarp_ev_udp_sendto(&m_Server, to, buf);
       else
-        llarp::LogWarn("failed to encode dns message when sending");
+        llarp::LogWarn("failed to write dns server failure");
     }
 
     void
     Proxy::HandlePktClient(llarp::Addr from, llarp_buffer_t* pkt)
     {
-      MessageHeader hdr;
-      if(!hdr.Decode(pkt))
+      MessageView view;
+      QuestionView question;
+      if(!view.Parse(*pkt) || !view.FirstQuestion(question))
       {
-        llarp::LogWarn("failed to parse dns header from ", from);
+        llarp::LogWarn("failed to parse dns reply from ", from);
         return;
       }
-      TX tx    = {hdr.id, from};
-      auto itr = m_Forwarded.find(tx);
-      if(itr != m_Forwarded.end())
+      const MessageHeader& hdr = view.Header();
+      Cache::Key key;
       {
-        llarp_buffer_t buf;
-        buf.sz   = pkt->sz;
-        buf.base = pkt->base;
-        buf.cur  = buf.base;
-        // forward reply
-        llarp_ev_udp_sendto(&m_Server, itr->second, buf);
-        // remove pending
+        util::Lock lock(&m_Access);
+        auto itr = m_Forwarded.find(TX{hdr.id, from});
+        if(itr == m_Forwarded.end())
+          return;
+        // a reply to some other question is forged or broken, keep waiting
+        // for the real one
+        if(hdr.qd_count != 1 || !m_LookupKey.Assign(question)
+           || !(m_LookupKey == itr->second))
+        {
+          METRICS_DYNAMIC_INCREMENT("dns.cache", "mismatch");
+          llarp::LogWarn("dropping dns reply for another question from ",
+                         from);
+          return;
+        }
+        key = itr->second;
         m_Forwarded.erase(itr);
       }
+      HandleReply(key, *pkt, true);
     }
 
     void
     Proxy::HandlePktServer(llarp::Addr from, llarp_buffer_t* pkt)
     {
-      MessageHeader hdr;
-      if(!hdr.Decode(pkt))
+      MessageView view;
+      QuestionView question;
+      if(!view.Parse(*pkt) || !view.FirstQuestion(question))
       {
-        llarp::LogWarn("failed to parse dns header from ", from);
+        llarp::LogWarn("failed to parse dns message from ", from);
         return;
       }
-      TX tx    = {hdr.id, from};
-      auto itr = m_Forwarded.find(tx);
-      Message msg(hdr);
-      if(!msg.Decode(pkt))
+      const MessageHeader& hdr = view.Header();
+      if(hdr.qd_count != 1)
       {
-        llarp::LogWarn("failed to parse dns message from ", from);
+        llarp::LogWarn("dropping dns message with ", hdr.qd_count,
+                       " questions from ", from);
         return;
       }
 
-      if(m_QueryHandler && m_QueryHandler->ShouldHookDNSMessage(msg))
+      const llarp_time_t now = llarp_ev_loop_time_now_ms(m_Loop);
+      Cache::Key key;
+      {
+        util::Lock lock(&m_Access);
+        if(!m_LookupKey.Assign(question))
+        {
+          llarp::LogWarn("bad name in dns question from ", from);
+          return;
+        }
+        if(m_Cache.Get(m_LookupKey, hdr.id, now, false, m_SendBuf))
+        {
+          METRICS_DYNAMIC_INCREMENT("dns.cache", "hit");
+          llarp_ev_udp_sendto(&m_Server, from, llarp_buffer_t(m_SendBuf));
+          return;
+        }
+        auto itr = m_Pending.find(m_LookupKey);
+        if(itr != m_Pending.end())
+        {
+          // same question is in flight, share its reply
+          METRICS_DYNAMIC_INCREMENT("dns.cache", "coalesced");
+          itr->second.askers.push_back({from, hdr.id});
+          return;
+        }
+        key = m_LookupKey;
+      }
+
+      // only misses are decoded in full, as the handler takes a message
+      bool hooked = false;
+      Message msg(hdr);
+      if(m_QueryHandler)
       {
-        if(!m_QueryHandler->HandleHookedDNSMessage(
-               std::move(msg),
-               std::bind(&Proxy::SendMessageTo, this, from,
-                         std::placeholders::_1)))
+        pkt->cur = pkt->base + MessageHeader::Size;
+        if(!msg.Decode(pkt))
         {
-          llarp::LogWarn("failed to handle hooked dns");
+          llarp::LogWarn("failed to parse dns message from ", from);
+          return;
         }
+        hooked = m_QueryHandler->ShouldHookDNSMessage(msg);
       }
-      else if(m_Resolvers.size() == 0)
+      if(!hooked && m_Resolvers.size() == 0)
       {
         // no upstream resolvers
         // let's serv fail it
-        msg.AddServFail();
-        SendMessageTo(from, std::move(msg));
+        SendServFail(from, view, hdr.id);
+        return;
       }
-      else if(itr == m_Forwarded.end())
+
       {
-        // new forwarded query
-        tx.from         = PickRandomResolver();
-        m_Forwarded[tx] = from;
-        llarp_buffer_t buf;
-        buf.sz   = pkt->sz;
-        buf.base = pkt->base;
-        buf.cur  = buf.base;
-        // do query
-        llarp_ev_udp_sendto(&m_Client, tx.from, buf);
+        util::Lock lock(&m_Access);
+        METRICS_DYNAMIC_INCREMENT("dns.cache", "miss");
+        auto inserted = m_Pending.emplace(key, Pending(*pkt, now));
+        inserted.first->second.askers.push_back({from, hdr.id});
+        if(!inserted.second)
+          return;
+        if(!hooked)
+        {
+          // new forwarded query, sent with a txid of our own so replies
+          // can be matched to the question
+          Pending& pending = inserted.first->second;
+          TX tx            = {0, PickRandomResolver()};
+          do
+          {
+            tx.txid = llarp::randint();
+          } while(m_Forwarded.count(tx));
+          pending.forwarded = true;
+          pending.upstream  = tx;
+          m_Forwarded.emplace(tx, key);
+          htobe16buf(pending.query.data(), tx.txid);
+          // do query
+          llarp_ev_udp_sendto(&m_Client, tx.from,
+                              llarp_buffer_t(pending.query));
+          htobe16buf(pending.query.data(), hdr.id);
+          return;
+        }
       }
-      else
+
+      // the handler may reply before returning, so no lock is held here
+      auto reply = [this, key](Message msg) {
+        std::array< byte_t, 1500 > tmp = {{0}};
+        llarp_buffer_t buf(tmp);
+        if(!msg.Encode(&buf))
+        {
+          llarp::LogWarn("failed to encode dns message when sending");
+          return;
+        }
+        buf.sz  = buf.cur - buf.base;
+        buf.cur = buf.base;
+        HandleReply(key, buf, false);
+      };
+      if(!m_QueryHandler->HandleHookedDNSMessage(std::move(msg), reply))
       {
-        // drop (?)
+        llarp::LogWarn("failed to handle hooked dns");
+        // fails whoever asked the same question meanwhile too
+        util::Lock lock(&m_Access);
+        FailPending(key, now);
       }
     }
 
@@ -1,12 +1,18 @@
 #ifndef LLARP_DNS_SERVER_HPP
 #define LLARP_DNS_SERVER_HPP
 
+#include <dns/cache.hpp>
 #include <dns/message.hpp>
+#include <dns/view.hpp>
 #include <ev/ev.h>
 #include <net/net.hpp>
 #include <util/string_view.hpp>
+#include <util/threading.hpp>
+
+#include <absl/base/thread_annotations.h>
 
 #include <unordered_map>
+#include <vector>
 
 namespace llarp
 {
@@ -27,8 +33,18 @@ namespace llarp
                              std::function< void(Message) > sendReply) = 0;
     };
 
+    /// dns server forwarding to upstream resolvers or a query handler.
+    /// upstream replies are cached, identical questions asked while one is
+    /// in flight share its reply, and cached replies are served stale when
+    /// upstream does not answer in time. what the handler answers is never
+    /// cached, its names map to addresses that come and go.
     struct Proxy
     {
+      /// how long upstream gets to reply before we serve stale or fail
+      static constexpr llarp_time_t UpstreamTimeout = 5000;
+      /// the handler may need to build paths before it can reply
+      static constexpr llarp_time_t HookedTimeout = 30000;
+
       Proxy(llarp_ev_loop_ptr loop, IQueryHandler* handler);
 
       bool
@@ -60,8 +76,21 @@ namespace llarp
       void
       HandlePktServer(llarp::Addr from, llarp_buffer_t* buf);
 
+      /// send a reply to everyone waiting for the answer to key, caching it
+      /// if it came from upstream
       void
-      SendMessageTo(llarp::Addr to, Message msg);
+      HandleReply(const Cache::Key& key, const llarp_buffer_t& reply,
+                  bool upstream) LOCKS_EXCLUDED(m_Access);
+
+      /// send a server failure in reply to query
+      void
+      SendServFail(llarp::Addr to, const MessageView& query, MsgID_t id);
+
+      /// answer everyone waiting on key with a failure, or from the cache
+      /// when upstream was asked
+      void
+      FailPending(const Cache::Key& key, llarp_time_t now)
+          EXCLUSIVE_LOCKS_REQUIRED(m_Access);
 
       llarp::Addr
       PickRandomResolver() const;
@@ -94,8 +123,41 @@ namespace llarp
         };
       };
 
-      // maps tx to who to send reply to
-      std::unordered_map< TX, llarp::Addr, TX::Hash > m_Forwarded;
+      /// who asked a question we are resolving
+      struct Asker
+      {
+        llarp::Addr from;
+        MsgID_t txid;
+      };
+
+      /// a question being resolved
+      struct Pending
+      {
+        Pending(const llarp_buffer_t& q, llarp_time_t now)
+            : query(q.base, q.base + q.sz), sent(now)
+        {
+        }
+
+        /// as it arrived, to fail it without decoding it
+        std::vector< byte_t > query;
+        llarp_time_t sent;
+        std::vector< Asker > askers;
+        /// false if the handler is resolving it
+        bool forwarded = false;
+        TX upstream    = {0, {}};
+      };
+
+      util::Mutex m_Access;  // protects m_Cache, m_Pending, m_Forwarded
+      Cache m_Cache GUARDED_BY(m_Access);
+      std::unordered_map< Cache::Key, Pending, Cache::Key::Hash > m_Pending
+          GUARDED_BY(m_Access);
+      // maps tx sent upstream to the question it asks
+      std::unordered_map< TX, Cache::Key, TX::Hash > m_Forwarded
+          GUARDED_BY(m_Access);
+      // reused for every lookup and reply so answering from the cache
+      // does not allocate
+      Cache::Key m_LookupKey GUARDED_BY(m_Access);
+      std::vector< byte_t > m_SendBuf GUARDED_BY(m_Access);
     };
   }  // namespace dns
 }  // namespace llarp
@@ -0,0 +1,289 @@
+#include <dns/view.hpp>
+
+#include <dns/dns.hpp>
+#include <util/endian.hpp>
+
+#include <cctype>
+#include <cstring>
+
+namespace llarp
+{
+  namespace dns
+  {
+    constexpr size_t NameView::MaxJumps;
+
+    /// move off past the name there without following pointers
+    static bool
+    SkipName(const byte_t* pkt, size_t sz, size_t& off)
+    {
+      while(off < sz)
+      {
+        const byte_t l = pkt[off];
+        if(l == 0)
+        {
+          ++off;
+          return true;
+        }
+        // a pointer ends the name
+        if((l & 0xc0) == 0xc0)
+        {
+          off += 2;
+          return off <= sz;
+        }
+        if(l > 63)
+          return false;
+        off += l + 1;
+      }
+      return false;
+    }
+
+    bool
+    NameView::Equals(string_view name) const
+    {
+      if(name.size() && name[name.size() - 1] == '.')
+        name.remove_suffix(1);
+      size_t pos = 0;
+      bool match = true;
+      const bool valid =
+          ForEachLabel([&](const char* label, size_t len) {
+            if(!match)
+              return;
+            if(pos && (pos >= name.size() || name[pos++] != '.'))
+            {
+              match = false;
+              return;
+            }
+            if(name.size() - pos < len)
+            {
+              match = false;
+              return;
+            }
+            for(size_t idx = 0; idx < len; ++idx)
+            {
+              if(std::tolower((unsigned char)label[idx])
+                 != std::tolower((unsigned char)name[pos + idx]))
+              {
+                match = false;
+                return;
+              }
+            }
+            pos += len;
+          });
+      return valid && match && pos == name.size();
+    }
+
+    bool
+    NameView::ToString(std::string& out) const
+    {
+      out.clear();
+      return ForEachLabel([&](const char* label, size_t len) {
+        for(size_t idx = 0; idx < len; ++idx)
+          out += std::tolower((unsigned char)label[idx]);
+        out += '.';
+      });
+    }
+
+    bool
+    MessageView::Parse(const byte_t* pkt, size_t sz)
+    {
+      if(sz < MessageHeader::Size)
+        return false;
+      m_Pkt             = pkt;
+      m_Size            = sz;
+      m_Header.id       = bufbe16toh(pkt);
+      m_Header.fields   = bufbe16toh(pkt + 2);
+      m_Header.qd_count = bufbe16toh(pkt + 4);
+      m_Header.an_count = bufbe16toh(pkt + 6);
+      m_Header.ns_count = bufbe16toh(pkt + 8);
+      m_Header.ar_count = bufbe16toh(pkt + 10);
+
+      size_t off = MessageHeader::Size;
+      for(size_t idx = 0; idx < m_Header.qd_count; ++idx)
+      {
+        if(!SkipName(pkt, sz, off))
+          return false;
+        off += 4;
+      }
+      if(off > sz)
+        return false;
+      m_Records = off;
+
+      const size_t records = size_t(m_Header.an_count) + m_Header.ns_count
+          + m_Header.ar_count;
+      for(size_t idx = 0; idx < records; ++idx)
+      {
+        if(!SkipName(pkt, sz, off) || off + 10 > sz)
+          return false;
+        off += 10 + bufbe16toh(pkt + off + 8);
+        if(off > sz)
+          return false;
+      }
+      return true;
+    }
+
+    bool
+    MessageView::FirstQuestion(QuestionView& q) const
+    {
+      if(m_Header.qd_count == 0)
+        return false;
+      ReadQuestion(MessageHeader::Size, q);
+      return true;
+    }
+
+    size_t
+    MessageView::ReadQuestion(size_t off, QuestionView& q) const
+    {
+      q.name = NameView{m_Pkt, m_Size, off};
+      SkipName(m_Pkt, m_Size, off);
+      q.qtype  = bufbe16toh(m_Pkt + off);
+      q.qclass = bufbe16toh(m_Pkt + off + 2);
+      return off + 4;
+    }
+
+    size_t
+    MessageView::ReadRecord(size_t off, RecordView& rr) const
+    {
+      rr.name = NameView{m_Pkt, m_Size, off};
+      SkipName(m_Pkt, m_Size, off);
+      rr.type      = bufbe16toh(m_Pkt + off);
+      rr.rclass    = bufbe16toh(m_Pkt + off + 2);
+      rr.ttlOffset = off + 4;
+      rr.ttl       = bufbe32toh(m_Pkt + off + 4);
+      rr.rdlen     = bufbe16toh(m_Pkt + off + 8);
+      rr.rdata     = m_Pkt + off + 10;
+      return off + 10 + rr.rdlen;
+    }
+
+    MessageWriter::MessageWriter(llarp_buffer_t& buf) : m_Buf(buf)
+    {
+      m_Buf.cur = m_Buf.base;
+    }
+
+    bool
+    MessageWriter::PutHeader(MsgID_t id, Fields_t fields)
+    {
+      m_Buf.cur = m_Buf.base;
+      m_Ok      = m_Buf.size_left() >= MessageHeader::Size;
+      if(!m_Ok)
+        return false;
+      htobe16buf(m_Buf.cur, id);
+      htobe16buf(m_Buf.cur + 2, fields);
+      std::memset(m_Buf.cur + 4, 0, MessageHeader::Size - 4);
+      m_Buf.cur += MessageHeader::Size;
+      return true;
+    }
+
+    bool
+    MessageWriter::PutName(string_view name)
+    {
+      if(name.size() && name[name.size() - 1] == '.')
+        name.remove_suffix(1);
+      while(name.size())
+      {
+        const size_t dot = name.find('.');
+        const size_t len = dot == string_view::npos ? name.size() : dot;
+        if(len == 0 || len > 63 || m_Buf.size_left() < len + 1)
+          return false;
+        *m_Buf.cur++ = len;
+        std::memcpy(m_Buf.cur, name.data(), len);
+        m_Buf.cur += len;
+        name.remove_prefix(dot == string_view::npos ? len : len + 1);
+      }
+      if(m_Buf.size_left() < 1)
+        return false;
+      *m_Buf.cur++ = 0;
+      return true;
+    }
+
+    bool
+    MessageWriter::PutQuestion(const QuestionView& q)
+    {
+      if(!m_Ok || m_Answers)
+        return m_Ok = false;
+      bool fits = true;
+      m_Ok      = q.name.ForEachLabel([&](const char* label, size_t len) {
+        if(!fits || m_Buf.size_left() < len + 1)
+        {
+          fits = false;
+          return;
+        }
+        *m_Buf.cur++ = len;
+        std::memcpy(m_Buf.cur, label, len);
+        m_Buf.cur += len;
+      });
+      m_Ok = m_Ok && fits && m_Buf.size_left() >= 5;
+      if(!m_Ok)
+        return false;
+      *m_Buf.cur++ = 0;
+      htobe16buf(m_Buf.cur, q.qtype);
+      htobe16buf(m_Buf.cur + 2, q.qclass);
+      m_Buf.cur += 4;
+      ++m_Questions;
+      return true;
+    }
+
+    bool
+    MessageWriter::PutQuestion(string_view name, QType_t qtype,
+                               QClass_t qclass)
+    {
+      if(!m_Ok || m_Answers)
+        return m_Ok = false;
+      m_Ok = PutName(name) && m_Buf.size_left() >= 4;
+      if(!m_Ok)
+        return false;
+      htobe16buf(m_Buf.cur, qtype);
+      htobe16buf(m_Buf.cur + 2, qclass);
+      m_Buf.cur += 4;
+      ++m_Questions;
+      return true;
+    }
+
+    bool
+    MessageWriter::PutAnswer(RRType_t type, RR_TTL_t ttl, const byte_t* rdata,
+                             uint16_t rdlen)
+    {
+      m_Ok = m_Ok && m_Questions && m_Buf.size_left() >= 12 + size_t(rdlen);
+      if(!m_Ok)
+        return false;
+      // the first question always starts right after the header
+      htobe16buf(m_Buf.cur, 0xc000 | MessageHeader::Size);
+      htobe16buf(m_Buf.cur + 2, type);
+      htobe16buf(m_Buf.cur + 4, qClassIN);
+      htobe32buf(m_Buf.cur + 6, ttl);
+      htobe16buf(m_Buf.cur + 10, rdlen);
+      if(rdlen)
+        std::memcpy(m_Buf.cur + 12, rdata, rdlen);
+      m_Buf.cur += 12 + rdlen;
+      ++m_Answers;
+      return true;
+    }
+
+    bool
+    MessageWriter::Finish()
+    {
+      if(!m_Ok)
+        return false;
+      htobe16buf(m_Buf.base + 4, m_Questions);
+      htobe16buf(m_Buf.base + 6, m_Answers);
+      m_Buf.sz  = m_Buf.cur - m_Buf.base;
+      m_Buf.cur = m_Buf.base;
+      return true;
+    }
+
+    bool
+    WriteServFail(const MessageView& query, MsgID_t id, llarp_buffer_t& buf)
+    {
+      // authorative response with recursion available, but don't allow
+      // recursion on this request
+      Fields_t fields = query.Header().fields;
+      fields |= flags_RCODEServFail | flags_QR | flags_AA | flags_RA;
+      fields &= ~flags_RD;
+      MessageWriter writer(buf);
+      writer.PutHeader(id, fields);
+      QuestionView q;
+      if(query.FirstQuestion(q))
+        writer.PutQuestion(q);
+      return writer.Finish();
+    }
+  }  // namespace dns
+}  // namespace llarp
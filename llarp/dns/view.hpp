@@ -0,0 +1,198 @@
+#ifndef LLARP_DNS_VIEW_HPP
+#define LLARP_DNS_VIEW_HPP
+
+#include <dns/message.hpp>
+#include <util/buffer.hpp>
+#include <util/string_view.hpp>
+
+#include <string>
+
+namespace llarp
+{
+  namespace dns
+  {
+    /// a name inside a packet. compression pointers are only followed when
+    /// the labels are read, and nothing is copied out of the packet.
+    struct NameView
+    {
+      /// most pointers followed before a name is considered a loop
+      static constexpr size_t MaxJumps = 16;
+
+      const byte_t* pkt = nullptr;
+      size_t sz         = 0;
+      size_t off        = 0;
+
+      /// call visit(label, len) for every label in order, false if the
+      /// name is malformed or loops
+      template < typename Visit >
+      bool
+      ForEachLabel(Visit visit) const
+      {
+        size_t pos   = off;
+        size_t jumps = 0;
+        size_t total = 0;
+        while(pos < sz)
+        {
+          const byte_t l = pkt[pos];
+          if(l == 0)
+            return true;
+          if((l & 0xc0) == 0xc0)
+          {
+            if(pos + 2 > sz || ++jumps > MaxJumps)
+              return false;
+            pos = ((l & 0x3f) << 8) | pkt[pos + 1];
+            continue;
+          }
+          total += l + 1;
+          if(l > 63 || pos + 1 + l > sz || total > 255)
+            return false;
+          visit(reinterpret_cast< const char* >(pkt + pos + 1), size_t(l));
+          pos += l + 1;
+        }
+        return false;
+      }
+
+      /// case insensitive compare against a dotted name, the trailing dot
+      /// is optional
+      bool
+      Equals(string_view name) const;
+
+      /// lowercased dotted name with a trailing dot, reusing the storage
+      /// of out
+      bool
+      ToString(std::string& out) const;
+    };
+
+    struct QuestionView
+    {
+      NameView name;
+      QType_t qtype;
+      QClass_t qclass;
+    };
+
+    struct RecordView
+    {
+      NameView name;
+      RRType_t type;
+      RRClass_t rclass;
+      RR_TTL_t ttl;
+      /// where the ttl sits in the packet, to rewrite it in place
+      size_t ttlOffset;
+      const byte_t* rdata;
+      uint16_t rdlen;
+    };
+
+    /// a dns message parsed in place over the buffer it arrived in. the
+    /// buffer must outlive the view.
+    class MessageView
+    {
+     public:
+      /// check the header and the bounds of every question and record,
+      /// false if pkt is not a well formed message
+      bool
+      Parse(const byte_t* pkt, size_t sz);
+
+      bool
+      Parse(const llarp_buffer_t& buf)
+      {
+        return Parse(buf.base, buf.sz);
+      }
+
+      const MessageHeader&
+      Header() const
+      {
+        return m_Header;
+      }
+
+      /// the first question, false if there are none
+      bool
+      FirstQuestion(QuestionView& q) const;
+
+      template < typename Visit >
+      void
+      ForEachQuestion(Visit visit) const
+      {
+        size_t off = MessageHeader::Size;
+        for(size_t idx = 0; idx < m_Header.qd_count; ++idx)
+        {
+          QuestionView q;
+          off = ReadQuestion(off, q);
+          visit(q);
+        }
+      }
+
+      /// visit every answer, authority and additional record
+      template < typename Visit >
+      void
+      ForEachRecord(Visit visit) const
+      {
+        const size_t records = size_t(m_Header.an_count) + m_Header.ns_count
+            + m_Header.ar_count;
+        size_t off = m_Records;
+        for(size_t idx = 0; idx < records; ++idx)
+        {
+          RecordView rr;
+          off = ReadRecord(off, rr);
+          visit(rr);
+        }
+      }
+
+     private:
+      /// these trust bounds already checked by Parse
+      size_t
+      ReadQuestion(size_t off, QuestionView& q) const;
+
+      size_t
+      ReadRecord(size_t off, RecordView& rr) const;
+
+      const byte_t* m_Pkt = nullptr;
+      size_t m_Size       = 0;
+      MessageHeader m_Header;
+      /// where the first record starts
+      size_t m_Records = 0;
+    };
+
+    /// writes a dns message straight into a preallocated send buffer.
+    /// names are written uncompressed except for records about the first
+    /// question, which point back at it. counts are filled in by Finish.
+    class MessageWriter
+    {
+     public:
+      explicit MessageWriter(llarp_buffer_t& buf);
+
+      bool
+      PutHeader(MsgID_t id, Fields_t fields);
+
+      bool
+      PutQuestion(const QuestionView& q);
+
+      bool
+      PutQuestion(string_view name, QType_t qtype, QClass_t qclass);
+
+      /// an answer about the first question
+      bool
+      PutAnswer(RRType_t type, RR_TTL_t ttl, const byte_t* rdata,
+                uint16_t rdlen);
+
+      /// write the counts and set the buffer size to the message, false if
+      /// anything before did not fit
+      bool
+      Finish();
+
+     private:
+      bool
+      PutName(string_view name);
+
+      llarp_buffer_t& m_Buf;
+      bool m_Ok           = true;
+      Count_t m_Questions = 0;
+      Count_t m_Answers   = 0;
+    };
+
+    /// write a server failure in reply to query with the given id into buf
+    bool
+    WriteServFail(const MessageView& query, MsgID_t id, llarp_buffer_t& buf);
+  }  // namespace dns
+}  // namespace llarp
+
+#endif
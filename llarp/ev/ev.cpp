@@ -4,6 +4,7 @@
 #include <util/string_view.hpp>
 
 #include <stddef.h>
+#include <string.h>
 
 // apparently current Solaris will emulate epoll.
 #if __linux__ || SOLARIS_HAVE_EPOLL
@@ -71,6 +72,16 @@ llarp_ev_add_udp(struct llarp_ev_loop *ev, struct llarp_udp_io *udp,
   return -1;
 }
 
+int
+llarp_ev_add_udp_shard(struct llarp_ev_loop *ev, struct llarp_udp_io *udp,
+                       const struct sockaddr *src, size_t idx, size_t num)
+{
+  udp->parent = ev;
+  if(ev->udp_listen_shard(udp, src, idx, num))
+    return 0;
+  return -1;
+}
+
 int
 llarp_ev_close_udp(struct llarp_udp_io *udp)
 {
@@ -93,6 +104,19 @@ llarp_ev_loop_stop(struct llarp_ev_loop *loop)
   loop->stop();
 }
 
+size_t
+llarp_ev_loop_set_udp_batch(struct llarp_ev_loop *loop, size_t n)
+{
+  loop->udp_batch_size = std::max(size_t(1), std::min(n, EV_UDP_MAX_BATCH));
+  return loop->udp_batch_size;
+}
+
+void
+llarp_ev_udp_flush(struct llarp_udp_io *udp)
+{
+  static_cast< llarp::ev_io * >(udp->impl)->flush_write();
+}
+
 int
 llarp_ev_udp_sendto(struct llarp_udp_io *udp, const sockaddr *to,
                     const llarp_buffer_t &buf)
@@ -203,12 +227,18 @@ llarp_ev_add_tun(llarp_ev_loop *loop, llarp_tun_io *tun)
 bool
 llarp_ev_tun_async_write(struct llarp_tun_io *tun, const llarp_buffer_t &buf)
 {
-  if(buf.sz > EV_WRITE_BUF_SZ)
+  if(buf.sz > EV_TUN_MAX_MTU)
   {
-    llarp::LogWarn("packet too big, ", buf.sz, " > ", EV_WRITE_BUF_SZ);
+    llarp::LogWarn("packet too big, ", buf.sz, " > ", EV_TUN_MAX_MTU);
     return false;
   }
+#if __linux__ || SOLARIS_HAVE_EPOLL
+  // spread over the queues of a multi queue interface
+  return static_cast< llarp::tun * >(tun->impl)->write_packet(buf.base,
+                                                               buf.sz);
+#else
   return static_cast< llarp::tun * >(tun->impl)->queue_write(buf.base, buf.sz);
+#endif
 }
 #else
 bool
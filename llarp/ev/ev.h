@@ -64,6 +64,12 @@ llarp_ev_loop_time_now_ms(const llarp_ev_loop_ptr &ev);
 void
 llarp_ev_loop_stop(struct llarp_ev_loop *ev);
 
+/// set how many datagrams are read or written per syscall on udp sockets,
+/// outbound datagrams are then queued and flushed once per tick
+/// 1 disables batching, returns the batch size that is now in use
+size_t
+llarp_ev_loop_set_udp_batch(struct llarp_ev_loop *ev, size_t n);
+
 /// UDP handling configuration
 struct llarp_udp_io
 {
@@ -85,11 +91,25 @@ int
 llarp_ev_add_udp(struct llarp_ev_loop *ev, struct llarp_udp_io *udp,
                  const struct sockaddr *src);
 
+/// add UDP handler as member idx of a SO_REUSEPORT group of num sockets all
+/// bound to src, inbound datagrams are steered by source address so that
+/// each remote always lands on the same member
+/// members must be added in order starting at 0
+/// returns -1 if the platform can't do this
+int
+llarp_ev_add_udp_shard(struct llarp_ev_loop *ev, struct llarp_udp_io *udp,
+                       const struct sockaddr *src, size_t idx, size_t num);
+
 /// send a UDP packet
 int
 llarp_ev_udp_sendto(struct llarp_udp_io *udp, const struct sockaddr *to,
                     const llarp_buffer_t &pkt);
 
+/// send every UDP packet still queued for batching now, call before writing
+/// to the socket directly so nothing overtakes them
+void
+llarp_ev_udp_flush(struct llarp_udp_io *udp);
+
 /// close UDP handler
 int
 llarp_ev_close_udp(struct llarp_udp_io *udp);
@@ -204,6 +224,13 @@ struct llarp_tun_io
   /// called every event loop tick after reads
   void (*tick)(struct llarp_tun_io *);
   void (*recvpkt)(struct llarp_tun_io *, const llarp_buffer_t &);
+  /// number of queues to open the interface with, linux only. every queue
+  /// past the first is read and written on a thread of its own, so recvpkt
+  /// must be thread safe when this is more than 1
+  int queues;
+  /// mtu to set on the interface, 0 leaves the system default. at most
+  /// EV_TUN_MAX_MTU, not supported on windows
+  int mtu;
 };
 
 /// create tun interface with network interface name ifname
@@ -4,6 +4,7 @@
 #include <ev/ev.h>
 #include <util/buffer.hpp>
 #include <util/codel.hpp>
+#include <util/packet_buffer.hpp>
 #include <util/threading.hpp>
 
 // writev
@@ -49,6 +50,18 @@ typedef struct sockaddr_un
 #ifndef EV_WRITE_BUF_SZ
 #define EV_WRITE_BUF_SZ (2 * 1024UL)
 #endif
+/// biggest packet a tun interface can be set up to carry, one read buffer
+/// on posix where writes are pooled, a write buffer on windows
+#ifndef EV_TUN_MAX_MTU
+#ifdef _WIN32
+#define EV_TUN_MAX_MTU EV_WRITE_BUF_SZ
+#else
+#define EV_TUN_MAX_MTU EV_READ_BUF_SZ
+#endif
+#endif
+#ifndef EV_UDP_MAX_BATCH
+#define EV_UDP_MAX_BATCH (256UL)
+#endif
 
 /// do io and reset errno after
 static ssize_t
@@ -274,23 +287,20 @@ namespace llarp
 #else
   struct posix_ev_io
   {
+    /// a queued write held in a pooled block, so a write queue only costs
+    /// a handle per slot and a tun can write packets bigger than
+    /// EV_WRITE_BUF_SZ
     struct WriteBuffer
     {
       llarp_time_t timestamp = 0;
-      size_t bufsz;
-      byte_t buf[EV_WRITE_BUF_SZ];
+      /// empty if the write was too big for a block
+      PacketBuffer data;
 
       WriteBuffer() = default;
 
       WriteBuffer(const byte_t* ptr, size_t sz)
+          : data(PacketBuffer::Copy(llarp_buffer_t(ptr, sz)))
       {
-        if(sz <= sizeof(buf))
-        {
-          bufsz = sz;
-          memcpy(buf, ptr, bufsz);
-        }
-        else
-          bufsz = 0;
       }
 
       struct GetTime
@@ -435,7 +445,7 @@ namespace llarp
       if(m_LossyWriteQueue)
       {
         m_LossyWriteQueue->Process([&](WriteBuffer& buffer) {
-          do_write(buffer.buf, buffer.bufsz);
+          do_write(buffer.data.data(), buffer.data.size());
           // if we would block we save the entries for later
           // discard entry
         });
@@ -447,14 +457,15 @@ namespace llarp
           while(amount && m_BlockingWriteQueue->size())
           {
             auto& itr      = m_BlockingWriteQueue->front();
-            ssize_t result = do_write(itr.buf, std::min(amount, itr.bufsz));
+            ssize_t result = do_write(itr.data.data(),
+                                      std::min(amount, itr.data.size()));
             if(result <= 0)
               return;
-            ssize_t dlt = itr.bufsz - result;
+            ssize_t dlt = itr.data.size() - result;
             if(dlt > 0)
             {
               // queue remaining to front of queue
-              WriteBuffer buff(itr.buf + dlt, itr.bufsz - dlt);
+              WriteBuffer buff(itr.data.data() + dlt, itr.data.size() - dlt);
               m_BlockingWriteQueue->pop_front();
               m_BlockingWriteQueue->push_front(buff);
               // TODO: errno?
@@ -470,17 +481,17 @@ namespace llarp
           while(m_BlockingWriteQueue->size())
           {
             auto& itr      = m_BlockingWriteQueue->front();
-            ssize_t result = do_write(itr.buf, itr.bufsz);
+            ssize_t result = do_write(itr.data.data(), itr.data.size());
             if(result <= 0)
             {
               errno = 0;
               return;
             }
-            ssize_t dlt = itr.bufsz - result;
+            ssize_t dlt = itr.data.size() - result;
             if(dlt > 0)
             {
               // queue remaining to front of queue
-              WriteBuffer buff(itr.buf + dlt, itr.bufsz - dlt);
+              WriteBuffer buff(itr.data.data() + dlt, itr.data.size() - dlt);
               m_BlockingWriteQueue->pop_front();
               m_BlockingWriteQueue->push_front(buff);
               // TODO: errno?
@@ -702,6 +713,27 @@ struct llarp_ev_loop
   byte_t readbuf[EV_READ_BUF_SZ] = {0};
   llarp_time_t _now              = 0;
 
+  /// max datagrams drained or flushed per syscall on udp sockets
+  /// 1 means one recvfrom/sendto per datagram (no batching)
+  size_t udp_batch_size = 1;
+
+  /// udp counters for the current tick, reset at the start of every tick
+  struct udp_tick_stats
+  {
+    /// recvmmsg/recvfrom calls made
+    size_t recv_calls = 0;
+    /// datagrams read
+    size_t recv_pkts = 0;
+    /// sendmmsg/sendto calls made
+    size_t send_calls = 0;
+    /// datagrams written
+    size_t send_pkts = 0;
+    /// queued datagrams sendmmsg failed on or that did not fit the socket
+    size_t send_drops = 0;
+  };
+
+  udp_tick_stats udp_stats;
+
   virtual bool
   init() = 0;
 
@@ -736,6 +768,14 @@ struct llarp_ev_loop
   virtual bool
   udp_listen(llarp_udp_io* l, const sockaddr* src) = 0;
 
+  /// listen as member idx of a SO_REUSEPORT group of num sockets
+  /// return false if not supported
+  virtual bool
+  udp_listen_shard(llarp_udp_io*, const sockaddr*, size_t, size_t)
+  {
+    return false;
+  }
+
   virtual llarp::ev_io*
   create_udp(llarp_udp_io* l, const sockaddr* src) = 0;
 
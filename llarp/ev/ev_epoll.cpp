@@ -1,4 +1,12 @@
 #include <ev/ev_epoll.hpp>
+#include <util/metrics.hpp>
+
+#include <array>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#endif
 
 namespace llarp
 {
@@ -101,12 +109,29 @@ namespace llarp
   {
     if(udp->tick)
       udp->tick(udp);
+    // send everything queued during this tick
+    flush_write();
     return true;
   }
 
+  size_t
+  udp_listener::batch_size() const
+  {
+#ifdef LLARP_HAVE_MMSG
+    if(udp->parent)
+      return udp->parent->udp_batch_size;
+#endif
+    return 1;
+  }
+
   int
   udp_listener::read(byte_t* buf, size_t sz)
   {
+#ifdef LLARP_HAVE_MMSG
+    const size_t n = batch_size();
+    if(n > 1)
+      return read_batch(n);
+#endif
     llarp_buffer_t b;
     b.base = buf;
     b.cur  = b.base;
@@ -114,6 +139,8 @@ namespace llarp
     socklen_t slen = sizeof(sockaddr_in6);
     sockaddr* addr = (sockaddr*)&src;
     ssize_t ret    = ::recvfrom(fd, b.base, sz, 0, addr, &slen);
+    if(udp->parent)
+      udp->parent->udp_stats.recv_calls++;
     if(ret < 0)
     {
       errno = 0;
@@ -121,6 +148,8 @@ namespace llarp
     }
     if(static_cast< size_t >(ret) > sz)
       return -1;
+    if(udp->parent)
+      udp->parent->udp_stats.recv_pkts++;
     b.sz = ret;
     udp->recvfrom(udp, addr, ManagedBuffer{b});
     return ret;
@@ -128,6 +157,39 @@ namespace llarp
 
   int
   udp_listener::sendto(const sockaddr* to, const void* data, size_t sz)
+  {
+#ifdef LLARP_HAVE_MMSG
+    const size_t n = batch_size();
+    if(n > 1 && sz <= EV_WRITE_BUF_SZ
+       && (to->sa_family == AF_INET || to->sa_family == AF_INET6))
+    {
+      ensure_batch(n);
+      if(m_SendQueued >= n)
+        flush_write();
+      const size_t idx = m_SendQueued++;
+      byte_t* slot     = &m_SendBufs[idx * EV_WRITE_BUF_SZ];
+      memcpy(slot, data, sz);
+      const socklen_t slen =
+          to->sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+      memcpy(&m_SendAddrs[idx], to, slen);
+      m_SendIOV[idx].iov_base = slot;
+      m_SendIOV[idx].iov_len  = sz;
+      auto& hdr               = m_SendHdrs[idx];
+      hdr                     = mmsghdr{};
+      hdr.msg_hdr.msg_name    = &m_SendAddrs[idx];
+      hdr.msg_hdr.msg_namelen = slen;
+      hdr.msg_hdr.msg_iov     = &m_SendIOV[idx];
+      hdr.msg_hdr.msg_iovlen  = 1;
+      return sz;
+    }
+    // flush what we have queued so we don't reorder datagrams
+    flush_write();
+#endif
+    return sendto_now(to, data, sz);
+  }
+
+  int
+  udp_listener::sendto_now(const sockaddr* to, const void* data, size_t sz)
   {
     socklen_t slen;
     switch(to->sa_family)
@@ -142,6 +204,12 @@ namespace llarp
         return -1;
     }
     ssize_t sent = ::sendto(fd, data, sz, SOCK_NONBLOCK, to, slen);
+    if(udp->parent)
+    {
+      udp->parent->udp_stats.send_calls++;
+      if(sent != -1)
+        udp->parent->udp_stats.send_pkts++;
+    }
     if(sent == -1)
     {
       llarp::LogWarn(strerror(errno));
@@ -149,6 +217,254 @@ namespace llarp
     return sent;
   }
 
+  void
+  udp_listener::flush_write()
+  {
+#ifdef LLARP_HAVE_MMSG
+    size_t idx = 0;
+    while(idx < m_SendQueued)
+    {
+      int sent = ::sendmmsg(fd, m_SendHdrs.data() + idx, m_SendQueued - idx,
+                            MSG_DONTWAIT);
+      if(udp->parent)
+        udp->parent->udp_stats.send_calls++;
+      if(sent <= 0)
+      {
+        if(errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          llarp::LogWarn("sendmmsg failed: ", strerror(errno));
+          // skip the datagram that failed so the rest still go out
+          if(udp->parent)
+            udp->parent->udp_stats.send_drops++;
+          ++idx;
+          errno = 0;
+          continue;
+        }
+        // socket is full, drop the rest like sendto would
+        llarp::LogDebug("dropping ", m_SendQueued - idx,
+                        " udp datagrams, send buffer full");
+        if(udp->parent)
+          udp->parent->udp_stats.send_drops += m_SendQueued - idx;
+        errno = 0;
+        break;
+      }
+      if(udp->parent)
+        udp->parent->udp_stats.send_pkts += sent;
+      idx += sent;
+    }
+    m_SendQueued = 0;
+#endif
+  }
+
+#ifdef LLARP_HAVE_MMSG
+  void
+  udp_listener::ensure_batch(size_t n)
+  {
+    if(m_RecvHdrs.size() >= n)
+      return;
+    // flush before we move the send ring around
+    flush_write();
+    m_RecvBufs.resize(n * EV_READ_BUF_SZ);
+    m_RecvAddrs.resize(n);
+    m_RecvIOV.resize(n);
+    m_RecvHdrs.resize(n);
+    m_SendBufs.resize(n * EV_WRITE_BUF_SZ);
+    m_SendAddrs.resize(n);
+    m_SendIOV.resize(n);
+    m_SendHdrs.resize(n);
+  }
+
+  int
+  udp_listener::read_batch(size_t n)
+  {
+    ensure_batch(n);
+    for(size_t idx = 0; idx < n; ++idx)
+    {
+      m_RecvIOV[idx].iov_base = &m_RecvBufs[idx * EV_READ_BUF_SZ];
+      m_RecvIOV[idx].iov_len  = EV_READ_BUF_SZ;
+      auto& hdr               = m_RecvHdrs[idx];
+      hdr                     = mmsghdr{};
+      hdr.msg_hdr.msg_name    = &m_RecvAddrs[idx];
+      hdr.msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+      hdr.msg_hdr.msg_iov     = &m_RecvIOV[idx];
+      hdr.msg_hdr.msg_iovlen  = 1;
+    }
+    int got = ::recvmmsg(fd, m_RecvHdrs.data(), n, MSG_DONTWAIT, nullptr);
+    if(udp->parent)
+      udp->parent->udp_stats.recv_calls++;
+    if(got <= 0)
+    {
+      errno = 0;
+      return -1;
+    }
+    if(udp->parent)
+      udp->parent->udp_stats.recv_pkts += got;
+    int total = 0;
+    for(int idx = 0; idx < got; ++idx)
+    {
+      const auto& hdr = m_RecvHdrs[idx];
+      // truncated datagrams are bogus
+      if(hdr.msg_hdr.msg_flags & MSG_TRUNC)
+        continue;
+      llarp_buffer_t b(&m_RecvBufs[idx * EV_READ_BUF_SZ], hdr.msg_len);
+      udp->recvfrom(udp, (const sockaddr*)&m_RecvAddrs[idx], ManagedBuffer{b});
+      total += hdr.msg_len;
+    }
+    return total;
+  }
+#endif
+
+#ifdef __linux__
+  constexpr size_t tun_queue::MaxWrites;
+  constexpr size_t tun_queue::MaxReads;
+
+  tun_queue::tun_queue(llarp_tun_io* tio, int queuefd)
+      : t(tio)
+      , fd(queuefd)
+      , wakefd(::eventfd(0, EFD_NONBLOCK))
+      , running(false)
+      , sleeping(false)
+      , writes(MaxWrites)
+  {
+  }
+
+  tun_queue::~tun_queue()
+  {
+    stop();
+    if(wakefd != -1)
+      ::close(wakefd);
+    ::close(fd);
+  }
+
+  bool
+  tun_queue::start()
+  {
+    if(wakefd == -1)
+      return false;
+    int flags = fcntl(fd, F_GETFL, 0);
+    if(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+      return false;
+    running.store(true);
+    worker = std::thread(&tun_queue::run, this);
+    return true;
+  }
+
+  void
+  tun_queue::stop()
+  {
+    if(!running.exchange(false))
+      return;
+    wakeup();
+    worker.join();
+  }
+
+  bool
+  tun_queue::queue_write(const byte_t* buf, size_t sz)
+  {
+    PacketBuffer pkt = PacketBuffer::Copy(llarp_buffer_t(buf, sz));
+    if(pkt.IsEmpty()
+       || writes.tryPushBack(std::move(pkt)) != thread::QueueReturn::Success)
+      return false;
+    // only pay for the syscall when the thread is parked in poll
+    if(sleeping.exchange(false))
+      wakeup();
+    return true;
+  }
+
+  void
+  tun_queue::wakeup()
+  {
+    const uint64_t one = 1;
+    // only fails if the counter is already set, which wakes it just as well
+    ssize_t ret = ::write(wakefd, &one, sizeof(one));
+    (void)ret;
+  }
+
+  void
+  tun_queue::run()
+  {
+    std::array< byte_t, EV_READ_BUF_SZ > buf;
+    pollfd fds[2];
+    fds[0].fd     = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = wakefd;
+    fds[1].events = POLLIN;
+    while(running.load())
+    {
+      sleeping.store(true);
+      // anything queued before sleeping was set would not wake us
+      if(writes.empty())
+      {
+        if(::poll(fds, 2, -1) == -1 && errno != EINTR)
+        {
+          llarp::LogError(t->ifname, " tun queue poll failed: ",
+                          strerror(errno));
+          break;
+        }
+        if(fds[1].revents & POLLIN)
+        {
+          uint64_t count;
+          ssize_t ret = ::read(wakefd, &count, sizeof(count));
+          (void)ret;
+        }
+      }
+      sleeping.store(false);
+      for(size_t idx = 0; idx < MaxWrites; ++idx)
+      {
+        auto pkt = writes.tryPopFront();
+        if(!pkt)
+          break;
+        if(::write(fd, pkt->data(), pkt->size()) == -1 && errno != EAGAIN)
+          llarp::LogWarn(t->ifname, " tun queue write failed: ",
+                         strerror(errno));
+      }
+      for(size_t idx = 0; idx < MaxReads; ++idx)
+      {
+        const ssize_t ret = ::read(fd, buf.data(), buf.size());
+        if(ret <= 0)
+          break;
+        t->recvpkt(t, llarp_buffer_t(buf.data(), ret));
+      }
+    }
+  }
+
+  bool
+  tun::setup_queues()
+  {
+    for(int idx = 1; idx < t->queues; ++idx)
+    {
+      const int queuefd = tuntap_open_queue(tunif);
+      std::unique_ptr< tun_queue > queue;
+      if(queuefd != -1)
+        queue.reset(new tun_queue(t, queuefd));
+      if(!queue || !queue->start())
+      {
+        // fewer queues still work, just with less parallelism
+        llarp::LogWarn(t->ifname, " has only ", idx, " of ", t->queues,
+                       " queues: ", strerror(errno));
+        break;
+      }
+      queues.emplace_back(std::move(queue));
+    }
+    return true;
+  }
+#endif
+
+  bool
+  tun::write_packet(const byte_t* buf, size_t sz)
+  {
+#ifdef __linux__
+    if(!queues.empty())
+    {
+      // keep every flow on one queue so its packets stay in order
+      const size_t idx = net::FlowHash(buf, sz) % (queues.size() + 1);
+      if(idx)
+        return queues[idx - 1]->queue_write(buf, sz);
+    }
+#endif
+    return queue_write(buf, sz);
+  }
+
   int
   tun::sendto(__attribute__((unused)) const sockaddr* to,
               __attribute__((unused)) const void* data,
@@ -225,7 +541,12 @@ namespace llarp
     }
     llarp::LogDebug("set ifname to ", t->ifname);
     strncpy(tunif->if_name, t->ifname, sizeof(tunif->if_name));
-    if(tuntap_start(tunif, TUNTAP_MODE_TUNNEL, 0) == -1)
+    int mode = TUNTAP_MODE_TUNNEL;
+#ifdef __linux__
+    if(t->queues > 1 && t->get_fd_promise == nullptr)
+      mode |= TUNTAP_MODE_MULTIQUEUE;
+#endif
+    if(tuntap_start(tunif, mode, 0) == -1)
     {
       llarp::LogWarn("failed to start interface");
       return false;
@@ -242,6 +563,11 @@ namespace llarp
         llarp::LogWarn("failed to set ip");
         return false;
       }
+      if(t->mtu && tuntap_set_mtu(tunif, t->mtu) == -1)
+      {
+        llarp::LogWarn("failed to set mtu to ", t->mtu);
+        return false;
+      }
     }
     fd = tunif->tun_fd;
     if(fd == -1)
@@ -250,7 +576,13 @@ namespace llarp
     int flags = fcntl(fd, F_GETFL, 0);
     if(flags == -1)
       return false;
-    return fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+    if(fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+      return false;
+#ifdef __linux__
+    if(mode & TUNTAP_MODE_MULTIQUEUE)
+      return setup_queues();
+#endif
+    return true;
   }
 
 };  // namespace llarp
@@ -315,7 +647,86 @@ llarp_epoll_loop::udp_listen(llarp_udp_io* l, const sockaddr* src)
   auto ev = create_udp(l, src);
   if(ev)
     l->fd = ev->fd;
-  return ev && add_ev(ev, false);
+  if(!(ev && add_ev(ev, false)))
+    return false;
+  udp_listeners.emplace_back(static_cast< llarp::udp_listener* >(ev));
+  return true;
+}
+
+bool
+llarp_epoll_loop::udp_listen_shard(llarp_udp_io* l, const sockaddr* src,
+                                   size_t idx, size_t num)
+{
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  int fd = udp_bind(src, true);
+  if(fd == -1)
+    return false;
+  // the program applies to the whole group, attach it once on the first
+  // member
+  if(idx == 0 && !udp_attach_steering(fd, num))
+  {
+    ::close(fd);
+    return false;
+  }
+  llarp::ev_io* ev = new llarp::udp_listener(fd, l);
+  l->impl          = ev;
+  l->fd            = fd;
+  if(!add_ev(ev, false))
+  {
+    l->impl = nullptr;
+    return false;
+  }
+  udp_listeners.emplace_back(static_cast< llarp::udp_listener* >(ev));
+  return true;
+#else
+  (void)l;
+  (void)src;
+  (void)idx;
+  (void)num;
+  return false;
+#endif
+}
+
+bool
+llarp_epoll_loop::udp_attach_steering(int fd, size_t num)
+{
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+  // A = low 32 bits of the source address, A %= num, return A
+  // the packet data starts at the udp payload so we go through the network
+  // header offset
+  const uint32_t netoff = static_cast< uint32_t >(SKF_NET_OFF);
+  sock_filter code[]    = {
+      // ip version
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, netoff),
+      BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 4),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 6, 0, 2),
+      // ipv6 source address is at 8, we want its last word
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, netoff + 20),
+      BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+      // ipv4 source address
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, netoff + 12),
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast< uint32_t >(num)),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+  };
+  sock_fprog prog;
+  prog.len    = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+  if(setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog))
+     == -1)
+  {
+    llarp::LogWarn("failed to attach udp steering program: ", strerror(errno));
+    errno = 0;
+    return false;
+  }
+  return true;
+#else
+  (void)fd;
+  (void)num;
+  return false;
+#endif
 }
 
 bool
@@ -337,6 +748,10 @@ llarp_epoll_loop::tick(int ms)
 {
   epoll_event events[1024];
   int result;
+  // anything queued by logic jobs since the last tick goes out before we
+  // block
+  flush_udp();
+  udp_stats  = udp_tick_stats{};
   result     = epoll_wait(epollfd, events, 1024, ms);
   bool didIO = false;
   if(result > 0)
@@ -384,12 +799,38 @@ llarp_epoll_loop::tick(int ms)
   }
   if(result != -1)
     tick_listeners();
+  if(udp_batch_size > 1)
+    publish_udp_stats();
   /// if we didn't get an io events we sleep to avoid 100% cpu use
   if(!didIO)
     std::this_thread::sleep_for(std::chrono::milliseconds(5));
   return result;
 }
 
+void
+llarp_epoll_loop::flush_udp()
+{
+  for(auto& listener : udp_listeners)
+    listener->flush_write();
+}
+
+void
+llarp_epoll_loop::publish_udp_stats()
+{
+  if(udp_stats.recv_calls)
+  {
+    METRICS_DYNAMIC_INT_UPDATE("ev.udp", "recv_calls", udp_stats.recv_calls);
+    METRICS_DYNAMIC_INT_UPDATE("ev.udp", "recv_pkts", udp_stats.recv_pkts);
+  }
+  if(udp_stats.send_calls)
+  {
+    METRICS_DYNAMIC_INT_UPDATE("ev.udp", "send_calls", udp_stats.send_calls);
+    METRICS_DYNAMIC_INT_UPDATE("ev.udp", "send_pkts", udp_stats.send_pkts);
+  }
+  if(udp_stats.send_drops)
+    METRICS_DYNAMIC_INT_UPDATE("ev.udp", "send_drops", udp_stats.send_drops);
+}
+
 int
 llarp_epoll_loop::run()
 {
@@ -397,6 +838,7 @@ llarp_epoll_loop::run()
   int result;
   do
   {
+    flush_udp();
     result = epoll_wait(epollfd, events, 1024, EV_TICK_INTERVAL);
     if(result > 0)
     {
@@ -432,7 +874,7 @@ llarp_epoll_loop::run()
 }
 
 int
-llarp_epoll_loop::udp_bind(const sockaddr* addr)
+llarp_epoll_loop::udp_bind(const sockaddr* addr, bool reuseport)
 {
   socklen_t slen;
   switch(addr->sa_family)
@@ -465,6 +907,24 @@ llarp_epoll_loop::udp_bind(const sockaddr* addr)
       return -1;
     }
   }
+#ifdef SO_REUSEPORT
+  if(reuseport)
+  {
+    int one = 1;
+    if(setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == -1)
+    {
+      perror("setsockopt()");
+      close(fd);
+      return -1;
+    }
+  }
+#else
+  if(reuseport)
+  {
+    close(fd);
+    return -1;
+  }
+#endif
   llarp::Addr a(*addr);
   llarp::LogDebug("bind to ", a);
   if(bind(fd, addr, slen) == -1)
@@ -533,6 +993,11 @@ llarp_epoll_loop::udp_close(llarp_udp_io* l)
   llarp::udp_listener* listener = static_cast< llarp::udp_listener* >(l->impl);
   if(listener)
   {
+    // send what we have left before we go away
+    listener->flush_write();
+    udp_listeners.erase(
+        std::remove(udp_listeners.begin(), udp_listeners.end(), listener),
+        udp_listeners.end());
     close_ev(listener);
     // remove handler
     auto itr = handlers.begin();
@@ -553,6 +1018,7 @@ void
 llarp_epoll_loop::stop()
 {
   // close all handlers before closing the epoll fd
+  udp_listeners.clear();
   auto itr = handlers.begin();
   while(itr != handlers.end())
   {
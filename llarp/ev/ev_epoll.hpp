@@ -2,6 +2,7 @@
 #define EV_EPOLL_HPP
 
 #include <ev/ev.hpp>
+#include <net/ip.hpp>
 #include <net/net.h>
 #include <net/net.hpp>
 #include <util/buffer.hpp>
@@ -12,11 +13,26 @@
 #include <cassert>
 #include <cstdio>
 #include <fcntl.h>
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
 #include <signal.h>
 #include <sys/epoll.h>
 #include <sys/un.h>
 #include <tuntap.h>
 #include <unistd.h>
+#include <util/queue.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// recvmmsg(2) and sendmmsg(2) are linux only, solaris' epoll emulation does
+// not come with them
+#if defined(__linux__)
+#define LLARP_HAVE_MMSG 1
+#endif
 
 namespace llarp
 {
@@ -38,8 +54,86 @@ namespace llarp
 
     int
     sendto(const sockaddr* to, const void* data, size_t sz) override;
+
+    /// flush all queued outbound datagrams, called at the end of each tick
+    void
+    flush_write() override;
+
+   private:
+    /// how many datagrams we move per syscall, 1 means no batching
+    size_t
+    batch_size() const;
+
+    /// send a single datagram right now
+    int
+    sendto_now(const sockaddr* to, const void* data, size_t sz);
+
+#ifdef LLARP_HAVE_MMSG
+    /// (re)allocate the preallocated recv/send rings for n datagrams
+    void
+    ensure_batch(size_t n);
+
+    int
+    read_batch(size_t n);
+
+    /// ring of receive buffers, EV_READ_BUF_SZ bytes per slot
+    std::vector< byte_t > m_RecvBufs;
+    std::vector< sockaddr_in6 > m_RecvAddrs;
+    std::vector< iovec > m_RecvIOV;
+    std::vector< mmsghdr > m_RecvHdrs;
+
+    /// queued outbound datagrams, EV_WRITE_BUF_SZ bytes per slot
+    std::vector< byte_t > m_SendBufs;
+    std::vector< sockaddr_in6 > m_SendAddrs;
+    std::vector< iovec > m_SendIOV;
+    std::vector< mmsghdr > m_SendHdrs;
+    /// number of datagrams queued in the send ring
+    size_t m_SendQueued = 0;
+#endif
   };
 
+#ifdef __linux__
+  /// a queue of a multi queue tun past the first, read and written on a
+  /// thread of its own instead of the event loop
+  struct tun_queue
+  {
+    /// packets waiting to be written before new ones are dropped
+    static constexpr size_t MaxWrites = 1024;
+    /// packets read in one go before looking at writes again
+    static constexpr size_t MaxReads = 64;
+
+    tun_queue(llarp_tun_io* tio, int queuefd);
+
+    ~tun_queue();
+
+    bool
+    start();
+
+    void
+    stop();
+
+    /// hand a packet to the queue's thread to write, false on drop
+    bool
+    queue_write(const byte_t* buf, size_t sz);
+
+   private:
+    void
+    run();
+
+    void
+    wakeup();
+
+    llarp_tun_io* t;
+    int fd;
+    int wakefd;
+    std::atomic_bool running;
+    std::atomic_bool sleeping;
+    std::thread worker;
+    /// pooled so queueing a write never touches the heap
+    thread::Queue< PacketBuffer > writes;
+  };
+#endif
+
   struct tun : public ev_io
   {
     llarp_tun_io* t;
@@ -76,11 +170,26 @@ namespace llarp
     bool
     setup();
 
+    /// write a packet on the queue its flow hashes to
+    bool
+    write_packet(const byte_t* buf, size_t sz);
+
     ~tun()
     {
+#ifdef __linux__
+      queues.clear();
+#endif
       if(tunif)
         tuntap_destroy(tunif);
     }
+
+#ifdef __linux__
+    /// every queue past the first one, which is on the event loop
+    std::vector< std::unique_ptr< tun_queue > > queues;
+
+    bool
+    setup_queues();
+#endif
   };
 };  // namespace llarp
 
@@ -89,6 +198,8 @@ struct llarp_epoll_loop
       public std::enable_shared_from_this< llarp_epoll_loop >
 {
   int epollfd;
+  /// udp sockets owned by handlers, so we can flush their send rings
+  std::vector< llarp::udp_listener* > udp_listeners;
 
   llarp_epoll_loop() : epollfd(-1)
   {
@@ -107,6 +218,10 @@ struct llarp_epoll_loop
   virtual bool
   udp_listen(llarp_udp_io* l, const sockaddr* src);
 
+  bool
+  udp_listen_shard(llarp_udp_io* l, const sockaddr* src, size_t idx,
+                   size_t num) override;
+
   bool
   running() const;
 
@@ -116,11 +231,24 @@ struct llarp_epoll_loop
   int
   tick(int ms);
 
+  /// send all batched outbound datagrams on every udp socket
+  void
+  flush_udp();
+
+  /// push this tick's udp counters to metrics
+  void
+  publish_udp_stats();
+
   int
   run();
 
   int
-  udp_bind(const sockaddr* addr);
+  udp_bind(const sockaddr* addr, bool reuseport = false);
+
+  /// steer datagrams across a reuseport group of num sockets by the low 32
+  /// bits of their source address modulo num
+  static bool
+  udp_attach_steering(int fd, size_t num);
 
   bool
   close_ev(llarp::ev_io* ev);
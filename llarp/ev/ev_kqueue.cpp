@@ -255,6 +255,8 @@ namespace llarp
 
     if(tuntap_set_ip(tunif, t->ifaddr, t->ifaddr, t->netmask) == -1)
       return false;
+    if(t->mtu && tuntap_set_mtu(tunif, t->mtu) == -1)
+      return false;
     fd = tunif->tun_fd;
     return fd != -1;
   }
@@ -206,6 +206,11 @@ namespace llarp
       llarp::LogWarn("failed to set ip");
       return false;
     }
+    if(t->mtu && tuntap_set_mtu(tunif, t->mtu) == -1)
+    {
+      llarp::LogWarn("failed to set mtu to ", t->mtu);
+      return false;
+    }
     fd = tunif->tun_fd;
     if(fd == -1)
       return false;
@@ -108,7 +108,7 @@ namespace llarp
       if(m_UpstreamQueue.size() > MaxUpstreamQueueSize)
         return false;
 
-      llarp::net::IPv4Packet pkt;
+      llarp::net::IPPacket pkt;
       if(!pkt.Load(buf.underlying))
         return false;
 
@@ -118,7 +118,7 @@ namespace llarp
       else
         dst = pkt.dst();
       pkt.UpdateIPv4PacketOnDst(m_IP, dst);
-      m_UpstreamQueue.emplace(pkt, counter);
+      m_UpstreamQueue.emplace(std::move(pkt), counter);
       m_TxRate += buf.underlying.sz;
       m_LastActive = m_Parent->Now();
       return true;
@@ -127,7 +127,7 @@ namespace llarp
     bool
     Endpoint::QueueInboundTraffic(ManagedBuffer buf)
     {
-      llarp::net::IPv4Packet pkt;
+      llarp::net::IPPacket pkt;
       if(!pkt.Load(buf.underlying))
         return false;
 
@@ -121,12 +121,12 @@ namespace llarp
 
       struct UpstreamBuffer
       {
-        UpstreamBuffer(const llarp::net::IPv4Packet& p, uint64_t c)
-            : pkt(p), counter(c)
+        UpstreamBuffer(llarp::net::IPPacket p, uint64_t c)
+            : pkt(std::move(p)), counter(c)
         {
         }
 
-        llarp::net::IPv4Packet pkt;
+        llarp::net::IPPacket pkt;
         uint64_t counter;
 
         bool
@@ -177,10 +177,10 @@ namespace llarp
       (void)p;
       if(m_WritePacket)
       {
-        llarp::net::IPv4Packet pkt;
+        llarp::net::IPPacket pkt;
         if(!pkt.Load(buf))
           return false;
-        m_Downstream.emplace(counter, pkt);
+        m_Downstream.emplace(counter, std::move(pkt));
         m_LastUse = router->Now();
         return true;
       }
@@ -199,7 +199,7 @@ namespace llarp
     }
 
     bool
-    BaseSession::QueueUpstreamTraffic(llarp::net::IPv4Packet pkt,
+    BaseSession::QueueUpstreamTraffic(llarp::net::IPPacket pkt,
                                       const size_t N)
     {
       const llarp_buffer_t& buf = pkt.Buffer();
@@ -56,7 +56,7 @@ namespace llarp
       HandlePathBuilt(llarp::path::Path* p) override;
 
       bool
-      QueueUpstreamTraffic(llarp::net::IPv4Packet pkt, const size_t packSize);
+      QueueUpstreamTraffic(llarp::net::IPPacket pkt, const size_t packSize);
 
       /// flush upstream and downstream traffic
       bool
@@ -115,7 +115,7 @@ namespace llarp
       using TieredQueue_t = std::map< uint8_t, UpstreamTrafficQueue_t >;
       TieredQueue_t m_Upstream;
 
-      using DownstreamPkt = std::pair< uint64_t, llarp::net::IPv4Packet >;
+      using DownstreamPkt = std::pair< uint64_t, llarp::net::IPPacket >;
 
       struct DownstreamPktSorter
       {
@@ -27,15 +27,15 @@ namespace llarp
         : m_Router(r)
         , m_Resolver(r->netloop(), this)
         , m_Name(name)
-        , m_Tun{{0}, 0, {0}, 0, 0, 0, 0, 0, 0, 0}
+        , m_Tun{{0}, 0, {0}, 0, 0, 0, 0, 0, 0, 0, 1}
         , m_LocalResolverAddr("127.0.0.1", 53)
-        , m_InetToNetwork(name + "_exit_rx", r->netloop(), r->netloop())
-
     {
       m_Tun.user      = this;
       m_Tun.recvpkt   = &ExitHandlerRecvPkt;
       m_Tun.tick      = &ExitHandlerFlush;
       m_ShouldInitTun = true;
+      m_InetToNetwork.emplace_back(
+          new PacketQueue_t(name + "_exit_rx", r->netloop(), r->netloop()));
     }
 
     ExitEndpoint::~ExitEndpoint()
@@ -195,7 +195,7 @@ namespace llarp
     void
     ExitEndpoint::Flush()
     {
-      m_InetToNetwork.Process([&](Pkt_t &pkt) {
+      auto visit = [&](Pkt_t &pkt) {
         PubKey pk;
         {
           auto itr = m_IPToKey.find(pkt.dst());
@@ -236,7 +236,9 @@ namespace llarp
                     " as we are overloaded (probably)");
           }
         }
-      });
+      };
+      for(auto &queue : m_InetToNetwork)
+        queue->Process(visit);
       {
         auto itr = m_ActiveExits.begin();
         while(itr != m_ActiveExits.end())
@@ -268,6 +270,11 @@ namespace llarp
       if(m_ShouldInitTun)
       {
         auto loop = GetRouter()->netloop();
+        // OnInetPacket is called from every tun queue
+        while(m_InetToNetwork.size() < size_t(m_Tun.queues))
+          m_InetToNetwork.emplace_back(new PacketQueue_t(
+              m_Name + "_exit_rx" + std::to_string(m_InetToNetwork.size()),
+              loop, loop));
         if(!llarp_ev_add_tun(loop.get(), &m_Tun))
         {
           llarp::LogWarn("Could not create tunnel for exit endpoint");
@@ -356,27 +363,24 @@ namespace llarp
     huint32_t
     ExitEndpoint::AllocateNewAddress()
     {
-      if(m_NextAddr < m_HigestAddr)
-        return ++m_NextAddr;
-
-      // find oldest activity ip address
-      huint32_t found  = {0};
-      llarp_time_t min = std::numeric_limits< llarp_time_t >::max();
-      auto itr         = m_IPActivity.begin();
-      while(itr != m_IPActivity.end())
+      huint32_t found = {0};
+      bool reused     = false;
+      if(!m_IPPool.Obtain(Now(), found, reused))
       {
-        if(itr->second < min)
-        {
-          found.h = itr->first.h;
-          min     = itr->second;
-        }
-        ++itr;
+        LogError(Name(), " has no address left to hand out");
+        return found;
       }
       // kick old ident off exit
       // TODO: DoS
-      PubKey pk = m_IPToKey[found];
-      KickIdentOffExit(pk);
-
+      if(reused)
+      {
+        auto itr = m_IPToKey.find(found);
+        if(itr != m_IPToKey.end())
+        {
+          const PubKey pk = itr->second;
+          KickIdentOffExit(pk);
+        }
+      }
       return found;
     }
 
@@ -402,20 +406,25 @@ namespace llarp
     void
     ExitEndpoint::MarkIPActive(huint32_t ip)
     {
-      m_IPActivity[ip] = GetRouter()->Now();
+      m_IPPool.Touch(ip, GetRouter()->Now());
     }
 
     void
     ExitEndpoint::OnInetPacket(const llarp_buffer_t &buf)
     {
-      m_InetToNetwork.EmplaceIf(
+      if(m_InetToNetwork.empty())
+        return;
+      auto &queue =
+          *m_InetToNetwork[net::FlowHash(buf.base, buf.sz)
+                           % m_InetToNetwork.size()];
+      queue.EmplaceIf(
           [b = ManagedBuffer(buf)](Pkt_t &pkt) -> bool { return pkt.Load(b); });
     }
 
     bool
     ExitEndpoint::QueueSNodePacket(const llarp_buffer_t &buf, huint32_t from)
     {
-      net::IPv4Packet pkt;
+      net::IPPacket pkt;
       if(!pkt.Load(buf))
         return false;
       // rewrite ip
@@ -514,11 +523,25 @@ namespace llarp
         m_IfAddr                = ifaddr.xtohl();
         m_OurRange.netmask_bits = netmask_ipv4_bits(m_Tun.netmask);
         m_OurRange.addr         = m_IfAddr;
-        m_NextAddr              = m_IfAddr;
         m_HigestAddr            = m_IfAddr | (~m_OurRange.netmask_bits);
+        // everything between our address and the broadcast address
+        m_IPPool.Reset(m_Name + ".ip_pool", huint32_t{m_IfAddr.h + 1},
+                       huint32_t{m_HigestAddr.h - 1});
         LogInfo(Name(), " set ifaddr range to ", m_Tun.ifaddr, "/",
                 m_Tun.netmask, " lo=", m_IfAddr, " hi=", m_HigestAddr);
       }
+      if(k == "tun-queues")
+      {
+        const int num = std::atoi(v.c_str());
+        if(num < 1 || num > MaxTunQueues)
+        {
+          LogError(Name(), " tun-queues must be between 1 and ", MaxTunQueues,
+                   ", not ", v);
+          return false;
+        }
+        m_Tun.queues = num;
+        LogInfo(Name(), " using ", num, " tun queues");
+      }
       if(k == "ifname")
       {
         if(v.length() >= sizeof(m_Tun.ifname))
@@ -601,29 +624,57 @@ namespace llarp
     void
     ExitEndpoint::RemoveExit(const exit::Endpoint *ep)
     {
-      auto range = m_ActiveExits.equal_range(ep->PubKey());
-      auto itr   = range.first;
+      const PubKey pk = ep->PubKey();
+      auto range      = m_ActiveExits.equal_range(pk);
+      auto itr        = range.first;
       while(itr != range.second)
       {
         if(itr->second->LocalPath() == ep->LocalPath())
         {
+          auto chosen = m_ChosenExits.find(pk);
+          if(chosen != m_ChosenExits.end() && chosen->second == ep)
+            m_ChosenExits.erase(chosen);
           itr = m_ActiveExits.erase(itr);
           // now ep is gone af
+          ReleaseIdentIfUnused(pk);
           return;
         }
         ++itr;
       }
     }
 
+    void
+    ExitEndpoint::ReleaseIdentIfUnused(const PubKey &pk)
+    {
+      if(m_ActiveExits.count(pk)
+         || m_SNodeSessions.count(RouterID(pk.as_array())))
+        return;
+      auto itr = m_KeyToIP.find(pk);
+      if(itr == m_KeyToIP.end())
+        return;
+      const huint32_t ip = itr->second;
+      LogInfo(Name(), " released ", ip, " from ", pk);
+      m_IPToKey.erase(ip);
+      m_KeyToIP.erase(itr);
+      // a new session makes it a service node again
+      m_SNodeKeys.erase(pk);
+      m_IPPool.Release(ip);
+    }
+
     void
     ExitEndpoint::Tick(llarp_time_t now)
     {
+      // idents whose ip may be free once the expired sessions are gone
+      std::set< PubKey > expired;
       {
         auto itr = m_SNodeSessions.begin();
         while(itr != m_SNodeSessions.end())
         {
           if(itr->second->IsExpired(now))
+          {
+            expired.emplace(itr->first.as_array());
             itr = m_SNodeSessions.erase(itr);
+          }
           else
             ++itr;
         }
@@ -634,10 +685,15 @@ namespace llarp
         while(itr != m_ActiveExits.end())
         {
           if(itr->second->IsExpired(now))
+          {
+            expired.emplace(itr->first);
             itr = m_ActiveExits.erase(itr);
+          }
           else
             ++itr;
         }
+        for(const auto &pk : expired)
+          ReleaseIdentIfUnused(pk);
         // pick chosen exits and tick
         m_ChosenExits.clear();
         itr = m_ActiveExits.begin();
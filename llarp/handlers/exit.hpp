@@ -4,6 +4,7 @@
 #include <exit/endpoint.hpp>
 #include <handlers/tun.hpp>
 #include <dns/server.hpp>
+#include <net/ip_pool.hpp>
 #include <unordered_map>
 
 namespace llarp
@@ -125,6 +126,11 @@ namespace llarp
       void
       KickIdentOffExit(const PubKey& pk);
 
+      /// hand pk's ip back to the pool once it has no exit or snode session
+      /// left
+      void
+      ReleaseIdentIfUnused(const PubKey& pk);
+
       AbstractRouter* m_Router;
       dns::Proxy m_Resolver;
       bool m_ShouldInitTun;
@@ -156,25 +162,25 @@ namespace llarp
 
       huint32_t m_IfAddr;
       huint32_t m_HigestAddr;
-      huint32_t m_NextAddr;
       IPRange m_OurRange;
 
-      std::unordered_map< huint32_t, llarp_time_t, huint32_t::Hash >
-          m_IPActivity;
+      /// addresses handed out to exit clients
+      net::IPPool m_IPPool;
 
       llarp_tun_io m_Tun;
 
       Addr m_LocalResolverAddr;
       std::vector< Addr > m_UpstreamResolvers;
 
-      using Pkt_t = net::IPv4Packet;
+      using Pkt_t = net::IPPacket;
       using PacketQueue_t =
           util::CoDelQueue< Pkt_t, Pkt_t::GetTime, Pkt_t::PutTime,
-                            Pkt_t::CompareOrder, Pkt_t::GetNow, util::NullMutex,
-                            util::NullLock, 5, 100, 1024 >;
+                            Pkt_t::CompareOrder, Pkt_t::GetNow, util::Mutex,
+                            util::Lock, 5, 100, 1024 >;
 
-      /// internet to llarp packet queue
-      PacketQueue_t m_InetToNetwork;
+      /// internet to llarp packet queues, one per tun queue, picked by flow
+      /// hash
+      std::vector< std::unique_ptr< PacketQueue_t > > m_InetToNetwork;
     };
   }  // namespace handlers
 }  // namespace llarp
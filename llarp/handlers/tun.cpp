@@ -33,8 +33,6 @@ namespace llarp
     TunEndpoint::TunEndpoint(const std::string &nickname, AbstractRouter *r,
                              service::Context *parent)
         : service::Endpoint(nickname, r, parent)
-        , m_UserToNetworkPktQueue(nickname + "_sendq", r->netloop(),
-                                  r->netloop())
         , m_NetworkToUserPktQueue(nickname + "_recvq", r->netloop(),
                                   r->netloop())
         , m_Resolver(r->netloop(), this)
@@ -47,6 +45,10 @@ namespace llarp
 #endif
       tunif.user    = this;
       tunif.netmask = DefaultTunNetmask;
+      tunif.queues  = 1;
+      tunif.mtu     = 0;
+      m_UserToNetworkPktQueues.emplace_back(
+          new SendQueue_t(nickname + "_sendq", r->netloop(), r->netloop()));
 
       // eh this shouldn't do anything on windows anyway
       strncpy(tunif.ifaddr, DefaultTunSrcAddr, sizeof(tunif.ifaddr) - 1);
@@ -68,23 +70,26 @@ namespace llarp
       obj.Put("ustreamResolvers", resolvers);
       obj.Put("localResolver", m_LocalResolverAddr.ToString());
       util::StatusObject ips{};
-      for(const auto &item : m_IPActivity)
-      {
-        util::StatusObject ipObj{{"lastActive", item.second}};
+      m_IPPool.ForEach([&](huint32_t ip, llarp_time_t lastActive) {
+        auto itr = m_IPToAddr.find(ip);
+        if(itr == m_IPToAddr.end())
+          return;
+        util::StatusObject ipObj{{"lastActive", lastActive}};
         std::string remoteStr;
-        AlignedBuffer< 32 > addr = m_IPToAddr.at(item.first);
+        const AlignedBuffer< 32 > &addr = itr->second;
         if(m_SNodes.at(addr))
           remoteStr = RouterID(addr.as_array()).ToString();
         else
           remoteStr = service::Address(addr.as_array()).ToString();
         ipObj.Put("remote", remoteStr);
-        std::string ipaddr = item.first.ToString();
+        std::string ipaddr = ip.ToString();
         ips.Put(ipaddr.c_str(), ipObj);
-      }
+      });
       obj.Put("addrs", ips);
       obj.Put("ourIP", m_OurIP.ToString());
-      obj.Put("nextIP", m_NextIP.ToString());
       obj.Put("maxIP", m_MaxIP.ToString());
+      obj.Put("ipsInUse", uint64_t(m_IPPool.NumInUse()));
+      obj.Put("ipEvictions", m_IPPool.Evictions());
       return obj;
     }
 
@@ -173,6 +178,32 @@ namespace llarp
         llarp::LogInfo(Name() + " setting ifname to ", tunif.ifname);
         return true;
       }
+      if(k == "tun-queues")
+      {
+        const int num = std::atoi(v.c_str());
+        if(num < 1 || num > MaxTunQueues)
+        {
+          llarp::LogError(Name(), " tun-queues must be between 1 and ",
+                          MaxTunQueues, ", not ", v);
+          return false;
+        }
+        tunif.queues = num;
+        llarp::LogInfo(Name(), " using ", num, " tun queues");
+        return true;
+      }
+      if(k == "tun-mtu")
+      {
+        const int mtu = std::atoi(v.c_str());
+        if(mtu < MinTunMTU || mtu > int(EV_TUN_MAX_MTU))
+        {
+          llarp::LogError(Name(), " tun-mtu must be between ", MinTunMTU,
+                          " and ", EV_TUN_MAX_MTU, ", not ", v);
+          return false;
+        }
+        tunif.mtu = mtu;
+        llarp::LogInfo(Name(), " using tun mtu ", mtu);
+        return true;
+      }
       if(k == "ifaddr")
       {
         std::string addr;
@@ -217,10 +248,10 @@ namespace llarp
     }
 
     bool
-    TunEndpoint::QueueOutboundTraffic(llarp::net::IPv4Packet &&pkt)
+    TunEndpoint::QueueOutboundTraffic(llarp::net::IPPacket &&pkt)
     {
       return m_NetworkToUserPktQueue.EmplaceIf(
-          [](llarp::net::IPv4Packet &) -> bool { return true; },
+          [](llarp::net::IPPacket &) -> bool { return true; },
           std::move(pkt));
     }
 
@@ -446,13 +477,77 @@ namespace llarp
       }
       llarp::LogInfo(Name() + " map ", addr.ToString(), " to ", ip);
 
-      m_IPToAddr[ip]   = addr;
-      m_AddrToIP[addr] = ip;
-      m_SNodes[addr]   = SNode;
+      PutMapping(ip, addr, SNode);
       MarkIPActiveForever(ip);
       return true;
     }
 
+    void
+    TunEndpoint::PutMapping(huint32_t ip, const AlignedBuffer< 32 > &addr,
+                            bool snode)
+    {
+      m_IPToAddr[ip]   = addr;
+      m_AddrToIP[addr] = ip;
+      m_SNodes[addr]   = snode;
+      util::Lock lock(&m_MappedIPsMutex);
+      m_MappedIPs.insert(ip);
+    }
+
+    void
+    TunEndpoint::ClearMapping(huint32_t ip)
+    {
+      auto itr = m_IPToAddr.find(ip);
+      if(itr != m_IPToAddr.end())
+      {
+        m_AddrToIP.erase(itr->second);
+        m_SNodes.erase(itr->second);
+        m_IPToAddr.erase(itr);
+      }
+      {
+        util::Lock lock(&m_MappedIPsMutex);
+        m_MappedIPs.erase(ip);
+      }
+      m_IPPool.Release(ip);
+    }
+
+    void
+    TunEndpoint::ReleaseIdleMappings(llarp_time_t now)
+    {
+      if(now < MappingIdleTimeout)
+        return;
+      const llarp_time_t idleSince = now - MappingIdleTimeout;
+      std::vector< huint32_t > idle;
+      // walks only the idle end of the activity list, pinned addresses are
+      // not on it
+      m_IPPool.ForEachIdle(idleSince, [&](huint32_t ip, llarp_time_t) {
+        idle.emplace_back(ip);
+      });
+      for(const auto ip : idle)
+      {
+        auto itr = m_IPToAddr.find(ip);
+        if(itr != m_IPToAddr.end())
+        {
+          auto snode = m_SNodes.find(itr->second);
+          if(snode != m_SNodes.end()
+             && HasSessionWith(itr->second, snode->second))
+          {
+            // still in use, look again once it has been idle for a while
+            m_IPPool.Touch(ip, now);
+            continue;
+          }
+        }
+        llarp::LogInfo(Name(), " released idle ", ip);
+        ClearMapping(ip);
+      }
+    }
+
+    bool
+    TunEndpoint::IsMappedIP(huint32_t ip) const
+    {
+      absl::ReaderMutexLock lock(&m_MappedIPsMutex);
+      return m_MappedIPs.count(ip) != 0;
+    }
+
     bool
     TunEndpoint::Start()
     {
@@ -474,6 +569,12 @@ namespace llarp
     bool
     TunEndpoint::SetupTun()
     {
+      // one send queue per tun queue, tunifRecvPkt may be called from all
+      // of them at once
+      while(m_UserToNetworkPktQueues.size() < size_t(tunif.queues))
+        m_UserToNetworkPktQueues.emplace_back(new SendQueue_t(
+            Name() + "_sendq" + std::to_string(m_UserToNetworkPktQueues.size()),
+            Router()->netloop(), Router()->netloop()));
       auto loop = EndpointNetLoop();
       if(!llarp_ev_add_tun(loop.get(), &tunif))
       {
@@ -531,10 +632,13 @@ namespace llarp
       llarp::Addr lAddr(tunif.ifaddr);
 
       m_OurIP                 = lAddr.xtohl();
-      m_NextIP                = m_OurIP;
       m_OurRange.netmask_bits = netmask_ipv4_bits(tunif.netmask);
       m_OurRange.addr         = m_OurIP;
       m_MaxIP                 = m_OurIP | (~m_OurRange.netmask_bits);
+      m_IPPool.Reset(Name() + ".ip_pool", m_OurIP, huint32_t{m_MaxIP.h - 1});
+      // addresses mapped by the config before the range was known
+      for(const auto &item : m_IPToAddr)
+        m_IPPool.Pin(item.first);
       llarp::LogInfo(Name(), " set ", tunif.ifname, " to have address ", lAddr);
       llarp::LogInfo(Name(), " allocated up to ", m_MaxIP, " on range ",
                      m_OurRange);
@@ -568,6 +672,7 @@ namespace llarp
       if(m_Exit)
         EnsureRouterIsKnown(m_Exit->Endpoint());
       Endpoint::Tick(now);
+      ReleaseIdleMappings(now);
     }
 
     bool
@@ -581,19 +686,38 @@ namespace llarp
     void
     TunEndpoint::FlushSend()
     {
-      m_UserToNetworkPktQueue.Process([&](net::IPv4Packet &pkt) {
+      for(auto &queue : m_UserToNetworkPktQueues)
+        FlushSendQueue(*queue);
+    }
+
+    void
+    TunEndpoint::ClearAddresses(OutboundPacket &pkt) const
+    {
+      if(IsMappedIP(pkt.destination))
+        pkt.UpdateIPv4PacketOnSrc();
+      else
+        pkt.UpdateIPv4PacketOnDst({0}, pkt.destination);
+    }
+
+    void
+    TunEndpoint::FlushSendQueue(SendQueue_t &queue)
+    {
+      queue.Process([&](OutboundPacket &pkt) {
         std::function< bool(const llarp_buffer_t &) > sendFunc;
-        auto itr = m_IPToAddr.find(pkt.dst());
+        // the addresses were cleared on the tun queue thread, only a
+        // mapping made or dropped since then means doing it again here
+        auto itr = m_IPToAddr.find(pkt.destination);
         if(itr == m_IPToAddr.end())
         {
-          if(m_Exit && !llarp::IsIPv4Bogon(pkt.dst()))
+          if(m_Exit && !llarp::IsIPv4Bogon(pkt.destination))
           {
-            pkt.UpdateIPv4PacketOnDst({0}, pkt.dst());
+            if(!(pkt.dst() == pkt.destination))
+              pkt.UpdateIPv4PacketOnDst({0}, pkt.destination);
             m_Exit->QueueUpstreamTraffic(std::move(pkt),
                                          llarp::routing::ExitPadSize);
           }
           else
-            llarp::LogWarn(Name(), " has no endpoint for ", pkt.dst());
+            llarp::LogWarn(Name(), " has no endpoint for ", pkt.destination);
           return true;
         }
 
@@ -608,9 +732,8 @@ namespace llarp
                                itr->second.as_array(), std::placeholders::_1,
                                service::eProtocolTraffic);
         }
-        // prepare packet for insertion into network
-        // this includes clearing IP addresses, recalculating checksums, etc
-        pkt.UpdateIPv4PacketOnSrc();
+        if(!(pkt.dst() == huint32_t{0}))
+          pkt.UpdateIPv4PacketOnSrc();
 
         if(sendFunc && sendFunc(pkt.Buffer()))
           return true;
@@ -629,19 +752,20 @@ namespace llarp
       auto usIP = m_OurIP;
       ManagedBuffer buf(b);
       return m_NetworkToUserPktQueue.EmplaceIf(
-          [buf, themIP, usIP](net::IPv4Packet &pkt) -> bool {
+          [buf, themIP, usIP](net::IPPacket &pkt) -> bool {
             // load
             if(!pkt.Load(buf))
               return false;
             // filter out:
             // - packets smaller than minimal IPv4 header
-            // - non-IPv4 packets
+            // - non-IPv4 packets, ipv6 is not routed yet
             // - packets with weird src/dst addresses
             //   (0.0.0.0/8 but not 0.0.0.0)
             // - packets with 0 src but non-0 dst and oposite
+            if(!pkt.IsV4())
+              return false;
             auto hdr = pkt.Header();
-            if(pkt.sz < sizeof(*hdr) || hdr->version != 4
-               || (hdr->saddr != 0 && *(byte_t *)&(hdr->saddr) == 0)
+            if((hdr->saddr != 0 && *(byte_t *)&(hdr->saddr) == 0)
                || (hdr->daddr != 0 && *(byte_t *)&(hdr->daddr) == 0)
                || ((hdr->saddr == 0) != (hdr->daddr == 0)))
             {
@@ -676,53 +800,27 @@ namespace llarp
           return itr->second;
         }
       }
-      // allocate new address
-      if(m_NextIP < m_MaxIP)
+      // allocate new address, once we are full the least active one is taken
+      // from whoever had it
+      // TODO: prevent DoS
+      bool reused = false;
+      if(!m_IPPool.Obtain(now, nextIP, reused))
       {
-        do
-        {
-          nextIP = ++m_NextIP;
-        } while(m_IPToAddr.find(nextIP) != m_IPToAddr.end()
-                && m_NextIP < m_MaxIP);
-        if(nextIP < m_MaxIP)
-        {
-          m_AddrToIP[ident]  = nextIP;
-          m_IPToAddr[nextIP] = ident;
-          m_SNodes[ident]    = snode;
-          llarp::LogInfo(Name(), " mapped ", ident, " to ", nextIP);
-          MarkIPActive(nextIP);
-          return nextIP;
-        }
+        llarp::LogError(Name(), " has no address left for ", ident);
+        return nextIP;
       }
-
-      // we are full
-      // expire least active ip
-      // TODO: prevent DoS
-      std::pair< huint32_t, llarp_time_t > oldest = {huint32_t{0}, 0};
-
-      // find oldest entry
-      auto itr = m_IPActivity.begin();
-      while(itr != m_IPActivity.end())
+      if(reused)
       {
-        if(itr->second <= now)
+        auto itr = m_IPToAddr.find(nextIP);
+        if(itr != m_IPToAddr.end())
         {
-          if((now - itr->second) > oldest.second)
-          {
-            oldest.first  = itr->first;
-            oldest.second = itr->second;
-          }
+          llarp::LogInfo(Name(), " unmapped ", itr->second, " from ", nextIP);
+          m_AddrToIP.erase(itr->second);
+          m_SNodes.erase(itr->second);
         }
-        ++itr;
       }
-      // remap address
-      m_IPToAddr[oldest.first] = ident;
-      m_AddrToIP[ident]        = oldest.first;
-      m_SNodes[ident]          = snode;
-      nextIP                   = oldest.first;
-
-      // mark ip active
-      m_IPActivity[nextIP] = std::max(m_IPActivity[nextIP], now);
-
+      PutMapping(nextIP, ident, snode);
+      llarp::LogInfo(Name(), " mapped ", ident, " to ", nextIP);
       return nextIP;
     }
 
@@ -735,13 +833,13 @@ namespace llarp
     void
     TunEndpoint::MarkIPActive(huint32_t ip)
     {
-      m_IPActivity[ip] = std::max(Now(), m_IPActivity[ip]);
+      m_IPPool.Touch(ip, Now());
     }
 
     void
     TunEndpoint::MarkIPActiveForever(huint32_t ip)
     {
-      m_IPActivity[ip] = std::numeric_limits< uint64_t >::max();
+      m_IPPool.Pin(ip);
     }
 
     void
@@ -763,7 +861,7 @@ namespace llarp
       // flush snode traffic
       self->FlushSNodeTraffic();
       // flush network to user
-      self->m_NetworkToUserPktQueue.Process([tun](net::IPv4Packet &pkt) {
+      self->m_NetworkToUserPktQueue.Process([tun](net::IPPacket &pkt) {
         if(!llarp_ev_tun_async_write(tun, pkt.Buffer()))
           llarp::LogWarn("packet dropped");
       });
@@ -772,12 +870,20 @@ namespace llarp
     void
     TunEndpoint::tunifRecvPkt(llarp_tun_io *tun, const llarp_buffer_t &b)
     {
-      // called for every packet read from user in isolated network thread
+      // called for every packet read from user in isolated network thread,
+      // or on the thread of the tun queue it was read from
       TunEndpoint *self = static_cast< TunEndpoint * >(tun->user);
+      auto &queues      = self->m_UserToNetworkPktQueues;
+      auto &queue       = *queues[net::FlowHash(b.base, b.sz) % queues.size()];
       ManagedBuffer buf(b);
-      if(!self->m_UserToNetworkPktQueue.EmplaceIf(
-             [buf](net::IPv4Packet &pkt) -> bool {
-               return pkt.Load(buf) && pkt.Header()->version == 4;
+      if(!queue.EmplaceIf(
+             [self, buf](OutboundPacket &pkt) -> bool {
+               // ipv6 is not routed yet
+               if(!(pkt.Load(buf) && pkt.IsV4()))
+                 return false;
+               pkt.destination = pkt.dst();
+               self->ClearAddresses(pkt);
+               return true;
              }))
       {
 #if defined(DEBUG) || !defined(RELEASE_MOTTO)
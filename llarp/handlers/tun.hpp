@@ -4,12 +4,14 @@
 #include <dns/server.hpp>
 #include <ev/ev.h>
 #include <net/ip.hpp>
+#include <net/ip_pool.hpp>
 #include <net/net.hpp>
 #include <service/endpoint.hpp>
 #include <util/codel.hpp>
 #include <util/threading.hpp>
 
 #include <future>
+#include <unordered_set>
 
 namespace llarp
 {
@@ -19,6 +21,13 @@ namespace llarp
     static const char DefaultTunIfname[]  = "lokinet0";
     static const char DefaultTunDstAddr[] = "10.10.0.1";
     static const char DefaultTunSrcAddr[] = "10.10.0.2";
+    /// most tun queues an endpoint will open
+    static const int MaxTunQueues = 16;
+    /// smallest tun mtu we accept, what every ipv4 host has to take
+    static const int MinTunMTU = 576;
+    /// how long a mapped ip with no session left sits idle before we let
+    /// it go
+    static const llarp_time_t MappingIdleTimeout = 5 * 60 * 1000;
 
     struct TunEndpoint : public service::Endpoint, public dns::IQueryHandler
     {
@@ -74,7 +83,7 @@ namespace llarp
 
       /// queue outbound packet to the world
       bool
-      QueueOutboundTraffic(llarp::net::IPv4Packet&& pkt);
+      QueueOutboundTraffic(llarp::net::IPPacket&& pkt);
 
       /// we have a resolvable ip address
       bool
@@ -144,10 +153,23 @@ namespace llarp
 
      protected:
       using PacketQueue_t = llarp::util::CoDelQueue<
-          net::IPv4Packet, net::IPv4Packet::GetTime, net::IPv4Packet::PutTime,
-          net::IPv4Packet::CompareOrder, net::IPv4Packet::GetNow >;
-      /// queue for sending packets over the network from us
-      PacketQueue_t m_UserToNetworkPktQueue;
+          net::IPPacket, net::IPPacket::GetTime, net::IPPacket::PutTime,
+          net::IPPacket::CompareOrder, net::IPPacket::GetNow >;
+      /// a packet read from the tun, its addresses are cleared for the
+      /// network on the tun queue thread it was read on
+      struct OutboundPacket : public net::IPPacket
+      {
+        /// where it was going before that
+        huint32_t destination = {0};
+      };
+      using SendQueue_t = llarp::util::CoDelQueue<
+          OutboundPacket, net::IPPacket::GetTime, net::IPPacket::PutTime,
+          net::IPPacket::CompareOrder, net::IPPacket::GetNow >;
+      using SendQueues_t = std::vector< std::unique_ptr< SendQueue_t > >;
+      /// queues for sending packets over the network from us, one per tun
+      /// queue so tun threads rarely contend, picked by flow hash so each
+      /// flow stays in order
+      SendQueues_t m_UserToNetworkPktQueues;
       /// queue for sending packets to user from network
       PacketQueue_t m_NetworkToUserPktQueue;
       /// return true if we have a remote loki address for this ip address
@@ -166,6 +188,31 @@ namespace llarp
       virtual void
       FlushSend();
 
+      void
+      FlushSendQueue(SendQueue_t& queue);
+
+      /// clear the addresses of a packet we read for the network, traffic
+      /// for a remote loses both, traffic for the exit keeps its destination
+      void
+      ClearAddresses(OutboundPacket& pkt) const;
+
+      /// map ip and addr to each other
+      void
+      PutMapping(huint32_t ip, const AlignedBuffer< 32 >& addr, bool snode);
+
+      /// unmap ip and hand it back to the pool
+      void
+      ClearMapping(huint32_t ip);
+
+      /// clear the mappings that were idle since before now minus
+      /// MappingIdleTimeout and have no session left
+      void
+      ReleaseIdleMappings(llarp_time_t now);
+
+      /// is ip mapped to a remote, safe to call from any thread
+      bool
+      IsMappedIP(huint32_t ip) const LOCKS_EXCLUDED(m_MappedIPsMutex);
+
       /// maps ip to key (host byte order)
       std::unordered_map< huint32_t, AlignedBuffer< 32 >, huint32_t::Hash >
           m_IPToAddr;
@@ -173,6 +220,10 @@ namespace llarp
       std::unordered_map< AlignedBuffer< 32 >, huint32_t,
                           AlignedBuffer< 32 >::Hash >
           m_AddrToIP;
+      /// the ips in m_IPToAddr, for the tun queue threads
+      mutable util::Mutex m_MappedIPsMutex;
+      std::unordered_set< huint32_t, huint32_t::Hash > m_MappedIPs
+          GUARDED_BY(m_MappedIPsMutex);
 
       /// maps key to true if key is a service node, maps key to false if key is
       /// a hidden service
@@ -185,8 +236,8 @@ namespace llarp
       {
         ManagedBuffer copy{buf};
         return m_NetworkToUserPktQueue.EmplaceIf(
-            [&](llarp::net::IPv4Packet& pkt) -> bool {
-              if(!pkt.Load(copy.underlying))
+            [&](llarp::net::IPPacket& pkt) -> bool {
+              if(!(pkt.Load(copy.underlying) && pkt.IsV4()))
                 return false;
               pkt.UpdateIPv4PacketOnDst(pkt.src(), m_OurIP);
               return true;
@@ -218,13 +269,10 @@ namespace llarp
       /// our dns resolver
       dns::Proxy m_Resolver;
 
-      /// maps ip address to timestamp last active
-      std::unordered_map< huint32_t, llarp_time_t, huint32_t::Hash >
-          m_IPActivity;
+      /// addresses handed out to remotes, by when they were last active
+      net::IPPool m_IPPool;
       /// our ip address (host byte order)
       huint32_t m_OurIP;
-      /// next ip address to allocate (host byte order)
-      huint32_t m_NextIP;
       /// highest ip address to allocate (host byte order)
       huint32_t m_MaxIP;
       /// our ip range we are using
@@ -1,10 +1,52 @@
 #include <link/server.hpp>
 
 #include <crypto/crypto.hpp>
+#include <ev/ev.hpp>
+#include <ev/pipe.hpp>
 #include <util/fs.hpp>
 
 namespace llarp
 {
+  /// wakes the logic thread when a shard has queued datagrams for us or the
+  /// crypto worker has finished a job
+  ///
+  /// owned by the event loop, if the loop goes away first it takes the shard
+  /// threads with it so they never write to a dead pipe
+  struct ILinkLayer::ShardWakeup : public llarp_ev_pkt_pipe
+  {
+    ILinkLayer* link;
+
+    ShardWakeup(ILinkLayer* l) : llarp_ev_pkt_pipe(l->m_Loop), link(l)
+    {
+    }
+
+    ~ShardWakeup()
+    {
+      // StopShards detaches us, hold on to link
+      if(ILinkLayer* l = link)
+      {
+        l->StopShards();
+        l->m_ShardWakeup = nullptr;
+      }
+    }
+
+    void
+    OnRead(const llarp_buffer_t&) override
+    {
+      if(link)
+        link->DrainShards();
+    }
+
+    bool
+    tick() override
+    {
+      // detached, let the event loop delete us
+      if(link == nullptr)
+        return false;
+      return llarp_ev_pkt_pipe::tick();
+    }
+  };
+
   ILinkLayer::ILinkLayer(const SecretKey& routerEncSecret, GetRCFunc getrc,
                          LinkMessageHandler handler, SignBufferFunc signbuf,
                          SessionEstablishedHandler establishedSession,
@@ -23,6 +65,7 @@ namespace llarp
 
   ILinkLayer::~ILinkLayer()
   {
+    StopShards();
   }
 
   bool
@@ -104,9 +147,65 @@ namespace llarp
     else if(!GetIFAddr(ifname, m_ourAddr, af))
       return false;
     m_ourAddr.port(port);
+    // every member of the group must bind the same port so we can't shard an
+    // ephemeral one
+    if(m_NumShards > 1 && port)
+    {
+      if(llarp_ev_add_udp_shard(m_Loop.get(), &m_udp, m_ourAddr, 0,
+                                m_NumShards)
+         != -1)
+      {
+        for(size_t idx = 1; idx < m_NumShards; ++idx)
+        {
+          auto shard = std::make_unique< LinkShard >(idx, m_NumShards);
+          if(!shard->Bind(m_ourAddr, m_Loop->udp_batch_size))
+            return false;
+          m_Shards.emplace_back(std::move(shard));
+        }
+        LogInfo(Name(), " link on ", m_ourAddr, " reading on ", m_NumShards,
+                " threads");
+        return true;
+      }
+      LogWarn("cannot shard ", Name(), " link on ", m_ourAddr,
+              ", reading on 1 thread");
+      m_NumShards = 1;
+    }
     return llarp_ev_add_udp(m_Loop.get(), &m_udp, m_ourAddr) != -1;
   }
 
+  void
+  ILinkLayer::DrainShards()
+  {
+    for(const auto& shard : m_Shards)
+    {
+      shard->Drain([&](const Addr& from, const byte_t* buf, size_t sz) {
+        RecvFrom(from, buf, sz);
+      });
+    }
+    // a result can stop us and let go of the queue while it drains
+    if(auto results = m_Results)
+      results->Drain();
+  }
+
+  void
+  ILinkLayer::StopShards()
+  {
+    for(const auto& shard : m_Shards)
+      shard->Stop();
+    // jobs still running hold it until they finish and then drop their
+    // results
+    if(m_Results)
+    {
+      m_Results->Detach();
+      m_Results.reset();
+    }
+    if(m_ShardWakeup)
+    {
+      m_ShardWakeup->link = nullptr;
+      m_ShardWakeup       = nullptr;
+    }
+  }
+
   void
   ILinkLayer::Pump()
   {
@@ -209,9 +308,19 @@ namespace llarp
                      });
     }
 
+    std::vector< util::StatusObject > shards;
+    std::transform(m_Shards.cbegin(), m_Shards.cend(),
+                   std::back_inserter(shards),
+                   [](const auto& shard) -> util::StatusObject {
+                     return {{"index", uint64_t(shard->Index())},
+                             {"received", shard->Received()},
+                             {"dropped", shard->Dropped()}};
+                   });
+
     return {{"name", Name()},
             {"rank", uint64_t(Rank())},
             {"addr", m_ourAddr.ToString()},
+            {"shards", shards},
             {"sessions",
              util::StatusObject{{"pending", pending},
                                 {"established", established}}}};
@@ -238,6 +347,25 @@ namespace llarp
   {
     m_Logic = l;
     ScheduleTick(100);
+    if(m_Shards.empty() && m_CryptoWorker == nullptr)
+      return true;
+    auto wakeup = new ShardWakeup(this);
+    if(!wakeup->Start())
+    {
+      delete wakeup;
+      return false;
+    }
+    // add_ev frees it on failure
+    if(!m_Loop->add_ev(wakeup, false))
+      return false;
+    m_ShardWakeup = wakeup;
+    if(m_CryptoWorker)
+      m_Results = std::make_shared< LinkResultQueue >(OurCrypto(), wakeup);
+    for(const auto& shard : m_Shards)
+    {
+      if(!shard->Start(m_ShardWakeup))
+        return false;
+    }
     return true;
   }
 
@@ -270,6 +398,7 @@ namespace llarp
   {
     if(m_Logic && tick_id)
       m_Logic->remove_call(tick_id);
+    StopShards();
     {
       Lock l(&m_AuthedLinksMutex);
       auto itr = m_AuthedLinks.begin();
@@ -322,26 +451,33 @@ namespace llarp
   bool
   ILinkLayer::SendTo(const RouterID& remote, const llarp_buffer_t& buf)
   {
-    ILinkSession* s = nullptr;
-    {
-      Lock l(&m_AuthedLinksMutex);
-      auto range = m_AuthedLinks.equal_range(remote);
-      auto itr   = range.first;
-      // pick lowest backlog session
-      size_t min = std::numeric_limits< size_t >::max();
+    auto s = BestSessionTo(remote);
+    return s && s->SendMessageBuffer(buf);
+  }
+
+  std::shared_ptr< ILinkSession >
+  ILinkLayer::BestSessionTo(const RouterID& remote)
+  {
+    Lock l(&m_AuthedLinksMutex);
+    auto range = m_AuthedLinks.equal_range(remote);
+    auto itr   = range.first;
+    auto best  = range.second;
+    // pick lowest backlog session
+    size_t min = std::numeric_limits< size_t >::max();
 
-      while(itr != range.second)
+    while(itr != range.second)
+    {
+      auto backlog = itr->second->SendQueueBacklog();
+      if(backlog < min)
       {
-        auto backlog = itr->second->SendQueueBacklog();
-        if(backlog < min)
-        {
-          s   = itr->second.get();
-          min = backlog;
-        }
-        ++itr;
+        best = itr;
+        min  = backlog;
       }
+      ++itr;
     }
-    return s && s->SendMessageBuffer(buf);
+    if(best == range.second)
+      return nullptr;
+    return best->second;
   }
 
   bool
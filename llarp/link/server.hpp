@@ -4,15 +4,18 @@
 #include <crypto/types.hpp>
 #include <ev/ev.h>
 #include <link/session.hpp>
+#include <link/shard.hpp>
 #include <net/net.hpp>
 #include <router_contact.hpp>
 #include <util/logic.hpp>
 #include <util/threading.hpp>
+#include <util/threadpool.h>
 #include <util/status.hpp>
 
 #include <list>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace llarp
 {
@@ -82,7 +85,9 @@ namespace llarp
     static void
     udp_tick(llarp_udp_io* udp)
     {
-      static_cast< ILinkLayer* >(udp->user)->Pump();
+      ILinkLayer* self = static_cast< ILinkLayer* >(udp->user);
+      self->DrainShards();
+      self->Pump();
     }
 
     static void
@@ -106,6 +111,37 @@ namespace llarp
       llarp_ev_udp_sendto(&m_udp, to, pkt);
     }
 
+    /// read inbound traffic on num SO_REUSEPORT sockets, all but the first
+    /// get their own thread, call before Configure
+    void
+    SetShards(size_t num)
+    {
+      m_NumShards = std::max(size_t(1), num);
+    }
+
+    /// hand session decryption to worker, results come back on the logic
+    /// thread through Results(). without one sessions decrypt inline.
+    /// call before Start
+    void
+    SetCryptoWorker(llarp_threadpool* worker)
+    {
+      m_CryptoWorker = worker;
+    }
+
+    llarp_threadpool*
+    CryptoWorker() const
+    {
+      return m_CryptoWorker;
+    }
+
+    /// where crypto worker jobs hand their results back, null unless we
+    /// have a crypto worker and are started
+    const std::shared_ptr< LinkResultQueue >&
+    Results() const
+    {
+      return m_Results;
+    }
+
     bool
     Configure(llarp_ev_loop_ptr loop, const std::string& ifname, int af,
               uint16_t port);
@@ -146,6 +182,12 @@ namespace llarp
     bool
     SendTo(const RouterID& remote, const llarp_buffer_t& buf);
 
+    /// the session to remote with the smallest send backlog, the one SendTo
+    /// would use, or nullptr if we have none. callers sending to remote over
+    /// and over can keep a weak_ptr to it instead of looking remote up
+    std::shared_ptr< ILinkSession >
+    BestSessionTo(const RouterID& remote) LOCKS_EXCLUDED(m_AuthedLinksMutex);
+
     bool
     GetOurAddressInfo(AddressInfo& addr) const;
 
@@ -222,7 +264,25 @@ namespace llarp
     void
     ScheduleTick(uint64_t interval);
 
+    /// hand everything our shards have read to RecvFrom and run whatever
+    /// the crypto worker finished
+    void
+    DrainShards();
+
+    /// stop shard threads, drop crypto worker results and let go of the
+    /// wakeup pipe
+    void
+    StopShards();
+
+    struct ShardWakeup;
+
     uint32_t tick_id;
+    size_t m_NumShards = 1;
+    llarp_threadpool* m_CryptoWorker = nullptr;
+    std::shared_ptr< LinkResultQueue > m_Results;
+    std::vector< std::unique_ptr< LinkShard > > m_Shards;
+    /// owned by m_Loop
+    ShardWakeup* m_ShardWakeup = nullptr;
     const SecretKey& m_RouterEncSecret;
 
    protected:
@@ -13,6 +13,7 @@ namespace llarp
   struct LinkIntroMessage;
   struct ILinkMessage;
   struct ILinkLayer;
+  struct PacketBuffer;
   struct ILinkSession
   {
     virtual ~ILinkSession(){};
@@ -32,6 +33,14 @@ namespace llarp
     virtual bool
     SendMessageBuffer(const llarp_buffer_t &) = 0;
 
+    /// the pooled buffer holding the message we are currently handling, if
+    /// any, so decoders can share it instead of copying out of it
+    virtual const PacketBuffer *
+    CurrentRecvBuffer() const
+    {
+      return nullptr;
+    }
+
     /// start the connection
     virtual void
     Start() = 0;
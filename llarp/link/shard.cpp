@@ -0,0 +1,154 @@
+#include <link/shard.hpp>
+
+#include <ev/ev.hpp>
+#include <ev/pipe.hpp>
+#include <util/logger.hpp>
+
+namespace llarp
+{
+  LinkShard::LinkShard(size_t idx, size_t num)
+      : m_Index(idx)
+      , m_Num(num)
+      , m_Run(false)
+      , m_Signalled(false)
+      , m_Received(0)
+      , m_Dropped(0)
+      , m_Queue(QueueSize)
+  {
+    m_udp          = llarp_udp_io{};
+    m_udp.user     = this;
+    m_udp.recvfrom = &LinkShard::OnRecv;
+  }
+
+  LinkShard::~LinkShard()
+  {
+    Stop();
+  }
+
+  bool
+  LinkShard::Bind(const Addr& addr, size_t batch)
+  {
+    m_Loop = llarp_make_ev_loop();
+    llarp_ev_loop_set_udp_batch(m_Loop.get(), batch);
+    if(llarp_ev_add_udp_shard(m_Loop.get(), &m_udp, addr, m_Index, m_Num)
+       == -1)
+    {
+      LogError("failed to bind link shard ", m_Index, " on ", addr);
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  LinkShard::Start(llarp_ev_pkt_pipe* wakeup)
+  {
+    if(m_Thread || !m_Loop)
+      return false;
+    m_Wakeup = wakeup;
+    m_Run.store(true);
+    m_Thread = std::make_unique< std::thread >(std::bind(&LinkShard::Run, this));
+    return true;
+  }
+
+  void
+  LinkShard::Stop()
+  {
+    m_Run.store(false);
+    if(m_Thread)
+    {
+      m_Thread->join();
+      m_Thread.reset();
+    }
+    if(m_Loop)
+    {
+      llarp_ev_loop_stop(m_Loop.get());
+      m_Loop.reset();
+    }
+    m_Wakeup = nullptr;
+  }
+
+  void
+  LinkShard::Run()
+  {
+    while(m_Run.load())
+    {
+      m_Loop->update_time();
+      m_Loop->tick(EV_TICK_INTERVAL);
+    }
+  }
+
+  void
+  LinkShard::OnRecv(llarp_udp_io* udp, const sockaddr* from, ManagedBuffer buf)
+  {
+    LinkShard* self = static_cast< LinkShard* >(udp->user);
+    self->m_Received++;
+    const llarp_buffer_t& b = buf.underlying;
+    if(b.sz > MaxPacketSize)
+    {
+      self->m_Dropped++;
+      return;
+    }
+    Packet pkt;
+    pkt.from = Addr(*from);
+    pkt.sz   = b.sz;
+    std::copy_n(b.base, b.sz, pkt.buf.begin());
+    if(self->m_Queue.tryPushBack(std::move(pkt)) != thread::QueueReturn::Success)
+    {
+      self->m_Dropped++;
+      return;
+    }
+    // wake up the logic thread if it isn't already
+    if(self->m_Wakeup && !self->m_Signalled.exchange(true))
+    {
+      byte_t one = 1;
+      self->m_Wakeup->Write(llarp_buffer_t(&one, sizeof(one)));
+    }
+  }
+
+  constexpr size_t LinkResultQueue::QueueSize;
+
+  LinkResultQueue::LinkResultQueue(Crypto* c, llarp_ev_pkt_pipe* wakeup)
+      : crypto(c), m_Signalled(false), m_Wakeup(wakeup), m_Queue(QueueSize)
+  {
+  }
+
+  bool
+  LinkResultQueue::Push(Result result)
+  {
+    if(m_Queue.pushBack(std::move(result)) != thread::QueueReturn::Success)
+      return false;
+    if(!m_Signalled.exchange(true))
+    {
+      util::Lock lock(&m_WakeupMutex);
+      if(m_Wakeup)
+      {
+        byte_t one = 1;
+        m_Wakeup->Write(llarp_buffer_t(&one, sizeof(one)));
+      }
+    }
+    return true;
+  }
+
+  size_t
+  LinkResultQueue::Drain()
+  {
+    // clear before popping so a push racing with us signals again
+    m_Signalled.store(false);
+    size_t n = 0;
+    while(auto result = m_Queue.tryPopFront())
+    {
+      (*result)();
+      ++n;
+    }
+    return n;
+  }
+
+  void
+  LinkResultQueue::Detach()
+  {
+    m_Queue.disable();
+    util::Lock lock(&m_WakeupMutex);
+    m_Wakeup = nullptr;
+  }
+
+}  // namespace llarp
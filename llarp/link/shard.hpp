@@ -0,0 +1,153 @@
+#ifndef LLARP_LINK_SHARD_HPP
+#define LLARP_LINK_SHARD_HPP
+
+#include <ev/ev.h>
+#include <net/net_addr.hpp>
+#include <util/queue.hpp>
+#include <util/threading.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+struct llarp_ev_pkt_pipe;
+
+namespace llarp
+{
+  struct Crypto;
+
+  /// one extra member of a link layer's SO_REUSEPORT socket group
+  ///
+  /// each shard owns its own event loop and thread which does the udp reads
+  /// for the remotes the kernel steers to it, datagrams are then handed to
+  /// the link layer's logic thread through a lock free queue
+  struct LinkShard
+  {
+    /// biggest datagram we hand over, anything bigger is dropped
+    static constexpr size_t MaxPacketSize = 1500;
+    /// how many datagrams can be waiting for the logic thread
+    static constexpr size_t QueueSize = 512;
+
+    struct Packet
+    {
+      Addr from;
+      size_t sz = 0;
+      std::array< byte_t, MaxPacketSize > buf;
+    };
+
+    LinkShard(size_t idx, size_t num);
+
+    ~LinkShard();
+
+    /// bind our member socket, must be done in order of idx
+    bool
+    Bind(const Addr& addr, size_t batch);
+
+    /// start reading on our own thread, wakeup is written to whenever the
+    /// queue goes from empty to non empty
+    bool
+    Start(llarp_ev_pkt_pipe* wakeup);
+
+    /// stop our thread
+    void
+    Stop();
+
+    /// hand every queued datagram to visit, call from the logic thread
+    template < typename Visit >
+    size_t
+    Drain(Visit visit)
+    {
+      // clear before popping so a push racing with us signals again
+      m_Signalled.store(false);
+      size_t n = 0;
+      while(auto pkt = m_Queue.tryPopFront())
+      {
+        visit(pkt->from, pkt->buf.data(), pkt->sz);
+        ++n;
+      }
+      return n;
+    }
+
+    size_t
+    Index() const
+    {
+      return m_Index;
+    }
+
+    /// datagrams read on this shard
+    uint64_t
+    Received() const
+    {
+      return m_Received.load();
+    }
+
+    /// datagrams dropped because the queue was full or they were too big
+    uint64_t
+    Dropped() const
+    {
+      return m_Dropped.load();
+    }
+
+   private:
+    static void
+    OnRecv(llarp_udp_io* udp, const sockaddr* from, ManagedBuffer buf);
+
+    void
+    Run();
+
+    const size_t m_Index;
+    const size_t m_Num;
+    llarp_ev_loop_ptr m_Loop;
+    llarp_udp_io m_udp;
+    llarp_ev_pkt_pipe* m_Wakeup = nullptr;
+    std::unique_ptr< std::thread > m_Thread;
+    std::atomic< bool > m_Run;
+    std::atomic< bool > m_Signalled;
+    std::atomic< uint64_t > m_Received;
+    std::atomic< uint64_t > m_Dropped;
+    thread::Queue< Packet > m_Queue;
+  };
+
+  /// jobs a link's crypto worker finished, waiting for the logic thread
+  ///
+  /// workers push onto a lock free queue and wake the logic thread through
+  /// the same pipe the shards use. jobs only hold this weakly and keep it
+  /// alive while they run, once the link stops whatever they hand back is
+  /// dropped.
+  struct LinkResultQueue
+  {
+    using Result = std::function< void() >;
+
+    /// how many results can be waiting before workers block
+    static constexpr size_t QueueSize = 1024;
+
+    LinkResultQueue(Crypto* c, llarp_ev_pkt_pipe* wakeup);
+
+    /// the link's crypto, jobs use it while they hold this
+    Crypto* const crypto;
+
+    /// hand result to the logic thread, waits while the queue is full.
+    /// false once the link stopped.
+    bool
+    Push(Result result);
+
+    /// run every queued result, call from the logic thread
+    size_t
+    Drain();
+
+    /// the link stopped, refuse results and never touch the pipe again
+    void
+    Detach();
+
+   private:
+    std::atomic< bool > m_Signalled;
+    /// only taken to wake the logic thread, never to queue
+    util::Mutex m_WakeupMutex;
+    llarp_ev_pkt_pipe* m_Wakeup GUARDED_BY(m_WakeupMutex);
+    thread::Queue< Result > m_Queue;
+  };
+}  // namespace llarp
+
+#endif
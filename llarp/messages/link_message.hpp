@@ -12,6 +12,16 @@ namespace llarp
   struct ILinkSession;
   struct AbstractRouter;
 
+  /// order link messages go out in when a peer is backed up
+  enum LinkMessagePriority
+  {
+    /// path builds, dht and session control
+    eLinkControl = 0,
+    /// relayed path traffic
+    eLinkBulk = 1,
+    eLinkNumPriorities
+  };
+
   /// parsed link layer message
   struct ILinkMessage : public IBEncodeMessage
   {
@@ -34,6 +44,13 @@ namespace llarp
     // the name of this kind of message
     virtual const char*
     Name() const = 0;
+
+    /// which class this message is queued in when the peer is backed up
+    virtual LinkMessagePriority
+    Priority() const
+    {
+      return eLinkControl;
+    }
   };
 
 }  // namespace llarp
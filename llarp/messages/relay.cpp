@@ -1,11 +1,37 @@
 #include <messages/relay.hpp>
 
+#include <link/session.hpp>
 #include <path/path.hpp>
 #include <router/abstractrouter.hpp>
 #include <util/bencode.hpp>
 
 namespace llarp
 {
+  /// read the onion payload, sharing the link session's inbound buffer when
+  /// it has one instead of copying out of it
+  static bool
+  DecodePayload(const ILinkSession *session, PacketBuffer &X, bool &read,
+                const llarp_buffer_t &key, llarp_buffer_t *buf)
+  {
+    if(!(key == "x"))
+      return true;
+    llarp_buffer_t strbuf;
+    if(!bencode_read_string(buf, &strbuf))
+      return false;
+    if(strbuf.sz > MaxRelayPayloadSize)
+      return false;
+    const PacketBuffer *inbound =
+        session ? session->CurrentRecvBuffer() : nullptr;
+    if(inbound)
+      X = inbound->SliceOrCopy(strbuf);
+    else
+      X = PacketBuffer::Copy(strbuf);
+    if(X.IsEmpty())
+      return false;
+    read = true;
+    return true;
+  }
+
   RelayUpstreamMessage::RelayUpstreamMessage() : ILinkMessage()
   {
   }
@@ -51,7 +77,7 @@ namespace llarp
     if(!BEncodeMaybeReadVersion("v", version, LLARP_PROTO_VERSION, read, key,
                                 buf))
       return false;
-    if(!BEncodeMaybeReadDictEntry("x", X, read, key, buf))
+    if(!DecodePayload(session, X, read, key, buf))
       return false;
     if(!BEncodeMaybeReadDictEntry("y", Y, read, key, buf))
       return false;
@@ -64,7 +90,10 @@ namespace llarp
     auto path = r->pathContext().GetByDownstream(session->GetPubKey(), pathid);
     if(path)
     {
-      return path->HandleUpstream(llarp_buffer_t(X), Y, r);
+      // peel the onion in place, X is a slice of the session's inbound
+      // message which nothing reads once it is handled
+      PacketBuffer payload = X;
+      return path->HandleUpstream(payload, Y, r);
     }
     return false;
   }
@@ -114,7 +143,7 @@ namespace llarp
     if(!BEncodeMaybeReadVersion("v", version, LLARP_PROTO_VERSION, read, key,
                                 buf))
       return false;
-    if(!BEncodeMaybeReadDictEntry("x", X, read, key, buf))
+    if(!DecodePayload(session, X, read, key, buf))
       return false;
     if(!BEncodeMaybeReadDictEntry("y", Y, read, key, buf))
       return false;
@@ -127,7 +156,10 @@ namespace llarp
     auto path = r->pathContext().GetByUpstream(session->GetPubKey(), pathid);
     if(path)
     {
-      return path->HandleDownstream(llarp_buffer_t(X), Y, r);
+      // peel the onion in place, X is a slice of the session's inbound
+      // message which nothing reads once it is handled
+      PacketBuffer payload = X;
+      return path->HandleDownstream(payload, Y, r);
     }
     llarp::LogWarn("unhandled downstream message");
     return false;
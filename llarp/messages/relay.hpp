@@ -1,19 +1,22 @@
 #ifndef LLARP_MESSAGES_RELAY_HPP
 #define LLARP_MESSAGES_RELAY_HPP
 
-#include <crypto/encrypted.hpp>
 #include <crypto/types.hpp>
 #include <messages/link_message.hpp>
 #include <path/path_types.hpp>
+#include <util/packet_buffer.hpp>
 
 #include <vector>
 
 namespace llarp
 {
+  /// biggest onion payload a relay message carries
+  constexpr size_t MaxRelayPayloadSize = MAX_LINK_MSG_SIZE - 128;
+
   struct RelayUpstreamMessage : public ILinkMessage
   {
     PathID_t pathid;
-    Encrypted< MAX_LINK_MSG_SIZE - 128 > X;
+    PacketBuffer X;
     TunnelNonce Y;
 
     RelayUpstreamMessage();
@@ -37,12 +40,18 @@ namespace llarp
     {
       return "RelayUpstream";
     }
+
+    LinkMessagePriority
+    Priority() const override
+    {
+      return eLinkBulk;
+    }
   };
 
   struct RelayDownstreamMessage : public ILinkMessage
   {
     PathID_t pathid;
-    Encrypted< MAX_LINK_MSG_SIZE - 128 > X;
+    PacketBuffer X;
     TunnelNonce Y;
     RelayDownstreamMessage();
     RelayDownstreamMessage(ILinkSession* from);
@@ -65,6 +74,12 @@ namespace llarp
     {
       return "RelayDownstream";
     }
+
+    LinkMessagePriority
+    Priority() const override
+    {
+      return eLinkBulk;
+    }
   };
 }  // namespace llarp
 
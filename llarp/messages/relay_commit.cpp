@@ -1,12 +1,14 @@
 #include <messages/relay_commit.hpp>
 
 #include <messages/path_confirm.hpp>
+#include <path/build_pipeline.hpp>
 #include <path/path.hpp>
 #include <router/abstractrouter.hpp>
 #include <util/bencode.hpp>
 #include <util/buffer.hpp>
 #include <util/logger.hpp>
 #include <util/logic.hpp>
+#include <util/time.hpp>
 #include <nodedb.hpp>
 
 namespace llarp
@@ -191,6 +193,8 @@ namespace llarp
     LR_CommitRecord record;
     // the actual hop
     std::shared_ptr< Hop > hop;
+    // when we got the commit
+    llarp_time_t started;
 
     LRCMFrameDecrypt(Context* ctx, Decrypter* dec,
                      const LR_CommitMessage* commit)
@@ -198,6 +202,7 @@ namespace llarp
         , frames(commit->frames)
         , context(ctx)
         , hop(std::make_shared< Hop >())
+        , started(time_now_ms())
     {
       hop->info.downstream = commit->session->GetPubKey();
     }
@@ -212,6 +217,8 @@ namespace llarp
     {
       std::shared_ptr< LRCMFrameDecrypt > self(
           static_cast< LRCMFrameDecrypt* >(user));
+      path::BuildPipeline::RecordLatency("transit_ms", self->started,
+                                         time_now_ms());
       if(!self->context->Router()->ConnectionToRouterAllowed(
              self->hop->info.upstream))
       {
@@ -268,6 +275,8 @@ namespace llarp
     {
       std::unique_ptr< LRCMFrameDecrypt > self(
           static_cast< LRCMFrameDecrypt* >(user));
+      path::BuildPipeline::RecordLatency("transit_ms", self->started,
+                                         time_now_ms());
       // persist session to downstream until path expiration
       self->context->Router()->PersistSessionUntil(
           self->hop->info.downstream, self->hop->ExpireTime() + 10000);
@@ -386,8 +395,10 @@ namespace llarp
     // copy frames so we own them
     LRCMFrameDecrypt* frames = new LRCMFrameDecrypt(context, decrypter, this);
 
-    // decrypt frames async
-    decrypter->AsyncDecrypt(context->Worker(), frames->frames[0], frames);
+    // decrypt frames async, batched with the rest of this build storm
+    context->Pipeline().Queue([decrypter, frames]() {
+      decrypter->DecryptNow(frames->frames[0], frames);
+    });
     return true;
   }
 }  // namespace llarp
@@ -138,6 +138,16 @@ namespace llarp
             result.emplace_back(addName(id, "max", suffix),
                                 std::to_string(record.max()), time);
           }
+          if(record.quantiles())
+          {
+            const auto &quantiles = *record.quantiles();
+            for(size_t i = 0; i < Record::NUM_QUANTILES; ++i)
+            {
+              result.emplace_back(
+                  addName(id, Record::QUANTILE_NAMES[i], suffix),
+                  std::to_string(quantiles[i]), time);
+            }
+          }
         }
         return result;
       }
@@ -0,0 +1,123 @@
+#include <metrics/prometheus.hpp>
+
+#include <util/logger.hpp>
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <set>
+
+namespace llarp
+{
+  namespace metrics
+  {
+    const char PROMETHEUS_CONTENT_TYPE[] = "text/plain; version=0.0.4";
+
+    namespace
+    {
+      void
+      appendName(std::string& out, string_view name)
+      {
+        for(char c : name)
+        {
+          const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+              || (c >= '0' && c <= '9');
+          out.push_back(ok ? c : '_');
+        }
+      }
+
+      /// the series a record called name writes, a summary and a gauge
+      /// each for its min and max
+      std::array< std::string, 5 >
+      seriesNames(const std::string& name)
+      {
+        return {{name, name + "_sum", name + "_count", name + "_min",
+                 name + "_max"}};
+      }
+
+      /// name, or name with a number on the end if a record written before
+      /// already took one of its series
+      std::string
+      uniqueName(std::set< std::string >& used, const std::string& name)
+      {
+        std::string unique = name;
+        for(size_t n = 2;; ++n)
+        {
+          const auto series = seriesNames(unique);
+          if(std::none_of(series.begin(), series.end(),
+                          [&](const std::string& s) { return used.count(s); }))
+          {
+            used.insert(series.begin(), series.end());
+            return unique;
+          }
+          unique = name + "_" + std::to_string(n);
+        }
+      }
+
+      void
+      writeRecord(std::ostream& stream, const Record& record,
+                  const std::string& name)
+      {
+        // sum and count only ever go up, which is a summary whether or not
+        // there are quantiles
+        stream << "# TYPE " << name << " summary\n";
+        if(record.quantiles())
+        {
+          const auto& quantiles = *record.quantiles();
+          for(size_t i = 0; i < Record::NUM_QUANTILES; ++i)
+          {
+            stream << name << "{quantile=\"" << Record::QUANTILES[i]
+                   << "\"} " << quantiles[i] << '\n';
+          }
+        }
+        stream << name << "_sum " << record.total() << '\n';
+        stream << name << "_count " << record.count() << '\n';
+        // a summary has no min or max, they are gauges of their own
+        if(Record::DEFAULT_MIN != record.min())
+        {
+          stream << "# TYPE " << name << "_min gauge\n";
+          stream << name << "_min " << record.min() << '\n';
+        }
+        if(Record::DEFAULT_MAX != record.max())
+        {
+          stream << "# TYPE " << name << "_max gauge\n";
+          stream << name << "_max " << record.max() << '\n';
+        }
+      }
+    }  // namespace
+
+    std::string
+    prometheusName(const Id& id)
+    {
+      std::string name = "lokinet_";
+      appendName(name, id.categoryName());
+      name.push_back('_');
+      appendName(name, id.metricName());
+      return name;
+    }
+
+    void
+    prometheusText(std::ostream& stream, CollectorRepo& repo)
+    {
+      std::set< std::string > used;
+      for(const Category* category : repo.registry().getAll())
+      {
+        if(!category->enabled())
+        {
+          continue;
+        }
+        for(const Record& record : repo.collectTotals(category))
+        {
+          const std::string name = prometheusName(record.id());
+          const std::string unique = uniqueName(used, name);
+          if(unique != name)
+          {
+            LogDebug("metric ", record.id(), " is exported as ", unique,
+                     " since ", name, " is taken");
+          }
+          writeRecord(stream, record, unique);
+        }
+      }
+    }
+  }  // namespace metrics
+}  // namespace llarp
@@ -0,0 +1,33 @@
+#ifndef LLARP_METRICS_PROMETHEUS_HPP
+#define LLARP_METRICS_PROMETHEUS_HPP
+
+#include <util/metrics_core.hpp>
+
+#include <iosfwd>
+#include <string>
+
+namespace llarp
+{
+  namespace metrics
+  {
+    /// content type of prometheusText's output
+    extern const char PROMETHEUS_CONTENT_TYPE[];
+
+    /// the metric name prometheus sees for id, "lokinet_<category>_<name>"
+    /// with everything outside [a-zA-Z0-9_] turned into '_'
+    std::string
+    prometheusName(const Id& id);
+
+    /// write the totals of the collectors of every enabled category in repo
+    /// in the prometheus text exposition format, for scrapers to pull. they
+    /// count everything ticked since the collectors were made, whatever the
+    /// publishers cleared in between, so sums and counts never go down.
+    /// every record is a summary, with its min and max as gauges beside it.
+    /// when two ids sanitise to the same name, such as "a.b" and "a_b", the
+    /// one written later gets "_2", "_3"... on the end.
+    void
+    prometheusText(std::ostream& stream, CollectorRepo& repo);
+  }  // namespace metrics
+}  // namespace llarp
+
+#endif
@@ -129,6 +129,15 @@ namespace llarp
             stream << ", max = ";
             formatValue(stream, record.max(), maxSpec);
           }
+          if(record.quantiles())
+          {
+            const auto &quantiles = *record.quantiles();
+            for(size_t i = 0; i < Record::NUM_QUANTILES; ++i)
+            {
+              stream << ", " << Record::QUANTILE_NAMES[i] << " = ";
+              formatValue(stream, quantiles[i], maxSpec);
+            }
+          }
         }
         stream << " ]\n";
       }
@@ -208,6 +217,14 @@ namespace llarp
           {
             result["max"] = record.max();
           }
+          if(record.quantiles())
+          {
+            const auto &quantiles = *record.quantiles();
+            for(size_t i = 0; i < Record::NUM_QUANTILES; ++i)
+            {
+              result[Record::QUANTILE_NAMES[i]] = quantiles[i];
+            }
+          }
         }
 
         return result;
@@ -0,0 +1,230 @@
+#include <net/checksum.hpp>
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LLARP_CHECKSUM_X86 1
+#include <immintrin.h>
+#endif
+
+namespace llarp
+{
+  namespace net
+  {
+    using SumFunc = uint64_t (*)(const byte_t*, size_t, uint64_t);
+
+    /// one's complement add, the carry out wraps around to the bottom
+    static inline uint64_t
+    AddCarry(uint64_t sum, uint64_t w)
+    {
+      sum += w;
+      return sum + (sum < w);
+    }
+
+    /// add up whatever is left after the wide loads, sz < 8
+    static uint64_t
+    SumTail(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      if(sz >= 4)
+      {
+        uint32_t w;
+        std::memcpy(&w, buf, 4);
+        sum = AddCarry(sum, w);
+        buf += 4;
+        sz -= 4;
+      }
+      if(sz >= 2)
+      {
+        uint16_t w;
+        std::memcpy(&w, buf, 2);
+        sum = AddCarry(sum, w);
+        buf += 2;
+        sz -= 2;
+      }
+      if(sz)
+      {
+        // an odd byte is padded with a zero byte after it
+        uint16_t w = 0;
+        std::memcpy(&w, buf, 1);
+        sum = AddCarry(sum, w);
+      }
+      return sum;
+    }
+
+    /// the words of buf are summed in memory order, which gives the same
+    /// checksum bytes on either endianness (rfc 1071 section 2b). wider
+    /// loads just sum four words at once, folding takes care of that.
+    static uint64_t
+    SumScalar(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      // two chains so the carries of one don't hold up the other
+      uint64_t other = 0;
+      while(sz >= 16)
+      {
+        uint64_t w[2];
+        std::memcpy(w, buf, 16);
+        sum   = AddCarry(sum, w[0]);
+        other = AddCarry(other, w[1]);
+        buf += 16;
+        sz -= 16;
+      }
+      sum = AddCarry(sum, other);
+      if(sz >= 8)
+      {
+        uint64_t w;
+        std::memcpy(&w, buf, 8);
+        sum = AddCarry(sum, w);
+        buf += 8;
+        sz -= 8;
+      }
+      return SumTail(buf, sz, sum);
+    }
+
+#ifdef LLARP_CHECKSUM_X86
+    __attribute__((target("sse2"))) static uint64_t
+    SumSSE2(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i acc0       = zero;
+      __m128i acc1       = zero;
+      while(sz >= 32)
+      {
+        const __m128i v0 =
+            _mm_loadu_si128(reinterpret_cast< const __m128i* >(buf));
+        const __m128i v1 =
+            _mm_loadu_si128(reinterpret_cast< const __m128i* >(buf + 16));
+        // widen each 32 bit word into a 64 bit lane so nothing carries out
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v0, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v0, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v1, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v1, zero));
+        buf += 32;
+        sz -= 32;
+      }
+      uint64_t lanes[2];
+      _mm_storeu_si128(reinterpret_cast< __m128i* >(lanes),
+                       _mm_add_epi64(acc0, acc1));
+      return SumScalar(buf, sz, sum + lanes[0] + lanes[1]);
+    }
+
+    __attribute__((target("avx2"))) static uint64_t
+    SumAVX2(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      __m256i acc0       = zero;
+      __m256i acc1       = zero;
+      while(sz >= 64)
+      {
+        const __m256i v0 =
+            _mm256_loadu_si256(reinterpret_cast< const __m256i* >(buf));
+        const __m256i v1 =
+            _mm256_loadu_si256(reinterpret_cast< const __m256i* >(buf + 32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+        buf += 64;
+        sz -= 64;
+      }
+      uint64_t lanes[4];
+      _mm256_storeu_si256(reinterpret_cast< __m256i* >(lanes),
+                          _mm256_add_epi64(acc0, acc1));
+      sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+      // the rest runs legacy sse code, which stalls on dirty upper halves
+      _mm256_zeroupper();
+      return SumSSE2(buf, sz, sum);
+    }
+#endif
+
+    static SumFunc
+    GetSumFunc(ChecksumKernel kernel)
+    {
+      switch(kernel)
+      {
+#ifdef LLARP_CHECKSUM_X86
+        case ChecksumKernel::AVX2:
+          return &SumAVX2;
+        case ChecksumKernel::SSE2:
+          return &SumSSE2;
+#endif
+        default:
+          return &SumScalar;
+      }
+    }
+
+    static nuint16_t
+    Fold(uint64_t sum)
+    {
+      // only need to do it 2 times to be sure at each width
+      // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
+      sum = (sum & 0xFFffFFff) + (sum >> 32);
+      sum = (sum & 0xFFffFFff) + (sum >> 32);
+      sum = (sum & 0xFFff) + (sum >> 16);
+      sum = (sum & 0xFFff) + (sum >> 16);
+      sum = (sum & 0xFFff) + (sum >> 16);
+      return nuint16_t{uint16_t((~sum) & 0xFFff)};
+    }
+
+    bool
+    ChecksumKernelSupported(ChecksumKernel kernel)
+    {
+#ifdef LLARP_CHECKSUM_X86
+      // may run before the cpu model is set up during static init
+      __builtin_cpu_init();
+#endif
+      switch(kernel)
+      {
+        case ChecksumKernel::Scalar:
+          return true;
+#ifdef LLARP_CHECKSUM_X86
+        case ChecksumKernel::SSE2:
+          return __builtin_cpu_supports("sse2");
+        case ChecksumKernel::AVX2:
+          return __builtin_cpu_supports("avx2");
+#endif
+        default:
+          return false;
+      }
+    }
+
+    ChecksumKernel
+    BestChecksumKernel()
+    {
+      static const ChecksumKernel best = []() {
+        for(auto kernel : {ChecksumKernel::AVX2, ChecksumKernel::SSE2})
+          if(ChecksumKernelSupported(kernel))
+            return kernel;
+        return ChecksumKernel::Scalar;
+      }();
+      return best;
+    }
+
+    const char*
+    ChecksumKernelName(ChecksumKernel kernel)
+    {
+      switch(kernel)
+      {
+        case ChecksumKernel::SSE2:
+          return "sse2";
+        case ChecksumKernel::AVX2:
+          return "avx2";
+        default:
+          return "scalar";
+      }
+    }
+
+    nuint16_t
+    ipchksum(const byte_t* buf, size_t sz, uint32_t sum)
+    {
+      static const SumFunc best = GetSumFunc(BestChecksumKernel());
+      return Fold(best(buf, sz, sum));
+    }
+
+    nuint16_t
+    ipchksum(ChecksumKernel kernel, const byte_t* buf, size_t sz,
+             uint32_t sum)
+    {
+      return Fold(GetSumFunc(kernel)(buf, sz, sum));
+    }
+  }  // namespace net
+}  // namespace llarp
@@ -0,0 +1,53 @@
+#ifndef LLARP_NET_CHECKSUM_HPP
+#define LLARP_NET_CHECKSUM_HPP
+
+#include <net/net_int.hpp>
+#include <util/types.hpp>
+
+namespace llarp
+{
+  namespace net
+  {
+    /// implementations of the one's complement sum, picked at runtime from
+    /// what the cpu supports
+    enum class ChecksumKernel
+    {
+      Scalar,
+      SSE2,
+      AVX2
+    };
+
+    /// whether this build and this cpu can run kernel
+    bool
+    ChecksumKernelSupported(ChecksumKernel kernel);
+
+    /// the fastest kernel this cpu supports, used by ipchksum
+    ChecksumKernel
+    BestChecksumKernel();
+
+    const char*
+    ChecksumKernelName(ChecksumKernel kernel);
+
+    /// internet checksum (rfc 1071) of buf, starting from the unfolded
+    /// partial sum sum. the result is in network order, ready to be written
+    /// into a header.
+    nuint16_t
+    ipchksum(const byte_t* buf, size_t sz, uint32_t sum = 0);
+
+    /// ipchksum with a given kernel, which must be supported
+    nuint16_t
+    ipchksum(ChecksumKernel kernel, const byte_t* buf, size_t sz,
+             uint32_t sum = 0);
+
+    /// partial sum of the ipv4 pseudo header for a tcp or udp checksum
+    inline uint32_t
+    ipchksum_pseudoIPv4(nuint32_t src, nuint32_t dst, uint8_t proto,
+                        uint16_t innerlen)
+    {
+      return (src.n & 0xFFff) + (src.n >> 16) + (dst.n & 0xFFff)
+          + (dst.n >> 16) + htons(proto) + htons(innerlen);
+    }
+  }  // namespace net
+}  // namespace llarp
+
+#endif
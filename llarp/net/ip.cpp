@@ -15,79 +15,82 @@ namespace llarp
 {
   namespace net
   {
+    constexpr size_t IPPacket::MaxSize;
+
+    IPPacket::IPPacket(const IPPacket &other) : timestamp(other.timestamp)
+    {
+      if(!other.m_Data.IsEmpty())
+        m_Data = PacketBuffer::Copy(other.ConstBuffer());
+    }
+
+    IPPacket &
+    IPPacket::operator=(const IPPacket &other)
+    {
+      if(this != &other)
+      {
+        timestamp = other.timestamp;
+        if(other.m_Data.IsEmpty())
+          m_Data.Clear();
+        else
+          Load(other.ConstBuffer());
+      }
+      return *this;
+    }
+
     bool
-    IPv4Packet::Load(const llarp_buffer_t &pkt)
+    IPPacket::Load(const llarp_buffer_t &pkt)
     {
-      if(pkt.sz > sizeof(buf))
+      if(pkt.sz > MaxSize)
         return false;
-      sz = pkt.sz;
-      memcpy(buf, pkt.base, sz);
+      // never shared since copies are deep, so writing over it is fine. a
+      // bigger packet needs a block from a bigger size class
+      if(m_Data.IsEmpty() || m_Data.Capacity() < pkt.sz)
+        m_Data = PacketBuffer::Alloc(pkt.sz);
+      else if(!m_Data.Resize(pkt.sz))
+        return false;
+      if(m_Data.IsEmpty())
+        return false;
+      if(pkt.sz)
+        memcpy(m_Data.data(), pkt.base, pkt.sz);
       return true;
     }
 
     llarp_buffer_t
-    IPv4Packet::ConstBuffer() const
+    IPPacket::ConstBuffer() const
     {
-      return {buf, sz};
+      return {m_Data.data(), m_Data.size()};
     }
 
     llarp_buffer_t
-    IPv4Packet::Buffer()
+    IPPacket::Buffer()
     {
-      return {buf, sz};
+      return {m_Data.data(), m_Data.size()};
     }
 
-#if 0
+    /// partial sum of two addresses, adding it to a checksum takes the
+    /// addresses out of it
     static uint32_t
-    ipchksum_pseudoIPv4(nuint32_t src_ip, nuint32_t dst_ip, uint8_t proto,
-                        uint16_t innerlen)
+    addIPv4Sum(nuint32_t src_ip, nuint32_t dst_ip)
     {
-#define IPCS(x) ((uint32_t)(x & 0xFFff) + (uint32_t)(x >> 16))
-      uint32_t sum = IPCS(src_ip.n) + IPCS(dst_ip.n) + (uint32_t)proto
-          + (uint32_t)htons(innerlen);
-#undef IPCS
-      return sum;
+#define ADDIPCS(x) ((uint32_t)(x.n & 0xFFff) + (uint32_t)(x.n >> 16))
+      return ADDIPCS(src_ip) + ADDIPCS(dst_ip);
+#undef ADDIPCS
     }
 
-    static uint16_t
-    ipchksum(const byte_t *buf, size_t sz, uint32_t sum = 0)
+    /// partial sum of the complement of two addresses, adding it to a
+    /// checksum puts the addresses into it
+    static uint32_t
+    subIPv4Sum(nuint32_t src_ip, nuint32_t dst_ip)
     {
-      while(sz > 1)
-      {
-        sum += *(const uint16_t *)buf;
-        sz -= sizeof(uint16_t);
-        buf += sizeof(uint16_t);
-      }
-      if(sz != 0)
-      {
-        uint16_t x = 0;
-
-        *(byte_t *)&x = *(const byte_t *)buf;
-        sum += x;
-      }
-
-      // only need to do it 2 times to be sure
-      // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
-      sum = (sum & 0xFFff) + (sum >> 16);
-      sum += sum >> 16;
-
-      return uint16_t((~sum) & 0xFFff);
+#define SUBIPCS(x) ((uint32_t)((~x.n) & 0xFFff) + (uint32_t)((~x.n) >> 16))
+      return SUBIPCS(src_ip) + SUBIPCS(dst_ip);
+#undef SUBIPCS
     }
-#endif
 
     static nuint16_t
-    deltaIPv4Checksum(nuint16_t old_sum, nuint32_t old_src_ip,
-                      nuint32_t old_dst_ip, nuint32_t new_src_ip,
-                      nuint32_t new_dst_ip)
+    deltaIPv4Checksum(nuint16_t old_sum, uint32_t delta)
     {
-#define ADDIPCS(x) ((uint32_t)(x.n & 0xFFff) + (uint32_t)(x.n >> 16))
-#define SUBIPCS(x) ((uint32_t)((~x.n) & 0xFFff) + (uint32_t)((~x.n) >> 16))
-
-      uint32_t sum = uint32_t(old_sum.n) + ADDIPCS(old_src_ip)
-          + ADDIPCS(old_dst_ip) + SUBIPCS(new_src_ip) + SUBIPCS(new_dst_ip);
-
-#undef ADDIPCS
-#undef SUBIPCS
+      uint32_t sum = uint32_t(old_sum.n) + delta;
 
       // only need to do it 2 times to be sure
       // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
@@ -98,16 +101,15 @@ namespace llarp
     }
 
     static void
-    checksumDstIPv4TCP(byte_t *pld, ABSL_ATTRIBUTE_UNUSED size_t psz,
-                       size_t fragoff, size_t chksumoff, nuint32_t oSrcIP,
-                       nuint32_t oDstIP, nuint32_t nSrcIP, nuint32_t nDstIP)
+    checksumIPv4TCP(byte_t *pld, ABSL_ATTRIBUTE_UNUSED size_t psz,
+                    size_t fragoff, size_t chksumoff, uint32_t delta)
     {
       if(fragoff > chksumoff)
         return;
 
       auto check = (nuint16_t *)(pld + chksumoff - fragoff);
 
-      *check = deltaIPv4Checksum(*check, oSrcIP, oDstIP, nSrcIP, nDstIP);
+      *check = deltaIPv4Checksum(*check, delta);
       // usually, TCP checksum field cannot be 0xFFff,
       // because one's complement addition cannot result in 0x0000,
       // and there's inversion in the end;
@@ -117,9 +119,8 @@ namespace llarp
     }
 
     static void
-    checksumDstIPv4UDP(byte_t *pld, ABSL_ATTRIBUTE_UNUSED size_t psz,
-                       size_t fragoff, nuint32_t oSrcIP, nuint32_t oDstIP,
-                       nuint32_t nSrcIP, nuint32_t nDstIP)
+    checksumIPv4UDP(byte_t *pld, ABSL_ATTRIBUTE_UNUSED size_t psz,
+                    size_t fragoff, uint32_t delta)
     {
       if(fragoff > 6)
         return;
@@ -128,7 +129,7 @@ namespace llarp
       if(check->n == 0x0000)
         return;  // 0 is used to indicate "no checksum", don't change
 
-      *check = deltaIPv4Checksum(*check, oSrcIP, oDstIP, nSrcIP, nDstIP);
+      *check = deltaIPv4Checksum(*check, delta);
       // 0 is used to indicate "no checksum"
       // 0xFFff and 0 are equivalent in one's complement math
       // 0xFFff + 1 = 0x10000 -> 0x0001 (same as 0 + 1)
@@ -139,43 +140,43 @@ namespace llarp
       //   check->n = 0xFFff;
     }
 
-    void
-    IPv4Packet::UpdateIPv4PacketOnDst(huint32_t newSrcIP, huint32_t newDstIP)
+    /// swap the addresses of pkt for nSrcIP and nDstIP, fixing up the ip
+    /// and l4 checksums. newSum is subIPv4Sum of the new addresses.
+    static void
+    rewriteIPv4(IPPacket &pkt, nuint32_t nSrcIP, nuint32_t nDstIP,
+                uint32_t newSum)
     {
-      auto hdr = Header();
+      if(!pkt.IsV4())
+        return;
+      auto hdr = pkt.Header();
 
-      auto oSrcIP = nuint32_t{hdr->saddr};
-      auto oDstIP = nuint32_t{hdr->daddr};
-      auto nSrcIP = xhtonl(newSrcIP);
-      auto nDstIP = xhtonl(newDstIP);
+      const uint32_t delta =
+          addIPv4Sum(nuint32_t{hdr->saddr}, nuint32_t{hdr->daddr}) + newSum;
 
       // IPv4 checksum
       auto v4chk = (nuint16_t *)&(hdr->check);
-      *v4chk     = deltaIPv4Checksum(*v4chk, oSrcIP, oDstIP, nSrcIP, nDstIP);
+      *v4chk     = deltaIPv4Checksum(*v4chk, delta);
 
       // L4 checksum
       auto ihs = size_t(hdr->ihl * 4);
-      if(ihs <= sz)
+      if(ihs <= pkt.size())
       {
-        auto pld = buf + ihs;
-        auto psz = sz - ihs;
+        auto pld = pkt.data() + ihs;
+        auto psz = pkt.size() - ihs;
 
         auto fragoff = size_t((ntohs(hdr->frag_off) & 0x1Fff) * 8);
 
         switch(hdr->protocol)
         {
           case 6:  // TCP
-            checksumDstIPv4TCP(pld, psz, fragoff, 16, oSrcIP, oDstIP, nSrcIP,
-                               nDstIP);
+            checksumIPv4TCP(pld, psz, fragoff, 16, delta);
             break;
           case 17:   // UDP
           case 136:  // UDP-Lite - same checksum place, same 0->0xFFff condition
-            checksumDstIPv4UDP(pld, psz, fragoff, oSrcIP, oDstIP, nSrcIP,
-                               nDstIP);
+            checksumIPv4UDP(pld, psz, fragoff, delta);
             break;
           case 33:  // DCCP
-            checksumDstIPv4TCP(pld, psz, fragoff, 6, oSrcIP, oDstIP, nSrcIP,
-                               nDstIP);
+            checksumIPv4TCP(pld, psz, fragoff, 6, delta);
             break;
         }
       }
@@ -185,89 +186,37 @@ namespace llarp
       hdr->daddr = nDstIP.n;
     }
 
-    static void
-    checksumSrcIPv4TCP(byte_t *pld, ABSL_ATTRIBUTE_UNUSED size_t psz,
-                       size_t fragoff, size_t chksumoff, nuint32_t oSrcIP,
-                       nuint32_t oDstIP)
+    void
+    IPPacket::UpdateIPv4PacketOnDst(huint32_t newSrcIP, huint32_t newDstIP)
     {
-      if(fragoff > chksumoff)
-        return;
-
-      auto check = (nuint16_t *)(pld + chksumoff - fragoff);
-
-      *check =
-          deltaIPv4Checksum(*check, oSrcIP, oDstIP, nuint32_t{0}, nuint32_t{0});
-      // usually, TCP checksum field cannot be 0xFFff,
-      // because one's complement addition cannot result in 0x0000,
-      // and there's inversion in the end;
-      // emulate that.
-      if(check->n == 0xFFff)
-        check->n = 0x0000;
+      UpdateIPv4PacketsOnDst(this, 1, newSrcIP, newDstIP);
     }
 
-    static void
-    checksumSrcIPv4UDP(byte_t *pld, ABSL_ATTRIBUTE_UNUSED size_t psz,
-                       size_t fragoff, nuint32_t oSrcIP, nuint32_t oDstIP)
+    void
+    IPPacket::UpdateIPv4PacketOnSrc()
     {
-      if(fragoff > 6)
-        return;
-
-      auto check = (nuint16_t *)(pld + 6);
-      if(check->n == 0x0000)
-        return;  // 0 is used to indicate "no checksum", don't change
-
-      *check =
-          deltaIPv4Checksum(*check, oSrcIP, oDstIP, nuint32_t{0}, nuint32_t{0});
-      // 0 is used to indicate "no checksum"
-      // 0xFFff and 0 are equivalent in one's complement math
-      // 0xFFff + 1 = 0x10000 -> 0x0001 (same as 0 + 1)
-      // infact it's impossible to get 0 with such addition,
-      // when starting from non-0 value.
-      // inside deltachksum we don't invert so it's safe to skip check there
-      // if(check->n == 0x0000)
-      //   check->n = 0xFFff;
+      UpdateIPv4PacketsOnSrc(this, 1);
     }
 
     void
-    IPv4Packet::UpdateIPv4PacketOnSrc()
+    IPPacket::UpdateIPv4PacketsOnDst(IPPacket *pkts, size_t n,
+                                     huint32_t newSrcIP, huint32_t newDstIP)
     {
-      auto hdr = Header();
-
-      auto oSrcIP = nuint32_t{hdr->saddr};
-      auto oDstIP = nuint32_t{hdr->daddr};
-
-      // L4
-      auto ihs = size_t(hdr->ihl * 4);
-      if(ihs <= sz)
-      {
-        auto pld = buf + ihs;
-        auto psz = sz - ihs;
-
-        auto fragoff = size_t((ntohs(hdr->frag_off) & 0x1Fff) * 8);
-
-        switch(hdr->protocol)
-        {
-          case 6:  // TCP
-            checksumSrcIPv4TCP(pld, psz, fragoff, 16, oSrcIP, oDstIP);
-            break;
-          case 17:   // UDP
-          case 136:  // UDP-Lite
-            checksumSrcIPv4UDP(pld, psz, fragoff, oSrcIP, oDstIP);
-            break;
-          case 33:  // DCCP
-            checksumSrcIPv4TCP(pld, psz, fragoff, 6, oSrcIP, oDstIP);
-            break;
-        }
-      }
-
-      // IPv4
-      auto v4chk = (nuint16_t *)&(hdr->check);
-      *v4chk =
-          deltaIPv4Checksum(*v4chk, oSrcIP, oDstIP, nuint32_t{0}, nuint32_t{0});
+      const auto nSrcIP  = xhtonl(newSrcIP);
+      const auto nDstIP  = xhtonl(newDstIP);
+      const uint32_t sum = subIPv4Sum(nSrcIP, nDstIP);
+      for(size_t idx = 0; idx < n; ++idx)
+        rewriteIPv4(pkts[idx], nSrcIP, nDstIP, sum);
+    }
 
+    void
+    IPPacket::UpdateIPv4PacketsOnSrc(IPPacket *pkts, size_t n)
+    {
       // clear addresses
-      hdr->saddr = 0;
-      hdr->daddr = 0;
+      const nuint32_t zero{0};
+      const uint32_t sum = subIPv4Sum(zero, zero);
+      for(size_t idx = 0; idx < n; ++idx)
+        rewriteIPv4(pkts[idx], zero, zero, sum);
     }
   }  // namespace net
 }  // namespace llarp
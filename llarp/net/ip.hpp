@@ -4,6 +4,7 @@
 #include <ev/ev.h>
 #include <net/net.hpp>
 #include <util/buffer.hpp>
+#include <util/packet_buffer.hpp>
 #include <util/time.hpp>
 
 #ifndef _WIN32
@@ -82,12 +83,88 @@ namespace llarp
 {
   namespace net
   {
-    struct IPv4Packet
+    /// hash of the protocol, addresses and ports of the ipv4 packet in buf,
+    /// the same for every packet in a flow, 0 for anything that isn't ipv4
+    inline uint32_t
+    FlowHash(const byte_t* buf, size_t sz)
     {
-      static constexpr size_t MaxSize = 1500;
-      llarp_time_t timestamp;
-      size_t sz;
-      byte_t buf[MaxSize];
+      static constexpr size_t MinHeaderSize = 20;
+      if(sz < MinHeaderSize || (buf[0] >> 4) != 4)
+        return 0;
+      // fnv-1a
+      uint32_t hash = 2166136261UL;
+      auto mix      = [&hash](const byte_t* data, size_t len) {
+        for(size_t idx = 0; idx < len; ++idx)
+        {
+          hash ^= data[idx];
+          hash *= 16777619UL;
+        }
+      };
+      // protocol, then source and destination address
+      mix(buf + 9, 1);
+      mix(buf + 12, 8);
+      // later fragments carry no ports, so leave them out for all of them
+      const size_t ihl      = (buf[0] & 0x0f) * 4;
+      const bool fragmented = (buf[6] & 0x3f) != 0 || buf[7] != 0;
+      const bool ports      = buf[9] == IPPROTO_TCP || buf[9] == IPPROTO_UDP;
+      if(ports && !fragmented && sz >= ihl + 4)
+        mix(buf + ihl, 4);
+      return hash;
+    }
+
+    /// the fixed part of an ipv6 header (rfc 8200), laid out the same on
+    /// every platform
+    struct ipv6_header
+    {
+      /// version, traffic class and flow label
+      uint32_t preamble;
+      uint16_t payload_len;
+      uint8_t nexthdr;
+      uint8_t hoplimit;
+      byte_t srcaddr[16];
+      byte_t dstaddr[16];
+    };
+
+    /// an ipv4 or ipv6 packet of any size up to a pool block
+    ///
+    /// the bytes live in a block from the packet pool, so the queues between
+    /// tun and network only hold a handle per packet and an idle queue holds
+    /// no packet memory at all. copies are deep so rewriting one copy never
+    /// shows through another, moves just pass the block along.
+    struct IPPacket
+    {
+      static constexpr size_t MaxSize = PacketPool::BlockSize;
+      llarp_time_t timestamp          = 0;
+
+      IPPacket() = default;
+
+      IPPacket(const IPPacket& other);
+
+      IPPacket(IPPacket&& other) = default;
+
+      IPPacket&
+      operator=(const IPPacket& other);
+
+      IPPacket&
+      operator=(IPPacket&& other) = default;
+
+      byte_t*
+      data()
+      {
+        return m_Data.data();
+      }
+
+      const byte_t*
+      data() const
+      {
+        return m_Data.data();
+      }
+
+      size_t
+      size() const
+      {
+        return m_Data.size();
+      }
 
       llarp_buffer_t
       Buffer();
@@ -95,13 +172,35 @@ namespace llarp
       llarp_buffer_t
       ConstBuffer() const;
 
+      /// copy buf in, reusing our block if we have one
       bool
       Load(const llarp_buffer_t& buf);
 
+      /// ip version from the first nibble, 0 if empty
+      uint8_t
+      Version() const
+      {
+        return size() ? data()[0] >> 4 : 0;
+      }
+
+      /// version 4 and long enough for the fixed header
+      bool
+      IsV4() const
+      {
+        return Version() == 4 && size() >= sizeof(ip_header);
+      }
+
+      /// version 6 and long enough for the fixed header
+      bool
+      IsV6() const
+      {
+        return Version() == 6 && size() >= sizeof(ipv6_header);
+      }
+
       struct GetTime
       {
         llarp_time_t
-        operator()(const IPv4Packet& pkt) const
+        operator()(const IPPacket& pkt) const
         {
           return pkt.timestamp;
         }
@@ -114,7 +213,7 @@ namespace llarp
         {
         }
         void
-        operator()(IPv4Packet& pkt) const
+        operator()(IPPacket& pkt) const
         {
           pkt.timestamp = llarp_ev_loop_time_now_ms(loop);
         }
@@ -136,31 +235,51 @@ namespace llarp
       struct CompareSize
       {
         bool
-        operator()(const IPv4Packet& left, const IPv4Packet& right)
+        operator()(const IPPacket& left, const IPPacket& right)
         {
-          return left.sz < right.sz;
+          return left.size() < right.size();
         }
       };
 
       struct CompareOrder
       {
         bool
-        operator()(const IPv4Packet& left, const IPv4Packet& right)
+        operator()(const IPPacket& left, const IPPacket& right)
         {
           return left.timestamp < right.timestamp;
         }
       };
 
+      uint32_t
+      FlowHash() const
+      {
+        return net::FlowHash(data(), size());
+      }
+
+      /// ipv4 header, only valid if IsV4()
       inline ip_header*
       Header()
       {
-        return (ip_header*)&buf[0];
+        return (ip_header*)data();
       }
 
       inline const ip_header*
       Header() const
       {
-        return (ip_header*)&buf[0];
+        return (const ip_header*)data();
+      }
+
+      /// ipv6 header, only valid if IsV6()
+      inline ipv6_header*
+      HeaderV6()
+      {
+        return (ipv6_header*)data();
+      }
+
+      inline const ipv6_header*
+      HeaderV6() const
+      {
+        return (const ipv6_header*)data();
       }
 
       inline huint32_t
@@ -188,12 +307,27 @@ namespace llarp
       }
 
       // update ip packet (after packet gets out of network)
+      // does nothing to anything but ipv4
       void
       UpdateIPv4PacketOnDst(huint32_t newSrcIP, huint32_t newDstIP);
 
       // update ip packet (before packet gets inserted into network)
+      // does nothing to anything but ipv4
       void
       UpdateIPv4PacketOnSrc();
+
+      /// UpdateIPv4PacketOnDst for n packets going to the same addresses,
+      /// the sum of the new addresses is only worked out once
+      static void
+      UpdateIPv4PacketsOnDst(IPPacket* pkts, size_t n, huint32_t newSrcIP,
+                             huint32_t newDstIP);
+
+      /// UpdateIPv4PacketOnSrc for n packets
+      static void
+      UpdateIPv4PacketsOnSrc(IPPacket* pkts, size_t n);
+
+     private:
+      PacketBuffer m_Data;
     };
 
   }  // namespace net
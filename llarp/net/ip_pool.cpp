@@ -0,0 +1,177 @@
+#include <net/ip_pool.hpp>
+
+#include <util/metrics.hpp>
+
+#include <algorithm>
+
+namespace llarp
+{
+  namespace net
+  {
+    constexpr uint32_t IPPool::None;
+    constexpr llarp_time_t IPPool::Pinned;
+
+    void
+    IPPool::Reset(const std::string& name, huint32_t lowest, huint32_t highest)
+    {
+      m_Name   = name;
+      m_Lowest = lowest;
+      m_Size   = highest < lowest ? 0 : highest.h - lowest.h + 1;
+      m_Next   = 0;
+      m_Free.clear();
+      m_Used.assign(m_Size, false);
+      m_Slots.clear();
+      m_Oldest    = None;
+      m_Newest    = None;
+      m_InUse     = 0;
+      m_Evictions = 0;
+    }
+
+    bool
+    IPPool::Obtain(llarp_time_t now, huint32_t& ip, bool& reused)
+    {
+      uint32_t idx = None;
+      reused       = false;
+      // released addresses may have been pinned since
+      while(idx == None && !m_Free.empty())
+      {
+        if(!m_Used[m_Free.back()])
+          idx = m_Free.back();
+        m_Free.pop_back();
+      }
+      if(idx == None)
+      {
+        while(m_Next < m_Size && m_Used[m_Next])
+          ++m_Next;
+        if(m_Next < m_Size)
+          idx = m_Next++;
+      }
+      if(idx == None)
+      {
+        if(m_Oldest == None)
+          return false;
+        idx = m_Oldest;
+        Unlink(idx);
+        reused = true;
+        ++m_Evictions;
+        METRICS_DYNAMIC_INCREMENT(m_Name.c_str(), "evictions");
+      }
+      if(!reused)
+      {
+        m_Used[idx] = true;
+        ++m_InUse;
+      }
+      Get(idx).active = now;
+      Link(idx);
+      ip = huint32_t{m_Lowest.h + idx};
+      ReportMetrics();
+      return true;
+    }
+
+    void
+    IPPool::Touch(huint32_t ip, llarp_time_t now)
+    {
+      if(!InUse(ip))
+        return;
+      const uint32_t idx = ip.h - m_Lowest.h;
+      Slot& slot         = Get(idx);
+      if(slot.active == Pinned)
+        return;
+      slot.active = std::max(slot.active, now);
+      if(idx == m_Newest)
+        return;
+      Unlink(idx);
+      Link(idx);
+    }
+
+    void
+    IPPool::Pin(huint32_t ip)
+    {
+      if(!Contains(ip))
+        return;
+      const uint32_t idx = ip.h - m_Lowest.h;
+      Slot& slot         = Get(idx);
+      if(m_Used[idx])
+      {
+        if(slot.active != Pinned)
+          Unlink(idx);
+      }
+      else
+      {
+        m_Used[idx] = true;
+        ++m_InUse;
+      }
+      slot.active = Pinned;
+      ReportMetrics();
+    }
+
+    void
+    IPPool::Release(huint32_t ip)
+    {
+      if(!InUse(ip))
+        return;
+      const uint32_t idx = ip.h - m_Lowest.h;
+      Slot& slot         = Get(idx);
+      if(slot.active != Pinned)
+        Unlink(idx);
+      slot.active = 0;
+      m_Used[idx] = false;
+      --m_InUse;
+      if(idx < m_Next)
+        m_Free.emplace_back(idx);
+      ReportMetrics();
+    }
+
+    llarp_time_t
+    IPPool::LastActive(huint32_t ip) const
+    {
+      if(!InUse(ip))
+        return 0;
+      return m_Slots[ip.h - m_Lowest.h].active;
+    }
+
+    IPPool::Slot&
+    IPPool::Get(uint32_t idx)
+    {
+      if(idx >= m_Slots.size())
+        m_Slots.resize(idx + 1);
+      return m_Slots[idx];
+    }
+
+    void
+    IPPool::Link(uint32_t idx)
+    {
+      Slot& slot = m_Slots[idx];
+      slot.prev  = m_Newest;
+      slot.next  = None;
+      if(m_Newest == None)
+        m_Oldest = idx;
+      else
+        m_Slots[m_Newest].next = idx;
+      m_Newest = idx;
+    }
+
+    void
+    IPPool::Unlink(uint32_t idx)
+    {
+      Slot& slot = m_Slots[idx];
+      if(slot.prev == None)
+        m_Oldest = slot.next;
+      else
+        m_Slots[slot.prev].next = slot.next;
+      if(slot.next == None)
+        m_Newest = slot.prev;
+      else
+        m_Slots[slot.next].prev = slot.prev;
+      slot.prev = None;
+      slot.next = None;
+    }
+
+    void
+    IPPool::ReportMetrics() const
+    {
+      METRICS_DYNAMIC_INT_UPDATE(m_Name.c_str(), "in_use", m_InUse);
+      METRICS_DYNAMIC_INT_UPDATE(m_Name.c_str(), "free", m_Size - m_InUse);
+    }
+  }  // namespace net
+}  // namespace llarp
@@ -0,0 +1,146 @@
+#ifndef LLARP_NET_IP_POOL_HPP
+#define LLARP_NET_IP_POOL_HPP
+
+#include <net/net_int.hpp>
+#include <util/types.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace llarp
+{
+  namespace net
+  {
+    /// the addresses of a range an endpoint hands out to remote identities.
+    /// once every address is in use the least recently active one is taken
+    /// back. obtaining, touching and releasing an address are all O(1).
+    class IPPool
+    {
+     public:
+      /// hand out lowest through highest, name is the metrics category
+      void
+      Reset(const std::string& name, huint32_t lowest, huint32_t highest);
+
+      /// take an unused address, or the least recently active one once the
+      /// range is full. reused is set when ip was taken from its previous
+      /// owner. false when every address is pinned.
+      bool
+      Obtain(llarp_time_t now, huint32_t& ip, bool& reused);
+
+      /// ip was active at now, it is taken back last
+      void
+      Touch(huint32_t ip, llarp_time_t now);
+
+      /// ip is never taken back, claiming it if it was not in use
+      void
+      Pin(huint32_t ip);
+
+      /// ip can be handed out again
+      void
+      Release(huint32_t ip);
+
+      bool
+      Contains(huint32_t ip) const
+      {
+        return ip.h - m_Lowest.h < m_Size;
+      }
+
+      bool
+      InUse(huint32_t ip) const
+      {
+        return Contains(ip) && m_Used[ip.h - m_Lowest.h];
+      }
+
+      /// when ip was last active, max for pinned addresses
+      llarp_time_t
+      LastActive(huint32_t ip) const;
+
+      size_t
+      Capacity() const
+      {
+        return m_Size;
+      }
+
+      size_t
+      NumInUse() const
+      {
+        return m_InUse;
+      }
+
+      /// addresses taken back from their previous owner
+      uint64_t
+      Evictions() const
+      {
+        return m_Evictions;
+      }
+
+      /// visit every address in use with when it was last active
+      template < typename Visit >
+      void
+      ForEach(Visit visit) const
+      {
+        for(uint32_t idx = 0; idx < m_Slots.size(); ++idx)
+          if(m_Used[idx])
+            visit(huint32_t{m_Lowest.h + idx}, m_Slots[idx].active);
+      }
+
+      /// visit the addresses not active since idleSince, least recently
+      /// active first, stopping at the first one active since then. visit
+      /// must not touch or release addresses itself
+      template < typename Visit >
+      void
+      ForEachIdle(llarp_time_t idleSince, Visit visit) const
+      {
+        for(uint32_t idx = m_Oldest;
+            idx != None && m_Slots[idx].active < idleSince;
+            idx = m_Slots[idx].next)
+          visit(huint32_t{m_Lowest.h + idx}, m_Slots[idx].active);
+      }
+
+     private:
+      static constexpr uint32_t None = std::numeric_limits< uint32_t >::max();
+      static constexpr llarp_time_t Pinned =
+          std::numeric_limits< llarp_time_t >::max();
+
+      /// an address in the activity list, least recently active first
+      struct Slot
+      {
+        uint32_t prev       = None;
+        uint32_t next       = None;
+        llarp_time_t active = 0;
+      };
+
+      Slot&
+      Get(uint32_t idx);
+
+      /// put idx at the most recently active end
+      void
+      Link(uint32_t idx);
+
+      void
+      Unlink(uint32_t idx);
+
+      void
+      ReportMetrics() const;
+
+      std::string m_Name;
+      huint32_t m_Lowest = {0};
+      uint32_t m_Size    = 0;
+      /// every address below this was handed out at some point
+      uint32_t m_Next = 0;
+      /// released addresses below m_Next
+      std::vector< uint32_t > m_Free;
+      /// one bit per address in the range
+      std::vector< bool > m_Used;
+      /// grows with the highest address in use, not with the range
+      std::vector< Slot > m_Slots;
+      uint32_t m_Oldest    = None;
+      uint32_t m_Newest    = None;
+      size_t m_InUse       = 0;
+      uint64_t m_Evictions = 0;
+    };
+  }  // namespace net
+}  // namespace llarp
+
+#endif
@@ -8,16 +8,28 @@
 #include <util/logger.hpp>
 #include <util/logic.hpp>
 #include <util/mem.hpp>
+#include <util/threadpool.h>
 
 #include <fstream>
 #include <unordered_map>
 
 static const char skiplist_subdirs[] = "0123456789abcdef";
 static const std::string RC_FILE_EXT = ".signed";
+/// hops a path needs, fewer decoded than this and we decode some more
+static constexpr size_t MinSelectable = 3;
+/// stored rcs verified per selection while the store is being decoded
+static constexpr size_t LazyDecodeBatch = 4;
 
 bool
 llarp_nodedb::Remove(const llarp::RouterID &pk)
 {
+  if(store)
+  {
+    llarp::util::Lock lock(&access);
+    entries.erase(pk);
+    selection.Remove(pk);
+    return store->Remove(pk);
+  }
   bool removed = false;
   RemoveIf([&](const llarp::RouterContact &rc) -> bool {
     if(rc.pubkey == pk)
@@ -35,19 +47,190 @@ llarp_nodedb::Clear()
 {
   llarp::util::Lock lock(&access);
   entries.clear();
+  selection.Clear();
 }
 
 bool
 llarp_nodedb::Get(const llarp::RouterID &pk, llarp::RouterContact &result)
 {
-  llarp::util::Lock l(&access);
-  auto itr = entries.find(pk);
-  if(itr == entries.end())
+  {
+    llarp::util::Lock l(&access);
+    auto itr = entries.find(pk);
+    if(itr != entries.end())
+    {
+      result = itr->second;
+      return true;
+    }
+  }
+  return store && DecodeStored(pk, result);
+}
+
+bool
+llarp_nodedb::DecodeStored(const llarp::RouterID &pk,
+                           llarp::RouterContact &result)
+{
+  llarp::RouterContact rc;
+  if(!store->Get(pk, rc))
+    return false;
+  if(!(pk == rc.pubkey.as_array()) || !rc.Verify(crypto, llarp::time_now_ms()))
+  {
+    llarp::LogWarn(store->FilePath(), " contains invalid RC for ", pk);
+    llarp::util::Lock lock(&access);
+    store->Remove(pk);
+    return false;
+  }
+  llarp::util::Lock lock(&access);
+  // removed while we were verifying it
+  if(!store->Has(pk))
     return false;
-  result = itr->second;
+  auto inserted = entries.emplace(pk, rc);
+  if(inserted.second)
+    selection.Put(rc);
+  result = inserted.first->second;
   return true;
 }
 
+void
+llarp_nodedb::DecodeStore(std::function< void(void) > done)
+{
+  if(!store || storeDecoded)
+  {
+    done();
+    return;
+  }
+  std::vector< llarp::RouterContact > rcs;
+  {
+    llarp::util::Lock lock(&decode);
+    std::vector< llarp::RouterID > keys;
+    store->ForEach([&](const llarp::RouterID &pk) -> bool {
+      keys.emplace_back(pk);
+      return true;
+    });
+    for(const auto &pk : keys)
+    {
+      {
+        llarp::util::Lock l(&access);
+        if(entries.count(pk))
+          continue;
+      }
+      llarp::RouterContact rc;
+      if(!store->Get(pk, rc))
+        continue;
+      // the store is keyed by the rc's own pubkey, anything else is bogus
+      if(!(pk == rc.pubkey.as_array()))
+      {
+        llarp::LogWarn(store->FilePath(), " contains invalid RC for ", pk);
+        llarp::util::Lock l(&access);
+        store->Remove(pk);
+        continue;
+      }
+      rcs.emplace_back(std::move(rc));
+    }
+  }
+  llarp::VerifyRouterContacts(
+      crypto, verifier, std::move(rcs), llarp::time_now_ms(),
+      [this, done](std::vector< llarp::RouterContact > verified,
+                   std::vector< uint8_t > valid) {
+        size_t decoded = 0;
+        {
+          llarp::util::Lock l(&access);
+          for(size_t idx = 0; idx < verified.size(); ++idx)
+          {
+            const llarp::RouterID pk(verified[idx].pubkey.as_array());
+            if(!valid[idx])
+            {
+              llarp::LogWarn(store->FilePath(), " contains invalid RC for ",
+                             pk);
+              store->Remove(pk);
+              continue;
+            }
+            // removed while we were verifying it
+            if(!store->Has(pk))
+              continue;
+            if(entries.emplace(pk, verified[idx]).second)
+              selection.Put(verified[idx]);
+            ++decoded;
+          }
+        }
+        storeDecoded = true;
+        llarp::LogInfo("decoded ", decoded, " RCs from ", store->FilePath());
+        done();
+      });
+}
+
+void
+llarp_nodedb::DecodeStoreAsync(llarp::Logic *logic,
+                               std::function< void(void) > completionHandler)
+{
+  decodeQueued = true;
+  auto work    = [this, logic, completionHandler]() {
+    DecodeStore([logic, completionHandler]() {
+      if(logic && completionHandler)
+        logic->queue_func(completionHandler);
+    });
+  };
+  if(disk)
+    disk->QueueFunc(std::move(work));
+  else
+    work();
+}
+
+void
+llarp_nodedb::WantStoreDecoded()
+{
+  if(store && !storeDecoded && !decodeQueued.exchange(true))
+    DecodeStoreAsync();
+}
+
+void
+llarp_nodedb::PrepareSelection()
+{
+  if(!store || storeDecoded)
+    return;
+  WantStoreDecoded();
+  for(size_t n = 0;
+      n < LazyDecodeBatch && selection.NumHops() < MinSelectable; ++n)
+  {
+    llarp::RouterID pk;
+    if(!store->RandomKey(pk))
+      return;
+    {
+      absl::ReaderMutexLock l(&access);
+      if(entries.count(pk))
+        continue;
+    }
+    llarp::RouterContact rc;
+    DecodeStored(pk, rc);
+  }
+}
+
+void
+llarp_nodedb::MaintainStore()
+{
+  if(store->ShouldCompact())
+    store->Compact();
+  else if(store->ShouldCheckpoint())
+    store->Checkpoint();
+}
+
+void
+llarp_nodedb::QueueMaintenance()
+{
+  if(!store || !(store->ShouldCompact() || store->ShouldCheckpoint()))
+    return;
+  if(!disk)
+  {
+    MaintainStore();
+    return;
+  }
+  if(maintenanceQueued.exchange(true))
+    return;
+  disk->QueueFunc([this]() {
+    maintenanceQueued = false;
+    MaintainStore();
+  });
+}
+
 // kill rcs from disk async
 struct AsyncKillRCJobs
 {
@@ -72,6 +255,7 @@ void
 llarp_nodedb::RemoveIf(
     std::function< bool(const llarp::RouterContact &rc) > filter)
 {
+  WantStoreDecoded();
   AsyncKillRCJobs *job = new AsyncKillRCJobs();
   {
     llarp::util::Lock l(&access);
@@ -80,13 +264,23 @@ llarp_nodedb::RemoveIf(
     {
       if(filter(itr->second))
       {
-        job->files.insert(getRCFilePath(itr->second.pubkey));
+        if(store)
+          store->Remove(itr->first);
+        else
+          job->files.insert(getRCFilePath(itr->second.pubkey));
+        selection.Remove(itr->first);
         itr = entries.erase(itr);
       }
       else
         ++itr;
     }
   }
+  if(store)
+  {
+    delete job;
+    QueueMaintenance();
+    return;
+  }
   llarp_threadpool_queue_job(disk, {job, &AsyncKillRCJobs::Work});
 }
 
@@ -94,7 +288,9 @@ bool
 llarp_nodedb::Has(const llarp::RouterID &pk)
 {
   llarp::util::Lock lock(&access);
-  return entries.find(pk) != entries.end();
+  if(entries.find(pk) != entries.end())
+    return true;
+  return store && store->Has(pk);
 }
 
 /// skiplist directory is hex encoded first nibble
@@ -164,6 +360,14 @@ llarp_nodedb::Insert(const llarp::RouterContact &rc)
     if(itr != entries.end())
       entries.erase(itr);
     entries.emplace(rc.pubkey.as_array(), rc);
+    selection.Put(rc);
+  }
+  if(store)
+  {
+    if(!store->Put(rc))
+      return false;
+    QueueMaintenance();
+    return true;
   }
   if(!rc.BEncode(&buf))
     return false;
@@ -185,6 +389,22 @@ llarp_nodedb::Insert(const llarp::RouterContact &rc)
   return true;
 }
 
+/// read every rc file under dir without checking them
+static void
+ReadSubdir(const fs::path &dir, std::vector< llarp::RouterContact > &rcs)
+{
+  llarp::util::IterDir(dir, [&](const fs::path &f) -> bool {
+    if(!fs::is_regular_file(f) || f.extension() != RC_FILE_EXT)
+      return true;
+    llarp::RouterContact rc;
+    if(rc.Read(f.string().c_str()))
+      rcs.emplace_back(std::move(rc));
+    else
+      llarp::LogError("failed to read file ", f);
+    return true;
+  });
+}
+
 ssize_t
 llarp_nodedb::Load(const fs::path &path)
 {
@@ -193,33 +413,50 @@ llarp_nodedb::Load(const fs::path &path)
   {
     return -1;
   }
-  ssize_t loaded = 0;
-
+  std::vector< llarp::RouterContact > rcs;
   for(const char &ch : skiplist_subdirs)
   {
     if(!ch)
       continue;
     std::string p;
     p += ch;
-    fs::path sub = path / p;
-
-    ssize_t l = loadSubdir(sub);
-    if(l > 0)
-      loaded += l;
+    ReadSubdir(path / p, rcs);
   }
-  return loaded;
+  return InsertVerified(rcs);
 }
 
 ssize_t
 llarp_nodedb::loadSubdir(const fs::path &dir)
 {
-  ssize_t sz = 0;
-  llarp::util::IterDir(dir, [&](const fs::path &f) -> bool {
-    if(fs::is_regular_file(f) && loadfile(f))
-      sz++;
-    return true;
-  });
-  return sz;
+  std::vector< llarp::RouterContact > rcs;
+  ReadSubdir(dir, rcs);
+  return InsertVerified(rcs);
+}
+
+ssize_t
+llarp_nodedb::InsertVerified(const std::vector< llarp::RouterContact > &rcs)
+{
+  // the signatures are the expensive part of a big load, check them all
+  // at once
+  llarp::VerifyRouterContacts(
+      crypto, verifier, rcs, llarp::time_now_ms(),
+      [this](std::vector< llarp::RouterContact > verified,
+             std::vector< uint8_t > valid) {
+        llarp::util::Lock lock(&access);
+        for(size_t idx = 0; idx < verified.size(); ++idx)
+        {
+          const auto &rc = verified[idx];
+          if(!valid[idx])
+          {
+            llarp::LogError("RC for ", llarp::RouterID(rc.pubkey.as_array()),
+                            " is invalid");
+            continue;
+          }
+          if(entries.emplace(rc.pubkey.as_array(), rc).second)
+            selection.Put(rc);
+        }
+      });
+  return rcs.size();
 }
 
 bool
@@ -240,7 +477,8 @@ llarp_nodedb::loadfile(const fs::path &fpath)
   }
   {
     llarp::util::Lock lock(&access);
-    entries.emplace(rc.pubkey.as_array(), rc);
+    if(entries.emplace(rc.pubkey.as_array(), rc).second)
+      selection.Put(rc);
   }
   return true;
 }
@@ -248,6 +486,7 @@ llarp_nodedb::loadfile(const fs::path &fpath)
 void
 llarp_nodedb::visit(std::function< bool(const llarp::RouterContact &) > visit)
 {
+  WantStoreDecoded();
   llarp::util::Lock lock(&access);
   auto itr = entries.begin();
   while(itr != entries.end())
@@ -261,6 +500,7 @@ llarp_nodedb::visit(std::function< bool(const llarp::RouterContact &) > visit)
 bool
 llarp_nodedb::iterate(llarp_nodedb_iter &i)
 {
+  WantStoreDecoded();
   i.index = 0;
   llarp::util::Lock lock(&access);
   auto itr = entries.begin();
@@ -409,6 +649,38 @@ llarp_nodedb::load_dir(const char *dir)
   return Load(dir);
 }
 
+ssize_t
+llarp_nodedb::load_file(const char *file)
+{
+  auto s = std::make_unique< llarp::NodeDBFile >();
+  if(!s->Open(file))
+    return -1;
+  store = std::move(s);
+  {
+    llarp::util::Lock lock(&decode);
+    storeDecoded = false;
+    decodeQueued = false;
+  }
+  return store->Size();
+}
+
+ssize_t
+llarp_nodedb::import_dir(const char *dir)
+{
+  if(!store)
+    return -1;
+  llarp_nodedb old(crypto, disk);
+  ssize_t loaded = old.load_dir(dir);
+  if(loaded <= 0)
+    return loaded;
+  old.visit([&](const llarp::RouterContact &rc) -> bool {
+    Insert(rc);
+    return true;
+  });
+  store->Checkpoint();
+  return loaded;
+}
+
 int
 llarp_nodedb::iterate_all(struct llarp_nodedb_iter i)
 {
@@ -439,132 +711,69 @@ llarp_nodedb_async_load_rc(struct llarp_async_load_rc *job)
 size_t
 llarp_nodedb::num_loaded() const
 {
+  if(store)
+    return store->Size();
   absl::ReaderMutexLock l(&access);
   return entries.size();
 }
 
 bool
-llarp_nodedb::select_random_exit(llarp::RouterContact &result)
+llarp_nodedb::select_random_router(llarp::RouterID &router)
 {
-  llarp::util::Lock lock(&access);
+  if(store)
+    return store->RandomKey(router);
+  absl::ReaderMutexLock l(&access);
   const auto sz = entries.size();
-  auto itr      = entries.begin();
-  if(sz < 3)
+  if(sz == 0)
     return false;
-  auto idx = llarp::randint() % sz;
-  if(idx)
-    std::advance(itr, idx - 1);
-  while(itr != entries.end())
-  {
-    if(itr->second.IsExit())
-    {
-      result = itr->second;
-      return true;
-    }
-    ++itr;
-  }
-  // wrap around
-  itr = entries.begin();
-  while(idx--)
-  {
-    if(itr->second.IsExit())
-    {
-      result = itr->second;
-      return true;
-    }
-    ++itr;
-  }
-  return false;
+  auto itr = entries.begin();
+  if(sz > 1)
+    std::advance(itr, llarp::randint() % sz);
+  router = itr->first;
+  return true;
+}
+
+bool
+llarp_nodedb::select_random_exit(llarp::RouterContact &result)
+{
+  if(num_loaded() < MinSelectable)
+    return false;
+  PrepareSelection();
+  return selection.RandomExit(result);
 }
 
 bool
 llarp_nodedb::select_random_hop(const llarp::RouterContact &prev,
                                 llarp::RouterContact &result, size_t N)
 {
-  llarp::util::Lock lock(&access);
   /// checking for "guard" status for N = 0 is done by caller inside of
   /// pathbuilder's scope
-  size_t sz = entries.size();
-  if(sz < 3)
-    return false;
   if(!N)
     return false;
-  llarp_time_t now = llarp::time_now_ms();
-
-  auto itr   = entries.begin();
-  size_t pos = llarp::randint() % sz;
-  std::advance(itr, pos);
-  auto start = itr;
-  while(itr == entries.end())
-  {
-    if(prev.pubkey != itr->second.pubkey)
-    {
-      if(itr->second.addrs.size() && !itr->second.IsExpired(now))
-      {
-        result = itr->second;
-        return true;
-      }
-    }
-    itr++;
-  }
-  itr = entries.begin();
-  while(itr != start)
-  {
-    if(prev.pubkey != itr->second.pubkey)
-    {
-      if(itr->second.addrs.size() && !itr->second.IsExpired(now))
-      {
-        result = itr->second;
-        return true;
-      }
-    }
-    ++itr;
-  }
-  return false;
+  PrepareSelection();
+  if(selection.NumHops() < MinSelectable)
+    return false;
+  return selection.RandomHop(
+      llarp::time_now_ms(), result,
+      [&](const llarp::RouterContact &rc) -> bool {
+        return prev.pubkey != rc.pubkey;
+      });
 }
 
 bool
 llarp_nodedb::select_random_hop_excluding(
-    llarp::RouterContact &result, const std::set< llarp::RouterID > &exclude)
+    llarp::RouterContact &result, const std::set< llarp::RouterID > &exclude,
+    const llarp::SelectionIndex::Weight &weight)
 {
-  llarp::util::Lock lock(&access);
   /// checking for "guard" status for N = 0 is done by caller inside of
   /// pathbuilder's scope
-  const size_t sz = entries.size();
-  if(sz < 3)
-  {
+  PrepareSelection();
+  if(selection.NumHops() < MinSelectable)
     return false;
-  }
-  llarp_time_t now = llarp::time_now_ms();
-
-  auto itr   = entries.begin();
-  size_t pos = llarp::randint() % sz;
-  std::advance(itr, pos);
-  auto start = itr;
-  while(itr == entries.end())
-  {
-    if(exclude.count(itr->first) == 0)
-    {
-      if(itr->second.addrs.size() && !itr->second.IsExpired(now))
-      {
-        result = itr->second;
-        return true;
-      }
-    }
-    itr++;
-  }
-  itr = entries.begin();
-  while(itr != start)
-  {
-    if(exclude.count(itr->first) == 0)
-    {
-      if(itr->second.addrs.size() && !itr->second.IsExpired(now))
-      {
-        result = itr->second;
-        return true;
-      }
-    }
-    ++itr;
-  }
-  return false;
+  return selection.RandomHop(
+      llarp::time_now_ms(), result,
+      [&](const llarp::RouterContact &rc) -> bool {
+        return exclude.count(rc.pubkey.as_array()) == 0;
+      },
+      weight);
 }
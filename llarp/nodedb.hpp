@@ -1,6 +1,8 @@
 #ifndef LLARP_NODEDB_HPP
 #define LLARP_NODEDB_HPP
 
+#include <nodedb_file.hpp>
+#include <nodedb_index.hpp>
 #include <router_contact.hpp>
 #include <router_id.hpp>
 #include <util/common.hpp>
@@ -9,6 +11,7 @@
 
 #include <absl/base/thread_annotations.h>
 
+#include <atomic>
 #include <set>
 
 #ifdef _MSC_VER
@@ -41,8 +44,9 @@ struct llarp_nodedb_iter
 
 struct llarp_nodedb
 {
-  llarp_nodedb(llarp::Crypto *c, llarp_threadpool *diskworker)
-      : crypto(c), disk(diskworker)
+  llarp_nodedb(llarp::Crypto *c, llarp_threadpool *diskworker,
+               llarp_threadpool *cryptoworker = nullptr)
+      : crypto(c), disk(diskworker), verifier(cryptoworker)
   {
   }
 
@@ -53,15 +57,31 @@ struct llarp_nodedb
 
   llarp::Crypto *crypto;
   llarp_threadpool *disk;
+  /// where bulk loads check signatures, inline when not set
+  llarp_threadpool *verifier;
+  llarp::util::Mutex decode ACQUIRED_BEFORE(access);  // serialises DecodeStore
   mutable llarp::util::Mutex access;  // protects entries
   std::unordered_map< llarp::RouterID, llarp::RouterContact,
                       llarp::RouterID::Hash >
       entries GUARDED_BY(access);
   fs::path nodePath;
+  /// single file store, when open rcs are kept here instead of one file
+  /// each under nodePath and entries only holds the ones decoded so far
+  std::unique_ptr< llarp::NodeDBFile > store;
+  std::atomic< bool > storeDecoded{false};
+  /// is a background decode of the store queued or done?
+  std::atomic< bool > decodeQueued{false};
+  /// is a checkpoint or compaction of the store queued?
+  std::atomic< bool > maintenanceQueued{false};
+  /// entries that can be picked as hops or exits, kept in step with entries
+  /// while holding access
+  llarp::SelectionIndex selection;
 
   bool
   Remove(const llarp::RouterID &pk) LOCKS_EXCLUDED(access);
 
+  /// rcs the store has not decoded yet are left alone, they are verified
+  /// as they are decoded
   void
   RemoveIf(std::function< bool(const llarp::RouterContact &) > filter)
       LOCKS_EXCLUDED(access);
@@ -97,10 +117,13 @@ struct llarp_nodedb
   bool
   loadfile(const fs::path &fpath) LOCKS_EXCLUDED(access);
 
+  /// only visits decoded rcs, the rest of the store is decoded in the
+  /// background and visited once it is
   void
   visit(std::function< bool(const llarp::RouterContact &) > visit)
       LOCKS_EXCLUDED(access);
 
+  /// like visit
   bool
   iterate(llarp_nodedb_iter &i) LOCKS_EXCLUDED(access);
 
@@ -112,12 +135,30 @@ struct llarp_nodedb
   ssize_t
   store_dir(const char *dir);
 
+  /// keep rcs in the single file store at file, rcs already in it are
+  /// decoded and verified when first used
+  ssize_t
+  load_file(const char *file);
+
+  /// copy every rc under the skiplist directory dir into the store
+  ssize_t
+  import_dir(const char *dir);
+
+  /// decode and verify everything in the store on the disk thread, then
+  /// call completionHandler in logic
+  void
+  DecodeStoreAsync(llarp::Logic *l                               = nullptr,
+                   std::function< void(void) > completionHandler = nullptr);
+
   int
   iterate_all(llarp_nodedb_iter i);
 
   size_t
   num_loaded() const LOCKS_EXCLUDED(access);
 
+  bool
+  select_random_router(llarp::RouterID &router) LOCKS_EXCLUDED(access);
+
   bool
   select_random_exit(llarp::RouterContact &rc) LOCKS_EXCLUDED(access);
 
@@ -126,13 +167,49 @@ struct llarp_nodedb
                     llarp::RouterContact &result, size_t N)
       LOCKS_EXCLUDED(access);
 
+  /// weight, when set, skews the pick towards routers it rates higher
   bool
-  select_random_hop_excluding(llarp::RouterContact &result,
-                              const std::set< llarp::RouterID > &exclude)
+  select_random_hop_excluding(
+      llarp::RouterContact &result, const std::set< llarp::RouterID > &exclude,
+      const llarp::SelectionIndex::Weight &weight = nullptr)
       LOCKS_EXCLUDED(access);
 
   static bool
   ensure_dir(const char *dir);
+
+ private:
+  /// verify rcs read in bulk and keep the valid ones, returns how many
+  /// were read. with a verifier they show up once they are checked.
+  ssize_t
+  InsertVerified(const std::vector< llarp::RouterContact > &rcs)
+      LOCKS_EXCLUDED(access);
+
+  /// decode and verify pk from the store into entries
+  bool
+  DecodeStored(const llarp::RouterID &pk, llarp::RouterContact &result)
+      LOCKS_EXCLUDED(access);
+
+  /// read everything in the store not in entries yet and verify it on the
+  /// verifier, done is called once it is all in entries. disk thread only.
+  void
+  DecodeStore(std::function< void(void) > done) LOCKS_EXCLUDED(decode, access);
+
+  /// queue decoding the store unless it is queued or done already
+  void
+  WantStoreDecoded();
+
+  /// get the selection index ready to pick from without decoding the whole
+  /// store, verifies a few stored rcs at random while it is short
+  void
+  PrepareSelection() LOCKS_EXCLUDED(access);
+
+  /// checkpoint or compact the store if it is due
+  void
+  MaintainStore();
+
+  /// run MaintainStore on the disk thread if it is due
+  void
+  QueueMaintenance();
 };
 
 /// struct for async rc verification
@@ -0,0 +1,728 @@
+#include <nodedb_file.hpp>
+
+#include <crypto/crypto.hpp>
+#include <util/buffer.hpp>
+#include <util/endian.hpp>
+#include <util/logger.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace llarp
+{
+  /// data file: magic, version, pad, file id
+  static const char DataMagic[]          = "LLARPNDB";
+  static constexpr size_t DataHeaderSize = 24;
+  /// record: payload size, checksum, router id, bencoded rc
+  static constexpr size_t RecordHeaderSize = 40;
+  /// index file: magic, version, count, file id, covered, wasted
+  static const char IndexMagic[]          = "LLARPIDX";
+  static constexpr size_t IndexHeaderSize = 40;
+  /// index entry: router id, record offset, payload size, pad
+  static constexpr size_t IndexEntrySize  = 48;
+  static constexpr uint32_t FormatVersion = 1;
+  /// draws RandomKey makes before it falls back to walking every rc
+  static constexpr size_t RandomKeyAttempts = 16;
+
+  constexpr size_t NodeDBFile::CheckpointAfter;
+  constexpr uint64_t NodeDBFile::CompactMinWasted;
+  constexpr size_t NodeDBFile::MinMapping;
+
+  bool
+  MappedFile::Map(const fs::path &file, size_t reserve)
+  {
+    Unmap();
+#ifdef _WIN32
+    // copies cannot grow
+    (void)reserve;
+    std::ifstream f(file.string(), std::ios::binary);
+    if(!f.is_open())
+      return false;
+    f.seekg(0, std::ios::end);
+    m_Copy.resize(f.tellg());
+    f.seekg(0, std::ios::beg);
+    f.read((char *)m_Copy.data(), m_Copy.size());
+    if(!f)
+      return false;
+    m_Data   = m_Copy.data();
+    m_Size   = m_Copy.size();
+    m_Mapped = m_Size;
+    return true;
+#else
+    int fd = ::open(file.string().c_str(), O_RDONLY);
+    if(fd == -1)
+      return false;
+    struct stat st;
+    if(::fstat(fd, &st) == -1)
+    {
+      ::close(fd);
+      return false;
+    }
+    // mapping past the end is fine as long as nothing reads there before
+    // the file has grown to cover it
+    const size_t len = std::max(size_t(st.st_size), reserve);
+    if(st.st_size > 0)
+    {
+      void *ptr = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+      if(ptr == MAP_FAILED)
+      {
+        ::close(fd);
+        return false;
+      }
+      m_Data   = static_cast< const byte_t * >(ptr);
+      m_Size   = st.st_size;
+      m_Mapped = len;
+    }
+    ::close(fd);
+    return true;
+#endif
+  }
+
+  void
+  MappedFile::Unmap()
+  {
+#ifdef _WIN32
+    m_Copy.clear();
+#else
+    if(m_Data)
+      ::munmap(const_cast< byte_t * >(m_Data), m_Mapped);
+#endif
+    m_Data   = nullptr;
+    m_Size   = 0;
+    m_Mapped = 0;
+  }
+
+  bool
+  MappedFile::Grow(size_t sz)
+  {
+    if(sz > m_Mapped)
+      return false;
+    m_Size = std::max(m_Size, sz);
+    return true;
+  }
+
+  /// fnv-1a over the router id and the payload, catches torn writes
+  static uint32_t
+  Checksum(const byte_t *pk, const byte_t *payload, size_t sz)
+  {
+    uint32_t h = 2166136261U;
+    for(size_t idx = 0; idx < RouterID::SIZE; ++idx)
+      h = (h ^ pk[idx]) * 16777619U;
+    for(size_t idx = 0; idx < sz; ++idx)
+      h = (h ^ payload[idx]) * 16777619U;
+    return h;
+  }
+
+  static bool
+  WriteDataHeader(std::ostream &out, uint64_t id)
+  {
+    std::array< byte_t, DataHeaderSize > hdr;
+    hdr.fill(0);
+    std::copy_n(DataMagic, 8, hdr.begin());
+    htole32buf(hdr.data() + 8, FormatVersion);
+    htole64buf(hdr.data() + 16, id);
+    out.write((const char *)hdr.data(), hdr.size());
+    return out.good();
+  }
+
+  /// wait for what was written to file to reach the disk
+  static bool
+  SyncPath(const fs::path &file)
+  {
+#ifdef _WIN32
+    (void)file;
+    return true;
+#else
+    const int fd = ::open(file.string().c_str(), O_RDONLY);
+    if(fd == -1)
+      return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+  }
+
+  /// put from in place of to, from is synced first and the directory after
+  /// so a crash leaves either the old file or the whole new one
+  static bool
+  ReplaceFile(const fs::path &from, const fs::path &to)
+  {
+    if(!SyncPath(from))
+      LogWarn("failed to sync ", from);
+#ifdef _WIN32
+    fs::remove(to);
+#endif
+    if(std::rename(from.string().c_str(), to.string().c_str()) != 0)
+      return false;
+    fs::path dir = to.parent_path();
+    if(dir.empty())
+      dir = ".";
+    if(!SyncPath(dir))
+      LogWarn("failed to sync ", dir);
+    return true;
+  }
+
+  static uint64_t
+  NewFileID()
+  {
+    return randint();
+  }
+
+  NodeDBFile::~NodeDBFile()
+  {
+    Close();
+  }
+
+  fs::path
+  NodeDBFile::IndexPath() const
+  {
+    return fs::path(m_File.string() + ".idx");
+  }
+
+  bool
+  NodeDBFile::Open(const fs::path &file)
+  {
+    util::Lock m(&m_Maintenance);
+    util::Lock l(&m_Access);
+    CloseFiles();
+    m_File = file;
+    std::error_code ec;
+    if(!fs::exists(file, ec))
+    {
+      std::ofstream f(file.string(), std::ios::binary);
+      if(!f.is_open() || !WriteDataHeader(f, NewFileID()))
+      {
+        LogError("cannot create nodedb file ", file);
+        return false;
+      }
+      LogInfo("created nodedb file ", file);
+    }
+    return Load();
+  }
+
+  void
+  NodeDBFile::Close()
+  {
+    Checkpoint();
+    util::Lock m(&m_Maintenance);
+    util::Lock l(&m_Access);
+    CloseFiles();
+  }
+
+  void
+  NodeDBFile::CloseFiles()
+  {
+    m_Out.close();
+    m_Out.clear();
+    m_Data.Unmap();
+    m_Index.Unmap();
+    m_Indexed    = nullptr;
+    m_NumIndexed = 0;
+    m_Overlay.clear();
+    m_ID     = 0;
+    m_End    = 0;
+    m_Wasted = 0;
+    m_Live   = 0;
+  }
+
+  bool
+  NodeDBFile::Load()
+  {
+    if(!m_Data.Map(m_File))
+    {
+      LogError("cannot map nodedb file ", m_File);
+      return false;
+    }
+    const byte_t *hdr = m_Data.data();
+    if(m_Data.size() < DataHeaderSize || std::memcmp(hdr, DataMagic, 8) != 0
+       || le32toh(buf32toh(hdr + 8)) != FormatVersion)
+    {
+      LogError(m_File, " is not a nodedb file");
+      m_Data.Unmap();
+      return false;
+    }
+    m_ID = le64toh(buf64toh(hdr + 16));
+    if(!LoadIndex())
+    {
+      m_End    = DataHeaderSize;
+      m_Live   = 0;
+      m_Wasted = 0;
+    }
+    const size_t indexed = m_Live;
+    Scan(m_End);
+    m_Out.open(m_File.string(),
+               std::ios::in | std::ios::out | std::ios::binary);
+    if(!m_Out.is_open())
+    {
+      LogError("cannot open nodedb file ", m_File, " for writing");
+      return false;
+    }
+    LogInfo("opened nodedb file ", m_File, " with ", m_Live, " rcs, ",
+            indexed, " indexed, ", m_Overlay.size(), " records read");
+    return true;
+  }
+
+  bool
+  NodeDBFile::LoadIndex()
+  {
+    const fs::path file = IndexPath();
+    std::error_code ec;
+    if(!fs::exists(file, ec) || !m_Index.Map(file))
+      return false;
+    const byte_t *hdr = m_Index.data();
+    const size_t sz   = m_Index.size();
+    if(sz < IndexHeaderSize || std::memcmp(hdr, IndexMagic, 8) != 0
+       || le32toh(buf32toh(hdr + 8)) != FormatVersion)
+    {
+      LogWarn("ignoring bad nodedb index ", file);
+      m_Index.Unmap();
+      return false;
+    }
+    const size_t count     = le32toh(buf32toh(hdr + 12));
+    const uint64_t id      = le64toh(buf64toh(hdr + 16));
+    const uint64_t covered = le64toh(buf64toh(hdr + 24));
+    if(id != m_ID || covered < DataHeaderSize || covered > m_Data.size()
+       || sz != IndexHeaderSize + (count * IndexEntrySize))
+    {
+      LogWarn("ignoring stale nodedb index ", file);
+      m_Index.Unmap();
+      return false;
+    }
+    m_Indexed    = hdr + IndexHeaderSize;
+    m_NumIndexed = count;
+    m_Live       = count;
+    m_End        = covered;
+    m_Wasted     = le64toh(buf64toh(hdr + 32));
+    return true;
+  }
+
+  void
+  NodeDBFile::Scan(uint64_t from)
+  {
+    // pick up anything appended since the file was mapped
+    m_Data.Map(m_File);
+    const byte_t *base = m_Data.data();
+    const uint64_t sz  = m_Data.size();
+    uint64_t off       = from;
+    while(off + RecordHeaderSize <= sz)
+    {
+      const byte_t *rec    = base + off;
+      const uint32_t len   = le32toh(buf32toh(rec));
+      const uint32_t check = le32toh(buf32toh(rec + 4));
+      if(len > MAX_RC_SIZE || off + RecordHeaderSize + len > sz)
+        break;
+      if(Checksum(rec + 8, rec + RecordHeaderSize, len) != check)
+        break;
+      Apply(RouterID(rec + 8), {off, len});
+      off += RecordHeaderSize + len;
+    }
+    // the next append overwrites whatever a crash left behind
+    if(off < sz)
+      LogWarn("discarding ", sz - off, " bytes at the end of ", m_File);
+    m_End = off;
+  }
+
+  void
+  NodeDBFile::Apply(const RouterID &pk, Slot slot)
+  {
+    Slot old;
+    const bool had = Find(pk, old);
+    if(had)
+      m_Wasted += RecordHeaderSize + old.size;
+    // a removal is garbage from the moment it is written
+    if(slot.size == 0)
+      m_Wasted += RecordHeaderSize;
+    if(had && slot.size == 0)
+      --m_Live;
+    else if(!had && slot.size != 0)
+      ++m_Live;
+    m_Overlay[pk] = slot;
+  }
+
+  bool
+  NodeDBFile::Append(const RouterID &pk, const byte_t *payload, uint32_t size)
+  {
+    std::array< byte_t, RecordHeaderSize > hdr;
+    htole32buf(hdr.data(), size);
+    htole32buf(hdr.data() + 4, Checksum(pk.data(), payload, size));
+    std::copy(pk.begin(), pk.end(), hdr.begin() + 8);
+    m_Out.seekp(m_End);
+    m_Out.write((const char *)hdr.data(), hdr.size());
+    if(size)
+      m_Out.write((const char *)payload, size);
+    // readers go through the mapping, not our buffer
+    m_Out.flush();
+    if(!m_Out)
+    {
+      LogError("failed to append to nodedb file ", m_File);
+      m_Out.clear();
+      return false;
+    }
+    Apply(pk, {m_End, size});
+    m_End += RecordHeaderSize + size;
+    return true;
+  }
+
+  bool
+  NodeDBFile::Put(const RouterContact &rc)
+  {
+    std::array< byte_t, MAX_RC_SIZE > tmp;
+    llarp_buffer_t buf(tmp);
+    if(!rc.BEncode(&buf))
+      return false;
+    util::Lock l(&m_Access);
+    if(!m_Out.is_open())
+      return false;
+    return Append(rc.pubkey.as_array(), tmp.data(), buf.cur - buf.base);
+  }
+
+  bool
+  NodeDBFile::Remove(const RouterID &pk)
+  {
+    util::Lock l(&m_Access);
+    Slot slot;
+    if(!m_Out.is_open() || !Find(pk, slot))
+      return false;
+    return Append(pk, nullptr, 0);
+  }
+
+  bool
+  NodeDBFile::Has(const RouterID &pk) const
+  {
+    util::Lock l(&m_Access);
+    Slot slot;
+    return Find(pk, slot);
+  }
+
+  bool
+  NodeDBFile::Get(const RouterID &pk, RouterContact &rc) const
+  {
+    util::Lock l(&m_Access);
+    Slot slot;
+    if(!Find(pk, slot))
+      return false;
+    // the record was flushed before it was found, so the file covers it.
+    // remapping reserves half as much again as the file holds so the
+    // lookups after the next appends do not remap too
+    const uint64_t end = slot.offset + RecordHeaderSize + slot.size;
+    if(!m_Data.Grow(end)
+       && !m_Data.Map(m_File, std::max(m_End + (m_End / 2), MinMapping)))
+      return false;
+    if(end > m_Data.size())
+      return false;
+    byte_t *payload =
+        const_cast< byte_t * >(m_Data.data()) + slot.offset + RecordHeaderSize;
+    llarp_buffer_t buf(payload, slot.size);
+    return rc.BDecode(&buf);
+  }
+
+  bool
+  NodeDBFile::Find(const RouterID &pk, Slot &slot) const
+  {
+    auto itr = m_Overlay.find(pk);
+    if(itr == m_Overlay.end())
+      return FindIndexed(pk, slot);
+    slot = itr->second;
+    return slot.size != 0;
+  }
+
+  bool
+  NodeDBFile::FindIndexed(const RouterID &pk, Slot &slot) const
+  {
+    size_t lo = 0;
+    size_t hi = m_NumIndexed;
+    while(lo < hi)
+    {
+      const size_t mid    = lo + ((hi - lo) / 2);
+      const byte_t *entry = m_Indexed + (mid * IndexEntrySize);
+      const int cmp       = std::memcmp(pk.data(), entry, RouterID::SIZE);
+      if(cmp == 0)
+      {
+        slot.offset = le64toh(buf64toh(entry + 32));
+        slot.size   = le32toh(buf32toh(entry + 40));
+        return true;
+      }
+      if(cmp < 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    return false;
+  }
+
+  void
+  NodeDBFile::Live(std::function< bool(const RouterID &, Slot) > visit) const
+  {
+    for(size_t idx = 0; idx < m_NumIndexed; ++idx)
+    {
+      const byte_t *entry = m_Indexed + (idx * IndexEntrySize);
+      const RouterID pk(entry);
+      if(m_Overlay.count(pk))
+        continue;
+      const Slot slot{le64toh(buf64toh(entry + 32)),
+                      le32toh(buf32toh(entry + 40))};
+      if(!visit(pk, slot))
+        return;
+    }
+    for(const auto &item : m_Overlay)
+    {
+      if(item.second.size == 0)
+        continue;
+      if(!visit(item.first, item.second))
+        return;
+    }
+  }
+
+  void
+  NodeDBFile::ForEach(std::function< bool(const RouterID &) > visit) const
+  {
+    util::Lock l(&m_Access);
+    Live([&](const RouterID &pk, Slot) -> bool { return visit(pk); });
+  }
+
+  bool
+  NodeDBFile::RandomKey(RouterID &pk) const
+  {
+    util::Lock l(&m_Access);
+    if(m_Live == 0)
+      return false;
+    // draw from the index and the overlay by position, a draw of an index
+    // entry the overlay replaced or of a removal is drawn again. every rc
+    // is exactly one candidate so the pick stays uniform, and the overlay
+    // is kept small by checkpoints.
+    const size_t candidates = m_NumIndexed + m_Overlay.size();
+    for(size_t attempt = 0; attempt < RandomKeyAttempts; ++attempt)
+    {
+      const size_t idx = randint() % candidates;
+      if(idx < m_NumIndexed)
+      {
+        const RouterID k(m_Indexed + (idx * IndexEntrySize));
+        if(m_Overlay.count(k))
+          continue;
+        pk = k;
+        return true;
+      }
+      auto itr = std::next(m_Overlay.begin(), idx - m_NumIndexed);
+      if(itr->second.size == 0)
+        continue;
+      pk = itr->first;
+      return true;
+    }
+    // mostly removals, walk them instead
+    size_t skip = randint() % m_Live;
+    Live([&](const RouterID &k, Slot) -> bool {
+      if(skip--)
+        return true;
+      pk = k;
+      return false;
+    });
+    return true;
+  }
+
+  size_t
+  NodeDBFile::Size() const
+  {
+    util::Lock l(&m_Access);
+    return m_Live;
+  }
+
+  uint64_t
+  NodeDBFile::Wasted() const
+  {
+    util::Lock l(&m_Access);
+    return m_Wasted;
+  }
+
+  size_t
+  NodeDBFile::Unindexed() const
+  {
+    util::Lock l(&m_Access);
+    return m_Overlay.size();
+  }
+
+  bool
+  NodeDBFile::ShouldCheckpoint() const
+  {
+    util::Lock l(&m_Access);
+    return m_Overlay.size() >= CheckpointAfter;
+  }
+
+  bool
+  NodeDBFile::ShouldCompact() const
+  {
+    util::Lock l(&m_Access);
+    if(m_Wasted < CompactMinWasted)
+      return false;
+    // more garbage than rcs
+    return m_Wasted * 2 > m_End - DataHeaderSize;
+  }
+
+  bool
+  NodeDBFile::WriteIndex(const fs::path &file, uint64_t id, uint64_t covered,
+                         uint64_t wasted,
+                         std::vector< std::pair< RouterID, Slot > > slots) const
+  {
+    std::sort(slots.begin(), slots.end(),
+              [](const std::pair< RouterID, Slot > &a,
+                 const std::pair< RouterID, Slot > &b) -> bool {
+                return a.first < b.first;
+              });
+    const fs::path tmp(file.string() + ".tmp");
+    {
+      std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+      std::array< byte_t, IndexHeaderSize > hdr;
+      hdr.fill(0);
+      std::copy_n(IndexMagic, 8, hdr.begin());
+      htole32buf(hdr.data() + 8, FormatVersion);
+      htole32buf(hdr.data() + 12, slots.size());
+      htole64buf(hdr.data() + 16, id);
+      htole64buf(hdr.data() + 24, covered);
+      htole64buf(hdr.data() + 32, wasted);
+      out.write((const char *)hdr.data(), hdr.size());
+      std::array< byte_t, IndexEntrySize > entry;
+      entry.fill(0);
+      for(const auto &item : slots)
+      {
+        std::copy(item.first.begin(), item.first.end(), entry.begin());
+        htole64buf(entry.data() + 32, item.second.offset);
+        htole32buf(entry.data() + 40, item.second.size);
+        out.write((const char *)entry.data(), entry.size());
+      }
+      out.close();
+      if(!out)
+      {
+        LogError("failed to write nodedb index ", tmp);
+        return false;
+      }
+    }
+    if(!ReplaceFile(tmp, file))
+    {
+      LogError("failed to replace nodedb index ", file);
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  NodeDBFile::Checkpoint()
+  {
+    util::Lock m(&m_Maintenance);
+    util::Lock l(&m_Access);
+    if(!m_Out.is_open())
+      return false;
+    if(m_Overlay.empty())
+      return true;
+    std::vector< std::pair< RouterID, Slot > > slots;
+    slots.reserve(m_Live);
+    Live([&](const RouterID &pk, Slot slot) -> bool {
+      slots.emplace_back(pk, slot);
+      return true;
+    });
+    if(!WriteIndex(IndexPath(), m_ID, m_End, m_Wasted, std::move(slots)))
+      return false;
+    m_Index.Unmap();
+    m_Indexed    = nullptr;
+    m_NumIndexed = 0;
+    m_Overlay.clear();
+    // the index is checked against the file as it is now
+    m_Data.Map(m_File);
+    if(!LoadIndex())
+    {
+      // should not happen, rebuild from the records
+      m_Live   = 0;
+      m_Wasted = 0;
+      Scan(DataHeaderSize);
+      return false;
+    }
+    LogDebug("checkpointed nodedb file ", m_File, " with ", m_Live, " rcs");
+    return true;
+  }
+
+  bool
+  NodeDBFile::Compact()
+  {
+    util::Lock m(&m_Maintenance);
+    std::vector< std::pair< RouterID, Slot > > slots;
+    uint64_t copied;
+    {
+      util::Lock l(&m_Access);
+      if(!m_Out.is_open())
+        return false;
+      if(m_Wasted == 0)
+        return true;
+      slots.reserve(m_Live);
+      Live([&](const RouterID &pk, Slot slot) -> bool {
+        slots.emplace_back(pk, slot);
+        return true;
+      });
+      copied = m_End;
+    }
+    // records before copied never change, so the copy is made without
+    // holding up puts and lookups
+    std::sort(slots.begin(), slots.end(),
+              [](const std::pair< RouterID, Slot > &a,
+                 const std::pair< RouterID, Slot > &b) -> bool {
+                return a.second.offset < b.second.offset;
+              });
+    const fs::path tmp(m_File.string() + ".tmp");
+    const uint64_t id = NewFileID();
+    std::ifstream in(m_File.string(), std::ios::binary);
+    std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+    std::vector< byte_t > rec(RecordHeaderSize + MAX_RC_SIZE);
+    uint64_t end = DataHeaderSize;
+    bool ok      = WriteDataHeader(out, id);
+    for(auto &item : slots)
+    {
+      if(!ok)
+        break;
+      const size_t sz = RecordHeaderSize + item.second.size;
+      in.seekg(item.second.offset);
+      in.read((char *)rec.data(), sz);
+      out.write((const char *)rec.data(), sz);
+      ok                 = in.good() && out.good();
+      item.second.offset = end;
+      end += sz;
+    }
+
+    util::Lock l(&m_Access);
+    // anything appended meanwhile goes on the end as it is and is read
+    // back in when the new file is opened
+    uint64_t tail = m_End - copied;
+    in.seekg(copied);
+    while(ok && tail)
+    {
+      const size_t sz = std::min(tail, uint64_t(rec.size()));
+      in.read((char *)rec.data(), sz);
+      out.write((const char *)rec.data(), sz);
+      ok = in.good() && out.good();
+      tail -= sz;
+    }
+    out.close();
+    ok = ok && out.good();
+    // index first, it is ignored if we stop before the file is replaced
+    if(!ok || !WriteIndex(IndexPath(), id, end, 0, std::move(slots)))
+    {
+      LogError("failed to compact nodedb file ", m_File);
+      fs::remove(tmp);
+      return false;
+    }
+    const uint64_t before = m_End;
+    CloseFiles();
+    if(!ReplaceFile(tmp, m_File))
+      LogError("failed to replace nodedb file ", m_File);
+    if(!Load())
+      return false;
+    LogInfo("compacted nodedb file ", m_File, " from ", before, " to ", m_End,
+            " bytes");
+    return true;
+  }
+}  // namespace llarp
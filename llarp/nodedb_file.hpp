@@ -0,0 +1,228 @@
+#ifndef LLARP_NODEDB_FILE_HPP
+#define LLARP_NODEDB_FILE_HPP
+
+#include <router_contact.hpp>
+#include <router_id.hpp>
+#include <util/fs.hpp>
+#include <util/threading.hpp>
+#include <util/types.hpp>
+
+#include <absl/base/thread_annotations.h>
+
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp
+{
+  /// read only view of a whole file, memory mapped where we can
+  struct MappedFile
+  {
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &
+    operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+      Unmap();
+    }
+
+    /// map file, reserving at least reserve bytes of address space so the
+    /// file can grow that far without being remapped
+    bool
+    Map(const fs::path &file, size_t reserve = 0);
+
+    void
+    Unmap();
+
+    /// the file grew to at least sz bytes, true if the mapping already
+    /// covers them so nothing has to be remapped
+    bool
+    Grow(size_t sz);
+
+    const byte_t *
+    data() const
+    {
+      return m_Data;
+    }
+
+    size_t
+    size() const
+    {
+      return m_Size;
+    }
+
+   private:
+    const byte_t *m_Data = nullptr;
+    size_t m_Size        = 0;
+    /// bytes of address space mapped, past m_Size until the file grows
+    size_t m_Mapped = 0;
+#ifdef _WIN32
+    std::vector< byte_t > m_Copy;
+#endif
+  };
+
+  /// router contacts kept in one append only file as the bencoded rc they
+  /// arrived as. replacing or removing an rc appends a new record, the old
+  /// one is left as garbage until Compact rewrites the file.
+  ///
+  /// a sorted index of RouterID to record is checkpointed next to the file
+  /// and memory mapped on open, so opening only reads the records appended
+  /// since the last checkpoint. rcs are decoded when asked for, never on
+  /// open.
+  struct NodeDBFile
+  {
+    /// start checkpointing once this many records are not in the index
+    static constexpr size_t CheckpointAfter = 256;
+    /// never compact for less garbage than this
+    static constexpr uint64_t CompactMinWasted = 64 * 1024;
+    /// least address space reserved when a lookup has to remap the file
+    static constexpr size_t MinMapping = 1024 * 1024;
+
+    NodeDBFile() = default;
+    NodeDBFile(const NodeDBFile &) = delete;
+    NodeDBFile &
+    operator=(const NodeDBFile &) = delete;
+
+    ~NodeDBFile();
+
+    /// open or create the store at file
+    bool
+    Open(const fs::path &file) LOCKS_EXCLUDED(m_Maintenance, m_Access);
+
+    /// checkpoint and close
+    void
+    Close() LOCKS_EXCLUDED(m_Maintenance, m_Access);
+
+    /// append rc, replacing any rc with the same pubkey
+    bool
+    Put(const RouterContact &rc) LOCKS_EXCLUDED(m_Access);
+
+    bool
+    Remove(const RouterID &pk) LOCKS_EXCLUDED(m_Access);
+
+    bool
+    Has(const RouterID &pk) const LOCKS_EXCLUDED(m_Access);
+
+    /// decode the stored rc for pk, does not verify it
+    bool
+    Get(const RouterID &pk, RouterContact &rc) const LOCKS_EXCLUDED(m_Access);
+
+    /// visit every stored router id until visit returns false
+    void
+    ForEach(std::function< bool(const RouterID &) > visit) const
+        LOCKS_EXCLUDED(m_Access);
+
+    /// pick a stored router id at random
+    bool
+    RandomKey(RouterID &pk) const LOCKS_EXCLUDED(m_Access);
+
+    /// number of rcs stored
+    size_t
+    Size() const LOCKS_EXCLUDED(m_Access);
+
+    /// bytes held by replaced or removed records
+    uint64_t
+    Wasted() const LOCKS_EXCLUDED(m_Access);
+
+    /// number of records not covered by the index
+    size_t
+    Unindexed() const LOCKS_EXCLUDED(m_Access);
+
+    bool
+    ShouldCheckpoint() const LOCKS_EXCLUDED(m_Access);
+
+    bool
+    ShouldCompact() const LOCKS_EXCLUDED(m_Access);
+
+    /// write the index for every record appended so far
+    bool
+    Checkpoint() LOCKS_EXCLUDED(m_Maintenance, m_Access);
+
+    /// rewrite the file with only the live records, puts and removes may
+    /// carry on while the copy is made
+    bool
+    Compact() LOCKS_EXCLUDED(m_Maintenance, m_Access);
+
+    const fs::path &
+    FilePath() const
+    {
+      return m_File;
+    }
+
+    fs::path
+    IndexPath() const;
+
+   private:
+    /// where a record lives, a size of zero is a removed rc
+    struct Slot
+    {
+      uint64_t offset;
+      uint32_t size;
+    };
+
+    using Overlay =
+        std::unordered_map< RouterID, Slot, RouterID::Hash >;
+
+    bool
+    Load() EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    bool
+    LoadIndex() EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    void
+    Scan(uint64_t from) EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    void
+    Apply(const RouterID &pk, Slot slot) EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    bool
+    Append(const RouterID &pk, const byte_t *payload, uint32_t size)
+        EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    bool
+    Find(const RouterID &pk, Slot &slot) const
+        SHARED_LOCKS_REQUIRED(m_Access);
+
+    bool
+    FindIndexed(const RouterID &pk, Slot &slot) const
+        SHARED_LOCKS_REQUIRED(m_Access);
+
+    void
+    Live(std::function< bool(const RouterID &, Slot) > visit) const
+        SHARED_LOCKS_REQUIRED(m_Access);
+
+    bool
+    WriteIndex(const fs::path &file, uint64_t id, uint64_t covered,
+               uint64_t wasted,
+               std::vector< std::pair< RouterID, Slot > > slots) const;
+
+    void
+    CloseFiles() EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    /// serialises Checkpoint and Compact
+    util::Mutex m_Maintenance ACQUIRED_BEFORE(m_Access);
+    mutable util::Mutex m_Access;
+
+    fs::path m_File;
+    std::fstream m_Out GUARDED_BY(m_Access);
+    /// remapped as the file grows
+    mutable MappedFile m_Data GUARDED_BY(m_Access);
+    MappedFile m_Index GUARDED_BY(m_Access);
+    /// identifies the file so a stale index is never used with it
+    uint64_t m_ID GUARDED_BY(m_Access) = 0;
+    /// where the next record goes
+    uint64_t m_End GUARDED_BY(m_Access) = 0;
+    uint64_t m_Wasted GUARDED_BY(m_Access) = 0;
+    size_t m_Live GUARDED_BY(m_Access) = 0;
+    /// index entries, sorted by router id
+    const byte_t *m_Indexed GUARDED_BY(m_Access) = nullptr;
+    size_t m_NumIndexed GUARDED_BY(m_Access)     = 0;
+    /// records appended since the index was written
+    Overlay m_Overlay GUARDED_BY(m_Access);
+  };
+}  // namespace llarp
+
+#endif
@@ -0,0 +1,164 @@
+#include <nodedb_index.hpp>
+
+#include <crypto/crypto.hpp>
+#include <util/time.hpp>
+
+namespace llarp
+{
+  constexpr size_t SelectionIndex::MaxTries;
+
+  void
+  SelectionIndex::Set::Put(const Entry &entry)
+  {
+    const RouterID pk(entry->pubkey.as_array());
+    auto itr = position.find(pk);
+    if(itr != position.end())
+    {
+      items[itr->second] = entry;
+      return;
+    }
+    position.emplace(pk, items.size());
+    items.emplace_back(entry);
+  }
+
+  bool
+  SelectionIndex::Set::Remove(const RouterID &pk)
+  {
+    auto itr = position.find(pk);
+    if(itr == position.end())
+      return false;
+    const size_t idx = itr->second;
+    position.erase(itr);
+    if(idx + 1 != items.size())
+    {
+      items[idx] = std::move(items.back());
+      position[RouterID(items[idx]->pubkey.as_array())] = idx;
+    }
+    items.pop_back();
+    return true;
+  }
+
+  void
+  SelectionIndex::Set::Clear()
+  {
+    items.clear();
+    position.clear();
+  }
+
+  void
+  SelectionIndex::Put(const RouterContact &rc)
+  {
+    const RouterID pk(rc.pubkey.as_array());
+    const bool hop  = rc.addrs.size() && !rc.IsExpired(time_now_ms());
+    const bool exit = rc.IsExit();
+    Entry entry;
+    if(hop || exit)
+      entry = std::make_shared< const RouterContact >(rc);
+    util::Lock lock(&m_Access);
+    if(hop)
+      m_Hops.Put(entry);
+    else
+      m_Hops.Remove(pk);
+    if(exit)
+      m_Exits.Put(entry);
+    else
+      m_Exits.Remove(pk);
+  }
+
+  bool
+  SelectionIndex::Remove(const RouterID &pk)
+  {
+    util::Lock lock(&m_Access);
+    const bool hop  = m_Hops.Remove(pk);
+    const bool exit = m_Exits.Remove(pk);
+    return hop || exit;
+  }
+
+  void
+  SelectionIndex::Clear()
+  {
+    util::Lock lock(&m_Access);
+    m_Hops.Clear();
+    m_Exits.Clear();
+  }
+
+  size_t
+  SelectionIndex::NumHops() const
+  {
+    absl::ReaderMutexLock lock(&m_Access);
+    return m_Hops.items.size();
+  }
+
+  size_t
+  SelectionIndex::NumExits() const
+  {
+    absl::ReaderMutexLock lock(&m_Access);
+    return m_Exits.items.size();
+  }
+
+  bool
+  SelectionIndex::RandomHop(llarp_time_t now, RouterContact &result,
+                            const Filter &accept, const Weight &weight) const
+  {
+    Entry picked;
+    {
+      absl::ReaderMutexLock lock(&m_Access);
+      picked = Pick(m_Hops, now, accept, weight);
+    }
+    // copy outside the lock, entries are never modified once put
+    if(picked)
+      result = *picked;
+    return picked != nullptr;
+  }
+
+  bool
+  SelectionIndex::RandomExit(RouterContact &result) const
+  {
+    Entry picked;
+    {
+      absl::ReaderMutexLock lock(&m_Access);
+      picked = Pick(m_Exits, 0, nullptr, nullptr);
+    }
+    if(picked)
+      result = *picked;
+    return picked != nullptr;
+  }
+
+  SelectionIndex::Entry
+  SelectionIndex::Pick(const Set &set, llarp_time_t now, const Filter &accept,
+                       const Weight &weight) const
+  {
+    const size_t sz = set.items.size();
+    if(sz == 0)
+      return nullptr;
+    auto usable = [&](const Entry &entry) -> bool {
+      if(now && entry->IsExpired(now))
+        return false;
+      return !accept || accept(*entry);
+    };
+    for(size_t tries = 0; tries < MaxTries; ++tries)
+    {
+      const auto &entry = set.items[randint() % sz];
+      if(!usable(entry))
+        continue;
+      // rejection sampling keeps a weighted pick O(1) while the weights
+      // change under us
+      if(weight)
+      {
+        const double keep = weight(RouterID(entry->pubkey.as_array()));
+        if(keep < 1.0 && (randint() % 1024) >= keep * 1024)
+          continue;
+      }
+      return entry;
+    }
+    // almost nothing is usable, settle for whatever is
+    const size_t start = randint() % sz;
+    for(size_t idx = 0; idx < sz; ++idx)
+    {
+      const auto &entry = set.items[(start + idx) % sz];
+      if(usable(entry))
+        return entry;
+    }
+    return nullptr;
+  }
+}  // namespace llarp
@@ -0,0 +1,86 @@
+#ifndef LLARP_NODEDB_INDEX_HPP
+#define LLARP_NODEDB_INDEX_HPP
+
+#include <router_contact.hpp>
+#include <router_id.hpp>
+#include <util/threading.hpp>
+#include <util/types.hpp>
+
+#include <absl/base/thread_annotations.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp
+{
+  /// dense sets of the rcs a nodedb can hand out as path hops or exits, so
+  /// picking one at random does not walk the whole nodedb. entries are swap
+  /// removed and have their own lock, selecting only takes it shared.
+  class SelectionIndex
+  {
+   public:
+    /// candidates rejected by this are never picked
+    using Filter = std::function< bool(const RouterContact &) >;
+    /// chance in [0, 1] of keeping a candidate once picked
+    using Weight = std::function< double(const RouterID &) >;
+
+    /// random picks made before falling back to a scan
+    static constexpr size_t MaxTries = 32;
+
+    /// insert or replace rc in every set it belongs to
+    void
+    Put(const RouterContact &rc) LOCKS_EXCLUDED(m_Access);
+
+    bool
+    Remove(const RouterID &pk) LOCKS_EXCLUDED(m_Access);
+
+    void
+    Clear() LOCKS_EXCLUDED(m_Access);
+
+    /// routers with addresses that were not expired when put
+    size_t
+    NumHops() const LOCKS_EXCLUDED(m_Access);
+
+    size_t
+    NumExits() const LOCKS_EXCLUDED(m_Access);
+
+    /// pick a random hop that is not expired at now and passes accept,
+    /// weight skews the pick towards candidates it rates higher
+    bool
+    RandomHop(llarp_time_t now, RouterContact &result, const Filter &accept,
+              const Weight &weight = nullptr) const LOCKS_EXCLUDED(m_Access);
+
+    bool
+    RandomExit(RouterContact &result) const LOCKS_EXCLUDED(m_Access);
+
+   private:
+    using Entry = std::shared_ptr< const RouterContact >;
+
+    struct Set
+    {
+      std::vector< Entry > items;
+      std::unordered_map< RouterID, size_t, RouterID::Hash > position;
+
+      void
+      Put(const Entry &entry);
+
+      bool
+      Remove(const RouterID &pk);
+
+      void
+      Clear();
+    };
+
+    Entry
+    Pick(const Set &set, llarp_time_t now, const Filter &accept,
+         const Weight &weight) const SHARED_LOCKS_REQUIRED(m_Access);
+
+    mutable util::Mutex m_Access;  // protects m_Hops, m_Exits
+    Set m_Hops GUARDED_BY(m_Access);
+    Set m_Exits GUARDED_BY(m_Access);
+  };
+}  // namespace llarp
+
+#endif
@@ -0,0 +1,114 @@
+#include <path/build_pipeline.hpp>
+
+#include <util/logic.hpp>
+#include <util/metrics.hpp>
+
+#include <algorithm>
+#include <memory>
+
+namespace llarp
+{
+  namespace path
+  {
+    constexpr size_t BuildPipeline::MaxBatch;
+
+    BuildPipeline::BuildPipeline(Logic* logic, llarp_threadpool* worker)
+        : m_Logic(logic), m_Worker(worker)
+    {
+      m_InFlight.store(0);
+    }
+
+    BuildPipeline::~BuildPipeline()
+    {
+    }
+
+    void
+    BuildPipeline::Queue(Work work)
+    {
+      m_Pending.emplace_back(std::move(work));
+      if(m_Pending.size() >= MaxBatch)
+      {
+        Flush();
+        return;
+      }
+      if(m_FlushQueued)
+        return;
+      // runs after whatever else the logic thread has queued up, so every
+      // build request read in the same event loop pass lands in one batch
+      m_FlushQueued = true;
+      m_Logic->queue_func([this]() {
+        m_FlushQueued = false;
+        Flush();
+      });
+    }
+
+    void
+    BuildPipeline::Flush()
+    {
+      if(m_Pending.empty())
+        return;
+      const size_t num   = m_Pending.size();
+      const size_t depth = num + m_InFlight.load();
+      METRICS_DYNAMIC_INT_UPDATE("path.build", "queue_depth", depth);
+      METRICS_DYNAMIC_INT_UPDATE("path.build", "batch_size", num);
+      ++m_Batches;
+      m_Jobs += num;
+      m_LargestBatch = std::max(m_LargestBatch, num);
+
+      // deal the jobs out round robin so a storm of one kind of job does not
+      // end up on one worker
+      const size_t chunks = std::min(num, NumChunks());
+      std::vector< std::shared_ptr< std::vector< Work > > > work(chunks);
+      for(auto& chunk : work)
+      {
+        chunk = std::make_shared< std::vector< Work > >();
+        chunk->reserve((num / chunks) + 1);
+      }
+      for(size_t idx = 0; idx < num; ++idx)
+        work[idx % chunks]->emplace_back(std::move(m_Pending[idx]));
+      m_Pending.clear();
+
+      m_InFlight += num;
+      for(auto& chunk : work)
+      {
+        m_Worker->QueueFunc([this, chunk]() { RunChunk(*chunk); });
+      }
+    }
+
+    void
+    BuildPipeline::RunChunk(std::vector< Work >& chunk)
+    {
+      for(auto& work : chunk)
+      {
+        work();
+        --m_InFlight;
+      }
+    }
+
+    size_t
+    BuildPipeline::NumChunks() const
+    {
+      if(m_Worker->impl)
+        return std::max(m_Worker->impl->threadCount(), size_t(1));
+      return 1;
+    }
+
+    void
+    BuildPipeline::RecordLatency(const char* metric, llarp_time_t started,
+                                 llarp_time_t now)
+    {
+      METRICS_DYNAMIC_HISTOGRAM_UPDATE(
+          "path.build", metric, double(now >= started ? now - started : 0));
+    }
+
+    util::StatusObject
+    BuildPipeline::ExtractStatus() const
+    {
+      return util::StatusObject{{"pending", uint64_t(Pending())},
+                                {"inflight", uint64_t(InFlight())},
+                                {"batches", m_Batches},
+                                {"jobs", m_Jobs},
+                                {"largestBatch", uint64_t(m_LargestBatch)}};
+    }
+  }  // namespace path
+}  // namespace llarp
@@ -0,0 +1,86 @@
+#ifndef LLARP_PATH_BUILD_PIPELINE_HPP
+#define LLARP_PATH_BUILD_PIPELINE_HPP
+
+#include <util/status.hpp>
+#include <util/threadpool.h>
+#include <util/types.hpp>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace llarp
+{
+  class Logic;
+
+  namespace path
+  {
+    /// batches path build crypto, both the LRCM frames we are asked to
+    /// decrypt and the per hop key exchanges for paths we build ourselves
+    ///
+    /// work queued while the logic thread is busy (i.e. everything one pass of
+    /// the event loop reads off the wire) is flushed together and split into
+    /// one chunk per worker thread, so a build storm costs a handful of pool
+    /// jobs and keeps every worker doing dh instead of queueing behind one
+    struct BuildPipeline
+    {
+      using Work = std::function< void(void) >;
+
+      /// flush early once this many are waiting
+      static constexpr size_t MaxBatch = 256;
+
+      BuildPipeline(Logic* logic, llarp_threadpool* worker);
+
+      ~BuildPipeline();
+
+      /// queue crypto work, called from the logic thread
+      void
+      Queue(Work work);
+
+      /// hand everything queued to the workers now, called from the logic
+      /// thread
+      void
+      Flush();
+
+      /// number of jobs waiting to be flushed
+      size_t
+      Pending() const
+      {
+        return m_Pending.size();
+      }
+
+      /// number of jobs handed to workers that have not finished yet
+      size_t
+      InFlight() const
+      {
+        return m_InFlight.load();
+      }
+
+      /// record how long a build step took in ms
+      static void
+      RecordLatency(const char* metric, llarp_time_t started,
+                    llarp_time_t now);
+
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      void
+      RunChunk(std::vector< Work >& chunk);
+
+      size_t
+      NumChunks() const;
+
+      Logic* m_Logic;
+      llarp_threadpool* m_Worker;
+      std::vector< Work > m_Pending;
+      bool m_FlushQueued = false;
+      std::atomic< size_t > m_InFlight;
+      uint64_t m_Batches    = 0;
+      uint64_t m_Jobs       = 0;
+      size_t m_LargestBatch = 0;
+    };
+  }  // namespace path
+}  // namespace llarp
+
+#endif
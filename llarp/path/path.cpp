@@ -6,12 +6,14 @@
 #include <messages/path_latency.hpp>
 #include <messages/relay_commit.hpp>
 #include <messages/transfer_traffic.hpp>
+#include <path/build_pipeline.hpp>
 #include <path/pathbuilder.hpp>
 #include <profiling.hpp>
 #include <router/abstractrouter.hpp>
 #include <util/buffer.hpp>
 #include <util/endian.hpp>
 
+#include <array>
 #include <deque>
 
 namespace llarp
@@ -31,7 +33,9 @@ namespace llarp
     }
 
     PathContext::PathContext(AbstractRouter* router)
-        : m_Router(router), m_AllowTransit(false)
+        : m_Router(router)
+        , m_TransitExpiry(transit_expiry_resolution, time_now_ms())
+        , m_AllowTransit(false)
     {
     }
 
@@ -57,6 +61,24 @@ namespace llarp
       return m_Router->threadpool();
     }
 
+    BuildPipeline&
+    PathContext::Pipeline()
+    {
+      if(!m_Pipeline)
+        m_Pipeline = std::make_unique< BuildPipeline >(Logic(), Worker());
+      return *m_Pipeline;
+    }
+
+    util::StatusObject
+    PathContext::ExtractStatus() const
+    {
+      util::StatusObject obj{{"allowTransit", m_AllowTransit},
+                             {"transitHops", m_TransitPaths.Size()}};
+      if(m_Pipeline)
+        obj.Put("buildPipeline", m_Pipeline->ExtractStatus());
+      return obj;
+    }
+
     Crypto*
     PathContext::Crypto()
     {
@@ -163,10 +185,9 @@ namespace llarp
     bool
     PathContext::HasTransitHop(const TransitHopInfo& info)
     {
-      return MapHas(m_TransitPaths, info.txID,
-                    [info](const std::shared_ptr< TransitHop >& hop) -> bool {
-                      return info == hop->info;
-                    });
+      return m_TransitPaths.Has(info.txID, [&info](const TransitHop& hop) {
+        return info == hop.info;
+      });
     }
 
     IHopHandler*
@@ -183,36 +204,26 @@ namespace llarp
       if(own)
         return own;
 
-      return MapGet(m_TransitPaths, id,
-                    [remote](const std::shared_ptr< TransitHop >& hop) -> bool {
-                      return hop->info.upstream == remote;
-                    },
-                    [](const std::shared_ptr< TransitHop >& h) -> IHopHandler* {
-                      return h.get();
-                    });
+      return m_TransitPaths.Find(id, [&remote](const TransitHop& hop) {
+        return hop.info.upstream == remote;
+      });
     }
 
     bool
     PathContext::TransitHopPreviousIsRouter(const PathID_t& path,
                                             const RouterID& otherRouter)
     {
-      util::Lock lock(&m_TransitPaths.first);
-      auto itr = m_TransitPaths.second.find(path);
-      if(itr == m_TransitPaths.second.end())
-        return false;
-      return itr->second->info.downstream == otherRouter;
+      return m_TransitPaths.Has(path, [&otherRouter](const TransitHop& hop) {
+        return hop.info.downstream == otherRouter;
+      });
     }
 
     IHopHandler*
     PathContext::GetByDownstream(const RouterID& remote, const PathID_t& id)
     {
-      return MapGet(m_TransitPaths, id,
-                    [remote](const std::shared_ptr< TransitHop >& hop) -> bool {
-                      return hop->info.downstream == remote;
-                    },
-                    [](const std::shared_ptr< TransitHop >& h) -> IHopHandler* {
-                      return h.get();
-                    });
+      return m_TransitPaths.Find(id, [&remote](const TransitHop& hop) {
+        return hop.info.downstream == remote;
+      });
     }
 
     PathSet*
@@ -243,41 +254,38 @@ namespace llarp
     IHopHandler*
     PathContext::GetPathForTransfer(const PathID_t& id)
     {
-      RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        util::Lock lock(&map.first);
-        auto range = map.second.equal_range(id);
-        for(auto i = range.first; i != range.second; ++i)
-        {
-          if(i->second->info.upstream == us)
-            return i->second.get();
-        }
-      }
-      return nullptr;
+      const RouterID us(OurRouterID());
+      return m_TransitPaths.Find(
+          id, [&us](const TransitHop& hop) { return hop.info.upstream == us; });
     }
 
     void
     PathContext::PutTransitHop(std::shared_ptr< TransitHop > hop)
     {
-      MapPut(m_TransitPaths, hop->info.txID, hop);
-      MapPut(m_TransitPaths, hop->info.rxID, hop);
+      {
+        util::Lock lock(&m_ExpiryMutex);
+        m_TransitExpiry.Add(hop->ExpireTime(), hop);
+      }
+      m_TransitPaths.Put(hop->info.txID, hop);
+      m_TransitPaths.Put(hop->info.rxID, std::move(hop));
     }
 
     void
     PathContext::ExpirePaths(llarp_time_t now)
     {
-      util::Lock lock(&m_TransitPaths.first);
-      auto& map = m_TransitPaths.second;
-      auto itr  = map.begin();
-      while(itr != map.end())
       {
-        if(itr->second->Expired(now))
-        {
-          itr = map.erase(itr);
-        }
-        else
-          ++itr;
+        util::Lock lock(&m_ExpiryMutex);
+        m_TransitExpiry.Advance(
+            now, [&](std::shared_ptr< TransitHop >&& hop) {
+              // the lifetime may have grown since the hop was filed
+              if(!hop->Expired(now))
+              {
+                m_TransitExpiry.Add(hop->ExpireTime(), std::move(hop));
+                return;
+              }
+              m_TransitPaths.Remove(hop->info.txID, hop.get());
+              m_TransitPaths.Remove(hop->info.rxID, hop.get());
+            });
       }
 
       for(auto& builder : m_PathBuilders)
@@ -317,18 +325,9 @@ namespace llarp
       }
       if(h)
         return h;
-      RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        util::Lock lock(&map.first);
-        auto range = map.second.equal_range(id);
-        for(auto i = range.first; i != range.second; ++i)
-        {
-          if(i->second->info.upstream == us)
-            return i->second.get();
-        }
-      }
-      return nullptr;
+      const RouterID us(OurRouterID());
+      return m_TransitPaths.Find(
+          id, [&us](const TransitHop& hop) { return hop.info.upstream == us; });
     }
 
     void
@@ -512,6 +511,7 @@ namespace llarp
                              {"expiresSoon", ExpiresSoon(now)},
                              {"expiresAt", ExpireTime()},
                              {"ready", IsReady()},
+                             {"congested", IsCongested(now)},
                              {"hasExit", SupportsAnyRoles(ePathRoleExit)}};
 
       std::vector< util::StatusObject > hopsObj;
@@ -606,22 +606,41 @@ namespace llarp
     }
 
     bool
-    Path::HandleUpstream(const llarp_buffer_t& buf, const TunnelNonce& Y,
+    Path::HandleUpstream(PacketBuffer& X, const TunnelNonce& Y,
                          AbstractRouter* r)
     {
+      // all layers go on in one pass over the packet
+      std::array< SharedSecret, max_len > keys;
+      std::array< TunnelNonce, max_len > nonces;
       TunnelNonce n = Y;
+      size_t idx    = 0;
       for(const auto& hop : hops)
       {
-        r->crypto()->xchacha20(buf, hop.shared, n);
+        keys[idx]     = hop.shared;
+        nonces[idx++] = n;
         n ^= hop.nonceXOR;
       }
+      if(!r->crypto()->xchacha20_onion(&X, 1, keys.data(), nonces.data(),
+                                       idx))
+      {
+        LogError("failed to encrypt upstream on ", Name());
+        return false;
+      }
       RelayUpstreamMessage msg;
-      msg.X      = buf;
+      msg.X      = X;
       msg.Y      = Y;
       msg.pathid = TXID();
       if(r->SendToOrQueue(Upstream(), &msg))
+      {
+        // queued but backing up, steer away before it starts refusing
+        if(r->IsCongested(Upstream()))
+          m_LastCongested = r->Now();
         return true;
-      LogError("send to ", Upstream(), " failed");
+      }
+      // our first hop is backed up, the path set prefers other paths until
+      // this wears off
+      m_LastCongested = r->Now();
+      LogDebug("send to ", Upstream(), " failed, congested");
       return false;
     }
 
@@ -647,15 +666,26 @@ namespace llarp
     }
 
     bool
-    Path::HandleDownstream(const llarp_buffer_t& buf, const TunnelNonce& Y,
+    Path::HandleDownstream(PacketBuffer& X, const TunnelNonce& Y,
                            AbstractRouter* r)
     {
+      std::array< SharedSecret, max_len > keys;
+      std::array< TunnelNonce, max_len > nonces;
       TunnelNonce n = Y;
+      size_t idx    = 0;
       for(const auto& hop : hops)
       {
         n ^= hop.nonceXOR;
-        r->crypto()->xchacha20(buf, hop.shared, n);
+        keys[idx]     = hop.shared;
+        nonces[idx++] = n;
       }
+      if(!r->crypto()->xchacha20_onion(&X, 1, keys.data(), nonces.data(),
+                                       idx))
+      {
+        LogError("failed to decrypt downstream on ", Name());
+        return false;
+      }
+      const llarp_buffer_t buf(X);
       if(!HandleRoutingMessage(buf, r))
         return false;
       m_LastRecvMessage = r->Now();
@@ -694,8 +724,8 @@ namespace llarp
     bool
     Path::SendRoutingMessage(const routing::IMessage* msg, AbstractRouter* r)
     {
-      std::array< byte_t, MAX_LINK_MSG_SIZE / 2 > tmp;
-      llarp_buffer_t buf(tmp);
+      PacketBuffer pkt = PacketBuffer::Alloc(MAX_LINK_MSG_SIZE / 2);
+      llarp_buffer_t buf(pkt);
       // should help prevent bad paths with uninitialized members
       // FIXME: Why would we get uninitialized IMessages?
       if(msg->version != LLARP_PROTO_VERSION)
@@ -717,8 +747,9 @@ namespace llarp
         r->crypto()->randbytes(buf.cur, pad_size - buf.sz);
         buf.sz = pad_size;
       }
-      buf.cur = buf.base;
-      return HandleUpstream(buf, N, r);
+      if(!pkt.Resize(buf.sz))
+        return false;
+      return HandleUpstream(pkt, N, r);
     }
 
     bool
@@ -753,6 +784,7 @@ namespace llarp
         intro.expiresAt = buildStarted + hops[0].lifetime;
 
         r->routerProfiling().MarkPathSuccess(this);
+        BuildPipeline::RecordLatency("confirm_ms", buildStarted, now);
 
         // persist session with upstream router until the path is done
         r->PersistSessionUntil(Upstream(), intro.expiresAt);
@@ -7,18 +7,22 @@
 #include <path/path_types.hpp>
 #include <path/pathbuilder.hpp>
 #include <path/pathset.hpp>
+#include <path/transit_table.hpp>
 #include <router_id.hpp>
 #include <routing/handler.hpp>
 #include <routing/message.hpp>
 #include <service/Intro.hpp>
 #include <util/aligned.hpp>
+#include <util/packet_buffer.hpp>
 #include <util/threading.hpp>
 #include <util/time.hpp>
+#include <util/timing_wheel.hpp>
 
 #include <algorithm>
 #include <functional>
 #include <list>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -32,6 +36,8 @@ namespace llarp
 
   namespace path
   {
+    struct BuildPipeline;
+
     /// maximum path length
     constexpr size_t max_len = 8;
     /// default path length
@@ -49,6 +55,13 @@ namespace llarp
     /// if a path is inactive for this amount of time it's dead
     constexpr llarp_time_t alive_timeout = 60000;
 
+    /// transit hops are expired at most this many ms late
+    constexpr llarp_time_t transit_expiry_resolution = 100;
+
+    /// steer traffic away from a path for this many ms after its first hop
+    /// refused a message
+    constexpr llarp_time_t congestion_backoff = 2000;
+
     struct TransitHopInfo
     {
       TransitHopInfo() = default;
@@ -128,12 +141,12 @@ namespace llarp
 
       // handle data in upstream direction
       virtual bool
-      HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y,
+      HandleUpstream(PacketBuffer& X, const TunnelNonce& Y,
                      AbstractRouter* r) = 0;
 
       // handle data in downstream direction
       virtual bool
-      HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y,
+      HandleDownstream(PacketBuffer& X, const TunnelNonce& Y,
                        AbstractRouter* r) = 0;
 
       /// return timestamp last remote activity happened at
@@ -165,6 +178,11 @@ namespace llarp
       llarp_time_t lifetime = default_lifetime;
       llarp_proto_version_t version;
       llarp_time_t m_LastActivity = 0;
+      /// sessions we last relayed over in each direction, so relaying
+      /// does not look the peer up every time. they go away with the
+      /// session and are reset whenever a send has to be queued
+      std::weak_ptr< ILinkSession > m_UpstreamSession;
+      std::weak_ptr< ILinkSession > m_DownstreamSession;
 
       bool
       IsEndpoint(const RouterID& us) const
@@ -264,13 +282,18 @@ namespace llarp
 
       // handle data in upstream direction
       bool
-      HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y,
+      HandleUpstream(PacketBuffer& X, const TunnelNonce& Y,
                      AbstractRouter* r) override;
 
       // handle data in downstream direction
       bool
-      HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y,
+      HandleDownstream(PacketBuffer& X, const TunnelNonce& Y,
                        AbstractRouter* r) override;
+
+     private:
+      /// should we drop what we relay to next because its queue backed up
+      static bool
+      ShedRelay(const RouterID& next, AbstractRouter* r);
     };
 
     inline std::ostream&
@@ -502,17 +525,24 @@ namespace llarp
 
       // handle data in upstream direction
       bool
-      HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y,
+      HandleUpstream(PacketBuffer& X, const TunnelNonce& Y,
                      AbstractRouter* r) override;
 
       // handle data in downstream direction
       bool
-      HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y,
+      HandleDownstream(PacketBuffer& X, const TunnelNonce& Y,
                        AbstractRouter* r) override;
 
       bool
       IsReady() const;
 
+      /// true if our first hop dropped a message recently
+      bool
+      IsCongested(llarp_time_t now) const
+      {
+        return m_LastCongested && now < m_LastCongested + congestion_backoff;
+      }
+
       // Is this deprecated?
       // nope not deprecated :^DDDD
       PathID_t
@@ -565,6 +595,7 @@ namespace llarp
       std::vector< ObtainedExitHandler > m_ObtainedExitHooks;
       llarp_time_t m_LastRecvMessage     = 0;
       llarp_time_t m_LastLatencyTestTime = 0;
+      llarp_time_t m_LastCongested       = 0;
       uint64_t m_LastLatencyTestID       = 0;
       uint64_t m_UpdateExitTX            = 0;
       uint64_t m_CloseExitTX             = 0;
@@ -660,15 +691,6 @@ namespace llarp
       void
       RemovePathSet(PathSet* set);
 
-      using TransitHopsMap_t =
-          std::multimap< PathID_t, std::shared_ptr< TransitHop > >;
-
-      struct SyncTransitMap_t
-      {
-        util::Mutex first;  // protects second
-        TransitHopsMap_t second GUARDED_BY(first);
-      };
-
       // maps path id -> pathset owner of path
       using OwnedPathsMap_t = std::map< PathID_t, PathSet* >;
 
@@ -681,6 +703,13 @@ namespace llarp
       llarp_threadpool*
       Worker();
 
+      /// batches build crypto onto the worker pool
+      BuildPipeline&
+      Pipeline();
+
+      util::StatusObject
+      ExtractStatus() const;
+
       llarp::Crypto*
       Crypto();
 
@@ -698,10 +727,15 @@ namespace llarp
 
      private:
       AbstractRouter* m_Router;
-      SyncTransitMap_t m_TransitPaths;
-      SyncTransitMap_t m_Paths;
+      TransitHopTable m_TransitPaths;
+      /// every transit hop filed under when it runs out, so expiry only
+      /// looks at the hops that are due
+      util::Mutex m_ExpiryMutex;  // protects m_TransitExpiry
+      util::TimingWheel< std::shared_ptr< TransitHop > > m_TransitExpiry
+          GUARDED_BY(m_ExpiryMutex);
       SyncOwnedPathsMap_t m_OurPaths;
       std::list< Builder* > m_PathBuilders;
+      std::unique_ptr< BuildPipeline > m_Pipeline;
       bool m_AllowTransit;
     };
   }  // namespace path
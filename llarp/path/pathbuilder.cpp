@@ -2,12 +2,15 @@
 
 #include <messages/relay_commit.hpp>
 #include <nodedb.hpp>
+#include <path/build_pipeline.hpp>
 #include <path/path.hpp>
 #include <profiling.hpp>
 #include <router/abstractrouter.hpp>
 #include <util/buffer.hpp>
 #include <util/logic.hpp>
+#include <util/time.hpp>
 
+#include <atomic>
 #include <functional>
 
 namespace llarp
@@ -23,12 +26,15 @@ namespace llarp
     User* user = nullptr;
 
     Handler result;
-    size_t idx               = 0;
-    AbstractRouter* router   = nullptr;
-    llarp_threadpool* worker = nullptr;
-    Logic* logic             = nullptr;
-    Crypto* crypto           = nullptr;
+    AbstractRouter* router = nullptr;
+    Logic* logic           = nullptr;
+    Crypto* crypto         = nullptr;
     LR_CommitMessage LRCM;
+    /// hops still being generated
+    std::atomic< size_t > pending;
+    std::atomic< bool > failed;
+    /// when we started generating keys
+    llarp_time_t started = 0;
 
     ~AsyncPathKeyExchangeContext()
     {
@@ -41,37 +47,35 @@ namespace llarp
     {
       AsyncPathKeyExchangeContext< User >* ctx =
           static_cast< AsyncPathKeyExchangeContext< User >* >(u);
+      path::BuildPipeline::RecordLatency("keygen_ms", ctx->started,
+                                         time_now_ms());
       ctx->result(ctx);
       delete ctx;
     }
 
-    static void
-    GenerateNextKey(void* u)
+    /// key exchange and commit record for one hop, hops only read each
+    /// other's rc so they all run at the same time
+    bool
+    GenerateKey(size_t idx)
     {
-      AsyncPathKeyExchangeContext< User >* ctx =
-          static_cast< AsyncPathKeyExchangeContext< User >* >(u);
-
       // current hop
-      auto& hop   = ctx->path->hops[ctx->idx];
-      auto& frame = ctx->LRCM.frames[ctx->idx];
+      auto& hop   = path->hops[idx];
+      auto& frame = LRCM.frames[idx];
 
       // generate key
-      ctx->crypto->encryption_keygen(hop.commkey);
+      crypto->encryption_keygen(hop.commkey);
       hop.nonce.Randomize();
       // do key exchange
-      if(!ctx->crypto->dh_client(hop.shared, hop.rc.enckey, hop.commkey,
-                                 hop.nonce))
+      if(!crypto->dh_client(hop.shared, hop.rc.enckey, hop.commkey, hop.nonce))
       {
-        LogError(ctx->pathset->Name(),
+        LogError(pathset->Name(),
                  " Failed to generate shared key for path build");
-        delete ctx;
-        return;
+        return false;
       }
       // generate nonceXOR valueself->hop->pathKey
-      ctx->crypto->shorthash(hop.nonceXOR, llarp_buffer_t(hop.shared));
-      ++ctx->idx;
+      crypto->shorthash(hop.nonceXOR, llarp_buffer_t(hop.shared));
 
-      bool isFarthestHop = ctx->idx == ctx->path->hops.size();
+      bool isFarthestHop = idx + 1 == path->hops.size();
 
       LR_CommitRecord record;
       if(isFarthestHop)
@@ -80,10 +84,10 @@ namespace llarp
       }
       else
       {
-        hop.upstream = ctx->path->hops[ctx->idx].rc.pubkey;
-        if(ctx->pathset->ShouldBundleRC())
+        hop.upstream = path->hops[idx + 1].rc.pubkey;
+        if(pathset->ShouldBundleRC())
           record.nextRC =
-              std::make_unique< RouterContact >(ctx->path->hops[ctx->idx].rc);
+              std::make_unique< RouterContact >(path->hops[idx + 1].rc);
       }
       // build record
 
@@ -100,54 +104,63 @@ namespace llarp
       if(!record.BEncode(&buf))
       {
         // failed to encode?
-        LogError(ctx->pathset->Name(), " Failed to generate Commit Record");
+        LogError(pathset->Name(), " Failed to generate Commit Record");
         DumpBuffer(buf);
-        delete ctx;
-        return;
+        return false;
       }
       frame.Resize(buf.cur - buf.base);
       // use ephemeral keypair for frame
       SecretKey framekey;
-      ctx->crypto->encryption_keygen(framekey);
-      if(!frame.EncryptInPlace(framekey, hop.rc.enckey, ctx->crypto))
+      crypto->encryption_keygen(framekey);
+      if(!frame.EncryptInPlace(framekey, hop.rc.enckey, crypto))
       {
-        LogError(ctx->pathset->Name(), " Failed to encrypt LRCR");
-        delete ctx;
-        return;
+        LogError(pathset->Name(), " Failed to encrypt LRCR");
+        return false;
       }
+      return true;
+    }
 
-      if(isFarthestHop)
-      {
-        // farthest hop
-        ctx->logic->queue_job({ctx, &HandleDone});
-      }
+    /// called in a worker when a hop is done, the last one hands the LRCM
+    /// back to the logic thread
+    void
+    HopDone(bool success)
+    {
+      if(!success)
+        failed.store(true);
+      if(--pending)
+        return;
+      if(failed.load())
+        delete this;
       else
-      {
-        // next hop
-        llarp_threadpool_queue_job(ctx->worker, {ctx, &GenerateNextKey});
-      }
+        logic->queue_job({this, &HandleDone});
     }
 
     AsyncPathKeyExchangeContext(Crypto* c) : crypto(c)
     {
+      pending.store(0);
+      failed.store(false);
     }
 
     /// Generate all keys asynchronously and call handler when done
     void
-    AsyncGenerateKeys(Path_t* p, Logic* l, llarp_threadpool* pool, User* u,
-                      Handler func)
+    AsyncGenerateKeys(Path_t* p, Logic* l, path::BuildPipeline* pipeline,
+                      User* u, Handler func)
     {
-      path   = p;
-      logic  = l;
-      user   = u;
-      result = func;
-      worker = pool;
+      path    = p;
+      logic   = l;
+      user    = u;
+      result  = func;
+      started = time_now_ms();
 
       for(size_t idx = 0; idx < path::max_len; ++idx)
       {
         LRCM.frames[idx].Randomize();
       }
-      llarp_threadpool_queue_job(pool, {this, &GenerateNextKey});
+      pending.store(path->hops.size());
+      for(size_t idx = 0; idx < path->hops.size(); ++idx)
+      {
+        pipeline->Queue([this, idx]() { HopDone(GenerateKey(idx)); });
+      }
     }
   };
 
@@ -229,13 +242,18 @@ namespace llarp
         return got;
       }
       std::set< RouterID > exclude = {prev.pubkey};
+      auto& profiling              = router->routerProfiling();
+      // favour routers that paths were built over before
+      auto weight = [&](const RouterID& r) -> double {
+        return profiling.PathWeight(r);
+      };
       do
       {
         cur.Clear();
         --tries;
-        if(db->select_random_hop_excluding(cur, exclude))
+        if(db->select_random_hop_excluding(cur, exclude, weight))
         {
-          if(!router->routerProfiling().IsBadForPath(cur.pubkey))
+          if(!profiling.IsBadForPath(cur.pubkey))
             return true;
           exclude.insert(cur.pubkey);
         }
@@ -344,7 +362,8 @@ namespace llarp
       auto path    = new path::Path(hops, this, roles);
       path->SetBuildResultHook([this](Path* p) { this->HandlePathBuilt(p); });
       ++keygens;
-      ctx->AsyncGenerateKeys(path, router->logic(), router->threadpool(), this,
+      ctx->AsyncGenerateKeys(path, router->logic(),
+                             &router->pathContext().Pipeline(), this,
                              &PathBuilderKeysGenerated);
     }
 
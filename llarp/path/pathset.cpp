@@ -90,7 +90,9 @@ namespace llarp
     PathSet::GetEstablishedPathClosestTo(RouterID id, PathRole roles) const
     {
       Lock_t l(&m_PathsMutex);
-      Path* path = nullptr;
+      const auto now = Now();
+      Path* path     = nullptr;
+      bool congested = true;
       AlignedBuffer< 32 > dist;
       AlignedBuffer< 32 > to = id;
       dist.Fill(0xff);
@@ -100,11 +102,16 @@ namespace llarp
           continue;
         if(!item.second->SupportsAnyRoles(roles))
           continue;
+        // a congested path only wins if there is nothing else
+        const bool itemCongested = item.second->IsCongested(now);
+        if(itemCongested && !congested)
+          continue;
         AlignedBuffer< 32 > localDist = item.second->Endpoint() ^ to;
-        if(localDist < dist)
+        if(localDist < dist || (congested && !itemCongested))
         {
-          dist = localDist;
-          path = item.second;
+          dist      = localDist;
+          path      = item.second;
+          congested = itemCongested;
         }
       }
       return path;
@@ -114,8 +121,9 @@ namespace llarp
     PathSet::GetNewestPathByRouter(RouterID id, PathRole roles) const
     {
       Lock_t l(&m_PathsMutex);
-      Path* chosen = nullptr;
-      auto itr     = m_Paths.begin();
+      const auto now = Now();
+      Path* chosen   = nullptr;
+      auto itr       = m_Paths.begin();
       while(itr != m_Paths.end())
       {
         if(itr->second->IsReady() && itr->second->SupportsAnyRoles(roles))
@@ -124,6 +132,13 @@ namespace llarp
           {
             if(chosen == nullptr)
               chosen = itr->second;
+            else if(chosen->IsCongested(now)
+                    != itr->second->IsCongested(now))
+            {
+              // a congested path only wins if there is nothing else
+              if(chosen->IsCongested(now))
+                chosen = itr->second;
+            }
             else if(chosen->intro.expiresAt < itr->second->intro.expiresAt)
               chosen = itr->second;
           }
@@ -137,8 +152,9 @@ namespace llarp
     PathSet::GetPathByRouter(RouterID id, PathRole roles) const
     {
       Lock_t l(&m_PathsMutex);
-      Path* chosen = nullptr;
-      auto itr     = m_Paths.begin();
+      const auto now = Now();
+      Path* chosen   = nullptr;
+      auto itr       = m_Paths.begin();
       while(itr != m_Paths.end())
       {
         if(itr->second->IsReady() && itr->second->SupportsAnyRoles(roles))
@@ -147,6 +163,13 @@ namespace llarp
           {
             if(chosen == nullptr)
               chosen = itr->second;
+            else if(chosen->IsCongested(now)
+                    != itr->second->IsCongested(now))
+            {
+              // a congested path only wins if there is nothing else
+              if(chosen->IsCongested(now))
+                chosen = itr->second;
+            }
             else if(chosen->intro.latency > itr->second->intro.latency)
               chosen = itr->second;
           }
@@ -313,15 +336,24 @@ namespace llarp
     Path*
     PathSet::PickRandomEstablishedPath(PathRole roles) const
     {
-      std::vector< Path* > established;
+      std::vector< Path* > established, congested;
       Lock_t l(&m_PathsMutex);
-      auto itr = m_Paths.begin();
+      const auto now = Now();
+      auto itr       = m_Paths.begin();
       while(itr != m_Paths.end())
       {
         if(itr->second->IsReady() && itr->second->SupportsAnyRoles(roles))
-          established.push_back(itr->second);
+        {
+          if(itr->second->IsCongested(now))
+            congested.push_back(itr->second);
+          else
+            established.push_back(itr->second);
+        }
         ++itr;
       }
+      // only fall back to congested paths if they are all we have
+      if(established.empty())
+        established.swap(congested);
       auto sz = established.size();
       if(sz)
       {
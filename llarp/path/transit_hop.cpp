@@ -11,6 +11,7 @@
 #include <routing/handler.hpp>
 #include <util/buffer.hpp>
 #include <util/endian.hpp>
+#include <util/metrics.hpp>
 
 namespace llarp
 {
@@ -65,8 +66,8 @@ namespace llarp
       if(!IsEndpoint(r->pubkey()))
         return false;
 
-      std::array< byte_t, MAX_LINK_MSG_SIZE - 128 > tmp;
-      llarp_buffer_t buf(tmp);
+      PacketBuffer pkt = PacketBuffer::Alloc(MaxRelayPayloadSize);
+      llarp_buffer_t buf(pkt);
       if(!msg->BEncode(&buf))
       {
         llarp::LogError("failed to encode routing message");
@@ -84,44 +85,69 @@ namespace llarp
         r->crypto()->randbytes(buf.cur, dlt);
         buf.sz += dlt;
       }
-      buf.cur = buf.base;
-      return HandleDownstream(buf, N, r);
+      if(!pkt.Resize(buf.sz))
+        return false;
+      return HandleDownstream(pkt, N, r);
+    }
+
+    bool
+    TransitHop::ShedRelay(const RouterID& next, AbstractRouter* r)
+    {
+      // relayed traffic backs off first, the rest of a backed up peer's
+      // queue is left to our own paths and to control messages
+      if(!r->IsCongested(next))
+        return false;
+      METRICS_DYNAMIC_INCREMENT("path.transit", "drop_congested");
+      return true;
     }
 
     bool
-    TransitHop::HandleDownstream(const llarp_buffer_t& buf,
-                                 const TunnelNonce& Y, AbstractRouter* r)
+    TransitHop::HandleDownstream(PacketBuffer& X, const TunnelNonce& Y,
+                                 AbstractRouter* r)
     {
       RelayDownstreamMessage msg;
       msg.pathid = info.rxID;
       msg.Y      = Y ^ nonceXOR;
-      r->crypto()->xchacha20(buf, pathKey, Y);
-      msg.X = buf;
+      r->crypto()->xchacha20(llarp_buffer_t(X), pathKey, Y);
+      // shares the buffer, no copy
+      msg.X = X;
       llarp::LogDebug("relay ", msg.X.size(), " bytes downstream from ",
                       info.upstream, " to ", info.downstream);
-      return r->SendToOrQueue(info.downstream, &msg);
+      if(ShedRelay(info.downstream, r))
+        return false;
+      if(r->SendToOrQueueVia(m_DownstreamSession, info.downstream, &msg))
+        return true;
+      // the caller sends a discard back when it can, count it either way
+      METRICS_DYNAMIC_INCREMENT("path.transit", "drop_downstream");
+      return false;
     }
 
     bool
-    TransitHop::HandleUpstream(const llarp_buffer_t& buf, const TunnelNonce& Y,
+    TransitHop::HandleUpstream(PacketBuffer& X, const TunnelNonce& Y,
                                AbstractRouter* r)
     {
-      r->crypto()->xchacha20(buf, pathKey, Y);
+      r->crypto()->xchacha20(llarp_buffer_t(X), pathKey, Y);
       if(IsEndpoint(r->pubkey()))
       {
         m_LastActivity = r->Now();
-        return r->ParseRoutingMessageBuffer(buf, this, info.rxID);
+        return r->ParseRoutingMessageBuffer(llarp_buffer_t(X), this,
+                                            info.rxID);
       }
       else
       {
         RelayUpstreamMessage msg;
         msg.pathid = info.txID;
         msg.Y      = Y ^ nonceXOR;
-
-        msg.X = buf;
+        // shares the buffer, no copy
+        msg.X = X;
         llarp::LogDebug("relay ", msg.X.size(), " bytes upstream from ",
                         info.downstream, " to ", info.upstream);
-        return r->SendToOrQueue(info.upstream, &msg);
+        if(ShedRelay(info.upstream, r))
+          return false;
+        if(r->SendToOrQueueVia(m_UpstreamSession, info.upstream, &msg))
+          return true;
+        METRICS_DYNAMIC_INCREMENT("path.transit", "drop_upstream");
+        return false;
       }
     }
 
@@ -298,18 +324,21 @@ namespace llarp
         return SendRoutingMessage(&discarded, r);
       }
 
-      std::array< byte_t, service::MAX_PROTOCOL_MESSAGE_SIZE > tmp;
-      llarp_buffer_t buf(tmp);
+      PacketBuffer pkt =
+          PacketBuffer::Alloc(service::MAX_PROTOCOL_MESSAGE_SIZE);
+      llarp_buffer_t buf(pkt);
       if(!msg->T.BEncode(&buf))
       {
         llarp::LogWarn(info, " failed to transfer data message, encode failed");
         return SendRoutingMessage(&discarded, r);
       }
-      // rewind
-      buf.sz  = buf.cur - buf.base;
-      buf.cur = buf.base;
+      if(!pkt.Resize(buf.cur - buf.base))
+      {
+        llarp::LogWarn(info, " failed to transfer data message, too big");
+        return SendRoutingMessage(&discarded, r);
+      }
       // send
-      if(path->HandleDownstream(buf, msg->Y, r))
+      if(path->HandleDownstream(pkt, msg->Y, r))
         return true;
       return SendRoutingMessage(&discarded, r);
     }
@@ -0,0 +1,121 @@
+#include <path/transit_table.hpp>
+
+#include <crypto/crypto.hpp>
+#include <path/path.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace llarp
+{
+  namespace path
+  {
+    constexpr size_t TransitHopTable::NumShards;
+
+    /// slots a shard starts out with
+    static constexpr size_t MinSlots = 16;
+
+    TransitHopTable::TransitHopTable() : m_Seed(randint())
+    {
+    }
+
+    size_t
+    TransitHopTable::Hash(const PathID_t& id) const
+    {
+      static_assert(PATHIDSIZE == 2 * sizeof(uint64_t), "path id size");
+      uint64_t w[2];
+      std::memcpy(w, id.data(), sizeof(w));
+      uint64_t h = (w[0] ^ m_Seed) * 0x9E3779B97F4A7C15ULL;
+      h ^= (w[1] + (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+      return h ^ (h >> 32);
+    }
+
+    void
+    TransitHopTable::Grow(std::vector< Entry >& slots)
+    {
+      std::vector< Entry > old(std::max(slots.size() * 2, MinSlots));
+      old.swap(slots);
+      const size_t mask = slots.size() - 1;
+      for(auto& entry : old)
+      {
+        if(!entry.hop)
+          continue;
+        size_t idx = Home(entry.hash, mask);
+        while(slots[idx].hop)
+          idx = (idx + 1) & mask;
+        slots[idx] = std::move(entry);
+      }
+    }
+
+    void
+    TransitHopTable::Put(const PathID_t& id, std::shared_ptr< TransitHop > hop)
+    {
+      if(!hop)
+        return;
+      const size_t hash = Hash(id);
+      Shard& shard      = m_Shards[hash % NumShards];
+      util::Lock lock(&shard.mutex);
+      if((shard.count + 1) * 2 > shard.slots.size())
+        Grow(shard.slots);
+      const size_t mask = shard.slots.size() - 1;
+      size_t idx        = Home(hash, mask);
+      while(shard.slots[idx].hop)
+        idx = (idx + 1) & mask;
+      auto& entry = shard.slots[idx];
+      entry.hash  = hash;
+      entry.id    = id;
+      entry.hop   = std::move(hop);
+      ++shard.count;
+    }
+
+    bool
+    TransitHopTable::Remove(const PathID_t& id, const TransitHop* hop)
+    {
+      if(!hop)
+        return false;
+      const size_t hash = Hash(id);
+      Shard& shard      = m_Shards[hash % NumShards];
+      util::Lock lock(&shard.mutex);
+      if(shard.slots.empty())
+        return false;
+      auto& slots       = shard.slots;
+      const size_t mask = slots.size() - 1;
+      size_t hole       = Home(hash, mask);
+      while(slots[hole].hop.get() != hop || slots[hole].id != id)
+      {
+        if(!slots[hole].hop)
+          return false;
+        hole = (hole + 1) & mask;
+      }
+      // shift the rest of the run back over the hole so no lookup stops
+      // early at it, no tombstones to clean up later
+      for(size_t idx = (hole + 1) & mask; slots[idx].hop;
+          idx        = (idx + 1) & mask)
+      {
+        const size_t home = Home(slots[idx].hash, mask);
+        // an entry may only move back if the hole is still between its home
+        // and where it sits now
+        if(((idx - home) & mask) >= ((idx - hole) & mask))
+        {
+          slots[hole] = std::move(slots[idx]);
+          hole        = idx;
+        }
+      }
+      slots[hole].hop.reset();
+      --shard.count;
+      return true;
+    }
+
+    size_t
+    TransitHopTable::Size() const
+    {
+      size_t sz = 0;
+      for(const auto& shard : m_Shards)
+      {
+        util::Lock lock(&shard.mutex);
+        sz += shard.count;
+      }
+      return sz;
+    }
+  }  // namespace path
+}  // namespace llarp
@@ -0,0 +1,111 @@
+#ifndef LLARP_PATH_TRANSIT_TABLE_HPP
+#define LLARP_PATH_TRANSIT_TABLE_HPP
+
+#include <path/path_types.hpp>
+#include <util/threading.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace llarp
+{
+  namespace path
+  {
+    struct TransitHop;
+
+    /// the transit hops we relay for, keyed by both of their path ids
+    ///
+    /// split over shards with a lock each so relay lookups on different
+    /// paths don't queue up behind each other or behind expiry. every shard
+    /// is a linear probing table, one contiguous array that a lookup walks
+    /// a few slots of instead of chasing tree nodes. an id may be held by
+    /// more than one hop, callers pick the right one with a check on the hop.
+    class TransitHopTable
+    {
+     public:
+      static constexpr size_t NumShards = 16;
+
+      TransitHopTable();
+
+      /// add hop under id, keeps any other hops under the same id
+      void
+      Put(const PathID_t& id, std::shared_ptr< TransitHop > hop);
+
+      /// drop the entry that holds hop under id
+      /// returns false if there was none
+      bool
+      Remove(const PathID_t& id, const TransitHop* hop);
+
+      /// first hop under id that check(const TransitHop&) accepts, or
+      /// nullptr. the table keeps its own reference, the pointer stays good
+      /// until the hop is removed.
+      template < typename Check >
+      TransitHop*
+      Find(const PathID_t& id, Check check) const
+      {
+        const size_t hash = Hash(id);
+        const Shard& shard = m_Shards[hash % NumShards];
+        util::Lock lock(&shard.mutex);
+        if(shard.slots.empty())
+          return nullptr;
+        const size_t mask = shard.slots.size() - 1;
+        for(size_t idx = Home(hash, mask);; idx = (idx + 1) & mask)
+        {
+          const Entry& entry = shard.slots[idx];
+          if(!entry.hop)
+            return nullptr;
+          if(entry.hash == hash && entry.id == id && check(*entry.hop))
+            return entry.hop.get();
+        }
+      }
+
+      template < typename Check >
+      bool
+      Has(const PathID_t& id, Check check) const
+      {
+        return Find(id, check) != nullptr;
+      }
+
+      /// number of entries, a hop put under two ids counts twice
+      size_t
+      Size() const;
+
+     private:
+      struct Entry
+      {
+        size_t hash = 0;
+        PathID_t id;
+        std::shared_ptr< TransitHop > hop;
+      };
+
+      struct Shard
+      {
+        mutable util::Mutex mutex;  // protects slots and count
+        std::vector< Entry > slots GUARDED_BY(mutex);
+        size_t count GUARDED_BY(mutex) = 0;
+      };
+
+      /// path ids come off the wire, so they are mixed with a per table
+      /// seed to keep peers from piling theirs into one probe run
+      size_t
+      Hash(const PathID_t& id) const;
+
+      /// low bits pick the shard, the ones above pick the slot
+      static size_t
+      Home(size_t hash, size_t mask)
+      {
+        return (hash / NumShards) & mask;
+      }
+
+      /// double the slots, keeping the load at or under a half
+      static void
+      Grow(std::vector< Entry >& slots);
+
+      uint64_t m_Seed;
+      std::array< Shard, NumShards > m_Shards;
+    };
+  }  // namespace path
+}  // namespace llarp
+
+#endif
@@ -1,5 +1,6 @@
 #include <profiling.hpp>
 
+#include <algorithm>
 #include <fstream>
 
 namespace llarp
@@ -106,6 +107,21 @@ namespace llarp
     return !itr->second.IsGoodForConnect(chances);
   }
 
+  double
+  Profiling::PathWeight(const RouterID& r)
+  {
+    // never rule a router out entirely, its profile may be stale
+    static constexpr double MinWeight = 0.1;
+    lock_t lock(&m_ProfilesMutex);
+    auto itr = m_Profiles.find(r);
+    if(itr == m_Profiles.end())
+      return 1.0;
+    const auto& prof = itr->second;
+    const double weight = double(prof.pathSuccessCount + 1)
+        / double(prof.pathSuccessCount + prof.pathFailCount + 1);
+    return std::max(weight, MinWeight);
+  }
+
   bool
   Profiling::IsBadForPath(const RouterID& r, uint64_t chances)
   {
@@ -69,6 +69,11 @@ namespace llarp
     IsBadForPath(const RouterID& r, uint64_t chances = 8)
         LOCK_RETURNED(m_ProfilesMutex);
 
+    /// chance in [0, 1] of keeping r when picking it as a path hop, taken
+    /// from how many paths over it got built
+    double
+    PathWeight(const RouterID& r) LOCKS_EXCLUDED(m_ProfilesMutex);
+
     /// check if this router should be connected directly to
     bool
     IsBadForConnect(const RouterID& r, uint64_t chances = 8)
@@ -3,6 +3,7 @@
 
 #include <util/types.hpp>
 #include <util/status.hpp>
+#include <memory>
 #include <vector>
 #include <ev/ev.h>
 
@@ -152,6 +153,19 @@ namespace llarp
     virtual bool
     SendToOrQueue(const RouterID &remote, const ILinkMessage *msg) = 0;
 
+    /// SendToOrQueue, but first try session if it is still up. session is
+    /// pointed at the session msg went out on when nothing was queued ahead
+    /// of it and reset otherwise, so callers sending to remote over and over
+    /// skip finding its session every time
+    virtual bool
+    SendToOrQueueVia(std::weak_ptr< ILinkSession > &session,
+                     const RouterID &remote, const ILinkMessage *msg) = 0;
+
+    /// true if messages to remote are backing up, callers should steer
+    /// traffic elsewhere if they can
+    virtual bool
+    IsCongested(const RouterID &remote) const = 0;
+
     virtual void
     PersistSessionUntil(const RouterID &remote, llarp_time_t until) = 0;
 
@@ -0,0 +1,166 @@
+#include <router/outbound_queue.hpp>
+
+#include <constants/link_layer.hpp>
+#include <util/metrics.hpp>
+
+#include <cmath>
+
+namespace llarp
+{
+  constexpr size_t OutboundQueue::ControlByteLimit;
+  constexpr size_t OutboundQueue::BulkByteLimit;
+  constexpr llarp_time_t OutboundQueue::Target;
+  constexpr llarp_time_t OutboundQueue::Interval;
+
+  size_t
+  OutboundQueue::ByteLimit(LinkMessagePriority pri)
+  {
+    return pri == eLinkControl ? ControlByteLimit : BulkByteLimit;
+  }
+
+  bool
+  OutboundQueue::Push(PacketBuffer pkt, LinkMessagePriority pri,
+                      llarp_time_t now)
+  {
+    auto &cls = m_Classes[pri];
+    if(cls.bytes + pkt.size() > ByteLimit(pri))
+    {
+      ++cls.droppedFull;
+      METRICS_DYNAMIC_INCREMENT("router.sendq", "drop_full");
+      return false;
+    }
+    cls.bytes += pkt.size();
+    cls.msgs.emplace_back(Entry{std::move(pkt), now});
+    return true;
+  }
+
+  size_t
+  OutboundQueue::Pump(const SendFunc &send, llarp_time_t now,
+                      metrics::HistogramCollector *delay)
+  {
+    size_t sent = 0;
+    for(size_t pri = 0; pri < m_Classes.size(); ++pri)
+    {
+      auto &cls = m_Classes[pri];
+      // control messages are few and a late path build is still worth
+      // sending, only bulk gets shed
+      const bool codel = pri != eLinkControl;
+      while(!cls.msgs.empty())
+      {
+        if(codel && ShouldDrop(cls, now))
+        {
+          ++cls.droppedLate;
+          METRICS_DYNAMIC_INCREMENT("router.sendq", "drop_late");
+          PopFront(cls);
+          continue;
+        }
+        // the session is full, leave the rest for later
+        const auto &msg = cls.msgs.front();
+        if(!send(llarp_buffer_t(msg.pkt)))
+          return sent;
+        if(delay && delay->id().category()->enabled())
+          delay->tick(double(now >= msg.queued ? now - msg.queued : 0));
+        ++cls.sent;
+        ++sent;
+        PopFront(cls);
+      }
+    }
+    return sent;
+  }
+
+  bool
+  OutboundQueue::ShouldDrop(Class &cls, llarp_time_t now)
+  {
+    const llarp_time_t queued  = cls.msgs.front().queued;
+    const llarp_time_t sojourn = now > queued ? now - queued : 0;
+    bool okToDrop              = false;
+    // never drop the last packet's worth, there is no standing queue then
+    if(sojourn < Target || cls.bytes <= MAX_LINK_MSG_SIZE)
+      cls.firstAboveTime = 0;
+    else if(cls.firstAboveTime == 0)
+      cls.firstAboveTime = now + Interval;
+    else if(now >= cls.firstAboveTime)
+      okToDrop = true;
+
+    if(cls.dropping)
+    {
+      if(!okToDrop)
+      {
+        cls.dropping = false;
+        return false;
+      }
+      if(now < cls.dropNext)
+        return false;
+      ++cls.dropCount;
+      cls.dropNext += Interval / std::sqrt(cls.dropCount);
+      return true;
+    }
+    if(!okToDrop)
+      return false;
+    cls.dropping = true;
+    // if we were dropping recently pick up close to the old rate
+    if(cls.dropCount > 2 && now < cls.dropNext + (8 * Interval))
+      cls.dropCount -= 2;
+    else
+      cls.dropCount = 1;
+    cls.dropNext = now + Interval / std::sqrt(cls.dropCount);
+    return true;
+  }
+
+  void
+  OutboundQueue::PopFront(Class &cls)
+  {
+    cls.bytes -= cls.msgs.front().pkt.size();
+    cls.msgs.pop_front();
+  }
+
+  bool
+  OutboundQueue::Empty() const
+  {
+    for(const auto &cls : m_Classes)
+    {
+      if(!cls.msgs.empty())
+        return false;
+    }
+    return true;
+  }
+
+  size_t
+  OutboundQueue::Bytes() const
+  {
+    size_t bytes = 0;
+    for(const auto &cls : m_Classes)
+      bytes += cls.bytes;
+    return bytes;
+  }
+
+  bool
+  OutboundQueue::Congested() const
+  {
+    for(size_t pri = 0; pri < m_Classes.size(); ++pri)
+    {
+      const auto limit = ByteLimit(LinkMessagePriority(pri));
+      if(m_Classes[pri].bytes > limit / 2)
+        return true;
+    }
+    return false;
+  }
+
+  util::StatusObject
+  OutboundQueue::ExtractStatus() const
+  {
+    std::vector< util::StatusObject > classes;
+    for(const auto &cls : m_Classes)
+    {
+      classes.emplace_back(
+          util::StatusObject{{"queued", uint64_t(cls.msgs.size())},
+                             {"bytes", uint64_t(cls.bytes)},
+                             {"sent", cls.sent},
+                             {"droppedFull", cls.droppedFull},
+                             {"droppedLate", cls.droppedLate},
+                             {"dropping", cls.dropping}});
+    }
+    return util::StatusObject{{"classes", classes},
+                              {"congested", Congested()}};
+  }
+}  // namespace llarp
@@ -0,0 +1,104 @@
+#ifndef LLARP_ROUTER_OUTBOUND_QUEUE_HPP
+#define LLARP_ROUTER_OUTBOUND_QUEUE_HPP
+
+#include <messages/link_message.hpp>
+#include <util/packet_buffer.hpp>
+#include <util/status.hpp>
+#include <util/types.hpp>
+
+#include <array>
+#include <deque>
+#include <functional>
+
+namespace llarp
+{
+  namespace metrics
+  {
+    class HistogramCollector;
+  }  // namespace metrics
+
+  /// per peer queue of encoded link messages waiting on the link layer
+  ///
+  /// messages wait here while a session comes up or while the session's own
+  /// send queue is full. each priority class has its own byte budget and is
+  /// drained before the next one, so path builds and dht never sit behind
+  /// relayed data. bulk traffic is shed codel style once it has been sitting
+  /// here too long, a backed up peer drops old onions instead of delivering
+  /// them late.
+  struct OutboundQueue
+  {
+    /// bytes the control class may hold before we refuse new messages
+    static constexpr size_t ControlByteLimit = 128 * 1024;
+    /// bytes the bulk class may hold before we refuse new messages
+    static constexpr size_t BulkByteLimit = 512 * 1024;
+    /// codel target sojourn time in ms
+    static constexpr llarp_time_t Target = 10;
+    /// codel interval in ms
+    static constexpr llarp_time_t Interval = 100;
+
+    using SendFunc = std::function< bool(const llarp_buffer_t &) >;
+
+    /// queue an encoded message, drops it and returns false if its class is
+    /// over budget
+    bool
+    Push(PacketBuffer pkt, LinkMessagePriority pri, llarp_time_t now);
+
+    /// hand messages to send in priority order until it refuses one or we
+    /// run out, returns how many were sent. each sent message's time in the
+    /// queue is recorded to delay if there is one
+    size_t
+    Pump(const SendFunc &send, llarp_time_t now,
+         metrics::HistogramCollector *delay = nullptr);
+
+    bool
+    Empty() const;
+
+    /// bytes queued in all classes
+    size_t
+    Bytes() const;
+
+    /// true if any class is over half its budget, callers should steer
+    /// traffic elsewhere
+    bool
+    Congested() const;
+
+    util::StatusObject
+    ExtractStatus() const;
+
+    static size_t
+    ByteLimit(LinkMessagePriority pri);
+
+   private:
+    struct Entry
+    {
+      PacketBuffer pkt;
+      llarp_time_t queued;
+    };
+
+    struct Class
+    {
+      std::deque< Entry > msgs;
+      size_t bytes = 0;
+      // codel state
+      llarp_time_t firstAboveTime = 0;
+      llarp_time_t dropNext       = 0;
+      uint32_t dropCount          = 0;
+      bool dropping               = false;
+      // stats
+      uint64_t sent        = 0;
+      uint64_t droppedFull = 0;
+      uint64_t droppedLate = 0;
+    };
+
+    /// codel control law, true if the head of cls should be dropped
+    static bool
+    ShouldDrop(Class &cls, llarp_time_t now);
+
+    static void
+    PopFront(Class &cls);
+
+    std::array< Class, eLinkNumPriorities > m_Classes;
+  };
+}  // namespace llarp
+
+#endif
@@ -14,6 +14,7 @@
 #include <util/buffer.hpp>
 #include <util/encode.hpp>
 #include <util/logger.hpp>
+#include <util/async_logger.hpp>
 #include <util/file_logger.hpp>
 #include <util/logger_syslog.hpp>
 #include <util/metrics.hpp>
@@ -163,6 +164,8 @@ llarp_findOrCreateEncryption(llarp::Crypto *crypto, const fs::path &path,
 
 namespace llarp
 {
+  constexpr llarp_time_t Router::SessionRankInterval;
+
   bool
   Router::TryConnectAsync(RouterContact remote, uint16_t numretries)
   {
@@ -200,6 +203,7 @@ namespace llarp
   bool
   Router::OnSessionEstablished(ILinkSession *s)
   {
+    IndexBestSession(RouterID(s->GetPubKey()));
     return async_verify_RC(s->GetRemoteRC());
   }
 
@@ -239,7 +243,8 @@ namespace llarp
   {
     util::StatusObject obj{{"dht", _dht->impl->ExtractStatus()},
                            {"services", _hiddenServiceContext.ExtractStatus()},
-                           {"exit", _exitContext.ExtractStatus()}};
+                           {"exit", _exitContext.ExtractStatus()},
+                           {"paths", paths.ExtractStatus()}};
     std::vector< util::StatusObject > ob_links, ib_links;
     std::transform(inboundLinks.begin(), inboundLinks.end(),
                    std::back_inserter(ib_links),
@@ -253,6 +258,17 @@ namespace llarp
                    });
     obj.Put("links",
             util::StatusObject{{"outbound", ob_links}, {"inbound", ib_links}});
+    uint64_t queuedBytes = 0, congested = 0;
+    for(const auto &item : outboundMessageQueue)
+    {
+      queuedBytes += item.second.Bytes();
+      if(item.second.Congested())
+        ++congested;
+    }
+    obj.Put("sendQueues",
+            util::StatusObject{{"peers", uint64_t(outboundMessageQueue.size())},
+                               {"bytes", queuedBytes},
+                               {"congested", congested}});
     return obj;
   }
 
@@ -282,64 +298,38 @@ namespace llarp
   bool
   Router::GetRandomGoodRouter(RouterID &router)
   {
-    absl::ReaderMutexLock l(&nodedb()->access);
-    auto sz = nodedb()->entries.size();
-    if(sz == 0)
-      return false;
-    auto itr = nodedb()->entries.begin();
-    if(sz > 1)
-      std::advance(itr, randint() % sz);
-    router = itr->first;
-    return true;
+    return nodedb()->select_random_router(router);
   }
 
-  constexpr size_t MaxPendingSendQueueSize = 8;
-
   bool
   Router::SendToOrQueue(const RouterID &remote, const ILinkMessage *msg)
   {
-    for(const auto &link : inboundLinks)
-    {
-      if(link->HasSessionTo(remote))
-      {
-        SendTo(remote, msg, link.get());
-        return true;
-      }
-    }
-    for(const auto &link : outboundLinks)
-    {
-      if(link->HasSessionTo(remote))
-      {
-        SendTo(remote, msg, link.get());
-        return true;
-      }
-    }
-    // no link available
+    auto chosen = GetBestSession(remote);
+    // anything already waiting goes first to keep messages in order
+    if(chosen && !HasQueuedFor(remote) && SendTo(remote, msg, chosen.get()))
+      return true;
 
-    // this will create an entry in the outbound mq if it's not already there
-    auto itr = outboundMessageQueue.find(remote);
-    if(itr == outboundMessageQueue.end())
-    {
-      outboundMessageQueue.emplace(remote, MessageQueue());
-    }
-    // encode
-    llarp_buffer_t buf(linkmsg_buffer);
+    // encode straight into a pooled buffer
+    PacketBuffer pkt = PacketBuffer::Alloc(linkmsg_buffer.size());
+    llarp_buffer_t buf(pkt);
     if(!msg->BEncode(&buf))
       return false;
-    // queue buffer
+    pkt.Resize(buf.cur - buf.base);
+    // this will create an entry in the outbound mq if it's not already there
     auto &q = outboundMessageQueue[remote];
-
-    if(q.size() < MaxPendingSendQueueSize)
+    if(!q.Push(std::move(pkt), msg->Priority(), Now()))
     {
-      buf.sz = buf.cur - buf.base;
-      q.emplace(buf.sz);
-      memcpy(q.back().data(), buf.base, buf.sz);
+      LogWarn("send queue to ", remote, " is full, dropping ", msg->Name());
+      return false;
     }
-    else
+    if(chosen)
     {
-      LogWarn("tried to queue a message to ", remote,
-              " but the queue is full so we drop it like it's hawt");
+      // the session is backed up, try again in a bit
+      ScheduleOutboundPump();
+      return true;
     }
+    // no link available
+
     RouterContact remoteRC;
     // we don't have an open session to that router right now
     if(nodedb()->Get(remote, remoteRC))
@@ -457,6 +447,12 @@ namespace llarp
   {
     using namespace std::placeholders;
     conf->visit(std::bind(&Router::router_iter_config, this, _1, _2, _3));
+    // wrap whichever log stream the config ended up picking
+    if(m_AsyncLogging)
+    {
+      auto &log     = LogContext::Instance();
+      log.logStream = AsyncLogStream::Wrap(std::move(log.logStream));
+    }
     if(!InitOutboundLinks())
       return false;
     if(!Ready())
@@ -608,17 +604,25 @@ namespace llarp
   Router::HandleDHTLookupForExplore(RouterID,
                                     const std::vector< RouterContact > &results)
   {
-    const auto numConnected = NumberOfConnectedRouters();
-    for(const auto &rc : results)
-    {
-      if(!rc.Verify(crypto(), Now()))
-        continue;
-      nodedb()->InsertAsync(rc);
-
-      if(ConnectionToRouterAllowed(rc.pubkey)
-         && numConnected < minConnectedRouters)
-        TryConnectAsync(rc, 10);
-    }
+    // check the whole lot on the workers and carry on in logic
+    VerifyRouterContacts(
+        crypto(), threadpool(), results, Now(),
+        [this](std::vector< RouterContact > rcs,
+               std::vector< uint8_t > valid) {
+          _logic->queue_func([this, rcs, valid]() {
+            const auto numConnected = NumberOfConnectedRouters();
+            for(size_t idx = 0; idx < rcs.size(); ++idx)
+            {
+              if(!valid[idx])
+                continue;
+              nodedb()->InsertAsync(rcs[idx]);
+
+              if(ConnectionToRouterAllowed(rcs[idx].pubkey)
+                 && numConnected < minConnectedRouters)
+                TryConnectAsync(rcs[idx], 10);
+            }
+          });
+        });
   }
 
   void
@@ -763,6 +767,7 @@ namespace llarp
           llarp::LogError("failed to ensure keyfile ", transport_keyfile);
           return;
         }
+        server->SetShards(m_LinkThreads);
         if(server->Configure(netloop(), key, af, proto))
         {
           AddInboundLink(server);
@@ -838,6 +843,10 @@ namespace llarp
     }
     else if(StrEq(section, "logging"))
     {
+      if(StrEq(key, "async"))
+      {
+        m_AsyncLogging = IsTrueValue(val);
+      }
       if(StrEq(key, "type") && StrEq(val, "syslog"))
       {
         // TODO(despair): write event log syslog class
@@ -978,6 +987,24 @@ namespace llarp
           LogInfo("min connections set to ", minConnectedRouters);
         }
       }
+      if(StrEq(key, "udp-batch-size"))
+      {
+        auto ival = atoi(val);
+        if(ival > 0)
+        {
+          auto batch = llarp_ev_loop_set_udp_batch(netloop().get(), ival);
+          LogInfo("udp batch size set to ", batch);
+        }
+      }
+      if(StrEq(key, "link-threads"))
+      {
+        auto ival = atoi(val);
+        if(ival > 0)
+        {
+          m_LinkThreads = ival;
+          LogInfo("link threads set to ", m_LinkThreads);
+        }
+      }
       if(StrEq(key, "nickname"))
       {
         _rc.SetNick(val);
@@ -1100,6 +1127,16 @@ namespace llarp
     auto now = Now();
 
     routerProfiling().Tick();
+    FlushOutbound();
+
+    // forget peers we had no session to once they are due a lookup anyway
+    for(auto itr = m_SessionIndex.begin(); itr != m_SessionIndex.end();)
+    {
+      if(itr->second.none && now - itr->second.ranked >= SessionRankInterval)
+        itr = m_SessionIndex.erase(itr);
+      else
+        ++itr;
+    }
 
     if(IsServiceNode())
     {
@@ -1212,8 +1249,49 @@ namespace llarp
     return crypto()->sign(sig, identity(), buf);
   }
 
-  void
-  Router::SendTo(RouterID remote, const ILinkMessage *msg, ILinkLayer *selected)
+  bool
+  Router::SendToOrQueueVia(std::weak_ptr< ILinkSession > &session,
+                           const RouterID &remote, const ILinkMessage *msg)
+  {
+    auto s = session.lock();
+    // the session is only ours to use while nothing waits in the queue,
+    // otherwise this message would overtake the queued ones
+    if(s && s->IsEstablished() && !HasQueuedFor(remote))
+    {
+      llarp_buffer_t buf(linkmsg_buffer);
+      if(!msg->BEncode(&buf))
+        return false;
+      buf.sz  = buf.cur - buf.base;
+      buf.cur = buf.base;
+      if(s->SendMessageBuffer(buf))
+        return true;
+    }
+    // gone or backed up, take the long way and let queued messages go first
+    session.reset();
+    if(!SendToOrQueue(remote, msg))
+      return false;
+    if(!HasQueuedFor(remote))
+      session = GetBestSession(remote);
+    return true;
+  }
+
+  bool
+  Router::HasQueuedFor(const RouterID &remote) const
+  {
+    auto itr = outboundMessageQueue.find(remote);
+    return itr != outboundMessageQueue.end() && !itr->second.Empty();
+  }
+
+  bool
+  Router::IsCongested(const RouterID &remote) const
+  {
+    auto itr = outboundMessageQueue.find(remote);
+    return itr != outboundMessageQueue.end() && itr->second.Congested();
+  }
+
+  bool
+  Router::SendTo(RouterID remote, const ILinkMessage *msg,
+                 ILinkSession *selected)
   {
     const std::string remoteName = "TX_" + remote.ToString();
     METRICS_DYNAMIC_INCREMENT(msg->Name(), remoteName.c_str());
@@ -1223,7 +1301,7 @@ namespace llarp
     {
       LogWarn("failed to encode outbound message, buffer size left: ",
               buf.size_left());
-      return;
+      return false;
     }
     // set size of message
     buf.sz  = buf.cur - buf.base;
@@ -1231,20 +1309,72 @@ namespace llarp
     LogDebug("send ", buf.sz, " bytes to ", remote);
     if(selected)
     {
-      if(selected->SendTo(remote, buf))
-        return;
+      if(selected->SendMessageBuffer(buf))
+        return true;
     }
     for(const auto &link : outboundLinks)
     {
       if(link->SendTo(remote, buf))
-        return;
+        return true;
     }
     for(const auto &link : inboundLinks)
     {
       if(link->SendTo(remote, buf))
-        return;
+        return true;
     }
-    LogWarn("message to ", remote, " was dropped");
+    return false;
+  }
+
+  void
+  Router::FlushOutbound()
+  {
+    const auto now = Now();
+    bool backlog   = false;
+    auto itr       = outboundMessageQueue.begin();
+    while(itr != outboundMessageQueue.end())
+    {
+      const RouterID remote = itr->first;
+      ILinkLayer *link      = GetLinkWithSessionByPubkey(remote);
+      // no session yet, FlushOutboundFor gets it once one is up
+      if(link == nullptr)
+      {
+        ++itr;
+        continue;
+      }
+      itr->second.Pump(
+          [link, remote](const llarp_buffer_t &buf) -> bool {
+            return link->SendTo(remote, buf);
+          },
+          now, m_SendDelay);
+      if(itr->second.Empty())
+      {
+        itr = outboundMessageQueue.erase(itr);
+        continue;
+      }
+      backlog = true;
+      ++itr;
+    }
+    if(backlog)
+      ScheduleOutboundPump();
+  }
+
+  void
+  Router::ScheduleOutboundPump()
+  {
+    if(outbound_pump_job_id)
+      return;
+    outbound_pump_job_id = _logic->call_later(
+        {OutboundQueue::Target, this, &handle_outbound_pump});
+  }
+
+  void
+  Router::handle_outbound_pump(void *user, uint64_t, uint64_t left)
+  {
+    if(left)
+      return;
+    Router *self               = static_cast< Router * >(user);
+    self->outbound_pump_job_id = 0;
+    self->FlushOutbound();
   }
 
   void
@@ -1261,23 +1391,71 @@ namespace llarp
     // remove from valid routers if it's a valid router
     validRouters.erase(remote);
     m_Clients.erase(remote);
+    m_SessionIndex.erase(remote);
     LogInfo("Session to ", remote, " fully closed");
   }
 
   ILinkLayer *
   Router::GetLinkWithSessionByPubkey(const RouterID &pubkey)
   {
-    for(const auto &link : outboundLinks)
+    auto session = GetBestSession(pubkey);
+    return session ? session->GetLinkLayer() : nullptr;
+  }
+
+  std::shared_ptr< ILinkSession >
+  Router::GetBestSession(const RouterID &remote)
+  {
+    auto itr = m_SessionIndex.find(remote);
+    if(itr != m_SessionIndex.end())
     {
-      if(link->HasSessionTo(pubkey))
-        return link.get();
+      const SessionIndexEntry &entry = itr->second;
+      const bool fresh = Now() - entry.ranked < SessionRankInterval;
+      if(entry.none)
+      {
+        // don't ask every link on every send to a peer we have no session to
+        if(fresh)
+          return nullptr;
+      }
+      else
+      {
+        // nothing beats a session with no backlog
+        auto session = entry.session.lock();
+        if(session && session->IsEstablished()
+           && (fresh || session->SendQueueBacklog() == 0))
+          return session;
+      }
     }
+    // not indexed, the indexed one went away while others stay open or it
+    // is time to rank them again
+    return IndexBestSession(remote);
+  }
+
+  std::shared_ptr< ILinkSession >
+  Router::IndexBestSession(const RouterID &remote)
+  {
+    std::shared_ptr< ILinkSession > best;
+    ILinkLayer *bestLink = nullptr;
+    auto visit           = [&](ILinkLayer *link) {
+      auto session = link->BestSessionTo(remote);
+      if(!(session && session->IsEstablished()))
+        return;
+      if(bestLink == nullptr || link->Rank() < bestLink->Rank()
+         || (link->Rank() == bestLink->Rank()
+             && session->SendQueueBacklog() < best->SendQueueBacklog()))
+      {
+        best     = std::move(session);
+        bestLink = link;
+      }
+    };
+    for(const auto &link : outboundLinks)
+      visit(link.get());
     for(const auto &link : inboundLinks)
-    {
-      if(link->HasSessionTo(pubkey))
-        return link.get();
-    }
-    return nullptr;
+      visit(link.get());
+    SessionIndexEntry &entry = m_SessionIndex[remote];
+    entry.session            = best;
+    entry.ranked             = Now();
+    entry.none               = best == nullptr;
+    return best;
   }
 
   void
@@ -1297,15 +1475,15 @@ namespace llarp
       pendingEstablishJobs.erase(remote);
       return;
     }
-    while(itr->second.size())
-    {
-      llarp_buffer_t buf(itr->second.front());
-      if(!chosen->SendTo(remote, buf))
-        LogWarn("failed to send outbound message to ", remote, " via ",
-                chosen->Name());
-
-      itr->second.pop();
-    }
+    itr->second.Pump(
+        [chosen, remote](const llarp_buffer_t &buf) -> bool {
+          return chosen->SendTo(remote, buf);
+        },
+        Now(), m_SendDelay);
+    if(itr->second.Empty())
+      outboundMessageQueue.erase(itr);
+    else
+      ScheduleOutboundPump();
     pendingEstablishJobs.erase(remote);
   }
 
@@ -1395,6 +1573,11 @@ namespace llarp
       return false;
     this->_nodedb = nodedb;
 
+    if(metrics::DefaultManager::instance())
+      m_SendDelay = metrics::DefaultManager::instance()
+                        ->collectorRepo()
+                        .defaultHistogramCollector("router.sendq", "delay");
+
     if(enableRPCServer)
     {
       if(rpcBindAddr.empty())
@@ -1431,6 +1614,8 @@ namespace llarp
 
     llarp_threadpool_start(tp);
     llarp_threadpool_start(disk);
+    // get the rcs we did not decode on startup ready before they are wanted
+    this->nodedb()->DecodeStoreAsync();
 
     for(const auto &rc : bootstrapRCList)
       this->nodedb()->InsertAsync(rc);
@@ -12,6 +12,7 @@
 #include <nodedb.hpp>
 #include <path/path.hpp>
 #include <profiling.hpp>
+#include <router/outbound_queue.hpp>
 #include <router_contact.hpp>
 #include <routing/handler.hpp>
 #include <routing/message_parser.hpp>
@@ -21,6 +22,7 @@
 #include <util/fs.hpp>
 #include <util/logic.hpp>
 #include <util/mem.hpp>
+#include <util/packet_buffer.hpp>
 #include <util/status.hpp>
 #include <util/str.hpp>
 #include <util/threadpool.hpp>
@@ -88,6 +90,8 @@ namespace llarp
 
     // use file based logging?
     bool m_UseFileLogging = false;
+    // format and write log lines on a background thread?
+    bool m_AsyncLogging = false;
     // default log file path
     fs::path logfile = "lokinet.log";
 
@@ -215,6 +219,9 @@ namespace llarp
 
     uint16_t m_OutboundPort = 0;
 
+    /// how many threads read udp for each inbound link
+    size_t m_LinkThreads = 1;
+
     /// always maintain this many connections to other routers
     size_t minConnectedRouters = 2;
     /// hard upperbound limit on the number of router to router connections
@@ -229,6 +236,8 @@ namespace llarp
     bool sendPadding = false;
 
     uint32_t ticker_job_id = 0;
+    /// timer for pumping backed up outbound queues, 0 when not scheduled
+    uint32_t outbound_pump_job_id = 0;
 
     InboundMessageParser inbound_link_msg_parser;
     routing::InboundMessageParser inbound_routing_msg_parser;
@@ -295,12 +304,33 @@ namespace llarp
     Profiling _routerProfiling;
     std::string routerProfilesFile = "profiles.dat";
 
-    using MessageQueue = std::queue< std::vector< byte_t > >;
-
-    /// outbound message queue
-    std::unordered_map< RouterID, MessageQueue, RouterID::Hash >
+    /// per peer outbound message queue
+    std::unordered_map< RouterID, OutboundQueue, RouterID::Hash >
         outboundMessageQueue;
 
+    /// how long messages sat in outboundMessageQueue, resolved in Run so
+    /// the send path never looks it up. owned by the metrics manager, which
+    /// outlives the router
+    metrics::HistogramCollector *m_SendDelay = nullptr;
+
+    /// an indexed best session, or none if the peer had none when ranked
+    struct SessionIndexEntry
+    {
+      std::weak_ptr< ILinkSession > session;
+      llarp_time_t ranked = 0;
+      bool none           = false;
+    };
+
+    /// how long an index entry is trusted before a busy session or a peer
+    /// without one is looked up again
+    static constexpr llarp_time_t SessionRankInterval = 500;
+
+    /// best session to each peer across all links, filled in when a session
+    /// is established and dropped when the peer's sessions close, so sends
+    /// to connected peers don't ask every link
+    std::unordered_map< RouterID, SessionIndexEntry, RouterID::Hash >
+        m_SessionIndex;
+
     /// loki verified routers
     std::unordered_map< RouterID, RouterContact, RouterID::Hash > validRouters;
 
@@ -428,9 +458,22 @@ namespace llarp
     bool
     SendToOrQueue(const RouterID &remote, const ILinkMessage *msg) override;
 
-    /// sendto or drop
-    void
-    SendTo(RouterID remote, const ILinkMessage *msg, ILinkLayer *chosen);
+    bool
+    SendToOrQueueVia(std::weak_ptr< ILinkSession > &session,
+                     const RouterID &remote,
+                     const ILinkMessage *msg) override;
+
+    bool
+    IsCongested(const RouterID &remote) const override;
+
+    /// do we have messages for remote waiting in the outbound queue
+    bool
+    HasQueuedFor(const RouterID &remote) const;
+
+    /// send right now, trying chosen first, returns false if no session
+    /// would take it
+    bool
+    SendTo(RouterID remote, const ILinkMessage *msg, ILinkSession *chosen);
 
     /// manually flush outbound message queue for just 1 router
     void
@@ -471,10 +514,15 @@ namespace llarp
     bool
     CheckRenegotiateValid(RouterContact newRc, RouterContact oldRC) override;
 
-    /// flush outbound message queue
+    /// hand queued messages to every peer we have a session with, schedules
+    /// another go if some are still backed up
     void
     FlushOutbound();
 
+    /// flush outbound queues a moment from now
+    void
+    ScheduleOutboundPump();
+
     /// called by link when a remote session has no more sessions open
     void
     SessionClosed(RouterID remote) override;
@@ -497,6 +545,18 @@ namespace llarp
     ILinkLayer *
     GetLinkWithSessionByPubkey(const RouterID &remote);
 
+    /// the indexed session to remote if it is still established and idle
+    /// or was ranked recently, otherwise whatever IndexBestSession finds.
+    /// peers without a session are only looked up again once their entry
+    /// is SessionRankInterval old.
+    std::shared_ptr< ILinkSession >
+    GetBestSession(const RouterID &remote);
+
+    /// ask every link for its best session to remote and index the one on
+    /// the lowest ranked link with the least backlog, or that there is none
+    std::shared_ptr< ILinkSession >
+    IndexBestSession(const RouterID &remote);
+
     /// parse a routing message in a buffer and handle it with a handler if
     /// successful parsing return true on parse and handle success otherwise
     /// return false
@@ -540,6 +600,9 @@ namespace llarp
     static void
     handle_router_ticker(void *user, uint64_t orig, uint64_t left);
 
+    static void
+    handle_outbound_pump(void *user, uint64_t orig, uint64_t left);
+
     static void
     HandleAsyncLoadRCForSendTo(llarp_async_load_rc *async);
 
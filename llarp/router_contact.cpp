@@ -6,11 +6,17 @@
 #include <util/bencode.hpp>
 #include <util/buffer.hpp>
 #include <util/logger.hpp>
+#include <util/lru_cache.hpp>
 #include <util/mem.hpp>
+#include <util/metrics.hpp>
 #include <util/printer.hpp>
+#include <util/threadpool.h>
+#include <util/threading.hpp>
 #include <util/time.hpp>
 
+#include <atomic>
 #include <fstream>
+#include <memory>
 
 namespace llarp
 {
@@ -24,6 +30,49 @@ namespace llarp
 
   bool RouterContact::IgnoreBogons = false;
 
+  /// signature checks already done, keyed by a hash of the signed bytes and
+  /// the signature. the same rc comes back again and again through gossip,
+  /// explore lookups and sessions, and is only checked the first time.
+  struct VerifyCache
+  {
+    static constexpr size_t Capacity = 8192;
+
+    VerifyCache() : results(Capacity)
+    {
+    }
+
+    util::Mutex access;
+    util::LRUCache< ShortHash, bool, ShortHash::Hash > results
+        GUARDED_BY(access);
+
+    static VerifyCache &
+    Instance()
+    {
+      static VerifyCache cache;
+      return cache;
+    }
+
+    bool
+    Get(const ShortHash &key, bool &valid) LOCKS_EXCLUDED(access)
+    {
+      util::Lock lock(&access);
+      const bool *result = results.Get(key);
+      if(result == nullptr)
+        return false;
+      valid = *result;
+      return true;
+    }
+
+    void
+    Put(const ShortHash &key, bool valid) LOCKS_EXCLUDED(access)
+    {
+      util::Lock lock(&access);
+      results.Put(key, valid);
+    }
+  };
+
+  constexpr size_t VerifyCache::Capacity;
+
 #ifdef TESTNET
   // 1 minute for testnet
   llarp_time_t RouterContact::Lifetime = 60 * 1000;
@@ -321,8 +370,9 @@ namespace llarp
     RouterContact copy;
     copy = *this;
     copy.signature.Zero();
-    std::array< byte_t, MAX_RC_SIZE > tmp;
-    llarp_buffer_t buf(tmp);
+    // room for the signature after the signed bytes, for the cache key
+    std::array< byte_t, MAX_RC_SIZE + Signature::SIZE > tmp;
+    llarp_buffer_t buf(tmp.data(), MAX_RC_SIZE);
     if(!copy.BEncode(&buf))
     {
       llarp::LogError("bencode failed");
@@ -330,7 +380,79 @@ namespace llarp
     }
     buf.sz  = buf.cur - buf.base;
     buf.cur = buf.base;
-    return crypto->verify(pubkey, buf, signature);
+
+    std::copy(signature.begin(), signature.end(), tmp.begin() + buf.sz);
+    ShortHash key;
+    const bool cacheable = crypto->shorthash(
+        key, llarp_buffer_t(tmp.data(), buf.sz + Signature::SIZE));
+    bool valid = false;
+    if(cacheable && VerifyCache::Instance().Get(key, valid))
+    {
+      METRICS_DYNAMIC_INCREMENT("rc.verify", "cache_hit");
+      return valid;
+    }
+    METRICS_DYNAMIC_INCREMENT("rc.verify", "cache_miss");
+    valid = crypto->verify(pubkey, buf, signature);
+    if(cacheable)
+      VerifyCache::Instance().Put(key, valid);
+    return valid;
+  }
+
+  /// rcs being checked by VerifyRouterContacts
+  struct VerifyBatch
+  {
+    Crypto *crypto;
+    llarp_time_t now;
+    std::vector< RouterContact > rcs;
+    std::vector< uint8_t > valid;
+    /// chunks not checked yet
+    std::atomic< size_t > remaining;
+    VerifiedRouterContactsHandler done;
+
+    void
+    Verify(size_t begin, size_t end)
+    {
+      for(size_t idx = begin; idx < end; ++idx)
+        valid[idx] = rcs[idx].Verify(crypto, now);
+    }
+
+    void
+    Finish()
+    {
+      done(std::move(rcs), std::move(valid));
+    }
+  };
+
+  void
+  VerifyRouterContacts(Crypto *crypto, llarp_threadpool *worker,
+                       std::vector< RouterContact > rcs, llarp_time_t now,
+                       VerifiedRouterContactsHandler done)
+  {
+    /// rcs checked per job
+    static constexpr size_t Chunk = 64;
+    auto batch    = std::make_shared< VerifyBatch >();
+    batch->crypto = crypto;
+    batch->now    = now;
+    batch->rcs    = std::move(rcs);
+    batch->valid.resize(batch->rcs.size(), 0);
+    batch->done      = std::move(done);
+    const size_t num = batch->rcs.size();
+    if(worker == nullptr || num == 0)
+    {
+      batch->Verify(0, num);
+      batch->Finish();
+      return;
+    }
+    batch->remaining = (num + Chunk - 1) / Chunk;
+    for(size_t begin = 0; begin < num; begin += Chunk)
+    {
+      const size_t end = std::min(begin + Chunk, num);
+      worker->QueueFunc([batch, begin, end]() {
+        batch->Verify(begin, end);
+        if(--batch->remaining == 0)
+          batch->Finish();
+      });
+    }
   }
 
   bool
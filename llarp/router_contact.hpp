@@ -15,6 +15,8 @@
 #define MAX_RC_SIZE (1024)
 #define NICKLEN (32)
 
+struct llarp_threadpool;
+
 namespace llarp
 {
   struct Crypto;
@@ -218,6 +220,18 @@ namespace llarp
 
   using RouterLookupHandler =
       std::function< void(const std::vector< RouterContact > &) >;
+
+  /// f(rcs, valid), valid[i] is non zero if rcs[i] is valid
+  using VerifiedRouterContactsHandler = std::function< void(
+      std::vector< RouterContact >, std::vector< uint8_t >) >;
+
+  /// verify a lot of rcs at once in chunks spread over worker, for bulk
+  /// loads, gossip and explore results. done is called on the worker thread
+  /// that finishes last, or right away when there is no worker.
+  void
+  VerifyRouterContacts(Crypto *crypto, llarp_threadpool *worker,
+                       std::vector< RouterContact > rcs, llarp_time_t now,
+                       VerifiedRouterContactsHandler done);
 }  // namespace llarp
 
 #endif
@@ -4,10 +4,13 @@
 #include <util/logger.hpp>
 #include <router_id.hpp>
 #include <exit/context.hpp>
+#include <metrics/prometheus.hpp>
 
 #include <util/encode.hpp>
 #include <libabyss.hpp>
 
+#include <sstream>
+
 namespace llarp
 {
   namespace rpc
@@ -261,6 +264,25 @@ namespace llarp
         }
         return false;
       }
+
+      absl::optional< Document >
+      HandleGET(const std::string& path) override
+      {
+        if(path != "/metrics")
+        {
+          return {};
+        }
+        Document doc;
+        doc.contentType = metrics::PROMETHEUS_CONTENT_TYPE;
+        auto manager    = metrics::DefaultManager::instance();
+        if(manager)
+        {
+          std::ostringstream stream;
+          metrics::prometheusText(stream, manager->collectorRepo());
+          doc.body = stream.str();
+        }
+        return doc;
+      }
     };
 
     struct ReqHandlerImpl : public ::abyss::httpd::BaseReqHandler
@@ -847,6 +847,21 @@ namespace llarp
       return ProcessDataMessage(msg);
     }
 
+    bool
+    Endpoint::HasSessionWith(const AlignedBuffer< 32 >& addr,
+                             bool snode) const
+    {
+      if(snode)
+        return m_SNodeSessions.count(RouterID(addr.as_array())) != 0;
+      const Address remote(addr.as_array());
+      if(m_RemoteSessions.count(remote))
+        return true;
+      for(const auto& item : m_Sessions)
+        if(item.second.remote.Addr() == remote)
+          return true;
+      return false;
+    }
+
     bool
     Endpoint::HasPathToSNode(const RouterID& ident) const
     {
@@ -1038,7 +1053,7 @@ namespace llarp
     Endpoint::SendToSNodeOrQueue(const RouterID& addr,
                                  const llarp_buffer_t& buf)
     {
-      net::IPv4Packet pkt;
+      net::IPPacket pkt;
       if(!pkt.Load(buf))
         return false;
       auto range = m_SNodeSessions.equal_range(addr);
@@ -231,6 +231,11 @@ namespace llarp
       bool
       HasPathToSNode(const RouterID& remote) const;
 
+      /// do we still have any session with addr, built or not, inbound or
+      /// outbound
+      bool
+      HasSessionWith(const AlignedBuffer< 32 >& addr, bool snode) const;
+
       void
       PutSenderFor(const ConvoTag& tag, const ServiceInfo& info) override;
 
@@ -6,7 +6,8 @@ namespace llarp
 {
   void
   AndroidLogStream::PreLog(std::stringstream& ss, LogLevel lvl,
-                           const char* fname, int lineno) const
+                           const char* fname, int lineno, std::thread::id tid,
+                           absl::Time when) const
   {
     switch(lvl)
     {
@@ -26,7 +27,8 @@ namespace llarp
         break;
     }
 
-    ss << "(" << thread_id_string() << ") " << log_timestamp() << " " << fname
+    ss << "(" << thread_id_string(tid) << ") "
+       << log_timestamp("%c %Z", when) << " " << fname
        << ":" << lineno << "\t";
   }
 
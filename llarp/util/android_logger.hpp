@@ -10,10 +10,10 @@ namespace llarp
   {
     void
     PreLog(std::stringstream& s, LogLevel lvl, const char* fname,
-           int lineno) const override;
+           int lineno, std::thread::id tid, absl::Time when) const override;
 
     void
-    Log(LogLevel lvl, const std::string& msg) override;
+    Print(LogLevel lvl, const char* tag, const std::string& msg) override;
 
     void
     PostLog(std::stringstream&) const override{};
@@ -0,0 +1,255 @@
+#include <util/async_logger.hpp>
+
+#include <util/logger_internal.hpp>
+
+#include <algorithm>
+
+namespace llarp
+{
+  constexpr size_t AsyncLogStream::DefaultRingSize;
+  constexpr llarp_time_t AsyncLogStream::FlushInterval;
+
+  /// lines logged by one thread, written by that thread and read by the
+  /// background thread only
+  struct AsyncLogStream::Ring
+  {
+    explicit Ring(size_t sz) : slots(sz), mask(sz - 1)
+    {
+    }
+
+    bool
+    Push(Record&& rec)
+    {
+      const size_t t = tail.load(std::memory_order_relaxed);
+      if(t - head.load(std::memory_order_acquire) == slots.size())
+        return false;
+      slots[t & mask] = std::move(rec);
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    template < typename Visit >
+    void
+    Drain(Visit visit)
+    {
+      size_t h       = head.load(std::memory_order_relaxed);
+      const size_t t = tail.load(std::memory_order_acquire);
+      for(; h != t; ++h)
+        visit(std::move(slots[h & mask]));
+      head.store(h, std::memory_order_release);
+    }
+
+    std::vector< Record > slots;
+    const size_t mask;
+    std::atomic< size_t > head{0};
+    std::atomic< size_t > tail{0};
+    /// set once the thread logging into this ring exits
+    std::atomic_bool closed{false};
+  };
+
+  /// the ring the current thread logs into
+  struct AsyncLogStream::Producer
+  {
+    uint64_t owner = 0;
+    std::shared_ptr< Ring > ring;
+
+    ~Producer()
+    {
+      if(ring)
+        ring->closed = true;
+    }
+  };
+
+  static uint64_t
+  NextStreamID()
+  {
+    static std::atomic< uint64_t > ids{0};
+    return ++ids;
+  }
+
+  AsyncLogStream::AsyncLogStream(ILogStream_ptr sink, size_t ringSize)
+      : m_Sink(std::move(sink))
+      , m_RingSize(ringSize)
+      , m_ID(NextStreamID())
+      , m_Dropped(0)
+      , m_LastTick(0)
+  {
+  }
+
+  AsyncLogStream::~AsyncLogStream()
+  {
+    Stop();
+  }
+
+  ILogStream_ptr
+  AsyncLogStream::Wrap(ILogStream_ptr stream)
+  {
+    if(dynamic_cast< AsyncLogStream* >(stream.get()))
+      return stream;
+    auto async = new AsyncLogStream(std::move(stream));
+    ILogStream_ptr wrapped(async);
+    async->Start();
+    return wrapped;
+  }
+
+  void
+  AsyncLogStream::Start()
+  {
+    if(m_Worker.joinable())
+      return;
+    {
+      util::Lock lock(&m_StateMutex);
+      m_Stopping = false;
+    }
+    m_Worker = std::thread(&AsyncLogStream::Run, this);
+  }
+
+  void
+  AsyncLogStream::Stop()
+  {
+    {
+      util::Lock lock(&m_StateMutex);
+      m_Stopping = true;
+    }
+    if(m_Worker.joinable())
+      m_Worker.join();
+    Drain();
+  }
+
+  AsyncLogStream::Ring*
+  AsyncLogStream::GetRing()
+  {
+    static thread_local Producer producer;
+    if(producer.owner != m_ID)
+    {
+      // first line from this thread, or it logged to another stream before
+      if(producer.ring)
+        producer.ring->closed = true;
+      producer.ring  = std::make_shared< Ring >(m_RingSize);
+      producer.owner = m_ID;
+      util::Lock lock(&m_RingsMutex);
+      m_Rings.emplace_back(producer.ring);
+    }
+    return producer.ring.get();
+  }
+
+  void
+  AsyncLogStream::Log(LogLevel lvl, const char* fname, int lineno,
+                      std::string msg)
+  {
+    Record rec{lvl,         fname,          lineno, std::this_thread::get_id(),
+               absl::Now(), std::move(msg)};
+    if(!GetRing()->Push(std::move(rec)))
+      m_Dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void
+  AsyncLogStream::Run()
+  {
+    bool stopping = false;
+    while(!stopping)
+    {
+      {
+        util::Lock lock(&m_StateMutex);
+        m_StateMutex.AwaitWithTimeout(absl::Condition(&m_Stopping),
+                                      absl::Milliseconds(FlushInterval));
+        stopping = m_Stopping;
+      }
+      Drain();
+      // ticks come from the event loop but the wrapped stream is only ever
+      // touched from here
+      const llarp_time_t now = m_LastTick.load();
+      if(!stopping && now != m_TickedAt)
+      {
+        m_TickedAt = now;
+        m_Sink->Tick(now);
+      }
+    }
+  }
+
+  void
+  AsyncLogStream::Drain()
+  {
+    std::vector< std::shared_ptr< Ring > > rings;
+    {
+      util::Lock lock(&m_RingsMutex);
+      rings = m_Rings;
+    }
+    std::vector< Record > records;
+    std::vector< Ring* > finished;
+    for(const auto& ring : rings)
+    {
+      // a closed ring gets nothing new, so it is done once drained
+      const bool closed = ring->closed.load();
+      ring->Drain([&](Record&& rec) { records.emplace_back(std::move(rec)); });
+      if(closed)
+        finished.emplace_back(ring.get());
+    }
+    if(!finished.empty())
+    {
+      util::Lock lock(&m_RingsMutex);
+      m_Rings.erase(std::remove_if(m_Rings.begin(), m_Rings.end(),
+                                   [&](const std::shared_ptr< Ring >& ring) {
+                                     return std::find(finished.begin(),
+                                                      finished.end(),
+                                                      ring.get())
+                                         != finished.end();
+                                   }),
+                    m_Rings.end());
+    }
+
+    // keep lines from different threads in the order they were logged
+    std::stable_sort(records.begin(), records.end(),
+                     [](const Record& left, const Record& right) {
+                       return left.when < right.when;
+                     });
+    for(const auto& rec : records)
+    {
+      std::stringstream ss;
+      m_Sink->PreLog(ss, rec.lvl, rec.fname, rec.lineno, rec.tid, rec.when);
+      ss << rec.msg;
+      m_Sink->PostLog(ss);
+      m_Sink->Print(rec.lvl, rec.fname, ss.str());
+    }
+
+    const uint64_t dropped = m_Dropped.load();
+    if(dropped != m_DropsReported)
+    {
+      std::stringstream ss;
+      m_Sink->PreLog(ss, eLogWarn, "async_logger", __LINE__,
+                     std::this_thread::get_id(), absl::Now());
+      ss << "dropped " << (dropped - m_DropsReported)
+         << " log lines, logging faster than they can be written";
+      m_Sink->PostLog(ss);
+      m_Sink->Print(eLogWarn, "async_logger", ss.str());
+      m_DropsReported = dropped;
+    }
+  }
+
+  void
+  AsyncLogStream::PreLog(std::stringstream& out, LogLevel lvl,
+                         const char* fname, int lineno, std::thread::id tid,
+                         absl::Time when) const
+  {
+    m_Sink->PreLog(out, lvl, fname, lineno, tid, when);
+  }
+
+  void
+  AsyncLogStream::Print(LogLevel lvl, const char* fname,
+                        const std::string& msg)
+  {
+    m_Sink->Print(lvl, fname, msg);
+  }
+
+  void
+  AsyncLogStream::PostLog(std::stringstream& out) const
+  {
+    m_Sink->PostLog(out);
+  }
+
+  void
+  AsyncLogStream::Tick(llarp_time_t now)
+  {
+    m_LastTick.store(now);
+  }
+}  // namespace llarp
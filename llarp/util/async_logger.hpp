@@ -0,0 +1,113 @@
+#ifndef LLARP_UTIL_ASYNC_LOGGER_HPP
+#define LLARP_UTIL_ASYNC_LOGGER_HPP
+
+#include <util/logstream.hpp>
+#include <util/threading.hpp>
+
+#include <absl/base/thread_annotations.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace llarp
+{
+  /// log stream that hands lines off to a background thread which formats
+  /// them and writes them to the wrapped stream. each logging thread gets
+  /// its own single producer ring, so after its first line a thread logs
+  /// without taking a lock. lines that do not fit are dropped and counted.
+  struct AsyncLogStream : public ILogStream
+  {
+    /// lines each logging thread can have in flight, a power of 2
+    static constexpr size_t DefaultRingSize = 1024;
+    /// longest a line waits before the background thread picks it up
+    static constexpr llarp_time_t FlushInterval = 50;
+
+    explicit AsyncLogStream(ILogStream_ptr sink,
+                            size_t ringSize = DefaultRingSize);
+
+    ~AsyncLogStream();
+
+    /// make stream async unless it already is
+    static ILogStream_ptr
+    Wrap(ILogStream_ptr stream);
+
+    /// start the background thread, lines logged before are kept
+    void
+    Start();
+
+    /// write out everything logged so far and stop the background thread
+    void
+    Stop();
+
+    /// lines dropped because a ring was full
+    uint64_t
+    Dropped() const
+    {
+      return m_Dropped.load();
+    }
+
+    /// queue a line for the background thread, never blocks
+    void
+    Log(LogLevel lvl, const char* fname, int lineno,
+        std::string msg) override;
+
+    void
+    PreLog(std::stringstream& out, LogLevel lvl, const char* fname,
+           int lineno, std::thread::id tid, absl::Time when) const override;
+
+    void
+    Print(LogLevel lvl, const char* fname, const std::string& msg) override;
+
+    void
+    PostLog(std::stringstream& out) const override;
+
+    /// passed on to the wrapped stream from the background thread
+    void
+    Tick(llarp_time_t now) override;
+
+   private:
+    struct Record
+    {
+      LogLevel lvl;
+      const char* fname;
+      int lineno;
+      std::thread::id tid;
+      absl::Time when;
+      std::string msg;
+    };
+
+    struct Ring;
+    struct Producer;
+
+    Ring*
+    GetRing() LOCKS_EXCLUDED(m_RingsMutex);
+
+    void
+    Run();
+
+    /// write out every queued line, called from one thread at a time
+    void
+    Drain() LOCKS_EXCLUDED(m_RingsMutex);
+
+    const ILogStream_ptr m_Sink;
+    const size_t m_RingSize;
+    /// tells the rings of different streams apart in thread local storage
+    const uint64_t m_ID;
+
+    util::Mutex m_RingsMutex;  // protects m_Rings
+    std::vector< std::shared_ptr< Ring > > m_Rings GUARDED_BY(m_RingsMutex);
+
+    std::atomic< uint64_t > m_Dropped;
+    uint64_t m_DropsReported = 0;
+    std::atomic< llarp_time_t > m_LastTick;
+    llarp_time_t m_TickedAt = 0;
+
+    util::Mutex m_StateMutex;  // protects m_Stopping
+    bool m_Stopping GUARDED_BY(m_StateMutex) = false;
+    std::thread m_Worker;
+  };
+}  // namespace llarp
+
+#endif
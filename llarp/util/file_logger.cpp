@@ -26,7 +26,8 @@ namespace llarp
 
   void
   FileLogStream::PreLog(std::stringstream &ss, LogLevel lvl, const char *fname,
-                        int lineno) const
+                        int lineno, std::thread::id tid,
+                        absl::Time when) const
   {
     switch(lvl)
     {
@@ -46,7 +47,8 @@ namespace llarp
         ss << "[ERR] ";
         break;
     }
-    ss << "(" << thread_id_string() << ") " << log_timestamp() << " " << fname
+    ss << "(" << thread_id_string(tid) << ") "
+       << log_timestamp("%c %Z", when) << " " << fname
        << ":" << lineno << "\t";
   }
 
@@ -16,7 +16,7 @@ namespace llarp
 
     void
     PreLog(std::stringstream& out, LogLevel lvl, const char* fname,
-           int lineno) const override;
+           int lineno, std::thread::id tid, absl::Time when) const override;
 
     void
     Print(LogLevel, const char*, const std::string& msg) override;
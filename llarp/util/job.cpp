@@ -0,0 +1 @@
+#include <util/job.hpp>
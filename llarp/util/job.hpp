@@ -0,0 +1,247 @@
+#ifndef LLARP_UTIL_JOB_HPP
+#define LLARP_UTIL_JOB_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// a void() callable with inline storage
+    ///
+    /// like std::function but anything up to InlineSize bytes (a lambda
+    /// holding a shared_ptr and a few pointers, a bound member function) is
+    /// kept inside the job, so queueing work does not touch the heap
+    class Job
+    {
+     public:
+      static constexpr size_t InlineSize = 64;
+
+      Job() = default;
+
+      Job(std::nullptr_t)
+      {
+      }
+
+      template < typename F,
+                 typename = typename std::enable_if< !std::is_same<
+                     typename std::decay< F >::type, Job >::value >::type >
+      Job(F&& f)
+      {
+        using Func = typename std::decay< F >::type;
+        Emplace< Func >(std::forward< F >(f),
+                        std::integral_constant< bool, FitsInline< Func >() >{});
+      }
+
+      Job(const Job& other)
+      {
+        if(other.m_Ops)
+          other.m_Ops->copy(&m_Storage, &other.m_Storage);
+        m_Ops = other.m_Ops;
+      }
+
+      Job(Job&& other) noexcept
+      {
+        if(other.m_Ops)
+          other.m_Ops->move(&m_Storage, &other.m_Storage);
+        m_Ops       = other.m_Ops;
+        other.m_Ops = nullptr;
+      }
+
+      ~Job()
+      {
+        Reset();
+      }
+
+      Job&
+      operator=(const Job& other)
+      {
+        if(this != &other)
+        {
+          Job copy(other);
+          *this = std::move(copy);
+        }
+        return *this;
+      }
+
+      Job&
+      operator=(Job&& other) noexcept
+      {
+        if(this != &other)
+        {
+          Reset();
+          if(other.m_Ops)
+            other.m_Ops->move(&m_Storage, &other.m_Storage);
+          m_Ops       = other.m_Ops;
+          other.m_Ops = nullptr;
+        }
+        return *this;
+      }
+
+      void
+      operator()()
+      {
+        assert(m_Ops);
+        m_Ops->invoke(&m_Storage);
+      }
+
+      explicit operator bool() const
+      {
+        return m_Ops != nullptr;
+      }
+
+      void
+      Reset()
+      {
+        if(m_Ops)
+          m_Ops->destroy(&m_Storage);
+        m_Ops = nullptr;
+      }
+
+      /// true if a callable of type F is kept inline
+      template < typename F >
+      static constexpr bool
+      FitsInline()
+      {
+        return sizeof(F) <= InlineSize
+            && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible< F >::value;
+      }
+
+     private:
+      using Storage =
+          typename std::aligned_storage< InlineSize,
+                                         alignof(std::max_align_t) >::type;
+
+      struct Ops
+      {
+        void (*invoke)(Storage*);
+        void (*copy)(Storage*, const Storage*);
+        void (*move)(Storage*, Storage*);
+        void (*destroy)(Storage*);
+      };
+
+      /// callable lives in the storage itself
+      template < typename F >
+      struct InlineOps
+      {
+        static F*
+        Get(Storage* s)
+        {
+          return reinterpret_cast< F* >(s);
+        }
+
+        static const F*
+        Get(const Storage* s)
+        {
+          return reinterpret_cast< const F* >(s);
+        }
+
+        static void
+        Invoke(Storage* s)
+        {
+          (*Get(s))();
+        }
+
+        static void
+        Copy(Storage* to, const Storage* from)
+        {
+          new(to) F(*Get(from));
+        }
+
+        static void
+        Move(Storage* to, Storage* from)
+        {
+          new(to) F(std::move(*Get(from)));
+          Get(from)->~F();
+        }
+
+        static void
+        Destroy(Storage* s)
+        {
+          Get(s)->~F();
+        }
+
+        static const Ops*
+        Table()
+        {
+          static const Ops ops = {&Invoke, &Copy, &Move, &Destroy};
+          return &ops;
+        }
+      };
+
+      /// too big, the storage holds a pointer to it
+      template < typename F >
+      struct HeapOps
+      {
+        static F*&
+        Get(Storage* s)
+        {
+          return *reinterpret_cast< F** >(s);
+        }
+
+        static F*
+        Get(const Storage* s)
+        {
+          return *reinterpret_cast< F* const* >(s);
+        }
+
+        static void
+        Invoke(Storage* s)
+        {
+          (*Get(s))();
+        }
+
+        static void
+        Copy(Storage* to, const Storage* from)
+        {
+          new(to) F*(new F(*Get(from)));
+        }
+
+        static void
+        Move(Storage* to, Storage* from)
+        {
+          new(to) F*(Get(from));
+        }
+
+        static void
+        Destroy(Storage* s)
+        {
+          delete Get(s);
+        }
+
+        static const Ops*
+        Table()
+        {
+          static const Ops ops = {&Invoke, &Copy, &Move, &Destroy};
+          return &ops;
+        }
+      };
+
+      template < typename Func, typename F >
+      void
+      Emplace(F&& f, std::true_type)
+      {
+        new(&m_Storage) Func(std::forward< F >(f));
+        m_Ops = InlineOps< Func >::Table();
+      }
+
+      template < typename Func, typename F >
+      void
+      Emplace(F&& f, std::false_type)
+      {
+        new(&m_Storage) Func*(new Func(std::forward< F >(f)));
+        m_Ops = HeapOps< Func >::Table();
+      }
+
+      Storage m_Storage;
+      const Ops* m_Ops = nullptr;
+    };
+  }  // namespace thread
+}  // namespace llarp
+
+#endif
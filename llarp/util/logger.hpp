@@ -93,6 +93,9 @@ namespace llarp
   void
   SetLogLevel(LogLevel lvl);
 
+  /** internal */
+  constexpr bool _LogDebugStripped = true;
+
   /** internal */
   template < typename... TArgs >
   void
@@ -102,11 +105,11 @@ namespace llarp
     if(log.minLevel > lvl)
       return;
 
+    // only the arguments are formatted here, the stream adds the prefix
+    // and may do so later on another thread
     std::stringstream ss;
-    log.logStream->PreLog(ss, lvl, fname, lineno);
     LogAppend(ss, std::forward< TArgs >(args)...);
-    log.logStream->PostLog(ss);
-    log.logStream->Print(lvl, fname, ss.str());
+    log.logStream->Log(lvl, fname, lineno, ss.str());
   }
   /*
     std::stringstream ss;
@@ -235,11 +238,24 @@ namespace llarp
   */
 }  // namespace llarp
 
+#ifdef NDEBUG
+/// release builds compile debug lines out, the arguments are still checked.
+/// starts with a name so llarp::LogDebug keeps working
+#define LogDebug(...)                                                    \
+  _LogDebugStripped ? (void)0                                            \
+                    : ::llarp::_Log(llarp::eLogDebug, LOG_TAG, __LINE__, \
+                                    __VA_ARGS__)
+#define LogDebugTag(tag, ...)                                        \
+  _LogDebugStripped ? (void)0                                        \
+                    : ::llarp::_Log(llarp::eLogDebug, tag, __LINE__, \
+                                    __VA_ARGS__)
+#else
 #define LogDebug(...) _Log(llarp::eLogDebug, LOG_TAG, __LINE__, __VA_ARGS__)
+#define LogDebugTag(tag, ...) _Log(llarp::eLogDebug, tag, __LINE__, __VA_ARGS__)
+#endif
 #define LogInfo(...) _Log(llarp::eLogInfo, LOG_TAG, __LINE__, __VA_ARGS__)
 #define LogWarn(...) _Log(llarp::eLogWarn, LOG_TAG, __LINE__, __VA_ARGS__)
 #define LogError(...) _Log(llarp::eLogError, LOG_TAG, __LINE__, __VA_ARGS__)
-#define LogDebugTag(tag, ...) _Log(llarp::eLogDebug, tag, __LINE__, __VA_ARGS__)
 #define LogInfoTag(tag, ...) _Log(llarp::eLogInfo, tag, __LINE__, __VA_ARGS__)
 #define LogWarnTag(tag, ...) _Log(llarp::eLogWarn, tag, __LINE__, __VA_ARGS__)
 #define LogErrorTag(tag, ...) _Log(llarp::eLogError, tag, __LINE__, __VA_ARGS__)
@@ -28,9 +28,8 @@ namespace llarp
   }
 
   static inline std::string
-  thread_id_string()
+  thread_id_string(std::thread::id tid = std::this_thread::get_id())
   {
-    auto tid = std::this_thread::get_id();
     std::hash< std::thread::id > h;
     uint16_t id = h(tid) % 1000;
 #if defined(ANDROID) || defined(RPI)
@@ -45,8 +44,10 @@ namespace llarp
   struct log_timestamp
   {
     const char* format;
+    absl::Time when;
 
-    log_timestamp(const char* fmt = "%c %Z") : format(fmt)
+    log_timestamp(const char* fmt = "%c %Z", absl::Time t = absl::Now())
+        : format(fmt), when(t)
     {
     }
 
@@ -54,10 +55,9 @@ namespace llarp
     operator<<(std::ostream& out, const log_timestamp& ts)
     {
 #if defined(ANDROID) || defined(RPI)
-      (void)ts;
-      return out << time_now_ms();
+      return out << absl::ToUnixMillis(ts.when);
 #else
-      return out << absl::FormatTime(ts.format, absl::Now(), absl::LocalTimeZone());
+      return out << absl::FormatTime(ts.format, ts.when, absl::LocalTimeZone());
 #endif
     }
   };
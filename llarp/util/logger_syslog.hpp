@@ -9,7 +9,7 @@ namespace llarp
   {
     void
     PreLog(std::stringstream& s, LogLevel lvl, const char* fname,
-           int lineno) const override;
+           int lineno, std::thread::id tid, absl::Time when) const override;
 
     void
     Print(LogLevel lvl, const char* tag, const std::string& msg) override;
@@ -58,7 +58,7 @@ namespace llarp
   void
   Logic::queue_func(std::function< void(void) > f)
   {
-    this->thread->QueueFunc(f);
+    this->thread->QueueFunc(std::move(f));
   }
 
   uint32_t
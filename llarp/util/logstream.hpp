@@ -4,8 +4,12 @@
 #include <string>
 #include <util/loglevel.hpp>
 #include <sstream>
+#include <thread>
 #include <util/time.hpp>
 
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+
 namespace llarp
 {
   /// logger stream interface
@@ -13,9 +17,21 @@ namespace llarp
   {
     virtual ~ILogStream(){};
 
+    /// log a line whose arguments are already formatted into msg
+    virtual void
+    Log(LogLevel lvl, const char* fname, int lineno, std::string msg)
+    {
+      std::stringstream ss;
+      PreLog(ss, lvl, fname, lineno, std::this_thread::get_id(), absl::Now());
+      ss << msg;
+      PostLog(ss);
+      Print(lvl, fname, ss.str());
+    }
+
+    /// write the prefix for a line logged by thread tid at time when
     virtual void
-    PreLog(std::stringstream& out, LogLevel lvl, const char* fname,
-           int lineno) const = 0;
+    PreLog(std::stringstream& out, LogLevel lvl, const char* fname, int lineno,
+           std::thread::id tid, absl::Time when) const = 0;
     virtual void
     Print(LogLevel lvl, const char* filename, const std::string& msg) = 0;
 
@@ -0,0 +1 @@
+#include <util/lru_cache.hpp>
@@ -0,0 +1,152 @@
+#ifndef LLARP_UTIL_LRU_CACHE_HPP
+#define LLARP_UTIL_LRU_CACHE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// map holding at most capacity entries, putting a new key when full
+    /// evicts the one least recently put or looked up. not thread safe.
+    template < typename Key, typename Value,
+               typename Hash = std::hash< Key > >
+    class LRUCache
+    {
+     public:
+      using Entry = std::pair< const Key, Value >;
+
+      explicit LRUCache(size_t capacity) : m_Capacity(capacity)
+      {
+      }
+
+      size_t
+      Size() const
+      {
+        return m_Map.size();
+      }
+
+      size_t
+      Capacity() const
+      {
+        return m_Capacity;
+      }
+
+      /// number of entries pushed out to make room
+      size_t
+      Evicted() const
+      {
+        return m_Evicted;
+      }
+
+      /// find key and mark it most recently used, nullptr if absent
+      Value*
+      Get(const Key& key)
+      {
+        auto itr = m_Map.find(key);
+        if(itr == m_Map.end())
+          return nullptr;
+        m_Order.splice(m_Order.begin(), m_Order, itr->second);
+        return &itr->second->second;
+      }
+
+      /// find key without changing its place
+      const Value*
+      Peek(const Key& key) const
+      {
+        auto itr = m_Map.find(key);
+        if(itr == m_Map.end())
+          return nullptr;
+        return &itr->second->second;
+      }
+
+      bool
+      Contains(const Key& key) const
+      {
+        return m_Map.find(key) != m_Map.end();
+      }
+
+      /// insert or replace key as the most recently used entry
+      Value&
+      Put(const Key& key, Value value)
+      {
+        auto itr = m_Map.find(key);
+        if(itr != m_Map.end())
+        {
+          itr->second->second = std::move(value);
+          m_Order.splice(m_Order.begin(), m_Order, itr->second);
+          return itr->second->second;
+        }
+        if(m_Capacity == 0)
+          Clear();
+        else
+        {
+          while(m_Map.size() >= m_Capacity)
+            EvictOldest();
+        }
+        m_Order.emplace_front(key, std::move(value));
+        m_Map.emplace(key, m_Order.begin());
+        return m_Order.front().second;
+      }
+
+      bool
+      Erase(const Key& key)
+      {
+        auto itr = m_Map.find(key);
+        if(itr == m_Map.end())
+          return false;
+        m_Order.erase(itr->second);
+        m_Map.erase(itr);
+        return true;
+      }
+
+      /// least recently used entry, nullptr if empty
+      const Entry*
+      Oldest() const
+      {
+        if(m_Order.empty())
+          return nullptr;
+        return &m_Order.back();
+      }
+
+      void
+      EvictOldest()
+      {
+        if(m_Order.empty())
+          return;
+        m_Map.erase(m_Order.back().first);
+        m_Order.pop_back();
+        ++m_Evicted;
+      }
+
+      void
+      Clear()
+      {
+        m_Map.clear();
+        m_Order.clear();
+      }
+
+      /// visit entries from most to least recently used
+      void
+      ForEach(std::function< void(const Key&, const Value&) > visit) const
+      {
+        for(const auto& entry : m_Order)
+          visit(entry.first, entry.second);
+      }
+
+     private:
+      using Order = std::list< Entry >;
+
+      size_t m_Capacity;
+      size_t m_Evicted = 0;
+      Order m_Order;
+      std::unordered_map< Key, typename Order::iterator, Hash > m_Map;
+    };
+  }  // namespace util
+}  // namespace llarp
+
+#endif
@@ -171,6 +171,23 @@ namespace llarp
     }                                                                 \
   } while(false)
 
+// Records the quantiles as well, for latencies and the like
+#define METRICS_DYNAMIC_HISTOGRAM_UPDATE(CAT, METRIC, VALUE)                   \
+  do                                                                           \
+  {                                                                            \
+    using namespace llarp::metrics;                                            \
+    if(DefaultManager::instance())                                             \
+    {                                                                          \
+      CollectorRepo& repository = DefaultManager::instance()->collectorRepo(); \
+      HistogramCollector* collector =                                          \
+          repository.defaultHistogramCollector((CAT), (METRIC));               \
+      if(collector->id().category()->enabled())                                \
+      {                                                                        \
+        collector->tick((VALUE));                                              \
+      }                                                                        \
+    }                                                                          \
+  } while(false)
+
 #define METRICS_DYNAMIC_INCREMENT(CAT, METRIC) \
   METRICS_DYNAMIC_INT_UPDATE(CAT, METRIC, 1)
 
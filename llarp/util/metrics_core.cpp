@@ -1,31 +1,30 @@
 #include <util/metrics_core.hpp>
 
+#include <cmath>
 #include <iostream>
 
 namespace llarp
 {
   namespace metrics
   {
+    constexpr int IntCollector::DEFAULT_MIN;
+    constexpr int IntCollector::DEFAULT_MAX;
+    constexpr size_t Histogram::SUB_BUCKETS;
+    constexpr int Histogram::MIN_EXP;
+    constexpr int Histogram::MAX_EXP;
+    constexpr size_t Histogram::BUCKETS;
+
     Record
-    IntCollector::loadAndClear()
+    IntCollector::read(bool clear)
     {
-      size_t count;
-      uint64_t total;
-      int min;
-      int max;
+      size_t count  = 0;
+      int64_t total = 0;
+      int min       = DEFAULT_MIN;
+      int max       = DEFAULT_MAX;
 
+      for(auto &shard : m_shards)
       {
-        absl::WriterMutexLock l(&m_mutex);
-
-        count = m_count;
-        total = m_total;
-        min   = m_min;
-        max   = m_max;
-
-        m_count = 0;
-        m_total = 0;
-        m_min   = DEFAULT_MIN;
-        m_max   = DEFAULT_MAX;
+        shard.load(count, total, min, max, DEFAULT_MIN, DEFAULT_MAX, clear);
       }
 
       return {m_id, count, static_cast< double >(total),
@@ -36,25 +35,148 @@ namespace llarp
     }
 
     Record
-    IntCollector::load()
+    DoubleCollector::read(bool clear)
     {
-      size_t count;
-      int64_t total;
-      int min;
-      int max;
+      Record rec(m_id);
 
+      for(auto &shard : m_shards)
       {
-        absl::ReaderMutexLock l(&m_mutex);
+        shard.load(rec.count(), rec.total(), rec.min(), rec.max(),
+                   Record::DEFAULT_MIN, Record::DEFAULT_MAX, clear);
+      }
+
+      return rec;
+    }
 
-        count = m_count;
-        total = m_total;
-        min   = m_min;
-        max   = m_max;
+    size_t
+    Histogram::bucket(double value)
+    {
+      if(!(value > 0))
+      {
+        return 0;
+      }
+      int exp;
+      // value = frac * 2^exp, frac in [0.5, 1)
+      const double frac = std::frexp(value, &exp);
+      if(exp <= MIN_EXP)
+      {
+        return 0;
+      }
+      if(exp > MAX_EXP + 1)
+      {
+        return BUCKETS - 1;
       }
+      const size_t sub = static_cast< size_t >((frac - 0.5) * 2 * SUB_BUCKETS);
+      return 1 + (exp - 1 - MIN_EXP) * SUB_BUCKETS
+          + std::min(sub, SUB_BUCKETS - 1);
+    }
 
-      return {m_id, count, static_cast< double >(total),
-              (min == DEFAULT_MIN) ? Record::DEFAULT_MIN : min,
-              (max == DEFAULT_MAX) ? Record::DEFAULT_MAX : max};
+    double
+    Histogram::bucketLow(size_t idx)
+    {
+      if(idx == 0)
+      {
+        return 0;
+      }
+      const size_t exp = (idx - 1) / SUB_BUCKETS;
+      const size_t sub = (idx - 1) % SUB_BUCKETS;
+      return std::ldexp(1.0 + static_cast< double >(sub) / SUB_BUCKETS,
+                        static_cast< int >(exp) + MIN_EXP);
+    }
+
+    double
+    Histogram::quantile(double q) const
+    {
+      const size_t count = m_record.count();
+      // the rank of the value wanted, 1 based
+      const double want = std::ceil(q * static_cast< double >(count));
+      const auto rank   = std::max< size_t >(1, static_cast< size_t >(want));
+
+      size_t seen = 0;
+      size_t idx  = 0;
+      for(; idx < m_buckets.size(); ++idx)
+      {
+        seen += m_buckets[idx];
+        if(seen >= rank)
+        {
+          break;
+        }
+      }
+      // the end buckets are open ended, the extremes are all we know
+      if(idx == 0)
+      {
+        return m_record.min();
+      }
+      if(idx >= BUCKETS - 1)
+      {
+        return m_record.max();
+      }
+
+      const double mid = (bucketLow(idx) + bucketLow(idx + 1)) / 2;
+      return std::max(m_record.min(), std::min(m_record.max(), mid));
+    }
+
+    Record
+    Histogram::record() const
+    {
+      Record rec = m_record;
+      if(rec.count() == 0)
+      {
+        return rec;
+      }
+
+      Record::Quantiles quantiles;
+      for(size_t i = 0; i < Record::NUM_QUANTILES; ++i)
+      {
+        quantiles[i] = quantile(Record::QUANTILES[i]);
+      }
+      rec.quantiles() = quantiles;
+      return rec;
+    }
+
+    void
+    Histogram::merge(const Histogram &other)
+    {
+      metrics::combine(m_record, other.m_record);
+      for(size_t i = 0; i < BUCKETS; ++i)
+      {
+        m_buckets[i] += other.m_buckets[i];
+      }
+    }
+
+    void
+    HistogramCollector::clear()
+    {
+      for(auto &shard : m_shards)
+      {
+        shard.summary.reset(Record::DEFAULT_MIN, Record::DEFAULT_MAX);
+        for(auto &bucket : shard.buckets)
+        {
+          bucket.store(0, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    Histogram
+    HistogramCollector::read(bool clear)
+    {
+      Histogram histogram(m_id);
+      Record &rec = histogram.summary();
+      auto &out   = histogram.buckets();
+
+      for(auto &shard : m_shards)
+      {
+        shard.summary.load(rec.count(), rec.total(), rec.min(), rec.max(),
+                           Record::DEFAULT_MIN, Record::DEFAULT_MAX, clear);
+        for(size_t i = 0; i < Histogram::BUCKETS; ++i)
+        {
+          out[i] += clear
+              ? shard.buckets[i].exchange(0, std::memory_order_relaxed)
+              : shard.buckets[i].load(std::memory_order_relaxed);
+        }
+      }
+
+      return histogram;
     }
 
     std::tuple< Id, bool >
@@ -259,24 +381,30 @@ namespace llarp
       return *it->second.get();
     }
 
+    std::vector< MetricCollectors * >
+    CollectorRepo::categoryCollectors(const Category *category) const
+    {
+      absl::ReaderMutexLock l(&m_mutex);
+
+      auto it = m_categories.find(category);
+      if(it == m_categories.end())
+      {
+        return {};
+      }
+      return it->second;
+    }
+
     std::vector< Record >
     CollectorRepo::collectAndClear(const Category *category)
     {
-      absl::WriterMutexLock l(&m_mutex);
+      auto collectors = categoryCollectors(category);
 
       std::vector< Record > result;
+      result.reserve(collectors.size());
 
-      auto it = m_categories.find(category);
-
-      if(it != m_categories.end())
-      {
-        auto &collectors = it->second;
-        result.reserve(collectors.size());
-
-        std::transform(
-            collectors.begin(), collectors.end(), std::back_inserter(result),
-            [](MetricCollectors *c) { return c->combineAndClear(); });
-      }
+      std::transform(
+          collectors.begin(), collectors.end(), std::back_inserter(result),
+          [](MetricCollectors *c) { return c->combineAndClear(); });
 
       return result;
     }
@@ -284,21 +412,29 @@ namespace llarp
     std::vector< Record >
     CollectorRepo::collect(const Category *category)
     {
-      absl::WriterMutexLock l(&m_mutex);
+      auto collectors = categoryCollectors(category);
 
       std::vector< Record > result;
+      result.reserve(collectors.size());
 
-      auto it = m_categories.find(category);
+      std::transform(collectors.begin(), collectors.end(),
+                     std::back_inserter(result),
+                     [](MetricCollectors *c) { return c->combine(); });
 
-      if(it != m_categories.end())
-      {
-        auto &collectors = it->second;
-        result.reserve(collectors.size());
+      return result;
+    }
 
-        std::transform(collectors.begin(), collectors.end(),
-                       std::back_inserter(result),
-                       [](MetricCollectors *c) { return c->combine(); });
-      }
+    std::vector< Record >
+    CollectorRepo::collectTotals(const Category *category)
+    {
+      auto collectors = categoryCollectors(category);
+
+      std::vector< Record > result;
+      result.reserve(collectors.size());
+
+      std::transform(collectors.begin(), collectors.end(),
+                     std::back_inserter(result),
+                     [](MetricCollectors *c) { return c->combineTotal(); });
 
       return result;
     }
@@ -339,6 +475,26 @@ namespace llarp
       }
     }
 
+    HistogramCollector *
+    CollectorRepo::defaultHistogramCollector(const Id &id)
+    {
+      {
+        absl::ReaderMutexLock l(&m_mutex);
+        auto it = m_collectors.find(id);
+        if(it != m_collectors.end())
+        {
+          auto histograms = it->second->findHistogramCollectors();
+          if(histograms)
+            return histograms->defaultCollector();
+        }
+      }
+
+      {
+        absl::WriterMutexLock l(&m_mutex);
+        return getCollectors(id).histogramCollectors().defaultCollector();
+      }
+    }
+
     std::pair< std::vector< std::shared_ptr< DoubleCollector > >,
                std::vector< std::shared_ptr< IntCollector > > >
     CollectorRepo::allCollectors(const Id &id)
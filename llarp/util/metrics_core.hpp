@@ -6,38 +6,150 @@
 #include <util/stopwatch.hpp>
 #include <util/threading.hpp>
 
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace llarp
 {
   namespace metrics
   {
+    /// collectors are split into this many shards. each thread ticks the
+    /// shard it was handed, so threads don't fight over one cache line, and
+    /// the shards are only added up when the collector is read
+    constexpr size_t COLLECTOR_SHARDS = 8;
+
+    /// the shard the calling thread ticks
+    inline size_t
+    collectorShard()
+    {
+      static std::atomic< size_t > next{0};
+      static thread_local size_t shard =
+          next.fetch_add(1, std::memory_order_relaxed) % COLLECTOR_SHARDS;
+      return shard;
+    }
+
+    template < typename Value >
+    inline void
+    atomicAdd(std::atomic< Value > &atom, Value value)
+    {
+      Value cur = atom.load(std::memory_order_relaxed);
+      while(!atom.compare_exchange_weak(cur, cur + value,
+                                        std::memory_order_relaxed))
+        ;
+    }
+
+    template < typename Value >
+    inline void
+    atomicMin(std::atomic< Value > &atom, Value value)
+    {
+      Value cur = atom.load(std::memory_order_relaxed);
+      while(value < cur
+            && !atom.compare_exchange_weak(cur, value,
+                                           std::memory_order_relaxed))
+        ;
+    }
+
+    template < typename Value >
+    inline void
+    atomicMax(std::atomic< Value > &atom, Value value)
+    {
+      Value cur = atom.load(std::memory_order_relaxed);
+      while(cur < value
+            && !atom.compare_exchange_weak(cur, value,
+                                           std::memory_order_relaxed))
+        ;
+    }
+
+    /// count, total, min and max of the values ticked into one shard, on a
+    /// cache line of its own
+    template < typename Value, typename Total >
+    struct alignas(64) CollectorShard
+    {
+      std::atomic< size_t > count;
+      std::atomic< Total > total;
+      std::atomic< Value > min;
+      std::atomic< Value > max;
+
+      void
+      tick(Value value)
+      {
+        count.fetch_add(1, std::memory_order_relaxed);
+        atomicAdd(total, Total(value));
+        atomicMin(min, value);
+        atomicMax(max, value);
+      }
+
+      void
+      accumulate(size_t cnt, Total tot, Value mn, Value mx)
+      {
+        count.fetch_add(cnt, std::memory_order_relaxed);
+        atomicAdd(total, tot);
+        atomicMin(min, mn);
+        atomicMax(max, mx);
+      }
+
+      /// add this shard into the given totals, taking it back to empty if
+      /// clear is set
+      void
+      load(size_t &cnt, Total &tot, Value &mn, Value &mx, Value defaultMin,
+           Value defaultMax, bool clear)
+      {
+        const auto order = std::memory_order_relaxed;
+        if(clear)
+        {
+          cnt += count.exchange(0, order);
+          tot += total.exchange(0, order);
+          mn = std::min(mn, min.exchange(defaultMin, order));
+          mx = std::max(mx, max.exchange(defaultMax, order));
+        }
+        else
+        {
+          cnt += count.load(order);
+          tot += total.load(order);
+          mn = std::min(mn, min.load(order));
+          mx = std::max(mx, max.load(order));
+        }
+      }
+
+      void
+      reset(Value defaultMin, Value defaultMax)
+      {
+        count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        min.store(defaultMin, std::memory_order_relaxed);
+        max.store(defaultMax, std::memory_order_relaxed);
+      }
+    };
+
+    /// ticks take no lock, reads add up the shards. a read racing a tick
+    /// may see part of that tick, which only ever shows up in the next
+    /// sample instead of this one.
     class IntCollector
     {
+      using Shard = CollectorShard< int, int64_t >;
+
       const Id m_id;
-      size_t m_count GUARDED_BY(m_mutex);
-      int64_t m_total GUARDED_BY(m_mutex);
-      int m_min GUARDED_BY(m_mutex);
-      int m_max GUARDED_BY(m_mutex);
-      mutable util::Mutex m_mutex;
+      std::array< Shard, COLLECTOR_SHARDS > m_shards;
 
       IntCollector(const IntCollector &) = delete;
       IntCollector &
       operator=(const IntCollector &) = delete;
 
+      Record
+      read(bool clear);
+
      public:
       static constexpr int DEFAULT_MIN = std::numeric_limits< int >::max();
       static constexpr int DEFAULT_MAX = std::numeric_limits< int >::min();
 
-      IntCollector(const Id &id)
-          : m_id(id)
-          , m_count(0)
-          , m_total(0)
-          , m_min(DEFAULT_MIN)
-          , m_max(DEFAULT_MAX)
+      IntCollector(const Id &id) : m_id(id)
       {
+        clear();
       }
 
       const Id &
@@ -49,129 +161,215 @@ namespace llarp
       void
       clear()
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_count = 0;
-        m_total = 0;
-        m_min   = DEFAULT_MIN;
-        m_max   = DEFAULT_MAX;
+        for(auto &shard : m_shards)
+          shard.reset(DEFAULT_MIN, DEFAULT_MAX);
       }
 
       Record
-      loadAndClear();
+      loadAndClear()
+      {
+        return read(true);
+      }
 
       Record
-      load();
+      load()
+      {
+        return read(false);
+      }
 
       void
       tick(int value)
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_count++;
-        m_total += value;
-        m_min = std::min(m_min, value);
-        m_max = std::max(m_max, value);
+        m_shards[collectorShard()].tick(value);
       }
 
       void
       accumulate(size_t count, int total, int min, int max)
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_count += count;
-        m_total += total;
-        m_min = std::min(m_min, min);
-        m_max = std::max(m_max, max);
+        m_shards[collectorShard()].accumulate(count, total, min, max);
       }
 
+      /// not atomic with respect to concurrent ticks
       void
       set(size_t count, int total, int min, int max)
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_count = count;
-        m_total = total;
-        m_min   = min;
-        m_max   = max;
+        clear();
+        accumulate(count, total, min, max);
       }
     };
 
+    /// lock free like IntCollector
     class DoubleCollector
     {
-      Record m_record GUARDED_BY(m_mutex);
-      mutable util::Mutex m_mutex;
+      using Shard = CollectorShard< double, double >;
+
+      const Id m_id;
+      std::array< Shard, COLLECTOR_SHARDS > m_shards;
 
       DoubleCollector(const DoubleCollector &) = delete;
       DoubleCollector &
       operator=(const DoubleCollector &) = delete;
 
+      Record
+      read(bool clear);
+
      public:
-      DoubleCollector(const Id &id) : m_record(id)
+      DoubleCollector(const Id &id) : m_id(id)
       {
+        clear();
       }
 
       void
       clear()
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_record.count() = 0;
-        m_record.total() = 0.0;
-        m_record.min()   = Record::DEFAULT_MIN;
-        m_record.max()   = Record::DEFAULT_MAX;
+        for(auto &shard : m_shards)
+          shard.reset(Record::DEFAULT_MIN, Record::DEFAULT_MAX);
       }
 
       Record
       loadAndClear()
       {
-        absl::WriterMutexLock l(&m_mutex);
-        Record rec       = m_record;
-        m_record.count() = 0;
-        m_record.total() = 0.0;
-        m_record.min()   = Record::DEFAULT_MIN;
-        m_record.max()   = Record::DEFAULT_MAX;
-
-        return rec;
+        return read(true);
       }
 
       Record
       load()
       {
-        absl::ReaderMutexLock l(&m_mutex);
-        return m_record;
+        return read(false);
       }
 
       void
       tick(double value)
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_record.count()++;
-        m_record.total() += value;
-        m_record.min() = std::min(m_record.min(), value);
-        m_record.max() = std::max(m_record.max(), value);
+        m_shards[collectorShard()].tick(value);
       }
 
       void
       accumulate(size_t count, double total, double min, double max)
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_record.count() += count;
-        m_record.total() += total;
-        m_record.min() = std::min(m_record.min(), min);
-        m_record.max() = std::max(m_record.max(), max);
+        m_shards[collectorShard()].accumulate(count, total, min, max);
       }
 
+      /// not atomic with respect to concurrent ticks
       void
       set(size_t count, double total, double min, double max)
       {
-        absl::WriterMutexLock l(&m_mutex);
-        m_record.count() = count;
-        m_record.total() = total;
-        m_record.min()   = min;
-        m_record.max()   = max;
+        clear();
+        accumulate(count, total, min, max);
       }
 
       const Id &
       id() const
       {
-        absl::ReaderMutexLock l(&m_mutex);
-        return m_record.id();
+        return m_id;
+      }
+    };
+
+    /// merged bucket counts of a histogram collector
+    class Histogram
+    {
+     public:
+      /// buckets each power of two is cut into, values land in a bucket no
+      /// wider than 1 / SUB_BUCKETS of themselves
+      static constexpr size_t SUB_BUCKETS = 16;
+      /// smallest and largest powers of two with buckets of their own,
+      /// everything below goes in bucket 0 and everything above in the last
+      static constexpr int MIN_EXP = -20;
+      static constexpr int MAX_EXP = 44;
+      static constexpr size_t BUCKETS =
+          1 + (MAX_EXP - MIN_EXP + 1) * SUB_BUCKETS;
+
+      explicit Histogram(const Id &id = Id()) : m_record(id), m_buckets(BUCKETS)
+      {
+      }
+
+      /// the bucket value falls in
+      static size_t
+      bucket(double value);
+
+      /// lowest value that falls in bucket idx
+      static double
+      bucketLow(size_t idx);
+
+      /// the value at quantile q in [0, 1], reported as the middle of its
+      /// bucket. undefined when empty.
+      double
+      quantile(double q) const;
+
+      /// count, total, min and max, plus the quantiles if not empty
+      Record
+      record() const;
+
+      void
+      merge(const Histogram &other);
+
+      // clang-format off
+      Record& summary() { return m_record; }
+      const Record& summary() const { return m_record; }
+      std::vector< uint64_t >& buckets() { return m_buckets; }
+      const std::vector< uint64_t >& buckets() const { return m_buckets; }
+      // clang-format on
+
+     private:
+      Record m_record;
+      std::vector< uint64_t > m_buckets;
+    };
+
+    /// HdrHistogram style log linear histogram of the values ticked, sharded
+    /// and lock free like DoubleCollector. its records carry the quantiles
+    /// on top of count, total, min and max.
+    class HistogramCollector
+    {
+      struct Shard
+      {
+        CollectorShard< double, double > summary;
+        std::array< std::atomic< uint64_t >, Histogram::BUCKETS > buckets;
+      };
+
+      const Id m_id;
+      std::array< Shard, COLLECTOR_SHARDS > m_shards;
+
+      HistogramCollector(const HistogramCollector &) = delete;
+      HistogramCollector &
+      operator=(const HistogramCollector &) = delete;
+
+      Histogram
+      read(bool clear);
+
+     public:
+      HistogramCollector(const Id &id) : m_id(id)
+      {
+        clear();
+      }
+
+      const Id &
+      id() const
+      {
+        return m_id;
+      }
+
+      void
+      clear();
+
+      Histogram
+      loadAndClear()
+      {
+        return read(true);
+      }
+
+      Histogram
+      load()
+      {
+        return read(false);
+      }
+
+      void
+      tick(double value)
+      {
+        Shard &shard = m_shards[collectorShard()];
+        shard.summary.tick(value);
+        shard.buckets[Histogram::bucket(value)].fetch_add(
+            1, std::memory_order_relaxed);
       }
     };
 
@@ -188,31 +386,62 @@ namespace llarp
     {
     }
 
+    /// add toAdd into record. quantiles cannot be added up, so at most one
+    /// of them may carry any, the one a histogram reported. merge the
+    /// Histograms themselves to combine several.
     static inline void
     combine(Record &record, const Record &toAdd)
     {
+      assert(!(record.quantiles() && toAdd.quantiles()));
       record.id() = toAdd.id();
       record.count() += toAdd.count();
       record.total() += toAdd.total();
       record.min() = std::min(record.min(), toAdd.min());
       record.max() = std::max(record.max(), toAdd.max());
+      if(toAdd.quantiles())
+        record.quantiles() = toAdd.quantiles();
+    }
+
+    static inline void
+    combine(Histogram &histogram, const Histogram &toAdd)
+    {
+      histogram.merge(toAdd);
     }
 
+    static inline const Record &
+    toRecord(const Record &record)
+    {
+      return record;
+    }
+
+    static inline Record
+    toRecord(const Histogram &histogram)
+    {
+      return histogram.record();
+    }
+
+    /// the default collector of an id and those added to it. the set of
+    /// added collectors has a lock of its own so it can be read while the
+    /// repo is not locked, ticking the collectors takes no lock.
     template < typename Collector >
     class Collectors
     {
       using CollectorPtr = std::shared_ptr< Collector >;
       using CollectorSet = std::set< CollectorPtr >;
+      using Loaded = decltype(std::declval< Collector & >().load());
 
       Collector m_default;
-      CollectorSet m_collectors;
+      mutable util::Mutex m_mutex;
+      CollectorSet m_collectors GUARDED_BY(m_mutex);
+      /// everything cleared out of the collectors so far
+      Loaded m_cleared GUARDED_BY(m_mutex);
 
       Collectors(const Collectors &) = delete;
       Collectors &
       operator=(const Collectors &) = delete;
 
      public:
-      Collectors(const Id &id) : m_default(id)
+      Collectors(const Id &id) : m_default(id), m_cleared(id)
       {
       }
 
@@ -223,49 +452,74 @@ namespace llarp
       }
 
       std::shared_ptr< Collector >
-      add()
+      add() LOCKS_EXCLUDED(m_mutex)
       {
         auto ptr = std::make_shared< Collector >(m_default.id());
+        util::Lock l(&m_mutex);
         m_collectors.insert(ptr);
         return ptr;
       }
 
       bool
-      remove(Collector *collector)
+      remove(Collector *collector) LOCKS_EXCLUDED(m_mutex)
       {
         std::shared_ptr< Collector > ptr(collector, [](Collector *) {});
+        util::Lock l(&m_mutex);
         size_t count = m_collectors.erase(ptr);
+        // keep the totals what they were
+        if(count > 0)
+          metrics::combine(m_cleared, collector->load());
         return count > 0;
       }
 
       Record
-      combineAndClear()
+      combineAndClear() LOCKS_EXCLUDED(m_mutex)
       {
-        Record rec = m_default.loadAndClear();
+        auto rec = m_default.loadAndClear();
 
+        util::Lock l(&m_mutex);
         for(auto &ptr : m_collectors)
         {
           metrics::combine(rec, ptr->loadAndClear());
         }
+        metrics::combine(m_cleared, rec);
 
-        return rec;
+        return metrics::toRecord(rec);
       }
 
       Record
-      combine()
+      combine() LOCKS_EXCLUDED(m_mutex)
       {
-        Record rec = m_default.load();
+        auto rec = m_default.load();
 
+        util::Lock l(&m_mutex);
         for(auto &ptr : m_collectors)
         {
           metrics::combine(rec, ptr->load());
         }
-        return rec;
+        return metrics::toRecord(rec);
+      }
+
+      /// everything ticked since the collectors were made, whatever
+      /// combineAndClear took out in between
+      Record
+      combineTotal() LOCKS_EXCLUDED(m_mutex)
+      {
+        auto rec = m_default.load();
+
+        util::Lock l(&m_mutex);
+        for(auto &ptr : m_collectors)
+        {
+          metrics::combine(rec, ptr->load());
+        }
+        metrics::combine(rec, m_cleared);
+        return metrics::toRecord(rec);
       }
 
       std::vector< std::shared_ptr< Collector > >
-      collectors() const
+      collectors() const LOCKS_EXCLUDED(m_mutex)
       {
+        util::Lock l(&m_mutex);
         return std::vector< std::shared_ptr< Collector > >(m_collectors.begin(),
                                                            m_collectors.end());
       }
@@ -279,11 +533,19 @@ namespace llarp
 
     class MetricCollectors
     {
-      using DoubleCollectors = Collectors< DoubleCollector >;
-      using IntCollectors    = Collectors< IntCollector >;
+      using DoubleCollectors    = Collectors< DoubleCollector >;
+      using IntCollectors       = Collectors< IntCollector >;
+      using HistogramCollectors = Collectors< HistogramCollector >;
 
       DoubleCollectors m_doubleCollectors;
       IntCollectors m_intCollectors;
+      /// made on first use, few ids tick a histogram and each collector
+      /// holds tens of kilobytes of buckets
+      util::Mutex m_histogramMutex;
+      std::unique_ptr< HistogramCollectors > m_histogramOwner
+          GUARDED_BY(m_histogramMutex);
+      /// read without the lock by ticks and collects
+      std::atomic< HistogramCollectors * > m_histogramCollectors;
 
       MetricCollectors(const MetricCollectors &) = delete;
       MetricCollectors &
@@ -291,7 +553,9 @@ namespace llarp
 
      public:
       MetricCollectors(const Id &id)
-          : m_doubleCollectors(id), m_intCollectors(id)
+          : m_doubleCollectors(id)
+          , m_intCollectors(id)
+          , m_histogramCollectors(nullptr)
       {
       }
 
@@ -319,11 +583,34 @@ namespace llarp
         return m_intCollectors;
       }
 
+      /// the histogram collectors, making them if this is the first use
+      Collectors< HistogramCollector > &
+      histogramCollectors() LOCKS_EXCLUDED(m_histogramMutex)
+      {
+        util::Lock l(&m_histogramMutex);
+        if(!m_histogramOwner)
+        {
+          m_histogramOwner = std::make_unique< HistogramCollectors >(id());
+          m_histogramCollectors.store(m_histogramOwner.get(),
+                                      std::memory_order_release);
+        }
+        return *m_histogramOwner;
+      }
+
+      /// the histogram collectors, nullptr until first used
+      Collectors< HistogramCollector > *
+      findHistogramCollectors() const
+      {
+        return m_histogramCollectors.load(std::memory_order_acquire);
+      }
+
       Record
       combineAndClear()
       {
         Record res = m_doubleCollectors.combineAndClear();
         metrics::combine(res, m_intCollectors.combineAndClear());
+        if(auto histograms = findHistogramCollectors())
+          metrics::combine(res, histograms->combineAndClear());
         return res;
       }
 
@@ -332,6 +619,20 @@ namespace llarp
       {
         Record res = m_doubleCollectors.combine();
         metrics::combine(res, m_intCollectors.combine());
+        if(auto histograms = findHistogramCollectors())
+          metrics::combine(res, histograms->combine());
+        return res;
+      }
+
+      /// everything ticked since the id's collectors were made, for
+      /// exporters that want totals which only ever grow
+      Record
+      combineTotal()
+      {
+        Record res = m_doubleCollectors.combineTotal();
+        metrics::combine(res, m_intCollectors.combineTotal());
+        if(auto histograms = findHistogramCollectors())
+          metrics::combine(res, histograms->combineTotal());
         return res;
       }
 
@@ -452,6 +753,11 @@ namespace llarp
       CollectorRepo &
       operator=(const CollectorRepo &) = delete;
 
+      /// the collectors of category, which stay put once made so they can be
+      /// read after the lock is let go
+      std::vector< MetricCollectors * >
+      categoryCollectors(const Category *category) const;
+
       MetricCollectors &
       getCollectors(const Id &id);
 
@@ -466,6 +772,12 @@ namespace llarp
       std::vector< Record >
       collect(const Category *category);
 
+      /// like collect, but everything ticked since the collectors were made
+      /// instead of since they were last cleared, so counts and totals never
+      /// go down
+      std::vector< Record >
+      collectTotals(const Category *category);
+
       DoubleCollector *
       defaultDoubleCollector(const char *category, const char *name)
       {
@@ -510,6 +822,28 @@ namespace llarp
         return getCollectors(id).intCollectors().add();
       }
 
+      HistogramCollector *
+      defaultHistogramCollector(const char *category, const char *name)
+      {
+        return defaultHistogramCollector(m_registry->get(category, name));
+      }
+
+      HistogramCollector *
+      defaultHistogramCollector(const Id &id);
+
+      std::shared_ptr< HistogramCollector >
+      addHistogramCollector(const char *category, const char *name)
+      {
+        return addHistogramCollector(m_registry->get(category, name));
+      }
+
+      std::shared_ptr< HistogramCollector >
+      addHistogramCollector(const Id &id)
+      {
+        absl::WriterMutexLock l(&m_mutex);
+        return getCollectors(id).histogramCollectors().add();
+      }
+
       std::pair< std::vector< std::shared_ptr< DoubleCollector > >,
                  std::vector< std::shared_ptr< IntCollector > > >
       allCollectors(const Id &id);
@@ -1161,6 +1495,11 @@ namespace llarp
         Metric< IntCollector, int, &CollectorRepo::defaultIntCollector,
                 &CollectorRepo::defaultIntCollector >;
 
+    using HistogramMetric =
+        Metric< HistogramCollector, double,
+                &CollectorRepo::defaultHistogramCollector,
+                &CollectorRepo::defaultHistogramCollector >;
+
     class TimerGuard
     {
      private:
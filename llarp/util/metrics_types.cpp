@@ -144,6 +144,10 @@ namespace llarp
     const double Record::DEFAULT_MAX =
         std::numeric_limits< double >::max() * -2;
 
+    const Record::Quantiles Record::QUANTILES = {{0.5, 0.9, 0.99, 0.999}};
+    const char *const Record::QUANTILE_NAMES[NUM_QUANTILES] = {"p50", "p90",
+                                                               "p99", "p999"};
+
     std::ostream &
     Record::print(std::ostream &stream, int level, int spaces) const
     {
@@ -153,6 +157,11 @@ namespace llarp
       printer.printAttribute("total", m_total);
       printer.printAttribute("min", m_min);
       printer.printAttribute("max", m_max);
+      if(m_quantiles)
+      {
+        for(size_t idx = 0; idx < NUM_QUANTILES; ++idx)
+          printer.printAttribute(QUANTILE_NAMES[idx], (*m_quantiles)[idx]);
+      }
 
       return stream;
     }
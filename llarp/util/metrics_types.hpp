@@ -7,6 +7,7 @@
 
 #include <absl/types/span.h>
 #include <absl/types/optional.h>
+#include <array>
 #include <set>
 #include <memory>
 #include <cstring>
@@ -370,15 +371,29 @@ namespace llarp
 
     class Record
     {
+     public:
+      enum
+      {
+        NUM_QUANTILES = 4
+      };
+      using Quantiles = std::array< double, NUM_QUANTILES >;
+
+     private:
       Id m_id;
       size_t m_count;
       double m_total;
       double m_min;
       double m_max;
+      absl::optional< Quantiles > m_quantiles;
 
      public:
       static const double DEFAULT_MIN;
       static const double DEFAULT_MAX;
+
+      /// the quantiles a histogram reports, and their published names
+      static const Quantiles QUANTILES;
+      static const char *const QUANTILE_NAMES[NUM_QUANTILES];
+
       Record()
           : m_id()
           , m_count(0)
@@ -417,6 +432,10 @@ namespace llarp
 
       double max() const { return m_max; }
       double& max()      { return m_max; }
+
+      // only set on records from histogram collectors
+      const absl::optional< Quantiles >& quantiles() const { return m_quantiles; }
+      absl::optional< Quantiles >& quantiles()             { return m_quantiles; }
       // clang-format on
 
       std::ostream &
@@ -434,7 +453,7 @@ namespace llarp
     {
       return (lhs.id() == rhs.id() && lhs.count() == rhs.count()
               && lhs.total() == rhs.total() && lhs.min() == rhs.min()
-              && lhs.max() == rhs.max());
+              && lhs.max() == rhs.max() && lhs.quantiles() == rhs.quantiles());
     }
 
     class SampleGroup
@@ -0,0 +1 @@
+#include <util/mpmc_queue.hpp>
@@ -0,0 +1,139 @@
+#ifndef LLARP_UTIL_MPMC_QUEUE_HPP
+#define LLARP_UTIL_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// bounded lock free multi producer multi consumer ring
+    ///
+    /// each slot carries a sequence number telling producers and consumers
+    /// whose turn it is, so a push or pop is one CAS on the head or tail and
+    /// no thread ever waits on another (Vyukov's bounded MPMC queue)
+    template < typename T >
+    class MPMCQueue
+    {
+     public:
+      /// capacity is rounded up to a power of two
+      explicit MPMCQueue(size_t capacity)
+          : m_Mask(RoundUp(capacity) - 1)
+          , m_Slots(new Slot[m_Mask + 1])
+      {
+        m_Head.pos.store(0, std::memory_order_relaxed);
+        m_Tail.pos.store(0, std::memory_order_relaxed);
+        for(size_t idx = 0; idx <= m_Mask; ++idx)
+          m_Slots[idx].seq.store(idx, std::memory_order_relaxed);
+      }
+
+      MPMCQueue(const MPMCQueue&) = delete;
+      MPMCQueue&
+      operator=(const MPMCQueue&) = delete;
+
+      size_t
+      capacity() const
+      {
+        return m_Mask + 1;
+      }
+
+      /// push item, leaves it untouched and returns false if full
+      bool
+      tryPush(T& item)
+      {
+        size_t pos = m_Tail.pos.load(std::memory_order_relaxed);
+        for(;;)
+        {
+          Slot& slot      = m_Slots[pos & m_Mask];
+          const size_t s  = slot.seq.load(std::memory_order_acquire);
+          const auto diff = intptr_t(s) - intptr_t(pos);
+          if(diff == 0)
+          {
+            if(m_Tail.pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+            {
+              slot.item = std::move(item);
+              slot.seq.store(pos + 1, std::memory_order_release);
+              return true;
+            }
+          }
+          else if(diff < 0)
+            return false;
+          else
+            pos = m_Tail.pos.load(std::memory_order_relaxed);
+        }
+      }
+
+      /// pop into item, returns false if empty
+      bool
+      tryPop(T& item)
+      {
+        size_t pos = m_Head.pos.load(std::memory_order_relaxed);
+        for(;;)
+        {
+          Slot& slot      = m_Slots[pos & m_Mask];
+          const size_t s  = slot.seq.load(std::memory_order_acquire);
+          const auto diff = intptr_t(s) - intptr_t(pos + 1);
+          if(diff == 0)
+          {
+            if(m_Head.pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+            {
+              item = std::move(slot.item);
+              slot.seq.store(pos + m_Mask + 1, std::memory_order_release);
+              return true;
+            }
+          }
+          else if(diff < 0)
+            return false;
+          else
+            pos = m_Head.pos.load(std::memory_order_relaxed);
+        }
+      }
+
+      /// approximate, exact only when nobody else is using the queue
+      bool
+      empty() const
+      {
+        return m_Head.pos.load(std::memory_order_relaxed)
+            == m_Tail.pos.load(std::memory_order_relaxed);
+      }
+
+     private:
+      static size_t
+      RoundUp(size_t sz)
+      {
+        size_t cap = 2;
+        while(cap < sz)
+          cap <<= 1;
+        return cap;
+      }
+
+      struct Slot
+      {
+        std::atomic< size_t > seq;
+        T item;
+      };
+
+      const size_t m_Mask;
+      std::unique_ptr< Slot[] > m_Slots;
+      // head and tail on their own cache lines, producers and consumers
+      // should not be bouncing the same line between them
+      struct Index
+      {
+        char pad[64];
+        std::atomic< size_t > pos;
+      };
+
+      Index m_Head;
+      Index m_Tail;
+    };
+  }  // namespace thread
+}  // namespace llarp
+
+#endif
@@ -9,7 +9,8 @@ namespace llarp
 
   void
   OStreamLogStream::PreLog(std::stringstream& ss, LogLevel lvl,
-                           const char* fname, int lineno) const
+                           const char* fname, int lineno, std::thread::id tid,
+                           absl::Time when) const
   {
     switch(lvl)
     {
@@ -33,7 +34,8 @@ namespace llarp
         break;
     }
 
-    ss << "(" << thread_id_string() << ") " << log_timestamp() << " " << fname
+    ss << "(" << thread_id_string(tid) << ") "
+       << log_timestamp("%c %Z", when) << " " << fname
        << ":" << lineno << "\t";
   }
 
@@ -0,0 +1,278 @@
+#include <util/packet_buffer.hpp>
+
+#include <new>
+
+#include <string.h>
+
+namespace llarp
+{
+  constexpr size_t PacketPool::BlockSize;
+  constexpr size_t PacketPool::SmallBlockSize;
+  constexpr size_t PacketPool::BlocksPerSlab;
+  constexpr size_t PacketPool::CacheBatch;
+  constexpr size_t PacketPool::NumPools;
+
+  // a block's bytes follow its header, every header in a slab has to stay
+  // aligned
+  static_assert(sizeof(PacketPool::Block) % alignof(PacketPool::Block) == 0,
+                "block header size");
+  static_assert(PacketPool::BlockSize % alignof(PacketPool::Block) == 0,
+                "block size");
+  static_assert(PacketPool::SmallBlockSize % alignof(PacketPool::Block) == 0,
+                "small block size");
+
+  /// free blocks only the owning thread touches
+  struct PacketPool::LocalCache
+  {
+    PacketPool* pool = nullptr;
+    Block* head      = nullptr;
+    size_t count     = 0;
+
+    ~LocalCache()
+    {
+      // the thread is exiting, hand everything back
+      if(count)
+        pool->Drain(*this, count);
+    }
+  };
+
+  PacketPool::PacketPool(size_t blockSize, size_t index)
+      : m_BlockSize(blockSize), m_Index(index)
+  {
+  }
+
+  const std::array< PacketPool*, PacketPool::NumPools >&
+  PacketPool::Pools()
+  {
+    // never destroyed so buffers held by other statics stay valid at exit
+    static const std::array< PacketPool*, NumPools > pools = {
+        {new PacketPool(SmallBlockSize, 0), new PacketPool(BlockSize, 1)}};
+    return pools;
+  }
+
+  PacketPool&
+  PacketPool::Instance()
+  {
+    return *Pools().back();
+  }
+
+  PacketPool*
+  PacketPool::ForSize(size_t sz)
+  {
+    for(PacketPool* pool : Pools())
+    {
+      if(sz <= pool->BlockBytes())
+        return pool;
+    }
+    return nullptr;
+  }
+
+  PacketPool::LocalCache&
+  PacketPool::Local() const
+  {
+    static thread_local std::array< LocalCache, NumPools > caches;
+    LocalCache& cache = caches[m_Index];
+    cache.pool        = const_cast< PacketPool* >(this);
+    return cache;
+  }
+
+  void
+  PacketPool::Refill(LocalCache& cache)
+  {
+    util::Lock lock(&m_Mutex);
+    if(m_Free == nullptr)
+    {
+      // carve a new slab
+      const size_t stride = sizeof(Block) + m_BlockSize;
+      m_Slabs.emplace_back(new byte_t[stride * BlocksPerSlab]);
+      byte_t* slab = m_Slabs.back().get();
+      for(size_t idx = 0; idx < BlocksPerSlab; ++idx)
+      {
+        Block* block = new(slab + idx * stride) Block();
+        block->pool  = this;
+        block->next  = m_Free;
+        m_Free       = block;
+      }
+      m_NumFree += BlocksPerSlab;
+    }
+    while(m_Free && cache.count < CacheBatch)
+    {
+      Block* block = m_Free;
+      m_Free       = block->next;
+      block->next  = cache.head;
+      cache.head   = block;
+      ++cache.count;
+      --m_NumFree;
+    }
+  }
+
+  void
+  PacketPool::Drain(LocalCache& cache, size_t n)
+  {
+    // unlink the batch before locking
+    Block* first = cache.head;
+    Block* last  = first;
+    for(size_t idx = 1; idx < n; ++idx)
+      last = last->next;
+    cache.head = last->next;
+    cache.count -= n;
+    util::Lock lock(&m_Mutex);
+    last->next = m_Free;
+    m_Free     = first;
+    m_NumFree += n;
+  }
+
+  PacketPool::Block*
+  PacketPool::Get()
+  {
+    LocalCache& cache = Local();
+    if(cache.head == nullptr)
+      Refill(cache);
+    Block* block = cache.head;
+    cache.head   = block->next;
+    --cache.count;
+    block->next = nullptr;
+    block->refs.store(1);
+    return block;
+  }
+
+  void
+  PacketPool::Put(Block* block)
+  {
+    LocalCache& cache = Local();
+    block->next       = cache.head;
+    cache.head        = block;
+    if(++cache.count >= 2 * CacheBatch)
+      Drain(cache, CacheBatch);
+  }
+
+  size_t
+  PacketPool::Allocated() const
+  {
+    util::Lock lock(&m_Mutex);
+    return m_Slabs.size() * BlocksPerSlab;
+  }
+
+  size_t
+  PacketPool::Available() const
+  {
+    const size_t cached = Local().count;
+    util::Lock lock(&m_Mutex);
+    return m_NumFree + cached;
+  }
+
+  PacketBuffer::PacketBuffer(PacketPool::Block* block, byte_t* data, size_t sz)
+      : m_Block(block), m_Data(data), m_Size(sz)
+  {
+  }
+
+  PacketBuffer::PacketBuffer(const PacketBuffer& other)
+      : m_Block(other.m_Block), m_Data(other.m_Data), m_Size(other.m_Size)
+  {
+    if(m_Block)
+      m_Block->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  PacketBuffer::PacketBuffer(PacketBuffer&& other)
+      : m_Block(other.m_Block), m_Data(other.m_Data), m_Size(other.m_Size)
+  {
+    other.m_Block = nullptr;
+    other.m_Data  = nullptr;
+    other.m_Size  = 0;
+  }
+
+  PacketBuffer::~PacketBuffer()
+  {
+    Clear();
+  }
+
+  PacketBuffer&
+  PacketBuffer::operator=(const PacketBuffer& other)
+  {
+    if(this != &other)
+    {
+      PacketBuffer copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  PacketBuffer&
+  PacketBuffer::operator=(PacketBuffer&& other)
+  {
+    if(this != &other)
+    {
+      Clear();
+      m_Block       = other.m_Block;
+      m_Data        = other.m_Data;
+      m_Size        = other.m_Size;
+      other.m_Block = nullptr;
+      other.m_Data  = nullptr;
+      other.m_Size  = 0;
+    }
+    return *this;
+  }
+
+  PacketBuffer
+  PacketBuffer::Alloc(size_t sz)
+  {
+    PacketPool* pool = PacketPool::ForSize(sz);
+    if(pool == nullptr)
+      return {};
+    PacketPool::Block* block = pool->Get();
+    return PacketBuffer(block, block->data(), sz);
+  }
+
+  PacketBuffer
+  PacketBuffer::Copy(const llarp_buffer_t& buf)
+  {
+    PacketBuffer pkt = Alloc(buf.sz);
+    if(!pkt.IsEmpty() && buf.sz)
+      memcpy(pkt.data(), buf.base, buf.sz);
+    return pkt;
+  }
+
+  PacketBuffer
+  PacketBuffer::SliceOrCopy(const llarp_buffer_t& buf) const
+  {
+    if(m_Block)
+    {
+      const byte_t* begin = m_Block->data();
+      const byte_t* end   = begin + m_Block->size();
+      if(buf.base >= begin && buf.base + buf.sz <= end)
+      {
+        m_Block->refs.fetch_add(1, std::memory_order_relaxed);
+        return PacketBuffer(m_Block, buf.base, buf.sz);
+      }
+    }
+    return Copy(buf);
+  }
+
+  void
+  PacketBuffer::Clear()
+  {
+    if(m_Block
+       && m_Block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      m_Block->pool->Put(m_Block);
+    m_Block = nullptr;
+    m_Data  = nullptr;
+    m_Size  = 0;
+  }
+
+  bool
+  PacketBuffer::Resize(size_t sz)
+  {
+    if(sz > Capacity())
+      return false;
+    m_Size = sz;
+    return true;
+  }
+
+  size_t
+  PacketBuffer::Capacity() const
+  {
+    if(m_Block == nullptr)
+      return 0;
+    return m_Block->size() - (m_Data - m_Block->data());
+  }
+}  // namespace llarp
@@ -0,0 +1,213 @@
+#ifndef LLARP_PACKET_BUFFER_HPP
+#define LLARP_PACKET_BUFFER_HPP
+
+#include <constants/link_layer.hpp>
+#include <util/bencode.h>
+#include <util/buffer.hpp>
+#include <util/threading.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace llarp
+{
+  /// pool of fixed size blocks
+  ///
+  /// blocks are carved out of slabs that are never freed and recycled through
+  /// a free list, so once warmed up the relay path does not touch the heap.
+  /// each thread keeps a cache of free blocks and only takes the lock to
+  /// move a batch of them to or from the shared free list.
+  ///
+  /// there is one pool per size class. Instance() has blocks big enough for
+  /// any link layer message, small ones such as ip packets come out of a
+  /// pool of SmallBlockSize blocks instead of pinning a whole one.
+  class PacketPool
+  {
+   public:
+    /// the biggest block, enough for any link layer message
+    static constexpr size_t BlockSize = MAX_LINK_MSG_SIZE;
+    /// the small size class, enough for an ip packet at the usual mtus
+    static constexpr size_t SmallBlockSize = 2048;
+    static constexpr size_t BlocksPerSlab  = 32;
+    /// blocks moved between a thread's cache and the shared free list at a
+    /// time, a cache holds at most twice this
+    static constexpr size_t CacheBatch = 32;
+
+    /// header of a block, its bytes follow it in the slab
+    struct Block
+    {
+      std::atomic< size_t > refs;
+      Block* next;
+      PacketPool* pool;
+
+      byte_t*
+      data()
+      {
+        return reinterpret_cast< byte_t* >(this + 1);
+      }
+
+      size_t
+      size() const
+      {
+        return pool->m_BlockSize;
+      }
+    };
+
+    /// the pool of BlockSize blocks
+    static PacketPool&
+    Instance();
+
+    /// the pool with the smallest blocks that hold sz bytes, null if sz is
+    /// bigger than BlockSize
+    static PacketPool*
+    ForSize(size_t sz);
+
+    /// get a block with a refcount of 1
+    Block*
+    Get() LOCKS_EXCLUDED(m_Mutex);
+
+    /// give a block with no more references back to the free list
+    void
+    Put(Block* block) LOCKS_EXCLUDED(m_Mutex);
+
+    /// bytes in each of our blocks
+    size_t
+    BlockBytes() const
+    {
+      return m_BlockSize;
+    }
+
+    /// number of blocks we have carved out of slabs
+    size_t
+    Allocated() const LOCKS_EXCLUDED(m_Mutex);
+
+    /// number of blocks sitting in the shared free list and the calling
+    /// thread's cache
+    size_t
+    Available() const LOCKS_EXCLUDED(m_Mutex);
+
+   private:
+    struct LocalCache;
+
+    /// how many size classes there are
+    static constexpr size_t NumPools = 2;
+
+    PacketPool(size_t blockSize, size_t index);
+
+    /// every size class, smallest first
+    static const std::array< PacketPool*, NumPools >&
+    Pools();
+
+    /// the calling thread's cache of our blocks
+    LocalCache&
+    Local() const;
+
+    /// move up to CacheBatch blocks from the shared free list to cache
+    void
+    Refill(LocalCache& cache) LOCKS_EXCLUDED(m_Mutex);
+
+    /// move the first n blocks of cache to the shared free list
+    void
+    Drain(LocalCache& cache, size_t n) LOCKS_EXCLUDED(m_Mutex);
+
+    const size_t m_BlockSize;
+    /// which of a thread's caches is ours
+    const size_t m_Index;
+    mutable util::Mutex m_Mutex;
+    std::vector< std::unique_ptr< byte_t[] > > m_Slabs GUARDED_BY(m_Mutex);
+    Block* m_Free GUARDED_BY(m_Mutex) = nullptr;
+    size_t m_NumFree GUARDED_BY(m_Mutex) = 0;
+  };
+
+  /// refcounted view of a range of bytes inside a pooled block
+  ///
+  /// copies share the block instead of the bytes, so a message can go from
+  /// the link layer through onion crypto and back out without being copied
+  struct PacketBuffer
+  {
+    PacketBuffer() = default;
+
+    PacketBuffer(const PacketBuffer& other);
+
+    PacketBuffer(PacketBuffer&& other);
+
+    ~PacketBuffer();
+
+    PacketBuffer&
+    operator=(const PacketBuffer& other);
+
+    PacketBuffer&
+    operator=(PacketBuffer&& other);
+
+    /// get a block from the smallest size class that holds sz bytes and
+    /// view the first sz bytes of it, the contents are not initialized
+    static PacketBuffer
+    Alloc(size_t sz = PacketPool::BlockSize);
+
+    /// get a new block holding a copy of buf
+    /// returns an empty buffer if buf is too big
+    static PacketBuffer
+    Copy(const llarp_buffer_t& buf);
+
+    /// view buf without copying it if it lies inside our block, otherwise
+    /// fall back to a copy
+    PacketBuffer
+    SliceOrCopy(const llarp_buffer_t& buf) const;
+
+    /// drop our reference to the block
+    void
+    Clear();
+
+    /// change how many bytes we view, fails if it would run off the end of
+    /// the block
+    bool
+    Resize(size_t sz);
+
+    /// how many bytes we could view from where we start
+    size_t
+    Capacity() const;
+
+    bool
+    IsEmpty() const
+    {
+      return m_Block == nullptr;
+    }
+
+    size_t
+    size() const
+    {
+      return m_Size;
+    }
+
+    /// only a non const buffer hands out its bytes for writing, onion
+    /// crypto transforms them in place
+    byte_t*
+    data()
+    {
+      return m_Data;
+    }
+
+    const byte_t*
+    data() const
+    {
+      return m_Data;
+    }
+
+    bool
+    BEncode(llarp_buffer_t* buf) const
+    {
+      return bencode_write_bytestring(buf, m_Data, m_Size);
+    }
+
+   private:
+    PacketBuffer(PacketPool::Block* block, byte_t* data, size_t sz);
+
+    PacketPool::Block* m_Block = nullptr;
+    byte_t* m_Data             = nullptr;
+    size_t m_Size              = 0;
+  };
+}  // namespace llarp
+
+#endif
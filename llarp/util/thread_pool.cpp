@@ -4,6 +4,19 @@ namespace llarp
 {
   namespace thread
   {
+    namespace
+    {
+      // The pool the current thread works for and its queue, so jobs added
+      // from inside a job stay on the same worker.
+      struct WorkerId
+      {
+        const ThreadPool* pool;
+        size_t index;
+      };
+
+      thread_local WorkerId currentWorker = {nullptr, 0};
+    }  // namespace
+
     void
     ThreadPool::join()
     {
@@ -19,21 +32,23 @@ namespace llarp
     }
 
     void
-    ThreadPool::runJobs()
+    ThreadPool::runJobs(size_t self)
     {
       while(m_status.load(std::memory_order_relaxed) == Status::Run)
       {
-        auto functor = m_queue.tryPopFront();
+        Job job;
 
-        if(functor.has_value())
+        if(pop(job, self))
         {
-          functor.value()();
+          job();
         }
         else
         {
+          // Pairs with `push`: either we see the new job count, or the
+          // producer sees us idle and posts the semaphore.
           m_idleThreads++;
 
-          if(m_status == Status::Run && m_queue.empty())
+          if(m_status == Status::Run && m_jobCount.load() == 0)
           {
             m_semaphore.wait();
           }
@@ -44,18 +59,97 @@ namespace llarp
     }
 
     void
-    ThreadPool::drainQueue()
+    ThreadPool::drainQueue(size_t self)
     {
       while(m_status.load(std::memory_order_relaxed) == Status::Drain)
       {
-        auto functor = m_queue.tryPopFront();
+        Job job;
 
-        if(!functor)
+        if(!pop(job, self))
         {
           return;
         }
 
-        functor.value()();
+        job();
+      }
+    }
+
+    bool
+    ThreadPool::reserve()
+    {
+      size_t count = m_jobCount.load();
+
+      do
+      {
+        if(count >= m_capacity)
+        {
+          return false;
+        }
+      } while(!m_jobCount.compare_exchange_weak(count, count + 1));
+
+      return true;
+    }
+
+    void
+    ThreadPool::push(Job&& job)
+    {
+      size_t index;
+
+      if(currentWorker.pool == this)
+      {
+        index = currentWorker.index;
+      }
+      else
+      {
+        index = m_nextQueue.fetch_add(1, std::memory_order_relaxed)
+            % m_queues.size();
+      }
+
+      // Every queue can hold `capacity()` jobs and we hold a reservation, so
+      // this only spins while a consumer is still moving out of the slot.
+      while(!m_queues[index]->tryPush(job))
+      {
+        std::this_thread::yield();
+      }
+
+      if(m_idleThreads.load() > 0)
+      {
+        m_semaphore.notify();
+      }
+    }
+
+    bool
+    ThreadPool::pop(Job& job, size_t self)
+    {
+      const size_t num = m_queues.size();
+
+      for(size_t i = 0; i < num; ++i)
+      {
+        if(m_queues[(self + i) % num]->tryPop(job))
+        {
+          m_jobCount.fetch_sub(1);
+
+          if(m_spaceWaiters.load() > 0)
+          {
+            util::Lock lock(&m_spaceMutex);
+            m_space.Signal();
+          }
+
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    void
+    ThreadPool::removeAll()
+    {
+      Job job;
+
+      while(pop(job, 0))
+      {
+        job.Reset();
       }
     }
 
@@ -88,8 +182,10 @@ namespace llarp
     }
 
     void
-    ThreadPool::worker()
+    ThreadPool::worker(size_t self)
     {
+      currentWorker = {this, self};
+
       // Lock will be valid until the end of the statement
       size_t gateCount = (absl::ReaderMutexLock(&m_gateMutex), m_gateCount);
 
@@ -116,13 +212,13 @@ namespace llarp
 
         if(status == Status::Run)
         {
-          runJobs();
+          runJobs(self);
           status = m_status;
         }
 
         if(status == Status::Drain)
         {
-          drainQueue();
+          drainQueue(self);
         }
         else if(status == Status::Suspend)
         {
@@ -142,7 +238,7 @@ namespace llarp
       try
       {
         m_threads.at(m_createdThreads) =
-            std::thread(std::bind(&ThreadPool::worker, this));
+            std::thread(&ThreadPool::worker, this, m_createdThreads);
         ++m_createdThreads;
         return true;
       }
@@ -153,8 +249,13 @@ namespace llarp
     }
 
     ThreadPool::ThreadPool(size_t numThreads, size_t maxJobs)
-        : m_queue(maxJobs)
+        : m_queues(numThreads)
         , m_semaphore(0)
+        , m_capacity(maxJobs)
+        , m_jobCount(0)
+        , m_nextQueue(0)
+        , m_enabled(false)
+        , m_spaceWaiters(0)
         , m_idleThreads(0)
         , m_status(Status::Stop)
         , m_gateCount(0)
@@ -164,7 +265,11 @@ namespace llarp
     {
       assert(numThreads != 0);
       assert(maxJobs != 0);
-      disable();
+
+      for(auto& queue : m_queues)
+      {
+        queue = std::make_unique< JobQueue >(maxJobs);
+      }
     }
 
     ThreadPool::~ThreadPool()
@@ -172,60 +277,74 @@ namespace llarp
       shutdown();
     }
 
-    bool
-    ThreadPool::addJob(const Job& job)
+    void
+    ThreadPool::disable()
     {
-      assert(job);
-
-      QueueReturn ret = m_queue.pushBack(job);
+      m_enabled.store(false);
 
-      if(ret == QueueReturn::Success && m_idleThreads > 0)
-      {
-        m_semaphore.notify();
-      }
+      // Wake anyone blocked in `addJob` so they can fail.
+      util::Lock lock(&m_spaceMutex);
+      m_space.SignalAll();
+    }
 
-      return ret == QueueReturn::Success;
+    bool
+    ThreadPool::addJob(const Job& job)
+    {
+      return addJob(Job(job));
     }
+
     bool
     ThreadPool::addJob(Job&& job)
     {
       assert(job);
-      QueueReturn ret = m_queue.pushBack(std::move(job));
 
-      if(ret == QueueReturn::Success && m_idleThreads > 0)
+      if(!enabled())
       {
-        m_semaphore.notify();
+        return false;
       }
 
-      return ret == QueueReturn::Success;
+      if(!reserve())
+      {
+        util::Lock lock(&m_spaceMutex);
+        bool reserved = false;
+
+        ++m_spaceWaiters;
+
+        while(enabled() && !(reserved = reserve()))
+        {
+          m_space.Wait(&m_spaceMutex);
+        }
+
+        --m_spaceWaiters;
+
+        if(!reserved)
+        {
+          return false;
+        }
+      }
+
+      push(std::move(job));
+      return true;
     }
 
     bool
     ThreadPool::tryAddJob(const Job& job)
     {
-      assert(job);
-      QueueReturn ret = m_queue.tryPushBack(job);
-
-      if(ret == QueueReturn::Success && m_idleThreads > 0)
-      {
-        m_semaphore.notify();
-      }
-
-      return ret == QueueReturn::Success;
+      return tryAddJob(Job(job));
     }
 
     bool
     ThreadPool::tryAddJob(Job&& job)
     {
       assert(job);
-      QueueReturn ret = m_queue.tryPushBack(std::move(job));
 
-      if(ret == QueueReturn::Success && m_idleThreads > 0)
+      if(!enabled() || !reserve())
       {
-        m_semaphore.notify();
+        return false;
       }
 
-      return ret == QueueReturn::Success;
+      push(std::move(job));
+      return true;
     }
 
     void
@@ -253,11 +372,11 @@ namespace llarp
 
       if(m_status.load(std::memory_order_relaxed) == Status::Run)
       {
-        m_queue.disable();
+        disable();
         m_status = Status::Stop;
 
         interrupt();
-        m_queue.removeAll();
+        removeAll();
 
         join();
       }
@@ -288,7 +407,7 @@ namespace llarp
 
       waitThreads();
 
-      m_queue.enable();
+      enable();
       m_status = Status::Run;
 
       // `releaseThreads` has a release barrier so workers don't return from
@@ -306,7 +425,7 @@ namespace llarp
 
       if(m_status.load(std::memory_order_relaxed) == Status::Run)
       {
-        m_queue.disable();
+        disable();
         m_status = Status::Drain;
 
         // `interrupt` has an acquire barrier (locks a mutex), so nothing will
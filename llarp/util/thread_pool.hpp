@@ -1,11 +1,12 @@
 #ifndef LLARP_THREAD_POOL_HPP
 #define LLARP_THREAD_POOL_HPP
 
-#include <util/queue.hpp>
+#include <util/job.hpp>
+#include <util/mpmc_queue.hpp>
 #include <util/threading.hpp>
 
 #include <atomic>
-#include <functional>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -19,9 +20,15 @@ namespace llarp
       // of the threadpool are fixed at construction time:
       // - the max number of pending jobs
       // - the number of threads
+      //
+      // Each worker owns a lock free queue. Jobs added from a worker go on
+      // that worker's queue, jobs added from anywhere else are dealt round
+      // robin, and a worker whose queue is empty steals from the others
+      // before going to sleep. Jobs are stored with inline storage so adding
+      // one does not allocate.
      public:
-      using Job      = std::function< void() >;
-      using JobQueue = Queue< Job >;
+      using Job      = thread::Job;
+      using JobQueue = MPMCQueue< Job >;
 
       enum class Status
       {
@@ -32,8 +39,18 @@ namespace llarp
       };
 
      private:
-      JobQueue m_queue;             // The job queue
-      util::Semaphore m_semaphore;  // The semaphore for the queue.
+      std::vector< std::unique_ptr< JobQueue > > m_queues;  // Per worker
+      util::Semaphore m_semaphore;  // The semaphore for the queues.
+
+      const size_t m_capacity;
+      std::atomic_size_t m_jobCount;   // Queued jobs, including reserved slots
+      std::atomic_size_t m_nextQueue;  // Round robin for outside producers
+      std::atomic_bool m_enabled;
+
+      // Blocking `addJob` waits here for a free slot.
+      util::Mutex m_spaceMutex;
+      util::Condition m_space;
+      std::atomic_size_t m_spaceWaiters;
 
       std::atomic_size_t m_idleThreads;  // Number of idle threads
 
@@ -54,10 +71,25 @@ namespace llarp
       join();
 
       void
-      runJobs();
+      runJobs(size_t self);
+
+      void
+      drainQueue(size_t self);
+
+      // Claim one of the `capacity()` slots, fails if the pool is full.
+      bool
+      reserve();
+
+      // Push a job into a reserved slot.
+      void
+      push(Job&& job);
+
+      // Pop a job, trying queue `self` first then stealing from the others.
+      bool
+      pop(Job& job, size_t self);
 
       void
-      drainQueue();
+      removeAll();
 
       void
       waitThreads();
@@ -69,7 +101,7 @@ namespace llarp
       interrupt();
 
       void
-      worker();
+      worker(size_t self);
 
       bool
       spawn();
@@ -155,22 +187,16 @@ namespace llarp
       capacity() const;
     };
 
-    inline void
-    ThreadPool::disable()
-    {
-      m_queue.disable();
-    }
-
     inline void
     ThreadPool::enable()
     {
-      m_queue.enable();
+      m_enabled.store(true);
     }
 
     inline bool
     ThreadPool::enabled() const
     {
-      return m_queue.enabled();
+      return m_enabled.load();
     }
 
     inline size_t
@@ -201,13 +227,13 @@ namespace llarp
     inline size_t
     ThreadPool::jobCount() const
     {
-      return m_queue.size();
+      return m_jobCount.load(std::memory_order_relaxed);
     }
 
     inline size_t
     ThreadPool::capacity() const
     {
-      return m_queue.capacity();
+      return m_capacity;
     }
   }  // namespace thread
 }  // namespace llarp
@@ -57,14 +57,8 @@ void
 llarp_threadpool_queue_job(struct llarp_threadpool *pool,
                            struct llarp_thread_job job)
 {
-  if(pool->impl)
-    pool->impl->addJob(std::bind(job.work, job.user));
-  else
-  {
-    // single threaded mode
-    llarp::util::Lock lock(&pool->m_access);
-    pool->jobs.emplace(std::bind(job.work, job.user));
-  }
+  // two pointers, fits in the job without allocating
+  pool->QueueFunc([job]() { job.work(job.user); });
 }
 
 void
@@ -72,7 +66,7 @@ llarp_threadpool_tick(struct llarp_threadpool *pool)
 {
   while(pool->size())
   {
-    std::function< void(void) > job;
+    llarp::thread::Job job;
     {
       llarp::util::Lock lock(&pool->m_access);
       job = std::move(pool->jobs.front());
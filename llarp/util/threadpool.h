@@ -7,13 +7,14 @@
 #include <absl/base/thread_annotations.h>
 #include <memory>
 #include <queue>
+#include <utility>
 
 struct llarp_threadpool
 {
   std::unique_ptr< llarp::thread::ThreadPool > impl;
 
   mutable llarp::util::Mutex m_access;  // protects jobs
-  std::queue< std::function< void(void) > > jobs GUARDED_BY(m_access);
+  std::queue< llarp::thread::Job > jobs GUARDED_BY(m_access);
 
   llarp_threadpool(int workers, const char *name)
       : impl(std::make_unique< llarp::thread::ThreadPool >(workers,
@@ -33,15 +34,17 @@ struct llarp_threadpool
     return jobs.size();
   }
 
+  /// queue any void() callable, small ones are stored without allocating
+  template < typename F >
   void
-  QueueFunc(std::function< void(void) > f) LOCKS_EXCLUDED(m_access)
+  QueueFunc(F &&f) LOCKS_EXCLUDED(m_access)
   {
     if(impl)
-      impl->addJob(f);
+      impl->addJob(std::forward< F >(f));
     else
     {
       llarp::util::Lock lock(&m_access);
-      jobs.emplace(f);
+      jobs.emplace(std::forward< F >(f));
     }
   }
 };
@@ -5,6 +5,8 @@
 #include <util/threading.hpp>
 #include <util/threadpool.h>
 
+#include <functional>
+
 namespace llarp
 {
   namespace thread
@@ -0,0 +1 @@
+#include <util/timing_wheel.hpp>
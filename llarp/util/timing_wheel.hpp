@@ -0,0 +1,158 @@
+#ifndef LLARP_UTIL_TIMING_WHEEL_HPP
+#define LLARP_UTIL_TIMING_WHEEL_HPP
+
+#include <util/time.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// hierarchical timing wheel (varghese & lauck), holds items until a
+    /// given time and hands them back once it has passed
+    ///
+    /// time is cut into ticks of resolution ms. level 0 has a slot per tick
+    /// for the next 2^Bits ticks, each level above has a slot per revolution
+    /// of the one below, and items further out than all of them wait in an
+    /// overflow list. whenever a level wraps the next slot up is spread over
+    /// the levels below, so each item is moved at most Levels times and
+    /// advancing costs the slots passed plus the items due, never the items
+    /// still waiting. not thread safe.
+    template < typename T, size_t Bits = 8, size_t Levels = 3 >
+    class TimingWheel
+    {
+      static_assert(Bits > 0 && Levels > 0 && Bits * Levels < 64,
+                    "wheel does not fit in a tick counter");
+
+     public:
+      static constexpr size_t Slots = size_t(1) << Bits;
+
+      TimingWheel(llarp_time_t resolution, llarp_time_t now)
+          : m_Resolution(resolution ? resolution : 1)
+          , m_Tick(now / m_Resolution)
+      {
+      }
+
+      size_t
+      Size() const
+      {
+        return m_Size;
+      }
+
+      llarp_time_t
+      Resolution() const
+      {
+        return m_Resolution;
+      }
+
+      /// hold item until at, it comes back from the first Advance to a time
+      /// at or past at, up to one resolution late but never early
+      void
+      Add(llarp_time_t at, T item)
+      {
+        // round up so items are never early
+        uint64_t tick = (at + m_Resolution - 1) / m_Resolution;
+        // anything already due goes out on the next tick
+        if(tick <= m_Tick)
+          tick = m_Tick + 1;
+        Place(Entry{tick, std::move(item)});
+        ++m_Size;
+      }
+
+      /// move time forward to now, calling visit(T&&) for every item that
+      /// came due, in the order of the ticks they were due on
+      template < typename Visit >
+      void
+      Advance(llarp_time_t now, Visit visit)
+      {
+        const uint64_t target = now / m_Resolution;
+        while(m_Tick < target)
+        {
+          if(m_Size == 0)
+          {
+            // nothing to hand out, skip the empty slots
+            m_Tick = target;
+            return;
+          }
+          ++m_Tick;
+          Cascade();
+          auto& slot = m_Wheels[0][m_Tick & Mask];
+          if(slot.empty())
+            continue;
+          std::vector< Entry > due;
+          due.swap(slot);
+          m_Size -= due.size();
+          for(auto& entry : due)
+            visit(std::move(entry.item));
+        }
+      }
+
+     private:
+      static constexpr uint64_t Mask = Slots - 1;
+
+      struct Entry
+      {
+        uint64_t tick;
+        T item;
+      };
+
+      /// put entry on the lowest level whose revolution it falls in
+      void
+      Place(Entry entry)
+      {
+        for(size_t level = 0; level < Levels; ++level)
+        {
+          const size_t shift = Bits * (level + 1);
+          if((entry.tick >> shift) == (m_Tick >> shift))
+          {
+            const size_t slot = (entry.tick >> (Bits * level)) & Mask;
+            m_Wheels[level][slot].emplace_back(std::move(entry));
+            return;
+          }
+        }
+        m_Overflow.emplace_back(std::move(entry));
+      }
+
+      /// spread the slots of every level the current tick wraps onto the
+      /// levels below, top down so nothing skips a level
+      void
+      Cascade()
+      {
+        size_t wrapped = 0;
+        while(wrapped < Levels
+              && ((m_Tick >> (Bits * wrapped)) & Mask) == 0)
+          ++wrapped;
+        if(wrapped == Levels)
+          Respread(m_Overflow);
+        for(size_t level = std::min(wrapped, Levels - 1); level > 0; --level)
+          Respread(m_Wheels[level][(m_Tick >> (Bits * level)) & Mask]);
+      }
+
+      void
+      Respread(std::vector< Entry >& slot)
+      {
+        if(slot.empty())
+          return;
+        std::vector< Entry > moving;
+        moving.swap(slot);
+        for(auto& entry : moving)
+          Place(std::move(entry));
+      }
+
+      llarp_time_t m_Resolution;
+      uint64_t m_Tick;
+      size_t m_Size = 0;
+      std::array< std::array< std::vector< Entry >, Slots >, Levels >
+          m_Wheels;
+      std::vector< Entry > m_Overflow;
+    };
+  }  // namespace util
+}  // namespace llarp
+
+#endif
@@ -25,7 +25,8 @@ namespace llarp
 
   void
   Win32LogStream::PreLog(std::stringstream& ss, LogLevel lvl, const char* fname,
-                         int lineno) const
+                         int lineno, std::thread::id tid,
+                         absl::Time when) const
   {
     if(!isConsoleModern)
     {
@@ -60,11 +61,12 @@ namespace llarp
           ss << "[ERR] ";
           break;
       }
-      ss << "(" << thread_id_string() << ") " << log_timestamp() << " " << fname
+      ss << "(" << thread_id_string(tid) << ") "
+         << log_timestamp("%c %Z", when) << " " << fname
          << ":" << lineno << "\t";
     }
     else
-      OStreamLogStream::PreLog(ss, lvl, fname, lineno);
+      OStreamLogStream::PreLog(ss, lvl, fname, lineno, tid, when);
   }
 
   void
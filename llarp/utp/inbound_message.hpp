@@ -3,6 +3,7 @@
 
 #include <constants/link_layer.hpp>
 #include <util/aligned.hpp>
+#include <util/packet_buffer.hpp>
 #include <util/types.hpp>
 
 #include <utp_types.h>  // for uint32
@@ -42,31 +43,38 @@ namespace llarp
     /// maximum size for send queue for a session before we drop
     constexpr size_t MaxSendQueueSize = 64;
 
-    /// buffer for a link layer message
-    using MessageBuffer = AlignedBuffer< MAX_LINK_MSG_SIZE >;
-
     /// pending inbound message being received
     struct InboundMessage
     {
       /// timestamp of last activity
       llarp_time_t lastActive;
-      /// the underlying message buffer
-      MessageBuffer _msg;
+      /// the underlying message buffer, from the packet pool
+      PacketBuffer msg;
 
       /// for accessing message buffer
       llarp_buffer_t buffer;
 
-      InboundMessage() : lastActive(0), _msg(), buffer(_msg)
+      InboundMessage()
+          : lastActive(0)
+          , msg(PacketBuffer::Alloc(MAX_LINK_MSG_SIZE))
+          , buffer(msg)
       {
       }
 
-      InboundMessage(const InboundMessage& other)
-          : lastActive(other.lastActive), _msg(other._msg), buffer(_msg)
+      InboundMessage(InboundMessage&& other)
+          : lastActive(other.lastActive)
+          , msg(std::move(other.msg))
+          , buffer(msg)
       {
-        buffer.cur = buffer.base + (other.buffer.cur - other.buffer.base);
+        buffer.cur = other.buffer.cur;
         buffer.sz  = other.buffer.sz;
       }
 
+      InboundMessage(const InboundMessage&) = delete;
+
+      InboundMessage&
+      operator=(const InboundMessage&) = delete;
+
       /// return true if this inbound message can be removed due to expiration
       bool
       IsExpired(llarp_time_t now) const;
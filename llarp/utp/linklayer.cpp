@@ -2,6 +2,8 @@
 
 #include <utp/session.hpp>
 
+#include <ev/ev.hpp>
+
 #ifdef __linux__
 #include <linux/errqueue.h>
 #include <netinet/ip_icmp.h>
@@ -65,6 +67,32 @@ namespace llarp
         setsockopt(l->m_udp.fd, IPPROTO_IP, IP_DONTFRAGMENT, &val, sizeof(val));
       }
 #else
+      if(l->m_Loop->udp_batch_size > 1)
+      {
+        // when batching, regular datagrams are queued on the event loop and
+        // go out with sendmmsg at the end of the tick. the socket stays at
+        // IP_PMTUDISC_DONT so only mtu probes pay for the setsockopt calls
+        if(arg->flags != 2)
+        {
+          llarp_ev_udp_sendto(&l->m_udp, arg->address,
+                              llarp_buffer_t(arg->buf, arg->len));
+          return 0;
+        }
+        // the probe goes out directly, what is queued has to go first
+        llarp_ev_udp_flush(&l->m_udp);
+        int val = IP_PMTUDISC_DO;
+        setsockopt(l->m_udp.fd, IPPROTO_IP, IP_MTU_DISCOVER, &val, sizeof(val));
+        if(::sendto(l->m_udp.fd, (char*)arg->buf, arg->len, 0, arg->address,
+                    arg->address_len)
+               == -1
+           && errno)
+        {
+          LogError("sendto failed: ", strerror(errno));
+        }
+        val = IP_PMTUDISC_DONT;
+        setsockopt(l->m_udp.fd, IPPROTO_IP, IP_MTU_DISCOVER, &val, sizeof(val));
+        return 0;
+      }
       if(arg->flags == 2)
       {
         int val = IP_PMTUDISC_DO;
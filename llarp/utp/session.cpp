@@ -112,12 +112,21 @@ namespace llarp
         LogError("key exchange with ", other, " failed");
         return false;
       }
+      if(&K == &rxKey)
+        ++m_RXKeyGen;
       LogDebug("keys mixed with session to ", remoteAddr);
       return true;
     }
 
     bool
     Session::MutateKey(SharedSecret& K, const AlignedBuffer< 24 >& A)
+    {
+      return MutateKey(OurCrypto(), K, A);
+    }
+
+    bool
+    Session::MutateKey(Crypto* crypto, SharedSecret& K,
+                       const AlignedBuffer< 24 >& A)
     {
       AlignedBuffer< 56 > tmp;
       llarp_buffer_t buf{tmp};
@@ -125,7 +134,7 @@ namespace llarp
       buf.cur += K.size();
       std::copy(A.begin(), A.end(), buf.cur);
       buf.cur = buf.base;
-      return OurCrypto()->shorthash(K, buf);
+      return crypto->shorthash(K, buf);
     }
 
     void
@@ -162,7 +171,7 @@ namespace llarp
           s -= left;
           recvBufOffset = 0;
           buf += left;
-          if(!VerifyThenDecrypt(recvBuf.data()))
+          if(!QueueFragment(recvBuf.data()))
             return false;
         }
       }
@@ -171,7 +180,7 @@ namespace llarp
       {
         recvBufOffset = 0;
         LogDebug("process full sz=", s);
-        if(!VerifyThenDecrypt(buf))
+        if(!QueueFragment(buf))
           return false;
         buf += FragmentBufferSize;
         s -= FragmentBufferSize;
@@ -473,39 +482,49 @@ namespace llarp
     Session::VerifyThenDecrypt(const byte_t* ptr)
     {
       LogDebug("verify then decrypt ", remoteAddr);
+      if(!DecryptFragment(OurCrypto(), rxKey, ptr, rxFragBody))
+      {
+        LogError("bad fragment from ", remoteAddr);
+        Close();
+        return false;
+      }
+      return HandleFragment(rxFragBody);
+    }
+
+    bool
+    Session::DecryptFragment(Crypto* crypto, SharedSecret& K,
+                             const byte_t* ptr,
+                             AlignedBuffer< FragmentBodySize >& body)
+    {
       ShortHash digest;
 
       llarp_buffer_t hbuf(ptr + FragmentHashSize,
                           FragmentBufferSize - FragmentHashSize);
-      if(!OurCrypto()->hmac(digest.data(), hbuf, rxKey))
-      {
-        LogError("keyed hash failed");
+      if(!crypto->hmac(digest.data(), hbuf, K))
         return false;
-      }
       const ShortHash expected(ptr);
       if(expected != digest)
-      {
-        LogError("Message Integrity Failed: got ", digest, " from ", remoteAddr,
-                 " instead of ", expected);
-        Close();
         return false;
-      }
 
       llarp_buffer_t in(ptr + FragmentOverheadSize,
                         FragmentBufferSize - FragmentOverheadSize);
 
-      llarp_buffer_t out(rxFragBody);
+      llarp_buffer_t out(body);
 
       // decrypt
-      if(!OurCrypto()->xchacha20_alt(out, in, rxKey, ptr + FragmentHashSize))
-      {
-        LogError("failed to decrypt message from ", remoteAddr);
+      if(!crypto->xchacha20_alt(out, in, K, ptr + FragmentHashSize))
         return false;
-      }
-      // get inner nonce
-      AlignedBuffer< 24 > A(out.base);
-      // advance buffer
-      out.cur += A.size();
+      // the inner nonce moves the key on
+      const AlignedBuffer< 24 > A(body.data());
+      return MutateKey(crypto, K, A);
+    }
+
+    bool
+    Session::HandleFragment(const AlignedBuffer< FragmentBodySize >& body)
+    {
+      llarp_buffer_t out(body);
+      // skip inner nonce
+      out.cur += 24;
       // read msgid
       uint32_t msgid;
       if(!out.read_uint32(msgid))
@@ -545,12 +564,6 @@ namespace llarp
         LogError("inbound buffer is full");
         return false;  // not enough room
       }
-      // mutate key
-      if(!MutateKey(rxKey, A))
-      {
-        LogError("failed to mutate rx key");
-        return false;
-      }
 
       if(remaining == 0)
       {
@@ -563,11 +576,110 @@ namespace llarp
         buf.underlying.cur = buf.underlying.base;
         // process buffer
         LogDebug("got message ", msgid, " from ", remoteAddr);
+        m_CurrentRecv = &itr->second.msg;
         parent->HandleMessage(this, buf.underlying);
+        m_CurrentRecv = nullptr;
+      }
+      return true;
+    }
+
+    bool
+    Session::QueueFragment(const byte_t* ptr)
+    {
+      // keep the order, nothing jumps ahead of fragments already waiting
+      if(m_RXBusy || !m_RXPending.empty())
+      {
+        m_RXPending.emplace_back(ptr);
+        return true;
       }
+      // the handshake swaps keys between fragments, do it inline
+      if(parent->Results() == nullptr || state != eSessionReady)
+        return VerifyThenDecrypt(ptr);
+      m_RXPending.emplace_back(ptr);
+      DecryptPending();
       return true;
     }
 
+    void
+    Session::DecryptPending()
+    {
+      if(m_RXBusy || m_RXPending.empty())
+        return;
+      m_RXBusy   = true;
+      auto frags = std::make_shared< std::vector< FragmentBuffer > >();
+      frags->swap(m_RXPending);
+      std::weak_ptr< LinkResultQueue > results = parent->Results();
+      std::weak_ptr< Session > weak            = shared_from_this();
+      const SharedSecret key                   = rxKey;
+      parent->CryptoWorker()->QueueFunc([=]() {
+        // the link stopped, nobody is waiting for this
+        auto queue = results.lock();
+        if(!queue)
+          return;
+        using Body  = AlignedBuffer< FragmentBodySize >;
+        auto bodies = std::make_shared< std::vector< Body > >();
+        bodies->reserve(frags->size());
+        SharedSecret K = key;
+        for(const auto& frag : *frags)
+        {
+          bodies->emplace_back();
+          if(!DecryptFragment(queue->crypto, K, frag.data(), bodies->back()))
+          {
+            bodies->pop_back();
+            break;
+          }
+        }
+        queue->Push([weak, frags, bodies, K]() {
+          auto self = weak.lock();
+          if(self)
+            self->HandleDecrypted(*frags, *bodies, K);
+        });
+      });
+    }
+
+    void
+    Session::HandleDecrypted(
+        std::vector< FragmentBuffer >& frags,
+        const std::vector< AlignedBuffer< FragmentBodySize > >& bodies,
+        const SharedSecret& key)
+    {
+      m_RXBusy = false;
+      if(state == eClose)
+        return;
+      const uint64_t gen = m_RXKeyGen;
+      size_t idx         = 0;
+      while(idx < bodies.size())
+      {
+        if(!HandleFragment(bodies[idx++]))
+        {
+          Close();
+          return;
+        }
+        if(state == eClose)
+          return;
+        // a renegotiation, what came after it was sent under the new key
+        if(m_RXKeyGen != gen)
+          break;
+      }
+      if(m_RXKeyGen == gen)
+      {
+        if(bodies.size() < frags.size())
+        {
+          LogError("bad fragment from ", remoteAddr);
+          Close();
+          return;
+        }
+        rxKey = key;
+      }
+      else
+      {
+        // run the rest again under the new key, ahead of anything newer
+        m_RXPending.insert(m_RXPending.begin(), frags.begin() + idx,
+                           frags.end());
+      }
+      DecryptPending();
+    }
+
     void
     Session::Close()
     {
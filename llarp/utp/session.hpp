@@ -5,6 +5,8 @@
 #include <link/session.hpp>
 #include <utp/inbound_message.hpp>
 #include <deque>
+#include <memory>
+#include <vector>
 
 #include <utp.h>
 
@@ -14,7 +16,8 @@ namespace llarp
   {
     struct LinkLayer;
 
-    struct Session : public ILinkSession
+    struct Session : public ILinkSession,
+                     public std::enable_shared_from_this< Session >
     {
       /// remote router's rc
       RouterContact remoteRC;
@@ -49,6 +52,12 @@ namespace llarp
       size_t recvBufOffset;
       /// rx fragment message body
       AlignedBuffer< FragmentBodySize > rxFragBody;
+      /// full fragments read that wait for the crypto worker
+      std::vector< FragmentBuffer > m_RXPending;
+      /// is the crypto worker decrypting for us right now?
+      bool m_RXBusy = false;
+      /// bumped every time a key exchange replaces rxKey
+      uint64_t m_RXKeyGen = 0;
 
       /// the next message id for tx
       uint32_t m_NextTXMsgID;
@@ -56,6 +65,8 @@ namespace llarp
       uint32_t m_NextRXMsgID;
       /// messages we are recving right now
       std::unordered_map< uint32_t, InboundMessage > m_RecvMsgs;
+      /// the message we are handing to the router right now
+      const PacketBuffer* m_CurrentRecv = nullptr;
       /// are we stalled or nah?
       bool stalled = false;
 
@@ -133,6 +144,35 @@ namespace llarp
       bool
       VerifyThenDecrypt(const byte_t* buf);
 
+      /// verify and decrypt the fragment at buf into body then move K on to
+      /// the key for the next one, touches no session state so it is safe
+      /// to run on a worker
+      static bool
+      DecryptFragment(Crypto* crypto, SharedSecret& K, const byte_t* buf,
+                      AlignedBuffer< FragmentBodySize >& body);
+
+      /// add a decrypted fragment to its message, handing the message to the
+      /// router once it is whole
+      bool
+      HandleFragment(const AlignedBuffer< FragmentBodySize >& body);
+
+      /// decrypt the fragment at buf now, or later on the crypto worker once
+      /// the session is up
+      bool
+      QueueFragment(const byte_t* buf);
+
+      /// hand the pending fragments to the crypto worker
+      void
+      DecryptPending();
+
+      /// take back what the crypto worker made of frags, key is rxKey moved
+      /// past the last fragment it decrypted
+      void
+      HandleDecrypted(
+          std::vector< FragmentBuffer >& frags,
+          const std::vector< AlignedBuffer< FragmentBodySize > >& bodies,
+          const SharedSecret& key);
+
       /// encrypt a fragment then hash the ciphertext
       bool
       EncryptThenHash(const byte_t* ptr, uint32_t msgid, uint16_t sz,
@@ -142,6 +182,12 @@ namespace llarp
       bool
       SendMessageBuffer(const llarp_buffer_t& buf) override;
 
+      const PacketBuffer*
+      CurrentRecvBuffer() const override
+      {
+        return m_CurrentRecv;
+      }
+
       /// prune expired inbound messages
       void
       PruneInboundMessages(llarp_time_t now);
@@ -168,6 +214,9 @@ namespace llarp
       bool
       MutateKey(SharedSecret& K, const AlignedBuffer< 24 >& A);
 
+      static bool
+      MutateKey(Crypto* crypto, SharedSecret& K, const AlignedBuffer< 24 >& A);
+
       void
       Tick(llarp_time_t now) override;
 
@@ -24,7 +24,7 @@ namespace llarp
     NewServerFromRouter(AbstractRouter* r)
     {
       using namespace std::placeholders;
-      return NewServer(
+      auto link = NewServer(
           r->crypto(), r->encryption(), std::bind(&AbstractRouter::rc, r),
           std::bind(&AbstractRouter::HandleRecvLinkMessageBuffer, r, _1, _2),
           std::bind(&AbstractRouter::OnSessionEstablished, r, _1),
@@ -32,6 +32,9 @@ namespace llarp
           std::bind(&AbstractRouter::Sign, r, _1, _2),
           std::bind(&AbstractRouter::OnConnectTimeout, r, _1),
           std::bind(&AbstractRouter::SessionClosed, r, _1));
+      if(link)
+        link->SetCryptoWorker(r->threadpool());
+      return link;
     }
 
   }  // namespace utp
@@ -19,6 +19,10 @@ namespace llarp
                    bool(const llarp_buffer_t &, const llarp_buffer_t &,
                         const SharedSecret &, const byte_t *));
 
+      MOCK_METHOD5(xchacha20_onion,
+                   bool(PacketBuffer *, size_t, const SharedSecret *,
+                        const TunnelNonce *, size_t));
+
       MOCK_METHOD4(dh_client,
                    bool(SharedSecret &, const PubKey &, const SecretKey &,
                         const TunnelNonce &));
@@ -1,8 +1,11 @@
 #include <crypto/crypto_libsodium.hpp>
+#include <crypto/xchacha20_multi.hpp>
+#include <util/packet_buffer.hpp>
 
 #include <iostream>
 
 #include <gtest/gtest.h>
+#include <sodium/crypto_stream_xchacha20.h>
 
 namespace llarp
 {
@@ -71,4 +74,67 @@ namespace llarp
     ASSERT_TRUE(c->pqe_decrypt(block, otherShared, pq_keypair_to_secret(keys)));
     ASSERT_TRUE(otherShared == shared);
   }
+
+  TEST(XChaCha20Multi, MatchesLibsodium)
+  {
+    // odd sizes to hit partial blocks, more streams than any kernel has lanes
+    const std::vector< size_t > sizes = {0, 1, 63, 64, 65, 1500, 8000, 3, 127,
+                                         128, 129, 511, 4096, 7, 2, 1024, 9};
+    std::vector< std::vector< byte_t > > got, expected;
+    std::vector< SharedSecret > keys(sizes.size());
+    std::vector< TunnelNonce > nonces(sizes.size());
+    std::vector< XChaCha20Stream > streams;
+    for(size_t idx = 0; idx < sizes.size(); ++idx)
+    {
+      keys[idx].Randomize();
+      nonces[idx].Randomize();
+      std::vector< byte_t > data(sizes[idx]);
+      for(auto& b : data)
+        b = llarp::randint();
+      got.push_back(data);
+      expected.push_back(data);
+      crypto_stream_xchacha20_xor(expected[idx].data(), expected[idx].data(),
+                                  data.size(), nonces[idx].data(),
+                                  keys[idx].data());
+    }
+    for(size_t idx = 0; idx < sizes.size(); ++idx)
+      streams.push_back({got[idx].data(), got[idx].size(), keys[idx].data(),
+                         nonces[idx].data()});
+    xchacha20_multi_xor(streams.data(), streams.size());
+    for(size_t idx = 0; idx < sizes.size(); ++idx)
+      ASSERT_EQ(got[idx], expected[idx]) << "stream " << idx << " with "
+                                         << xchacha20_multi_kernel();
+  }
+
+  TEST(XChaCha20Multi, OnionLayers)
+  {
+    llarp::sodium::CryptoLibSodium crypto;
+    constexpr size_t layers = 4;
+    constexpr size_t num    = 3;
+    std::array< SharedSecret, layers > keys;
+    std::array< TunnelNonce, num * layers > nonces;
+    for(auto& k : keys)
+      k.Randomize();
+    for(auto& n : nonces)
+      n.Randomize();
+
+    std::array< PacketBuffer, num > pkts;
+    std::array< std::vector< byte_t >, num > expected;
+    for(size_t j = 0; j < num; ++j)
+    {
+      pkts[j] = PacketBuffer::Alloc(100 + j * 700);
+      for(size_t b = 0; b < pkts[j].size(); ++b)
+        pkts[j].data()[b] = llarp::randint();
+      expected[j].assign(pkts[j].data(), pkts[j].data() + pkts[j].size());
+      for(size_t i = 0; i < layers; ++i)
+      {
+        const llarp_buffer_t buf(expected[j]);
+        ASSERT_TRUE(crypto.xchacha20(buf, keys[i], nonces[j * layers + i]));
+      }
+    }
+    ASSERT_TRUE(crypto.xchacha20_onion(pkts.data(), num, keys.data(),
+                                       nonces.data(), layers));
+    for(size_t j = 0; j < num; ++j)
+      ASSERT_EQ(memcmp(pkts[j].data(), expected[j].data(), pkts[j].size()), 0);
+  }
 }  // namespace llarp
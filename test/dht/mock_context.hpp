@@ -110,7 +110,7 @@ namespace llarp
 
       MOCK_CONST_METHOD0(pendingExploreLookups, const PendingExploreLookups&());
 
-      MOCK_METHOD0(services, dht::Bucket< dht::ISNode >*());
+      MOCK_METHOD0(services, dht::Bucket< dht::ISNode, dht::TagIndex >*());
 
       MOCK_CONST_METHOD0(AllowTransit, const bool&());
       MOCK_METHOD0(AllowTransit, bool&());
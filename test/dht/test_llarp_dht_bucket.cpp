@@ -368,3 +368,47 @@ TEST_F(TestDhtBucket, TestBucketRandomized_1000)
     }
   }
 };
+
+TEST_F(TestDhtBucket, near_matches_full_scan)
+{
+  nodes->Clear();
+  std::vector< Key_t > keys;
+  for(size_t idx = 0; idx < 2000; ++idx)
+  {
+    Value_t n;
+    n.ID.Randomize();
+    // some keys sharing long prefixes so the walk has deep splits
+    if(idx % 10 == 0)
+      std::copy_n(keys.empty() ? us.begin() : keys.back().begin(), 20,
+                  n.ID.begin());
+    nodes->PutNode(n);
+    keys.push_back(n.ID);
+  }
+
+  for(size_t round = 0; round < 200; ++round)
+  {
+    Key_t target;
+    target.Randomize();
+    if(round % 4 == 0)
+      target = keys[round];
+    std::sort(keys.begin(), keys.end(),
+              [&target](const Key_t& a, const Key_t& b) {
+                return (a ^ target) < (b ^ target);
+              });
+    // leave out one of the nearest so exclusion is exercised
+    const std::set< Key_t > exclude{keys[round % 3]};
+    std::set< Key_t > expect;
+    for(size_t idx = 0; expect.size() < 8; ++idx)
+    {
+      if(!exclude.count(keys[idx]))
+        expect.insert(keys[idx]);
+    }
+
+    std::set< Key_t > result;
+    ASSERT_TRUE(nodes->GetManyNearExcluding(target, result, 8, exclude));
+    ASSERT_EQ(result, expect);
+    Key_t closest;
+    ASSERT_TRUE(nodes->FindClosest(target, closest));
+    ASSERT_EQ(closest, keys[0]);
+  }
+}
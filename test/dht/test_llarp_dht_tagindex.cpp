@@ -0,0 +1,99 @@
+#include <dht/tagindex.hpp>
+
+#include <dht/bucket.hpp>
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+using llarp::dht::ISNode;
+using llarp::dht::Key_t;
+using llarp::service::Tag;
+
+using Bucket_t = llarp::dht::Bucket< ISNode, llarp::dht::TagIndex >;
+
+class TestDhtTagIndex : public ::testing::Test
+{
+ public:
+  TestDhtTagIndex() : bucket(us, [&]() { return randInt++; })
+  {
+    us.Fill(16);
+  }
+
+  static ISNode
+  MakeNode(const Tag& tag, uint64_t T)
+  {
+    ISNode node;
+    node.ID.Randomize();
+    node.introset.topic = tag;
+    node.introset.T     = T;
+    return node;
+  }
+
+  std::set< Key_t >
+  Tagged(const Tag& tag, size_t start = 0) const
+  {
+    std::set< Key_t > keys;
+    bucket.index.VisitFrom(tag, start, [&keys](const Key_t& key) {
+      keys.insert(key);
+      return true;
+    });
+    return keys;
+  }
+
+  uint64_t randInt = 0;
+  Key_t us;
+  Bucket_t bucket;
+};
+
+TEST_F(TestDhtTagIndex, FollowsTheBucket)
+{
+  const Tag cats("cats");
+  const Tag dogs("dogs");
+  std::set< Key_t > catKeys;
+  for(size_t idx = 0; idx < 10; ++idx)
+  {
+    auto node = MakeNode(cats, 1);
+    bucket.PutNode(node);
+    catKeys.insert(node.ID);
+  }
+  auto dog = MakeNode(dogs, 1);
+  bucket.PutNode(dog);
+  ASSERT_EQ(bucket.index.Count(cats), 10u);
+  ASSERT_EQ(Tagged(cats), catKeys);
+  // any start visits every one of them once
+  ASSERT_EQ(Tagged(cats, 7), catKeys);
+  ASSERT_EQ(Tagged(dogs), std::set< Key_t >({dog.ID}));
+  ASSERT_EQ(bucket.index.Count(Tag("birds")), 0u);
+
+  // an older introset does not replace the stored one
+  auto moved = dog;
+  moved.introset.topic = cats;
+  bucket.PutNode(moved);
+  ASSERT_EQ(bucket.index.Count(dogs), 1u);
+
+  // a newer one moves it over to its new tag
+  moved.introset.T = 2;
+  bucket.PutNode(moved);
+  ASSERT_EQ(bucket.index.Count(dogs), 0u);
+  ASSERT_EQ(bucket.index.Count(cats), 11u);
+
+  // drop half of them
+  size_t idx = 0;
+  for(const auto& key : catKeys)
+  {
+    if(idx++ % 2)
+      bucket.DelNode(key);
+  }
+  bucket.ExpireNodes(
+      [&moved](const ISNode& node) { return node.ID == moved.ID; });
+  ASSERT_EQ(bucket.index.Count(cats), 5u);
+  for(const auto& key : Tagged(cats))
+  {
+    ASSERT_TRUE(bucket.HasNode(key));
+  }
+
+  bucket.Clear();
+  ASSERT_EQ(bucket.index.Count(cats), 0u);
+  ASSERT_TRUE(Tagged(cats).empty());
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <dns/cache.hpp>
+#include <dns/dns.hpp>
+#include <util/buffer.hpp>
+#include <util/endian.hpp>
+
+#include <vector>
+
+using llarp::dns::Cache;
+
+struct DNSCacheTest : public ::testing::Test
+{
+  /// offset of the ttl of the answer and the edns record in Reply()
+  static constexpr size_t AnswerTTL = 35;
+  static constexpr size_t OptTTL    = 50;
+
+  /// reply to example.com A with a compressed answer name and an edns record
+  static std::vector< byte_t >
+  Reply(uint16_t rcode, uint32_t ttl)
+  {
+    std::vector< byte_t > pkt = {
+        0x12, 0x34, 0x81, 0x80, 0, 1, 0, 1, 0, 0, 0, 1,
+        // question
+        7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0, 0, 1, 0, 1,
+        // answer
+        0xc0, 0x0c, 0, 1, 0, 1, 0, 0, 0, 0, 0, 4, 1, 2, 3, 4,
+        // edns
+        0, 0, 41, 0x10, 0, 0, 0, 0, 0, 0, 0};
+    pkt[3] |= rcode;
+    htobe32buf(pkt.data() + AnswerTTL, ttl);
+    return pkt;
+  }
+
+  static Cache::Key
+  Key()
+  {
+    llarp::dns::Question q;
+    q.qname  = "Example.COM.";
+    q.qtype  = llarp::dns::qTypeA;
+    q.qclass = llarp::dns::qClassIN;
+    return Cache::Key::From(q);
+  }
+
+  bool
+  Put(std::vector< byte_t > pkt, llarp_time_t now)
+  {
+    llarp_buffer_t buf(pkt);
+    return cache.Put(Key(), buf, now);
+  }
+
+  Cache cache;
+  std::vector< byte_t > got;
+};
+
+constexpr size_t DNSCacheTest::AnswerTTL;
+constexpr size_t DNSCacheTest::OptTTL;
+
+TEST_F(DNSCacheTest, CountsDownTTL)
+{
+  ASSERT_TRUE(Put(Reply(0, 60), 1000));
+  ASSERT_EQ(Key().qname, "example.com.");
+
+  ASSERT_TRUE(cache.Get(Key(), 0xabcd, 11000, false, got));
+  ASSERT_EQ(got.size(), Reply(0, 60).size());
+  ASSERT_EQ(bufbe16toh(got.data()), 0xabcd);
+  ASSERT_EQ(bufbe32toh(got.data() + AnswerTTL), 50u);
+  ASSERT_EQ(bufbe32toh(got.data() + OptTTL), 0u);
+}
+
+TEST_F(DNSCacheTest, ServesStaleOnlyWhenAsked)
+{
+  ASSERT_TRUE(Put(Reply(0, 60), 0));
+  ASSERT_FALSE(cache.Get(Key(), 1, 61000, false, got));
+  ASSERT_TRUE(cache.Get(Key(), 1, 61000, true, got));
+  ASSERT_EQ(bufbe32toh(got.data() + AnswerTTL), Cache::StaleTTL);
+  ASSERT_EQ(bufbe32toh(got.data() + OptTTL), 0u);
+
+  // too stale to serve at all
+  ASSERT_FALSE(cache.Get(Key(), 1, 60000 + Cache::StaleFor, true, got));
+  ASSERT_EQ(cache.Size(), 0u);
+}
+
+TEST_F(DNSCacheTest, NegativeReplies)
+{
+  // no such name and no soa to take a ttl from
+  auto nx = Reply(llarp::dns::flags_RCODENameError, 60);
+  nx[7]   = 0;
+  nx.erase(nx.begin() + 29, nx.begin() + 45);
+  ASSERT_TRUE(Put(nx, 0));
+  ASSERT_TRUE(cache.Get(Key(), 1, 4000, false, got));
+  ASSERT_FALSE(cache.Get(Key(), 1, 6000, false, got));
+}
+
+TEST_F(DNSCacheTest, SkipsUncacheable)
+{
+  ASSERT_FALSE(Put(Reply(llarp::dns::flags_RCODEServFail, 60), 0));
+  ASSERT_FALSE(Put(Reply(0, 0), 0));
+  auto truncated = Reply(0, 60);
+  truncated[2] |= 0x02;
+  ASSERT_FALSE(Put(truncated, 0));
+  // records running past the end
+  auto cut = Reply(0, 60);
+  cut.resize(40);
+  ASSERT_FALSE(Put(cut, 0));
+  ASSERT_EQ(cache.Size(), 0u);
+  ASSERT_FALSE(cache.Get(Key(), 1, 0, true, got));
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <dns/dns.hpp>
+#include <dns/message.hpp>
+#include <dns/view.hpp>
+#include <util/endian.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace llarp::dns;
+
+struct DNSViewTest : public ::testing::Test
+{
+  /// reply to www.Example.com A with a cname whose target and answer
+  /// names are compressed
+  std::vector< byte_t > pkt = {
+      0xbe, 0xef, 0x81, 0x80, 0, 1, 0, 2, 0, 0, 0, 0,
+      // question at 12
+      3, 'w', 'w', 'w', 7, 'E', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o',
+      'm', 0, 0, 1, 0, 1,
+      // www.example.com cname cdn.example.com
+      0xc0, 0x0c, 0, 5, 0, 1, 0, 0, 0, 60, 0, 6, 3, 'c', 'd', 'n', 0xc0, 0x10,
+      // cdn.example.com a 1.2.3.4, named by a pointer to the cname target
+      0xc0, 0x2d, 0, 1, 0, 1, 0, 0, 1, 0, 0, 4, 1, 2, 3, 4};
+};
+
+TEST_F(DNSViewTest, ParsesInPlace)
+{
+  MessageView view;
+  ASSERT_TRUE(view.Parse(pkt.data(), pkt.size()));
+  ASSERT_EQ(view.Header().id, 0xbeef);
+  ASSERT_EQ(view.Header().an_count, 2);
+
+  QuestionView q;
+  ASSERT_TRUE(view.FirstQuestion(q));
+  ASSERT_EQ(q.qtype, qTypeA);
+  ASSERT_EQ(q.qclass, qClassIN);
+  ASSERT_TRUE(q.name.Equals("www.example.com."));
+  ASSERT_TRUE(q.name.Equals("WWW.EXAMPLE.COM"));
+  ASSERT_FALSE(q.name.Equals("www.example.co"));
+  ASSERT_FALSE(q.name.Equals("ww.example.com"));
+  ASSERT_FALSE(q.name.Equals("www.example.com.au"));
+
+  std::vector< std::string > names;
+  std::vector< RR_TTL_t > ttls;
+  view.ForEachRecord([&](const RecordView& rr) {
+    std::string name;
+    ASSERT_TRUE(rr.name.ToString(name));
+    names.emplace_back(name);
+    ttls.emplace_back(rr.ttl);
+    ASSERT_EQ(bufbe32toh(pkt.data() + rr.ttlOffset), rr.ttl);
+  });
+  ASSERT_EQ(names, std::vector< std::string >({"www.example.com.",
+                                               "cdn.example.com."}));
+  ASSERT_EQ(ttls, std::vector< RR_TTL_t >({60, 256}));
+}
+
+TEST_F(DNSViewTest, RejectsMalformed)
+{
+  MessageView view;
+  // cut inside the last record
+  ASSERT_FALSE(view.Parse(pkt.data(), pkt.size() - 1));
+  // too short for a header
+  ASSERT_FALSE(view.Parse(pkt.data(), 11));
+  // label too long
+  auto bad = pkt;
+  bad[12]  = 64;
+  ASSERT_FALSE(view.Parse(bad.data(), bad.size()));
+
+  // a pointer to itself only fails once followed
+  bad     = pkt;
+  bad[33] = 0xc0;
+  bad[34] = 33;
+  ASSERT_TRUE(view.Parse(bad.data(), bad.size()));
+  size_t idx = 0;
+  view.ForEachRecord([&](const RecordView& rr) {
+    std::string name;
+    ASSERT_EQ(rr.name.ToString(name), idx++ != 0);
+  });
+}
+
+TEST_F(DNSViewTest, WritesReply)
+{
+  MessageView query;
+  ASSERT_TRUE(query.Parse(pkt.data(), pkt.size()));
+  QuestionView q;
+  ASSERT_TRUE(query.FirstQuestion(q));
+
+  std::array< byte_t, 512 > tmp;
+  llarp_buffer_t buf(tmp);
+  MessageWriter writer(buf);
+  const byte_t addr[4] = {10, 0, 0, 1};
+  ASSERT_TRUE(writer.PutHeader(0x1234, flags_QR | flags_RA));
+  ASSERT_TRUE(writer.PutQuestion(q));
+  ASSERT_TRUE(writer.PutAnswer(qTypeA, 10, addr, sizeof(addr)));
+  ASSERT_TRUE(writer.Finish());
+  ASSERT_EQ(buf.sz, 12u + 21u + 16u);
+
+  MessageView reply;
+  ASSERT_TRUE(reply.Parse(buf));
+  ASSERT_EQ(reply.Header().id, 0x1234);
+  ASSERT_EQ(reply.Header().qd_count, 1);
+  ASSERT_EQ(reply.Header().an_count, 1);
+  ASSERT_TRUE(reply.FirstQuestion(q));
+  ASSERT_TRUE(q.name.Equals("www.example.com"));
+  size_t answers = 0;
+  reply.ForEachRecord([&](const RecordView& rr) {
+    // the answer name points back at the question
+    ASSERT_TRUE(rr.name.Equals("www.example.com"));
+    ASSERT_EQ(rr.type, qTypeA);
+    ASSERT_EQ(rr.ttl, 10u);
+    ASSERT_EQ(std::vector< byte_t >(rr.rdata, rr.rdata + rr.rdlen),
+              std::vector< byte_t >(addr, addr + sizeof(addr)));
+    ++answers;
+  });
+  ASSERT_EQ(answers, 1u);
+
+  // written names decode with the full message decoder too
+  buf.sz = MessageHeader::Size + 21;
+  MessageHeader hdr;
+  ASSERT_TRUE(hdr.Decode(&buf));
+  hdr.an_count = 0;
+  Message msg(hdr);
+  ASSERT_TRUE(msg.Decode(&buf));
+  // written as asked, case and all
+  ASSERT_EQ(msg.questions[0].qname, "www.Example.com.");
+}
+
+TEST_F(DNSViewTest, WritesServFail)
+{
+  MessageView query;
+  ASSERT_TRUE(query.Parse(pkt.data(), pkt.size()));
+  std::array< byte_t, 512 > tmp;
+  llarp_buffer_t buf(tmp);
+  ASSERT_TRUE(WriteServFail(query, 7, buf));
+
+  MessageView reply;
+  ASSERT_TRUE(reply.Parse(buf));
+  ASSERT_EQ(reply.Header().id, 7);
+  ASSERT_EQ(reply.Header().fields & 0x0f, flags_RCODEServFail);
+  ASSERT_EQ(reply.Header().fields & flags_RD, 0);
+  ASSERT_EQ(reply.Header().qd_count, 1);
+  ASSERT_EQ(reply.Header().an_count, 0);
+  QuestionView q;
+  ASSERT_TRUE(reply.FirstQuestion(q));
+  ASSERT_TRUE(q.name.Equals("www.example.com"));
+
+  // too small a buffer
+  llarp_buffer_t small(tmp.data(), 20);
+  ASSERT_FALSE(WriteServFail(query, 7, small));
+}
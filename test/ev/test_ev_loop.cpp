@@ -1,6 +1,8 @@
 #include <crypto/crypto_libsodium.hpp>
 #include <ev/ev.h>
+#include <ev/ev.hpp>
 #include <ev/pipe.hpp>
+#include <net/net_addr.hpp>
 #include <util/aligned.hpp>
 #include <util/logic.hpp>
 #include <gtest/gtest.h>
@@ -133,3 +135,158 @@ TEST_F(EventLoopTest, PipeWrite1K)
   testpipe->PumpIt();
   RunLoop();
 };
+
+TEST_F(EventLoopTest, UDPBatchedSendRecv)
+{
+  struct UDPBatchTest
+  {
+    static constexpr size_t NumPackets = 100;
+    llarp_udp_io sender;
+    llarp_udp_io receiver;
+    std::vector< llarp::AlignedBuffer< 512 > > data;
+    size_t idx = 0;
+    bool sent  = false;
+
+    UDPBatchTest()
+    {
+      data.resize(NumPackets);
+      for(auto& d : data)
+        d.Randomize();
+      sender            = llarp_udp_io{};
+      receiver          = llarp_udp_io{};
+      receiver.user     = this;
+      receiver.recvfrom = &OnRecv;
+      sender.user       = this;
+      sender.recvfrom   = &OnRecv;
+      sender.tick       = &OnTick;
+    }
+
+    static void
+    OnRecv(llarp_udp_io* udp, const sockaddr*, ManagedBuffer buf)
+    {
+      UDPBatchTest* self = static_cast< UDPBatchTest* >(udp->user);
+      ASSERT_EQ(udp, &self->receiver);
+      ASSERT_LT(self->idx, self->data.size());
+      const auto& expect = self->data[self->idx];
+      ASSERT_EQ(buf.underlying.sz, expect.size());
+      ASSERT_EQ(memcmp(buf.underlying.base, expect.data(), expect.size()), 0);
+      ++self->idx;
+    }
+
+    /// queue everything in one tick so it goes out batched
+    static void
+    OnTick(llarp_udp_io* udp)
+    {
+      UDPBatchTest* self = static_cast< UDPBatchTest* >(udp->user);
+      if(self->sent)
+        return;
+      self->sent = true;
+      sockaddr_in to;
+      socklen_t tolen = sizeof(to);
+      ASSERT_EQ(getsockname(self->receiver.fd, (sockaddr*)&to, &tolen), 0);
+      for(const auto& d : self->data)
+        ASSERT_NE(
+            llarp_ev_udp_sendto(udp, (const sockaddr*)&to, llarp_buffer_t(d)),
+            -1);
+    }
+  };
+
+  ASSERT_EQ(llarp_ev_loop_set_udp_batch(loop.get(), 32), 32u);
+  UDPBatchTest test;
+  llarp::Addr addr(127, 0, 0, 1, 0);
+  ASSERT_EQ(llarp_ev_add_udp(loop.get(), &test.receiver, addr), 0);
+  ASSERT_EQ(llarp_ev_add_udp(loop.get(), &test.sender, addr), 0);
+  size_t recvCalls = 0;
+  size_t sendCalls = 0;
+  for(size_t tries = 0; tries < 100 && test.idx < test.data.size(); ++tries)
+  {
+    loop->update_time();
+    loop->tick(10);
+    recvCalls += loop->udp_stats.recv_calls;
+    sendCalls += loop->udp_stats.send_calls;
+  }
+  ASSERT_EQ(test.idx, test.data.size());
+#ifdef __linux__
+  // 100 datagrams in batches of 32
+  ASSERT_LT(recvCalls, test.data.size());
+  ASSERT_LT(sendCalls, test.data.size());
+#endif
+}
+
+#ifdef __linux__
+TEST_F(EventLoopTest, UDPShardSteering)
+{
+  struct UDPShardTest
+  {
+    static constexpr size_t NumShards = 2;
+    llarp_udp_io shards[NumShards];
+    llarp_udp_io senders[NumShards];
+    size_t got[NumShards] = {0, 0};
+    // the source each shard is reading from
+    llarp::Addr seen[NumShards];
+    size_t misrouted = 0;
+
+    UDPShardTest()
+    {
+      for(size_t idx = 0; idx < NumShards; ++idx)
+      {
+        shards[idx]          = llarp_udp_io{};
+        shards[idx].user     = this;
+        shards[idx].recvfrom = &OnRecv;
+        senders[idx]         = llarp_udp_io{};
+      }
+    }
+
+    static void
+    OnRecv(llarp_udp_io* udp, const sockaddr* from, ManagedBuffer)
+    {
+      UDPShardTest* self = static_cast< UDPShardTest* >(udp->user);
+      const size_t idx   = udp - self->shards;
+      llarp::Addr src(*from);
+      src.port(0);
+      // a remote must stick to one shard
+      if(self->got[idx] && self->seen[idx] != src)
+        ++self->misrouted;
+      self->seen[idx] = src;
+      ++self->got[idx];
+    }
+  };
+
+  UDPShardTest test;
+  llarp::Addr addr(127, 0, 0, 1, 0);
+  ASSERT_EQ(llarp_ev_add_udp_shard(loop.get(), &test.shards[0], addr, 0,
+                                   UDPShardTest::NumShards),
+            0);
+  sockaddr_in bound;
+  socklen_t boundlen = sizeof(bound);
+  ASSERT_EQ(getsockname(test.shards[0].fd, (sockaddr*)&bound, &boundlen), 0);
+  addr.port(ntohs(bound.sin_port));
+  ASSERT_EQ(llarp_ev_add_udp_shard(loop.get(), &test.shards[1], addr, 1,
+                                   UDPShardTest::NumShards),
+            0);
+  // the low words of these modulo 2 are 0 and 1, one source for each shard
+  llarp::Addr from[UDPShardTest::NumShards] = {llarp::Addr(127, 0, 0, 2, 0),
+                                               llarp::Addr(127, 0, 0, 1, 0)};
+  for(size_t idx = 0; idx < UDPShardTest::NumShards; ++idx)
+  {
+    ASSERT_EQ(llarp_ev_add_udp(loop.get(), &test.senders[idx], from[idx]), 0);
+  }
+  llarp::AlignedBuffer< 64 > data;
+  data.Randomize();
+  for(size_t n = 0; n < 10; ++n)
+    for(auto& sender : test.senders)
+      ASSERT_NE(llarp_ev_udp_sendto(&sender, addr, llarp_buffer_t(data)), -1);
+  for(size_t tries = 0;
+      tries < 100 && test.got[0] + test.got[1] < 20 && !test.misrouted;
+      ++tries)
+  {
+    loop->update_time();
+    loop->tick(10);
+  }
+  ASSERT_EQ(test.misrouted, 0u);
+  ASSERT_EQ(test.got[0], 10u);
+  ASSERT_EQ(test.got[1], 10u);
+  ASSERT_EQ(test.seen[0], from[0]);
+  ASSERT_EQ(test.seen[1], from[1]);
+}
+#endif
@@ -29,3 +29,36 @@ TEST_F(ExitTest, AddMultipleIP)
   ASSERT_TRUE(r.exitContext().FindEndpointForPath(firstPath)->LocalIP()
               == r.exitContext().FindEndpointForPath(secondPath)->LocalIP());
 };
+
+TEST_F(ExitTest, ReleaseIPOnClose)
+{
+  llarp::PubKey pk, other;
+  pk.Randomize();
+  other.Randomize();
+  llarp::PathID_t firstPath, secondPath, otherPath;
+  firstPath.Randomize();
+  secondPath.Randomize();
+  otherPath.Randomize();
+  llarp::exit::Context::Config_t conf;
+  conf.emplace("exit", "true");
+  conf.emplace("type", "null");
+  conf.emplace("ifaddr", "10.0.0.1/24");
+  ASSERT_TRUE(r.exitContext().AddExitEndpoint("test-exit", conf));
+  ASSERT_TRUE(r.exitContext().ObtainNewExit(pk, firstPath, true));
+  ASSERT_TRUE(r.exitContext().ObtainNewExit(pk, secondPath, true));
+  // a path finds any of its key's exits, so look both up
+  auto find = [&]() {
+    auto ep = r.exitContext().FindEndpointForPath(firstPath);
+    return ep ? ep : r.exitContext().FindEndpointForPath(secondPath);
+  };
+  const llarp::huint32_t ip = find()->LocalIP();
+  // pk keeps its ip while it has a session left
+  find()->Close();
+  ASSERT_NE(find(), nullptr);
+  ASSERT_TRUE(find()->LocalIP() == ip);
+  find()->Close();
+  ASSERT_EQ(find(), nullptr);
+  // and gives it back with the last one
+  ASSERT_TRUE(r.exitContext().ObtainNewExit(other, otherPath, true));
+  ASSERT_TRUE(r.exitContext().FindEndpointForPath(otherPath)->LocalIP() == ip);
+}
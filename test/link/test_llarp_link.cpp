@@ -31,6 +31,8 @@ struct LinkLayerTest : public ::testing::Test
 
     llarp::Crypto* crypto;
 
+    llarp_threadpool* worker = nullptr;
+
     bool gotLIM = false;
 
     const llarp::RouterContact&
@@ -72,6 +74,7 @@ struct LinkLayerTest : public ::testing::Test
     {
       if(!link)
         return false;
+      link->SetCryptoWorker(worker);
       if(!link->Configure(loop, localLoopBack(), AF_INET, port))
         return false;
       if(!link->GenEphemeralKeys())
@@ -111,6 +114,8 @@ struct LinkLayerTest : public ::testing::Test
 
   llarp_time_t oldRCLifetime;
 
+  llarp_threadpool* worker = nullptr;
+
   LinkLayerTest() : Alice(crypto), Bob(crypto), netLoop(nullptr)
   {
   }
@@ -130,6 +135,11 @@ struct LinkLayerTest : public ::testing::Test
   {
     Alice.TearDown();
     Bob.TearDown();
+    if(worker)
+    {
+      llarp_threadpool_stop(worker);
+      llarp_free_threadpool(&worker);
+    }
     logic.reset();
     netLoop.reset();
     llarp::RouterContact::IgnoreBogons = false;
@@ -164,9 +174,23 @@ struct LinkLayerTest : public ::testing::Test
     Stop();
     return true;
   }
+
+  /// decrypt on a crypto worker once sessions are up
+  void
+  UseCryptoWorker()
+  {
+    worker = llarp_init_threadpool(2, "link-test-crypto");
+    llarp_threadpool_start(worker);
+    Alice.worker = worker;
+    Bob.worker   = worker;
+  }
+
+  void
+  RenegWithBob();
 };
 
-TEST_F(LinkLayerTest, TestUTPAliceRenegWithBob)
+void
+LinkLayerTest::RenegWithBob()
 {
   Alice.link = llarp::utp::NewServer(
       &crypto, Alice.encryptionKey,
@@ -257,6 +281,17 @@ TEST_F(LinkLayerTest, TestUTPAliceRenegWithBob)
   ASSERT_TRUE(success);
 }
 
+TEST_F(LinkLayerTest, TestUTPAliceRenegWithBob)
+{
+  RenegWithBob();
+}
+
+TEST_F(LinkLayerTest, TestUTPAliceRenegWithBobOnCryptoWorker)
+{
+  UseCryptoWorker();
+  RenegWithBob();
+}
+
 TEST_F(LinkLayerTest, TestUTPAliceConnectToBob)
 {
   Alice.link = llarp::utp::NewServer(
@@ -274,6 +309,9 @@ TEST_F(LinkLayerTest, TestUTPAliceConnectToBob)
           }
           return false;
         }
+        // the session to bob that sends would go out on, nothing for others
+        EXPECT_EQ(Alice.link->BestSessionTo(Bob.GetRouterID()).get(), s);
+        EXPECT_EQ(Alice.link->BestSessionTo(Alice.GetRouterID()), nullptr);
         return AliceGotMessage(buf);
       },
       [&](llarp::ILinkSession* s) -> bool {
@@ -0,0 +1,97 @@
+#include <metrics/prometheus.hpp>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace llarp;
+using namespace ::testing;
+
+TEST(MetricsPrometheus, Name)
+{
+  metrics::Registry registry;
+  metrics::Id id = registry.get("path.build", "latency-ms");
+  ASSERT_EQ("lokinet_path_build_latency_ms", metrics::prometheusName(id));
+}
+
+TEST(MetricsPrometheus, Text)
+{
+  metrics::Registry registry;
+  metrics::CollectorRepo repo(&registry);
+
+  repo.defaultIntCollector("sendq", "drops")->tick(3);
+  auto latency = repo.defaultHistogramCollector("path.build", "latency");
+  latency->tick(10);
+  latency->tick(20);
+  repo.defaultIntCollector("off", "hidden")->tick(1);
+  registry.enable(registry.get("off"), false);
+
+  std::ostringstream stream;
+  metrics::prometheusText(stream, repo);
+  const std::string text = stream.str();
+
+  ASSERT_THAT(text, HasSubstr("lokinet_sendq_drops_count 1\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_sendq_drops_sum 3\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_sendq_drops_max 3\n"));
+  // plain counts are typed too, min and max as gauges of their own
+  ASSERT_THAT(text, HasSubstr("# TYPE lokinet_sendq_drops summary\n"));
+  ASSERT_THAT(text, HasSubstr("# TYPE lokinet_sendq_drops_min gauge\n"));
+  ASSERT_THAT(text, HasSubstr("# TYPE lokinet_sendq_drops_max gauge\n"));
+  ASSERT_THAT(text, HasSubstr("# TYPE lokinet_path_build_latency summary\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_path_build_latency{quantile=\"0.5\"} "));
+  ASSERT_THAT(text, HasSubstr("lokinet_path_build_latency_count 2\n"));
+  ASSERT_THAT(text, Not(HasSubstr("hidden")));
+
+  // a scrape leaves the collectors be
+  std::ostringstream again;
+  metrics::prometheusText(again, repo);
+  ASSERT_EQ(text, again.str());
+}
+
+TEST(MetricsPrometheus, TotalsSurvivePublishing)
+{
+  metrics::Registry registry;
+  metrics::CollectorRepo repo(&registry);
+
+  auto drops = repo.defaultIntCollector("sendq", "drops");
+  drops->tick(3);
+  auto latency = repo.defaultHistogramCollector("path.build", "latency");
+  latency->tick(10);
+  // a publisher clears what it reads
+  repo.collectAndClear(registry.get("sendq"));
+  repo.collectAndClear(registry.get("path.build"));
+  drops->tick(4);
+  latency->tick(20);
+  auto added = repo.addIntCollector("sendq", "drops");
+  added->tick(5);
+
+  std::ostringstream stream;
+  metrics::prometheusText(stream, repo);
+  const std::string text = stream.str();
+
+  ASSERT_THAT(text, HasSubstr("lokinet_sendq_drops_count 3\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_sendq_drops_sum 12\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_path_build_latency_count 2\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_path_build_latency_sum 30\n"));
+}
+
+TEST(MetricsPrometheus, CollidingNames)
+{
+  metrics::Registry registry;
+  metrics::CollectorRepo repo(&registry);
+
+  repo.defaultIntCollector("a.b", "c")->tick(1);
+  repo.defaultIntCollector("a_b", "c")->tick(2);
+  // takes a series of lokinet_a_b_c
+  repo.defaultIntCollector("a.b", "c.min")->tick(3);
+
+  std::ostringstream stream;
+  metrics::prometheusText(stream, repo);
+  const std::string text = stream.str();
+
+  ASSERT_THAT(text, HasSubstr("lokinet_a_b_c_sum 1\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_a_b_c_2_sum 2\n"));
+  ASSERT_THAT(text, HasSubstr("lokinet_a_b_c_min_2_sum 3\n"));
+  ASSERT_THAT(text, Not(HasSubstr("lokinet_a_b_c_min_sum")));
+}
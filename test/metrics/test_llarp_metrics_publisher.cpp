@@ -30,3 +30,26 @@ TEST(MetricsPublisher, StreamPublisher)
 
   std::cout << stream.str();
 }
+
+TEST(MetricsPublisher, StreamPublisherQuantiles)
+{
+  metrics::Category myCategory("MyCategory");
+  metrics::Description descA(&myCategory, "Latency");
+  metrics::Id metricA(&descA);
+
+  std::stringstream stream;
+  metrics::StreamPublisher myPublisher(stream);
+
+  std::vector< metrics::Record > records;
+  records.emplace_back(metricA, 4, 10.0, 1.0, 4.0);
+  records.back().quantiles() = metrics::Record::Quantiles{{2.0, 3.0, 4.0, 4.0}};
+
+  metrics::Sample sample;
+  sample.sampleTime(absl::Now());
+  sample.pushGroup(records.data(), records.size(), absl::Seconds(5));
+
+  myPublisher.publish(sample);
+
+  ASSERT_THAT(stream.str(), ::testing::HasSubstr("p50 = 2"));
+  ASSERT_THAT(stream.str(), ::testing::HasSubstr("p999 = 4"));
+}
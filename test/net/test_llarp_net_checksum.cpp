@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <net/checksum.hpp>
+
+#include <random>
+#include <vector>
+
+using llarp::net::ChecksumKernel;
+
+struct TestNetChecksum : public ::testing::Test
+{
+  /// the plain word at a time sum the kernels have to agree with
+  static uint16_t
+  Reference(const byte_t* buf, size_t sz)
+  {
+    uint32_t sum = 0;
+    for(size_t idx = 0; idx + 1 < sz; idx += 2)
+      sum += uint32_t(buf[idx]) << 8 | buf[idx + 1];
+    if(sz % 2)
+      sum += uint32_t(buf[sz - 1]) << 8;
+    while(sum >> 16)
+      sum = (sum & 0xFFff) + (sum >> 16);
+    return htons(uint16_t(~sum));
+  }
+
+  std::vector< ChecksumKernel > kernels = {
+      ChecksumKernel::Scalar, ChecksumKernel::SSE2, ChecksumKernel::AVX2};
+};
+
+TEST_F(TestNetChecksum, KnownHeader)
+{
+  const byte_t hdr[20] = {0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40,
+                          0x00, 0x40, 0x11, 0x00, 0x00, 0xc0, 0xa8,
+                          0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7};
+  const auto sum = llarp::net::ipchksum(hdr, sizeof(hdr));
+  ASSERT_EQ(ntohs(sum.n), 0xb861);
+}
+
+TEST_F(TestNetChecksum, KernelsAgree)
+{
+  ASSERT_TRUE(llarp::net::ChecksumKernelSupported(ChecksumKernel::Scalar));
+  ASSERT_TRUE(llarp::net::ChecksumKernelSupported(
+      llarp::net::BestChecksumKernel()));
+
+  std::mt19937 rng(1071);
+  std::vector< byte_t > data(1600);
+  for(auto& b : data)
+    b = rng();
+  // every length around the vector widths at every alignment
+  for(size_t off = 0; off < 4; ++off)
+  {
+    for(size_t sz = 0; sz < 300; ++sz)
+    {
+      const uint16_t expect = Reference(data.data() + off, sz);
+      for(const auto kernel : kernels)
+      {
+        if(!llarp::net::ChecksumKernelSupported(kernel))
+          continue;
+        ASSERT_EQ(llarp::net::ipchksum(kernel, data.data() + off, sz).n,
+                  expect)
+            << llarp::net::ChecksumKernelName(kernel) << " " << off << " "
+            << sz;
+      }
+    }
+  }
+
+  // all ones words so the sums carry a lot
+  std::fill(data.begin(), data.end(), 0xff);
+  for(const auto kernel : kernels)
+  {
+    if(!llarp::net::ChecksumKernelSupported(kernel))
+      continue;
+    ASSERT_EQ(llarp::net::ipchksum(kernel, data.data(), data.size()).n,
+              Reference(data.data(), data.size()));
+  }
+}
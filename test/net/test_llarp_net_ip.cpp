@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+
+#include <net/checksum.hpp>
+#include <net/ip.hpp>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+struct TestNetIP : public ::testing::Test
+{
+  /// udp packet from 10.0.0.1:1000 to 10.0.0.2 with destination port port
+  static std::array< byte_t, 28 >
+  UDP(uint16_t port)
+  {
+    std::array< byte_t, 28 > pkt = {
+        0x45, 0, 0, 28, 0, 0, 0, 0, 64, IPPROTO_UDP, 0, 0, 10, 0,
+        0,    1, 10, 0, 0, 2, 0x03, 0xe8};
+    pkt[22] = port >> 8;
+    pkt[23] = port & 0xff;
+    return pkt;
+  }
+
+  /// tcp or udp packet from 10.0.0.1 to 10.0.0.2 with correct checksums
+  static llarp::net::IPPacket
+  Checksummed(uint8_t proto, size_t payload)
+  {
+    const size_t l4 = proto == IPPROTO_TCP ? 20 : 8;
+    std::vector< byte_t > buf(20 + l4 + payload, 0);
+    for(size_t idx = 20 + l4; idx < buf.size(); ++idx)
+      buf[idx] = idx * 7;
+    const byte_t hdr[20] = {0x45, 0, 0, 0, 0, 1, 0, 0, 64, proto,
+                            0,    0, 10, 0, 0, 1, 10, 0, 0, 2};
+    std::copy_n(hdr, 20, buf.data());
+    htobe16buf(buf.data() + 2, buf.size());
+    htobe16buf(buf.data() + 20, 1000);
+    htobe16buf(buf.data() + 22, 53);
+    if(proto == IPPROTO_UDP)
+      htobe16buf(buf.data() + 24, l4 + payload);
+    else
+      buf[32] = 5 << 4;
+    llarp::net::IPPacket pkt;
+    EXPECT_TRUE(pkt.Load(llarp_buffer_t(buf)));
+    const size_t chk = proto == IPPROTO_TCP ? 36 : 26;
+    auto l4sum =
+        llarp::net::ipchksum(pkt.data() + 20, pkt.size() - 20, L4Pseudo(pkt));
+    std::copy_n((const byte_t*)&l4sum.n, 2, pkt.data() + chk);
+    auto ipsum = llarp::net::ipchksum(pkt.data(), 20);
+    std::copy_n((const byte_t*)&ipsum.n, 2, pkt.data() + 10);
+    return pkt;
+  }
+
+  static uint32_t
+  L4Pseudo(const llarp::net::IPPacket& pkt)
+  {
+    return llarp::net::ipchksum_pseudoIPv4(
+        llarp::nuint32_t{pkt.Header()->saddr},
+        llarp::nuint32_t{pkt.Header()->daddr}, pkt.Header()->protocol,
+        pkt.size() - 20);
+  }
+
+  /// a packet with correct checksums sums up to zero
+  static void
+  CheckSums(const llarp::net::IPPacket& pkt)
+  {
+    ASSERT_EQ(llarp::net::ipchksum(pkt.data(), 20).n, 0);
+    ASSERT_EQ(llarp::net::ipchksum(pkt.data() + 20, pkt.size() - 20,
+                                   L4Pseudo(pkt))
+                  .n,
+              0);
+  }
+};
+
+TEST_F(TestNetIP, FlowHashFollowsFlow)
+{
+  auto a = UDP(53);
+  auto b = UDP(53);
+  auto c = UDP(54);
+  ASSERT_NE(llarp::net::FlowHash(a.data(), a.size()), 0u);
+  ASSERT_EQ(llarp::net::FlowHash(a.data(), a.size()),
+            llarp::net::FlowHash(b.data(), b.size()));
+  ASSERT_NE(llarp::net::FlowHash(a.data(), a.size()),
+            llarp::net::FlowHash(c.data(), c.size()));
+
+  // fragments of either flow look the same, later ones carry no ports
+  a[6] = c[6] = 0x20;
+  ASSERT_EQ(llarp::net::FlowHash(a.data(), a.size()),
+            llarp::net::FlowHash(c.data(), c.size()));
+}
+
+TEST_F(TestNetIP, FlowHashNotIPv4)
+{
+  auto pkt = UDP(53);
+  ASSERT_EQ(llarp::net::FlowHash(pkt.data(), 19), 0u);
+  pkt[0] = 0x60;
+  ASSERT_EQ(llarp::net::FlowHash(pkt.data(), pkt.size()), 0u);
+}
+
+TEST_F(TestNetIP, RewriteKeepsChecksums)
+{
+  const llarp::huint32_t us{0x0a000101};
+  const llarp::huint32_t them{0xac100203};
+  for(const uint8_t proto : {IPPROTO_TCP, IPPROTO_UDP})
+  {
+    for(size_t payload = 0; payload < 64; payload += 13)
+    {
+      auto pkt = Checksummed(proto, payload);
+      CheckSums(pkt);
+      pkt.UpdateIPv4PacketOnDst(them, us);
+      ASSERT_EQ(pkt.src(), them);
+      ASSERT_EQ(pkt.dst(), us);
+      CheckSums(pkt);
+      pkt.UpdateIPv4PacketOnSrc();
+      ASSERT_EQ(pkt.Header()->saddr, 0u);
+      ASSERT_EQ(pkt.Header()->daddr, 0u);
+      CheckSums(pkt);
+    }
+  }
+}
+
+TEST_F(TestNetIP, BatchRewriteMatchesSingle)
+{
+  const llarp::huint32_t us{0x0a000101};
+  const llarp::huint32_t them{0xac100203};
+  std::vector< llarp::net::IPPacket > batch, single;
+  for(size_t idx = 0; idx < 5; ++idx)
+    batch.emplace_back(
+        Checksummed(idx % 2 ? IPPROTO_TCP : IPPROTO_UDP, idx * 10));
+  single = batch;
+
+  llarp::net::IPPacket::UpdateIPv4PacketsOnDst(batch.data(), batch.size(),
+                                                 them, us);
+  for(auto& pkt : single)
+    pkt.UpdateIPv4PacketOnDst(them, us);
+  for(size_t idx = 0; idx < batch.size(); ++idx)
+  {
+    ASSERT_EQ(batch[idx].size(), single[idx].size());
+    ASSERT_TRUE(std::equal(batch[idx].data(),
+                           batch[idx].data() + batch[idx].size(),
+                           single[idx].data()));
+  }
+
+  llarp::net::IPPacket::UpdateIPv4PacketsOnSrc(batch.data(), batch.size());
+  for(const auto& pkt : batch)
+    CheckSums(pkt);
+}
+
+TEST_F(TestNetIP, PacketCopiesAreDeep)
+{
+  auto pkt = Checksummed(IPPROTO_UDP, 100);
+  ASSERT_TRUE(pkt.IsV4());
+  ASSERT_FALSE(pkt.IsV6());
+  auto copy = pkt;
+  ASSERT_NE(copy.data(), pkt.data());
+  copy.UpdateIPv4PacketOnDst(llarp::huint32_t{0xac100203},
+                             llarp::huint32_t{0x0a000101});
+  ASSERT_EQ(pkt.src(), llarp::huint32_t{0x0a000001});
+  CheckSums(pkt);
+  CheckSums(copy);
+
+  // moving hands the block over
+  const byte_t* data = copy.data();
+  llarp::net::IPPacket moved(std::move(copy));
+  ASSERT_EQ(moved.data(), data);
+  ASSERT_EQ(copy.size(), 0u);
+  ASSERT_EQ(copy.Version(), 0);
+
+  // an empty packet stays empty when copied
+  llarp::net::IPPacket empty;
+  pkt = empty;
+  ASSERT_EQ(pkt.data(), nullptr);
+  ASSERT_FALSE(pkt.IsV4());
+}
+
+TEST_F(TestNetIP, PacketCarriesIPv6AndJumbo)
+{
+  // udp over ipv6 from 2001:db8::1 to 2001:db8::2
+  std::vector< byte_t > buf(40 + 8, 0);
+  buf[0] = 0x60;
+  buf[5] = 8;
+  buf[6] = IPPROTO_UDP;
+  buf[7] = 64;
+  for(const size_t off : {8, 24})
+  {
+    buf[off]     = 0x20;
+    buf[off + 1] = 0x01;
+    buf[off + 2] = 0x0d;
+    buf[off + 3] = 0xb8;
+  }
+  buf[23] = 1;
+  buf[39] = 2;
+  llarp::net::IPPacket pkt;
+  ASSERT_TRUE(pkt.Load(llarp_buffer_t(buf)));
+  ASSERT_TRUE(pkt.IsV6());
+  ASSERT_FALSE(pkt.IsV4());
+  ASSERT_EQ(pkt.HeaderV6()->nexthdr, IPPROTO_UDP);
+  ASSERT_EQ(pkt.HeaderV6()->srcaddr[15], 1);
+  ASSERT_EQ(pkt.HeaderV6()->dstaddr[15], 2);
+  // ipv4 rewrites leave it alone
+  pkt.UpdateIPv4PacketOnSrc();
+  ASSERT_TRUE(std::equal(buf.begin(), buf.end(), pkt.data()));
+
+  // too short for the fixed header
+  ASSERT_TRUE(pkt.Load(llarp_buffer_t(buf.data(), 39)));
+  ASSERT_FALSE(pkt.IsV6());
+
+  // bigger than the old 1500 byte limit, too big for a small block
+  std::vector< byte_t > jumbo(4000, 0x45);
+  ASSERT_TRUE(pkt.Load(llarp_buffer_t(jumbo)));
+  ASSERT_EQ(pkt.size(), jumbo.size());
+  // the bigger block is reused for what comes after
+  const byte_t* block = pkt.data();
+  ASSERT_TRUE(pkt.Load(llarp_buffer_t(buf)));
+  ASSERT_EQ(pkt.data(), block);
+
+  jumbo.resize(llarp::net::IPPacket::MaxSize + 1);
+  ASSERT_FALSE(pkt.Load(llarp_buffer_t(jumbo)));
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <net/ip_pool.hpp>
+
+#include <vector>
+
+using llarp::huint32_t;
+
+struct TestNetIPPool : public ::testing::Test
+{
+  TestNetIPPool()
+  {
+    pool.Reset("test.ip_pool", Addr(10), Addr(13));
+  }
+
+  static huint32_t
+  Addr(uint32_t last)
+  {
+    return huint32_t{(10u << 24) | last};
+  }
+
+  huint32_t
+  Obtain(llarp_time_t now, bool& reused)
+  {
+    huint32_t ip{0};
+    EXPECT_TRUE(pool.Obtain(now, ip, reused));
+    return ip;
+  }
+
+  llarp::net::IPPool pool;
+};
+
+TEST_F(TestNetIPPool, HandsOutInOrder)
+{
+  bool reused = true;
+  ASSERT_EQ(pool.Capacity(), 4u);
+  for(uint32_t idx = 10; idx <= 13; ++idx)
+  {
+    ASSERT_EQ(Obtain(idx, reused), Addr(idx));
+    ASSERT_FALSE(reused);
+  }
+  ASSERT_EQ(pool.NumInUse(), 4u);
+  ASSERT_FALSE(pool.Contains(Addr(14)));
+  ASSERT_FALSE(pool.Contains(Addr(9)));
+}
+
+TEST_F(TestNetIPPool, EvictsLeastRecentlyActive)
+{
+  bool reused = false;
+  for(uint32_t idx = 10; idx <= 13; ++idx)
+    Obtain(idx, reused);
+  pool.Touch(Addr(10), 100);
+  pool.Touch(Addr(12), 101);
+
+  ASSERT_EQ(Obtain(200, reused), Addr(11));
+  ASSERT_TRUE(reused);
+  ASSERT_EQ(Obtain(201, reused), Addr(13));
+  ASSERT_EQ(Obtain(202, reused), Addr(10));
+  ASSERT_EQ(pool.Evictions(), 3u);
+  ASSERT_EQ(pool.LastActive(Addr(10)), 202u);
+}
+
+TEST_F(TestNetIPPool, ReleaseAndPin)
+{
+  bool reused = false;
+  pool.Pin(Addr(11));
+  ASSERT_EQ(Obtain(1, reused), Addr(10));
+  ASSERT_EQ(Obtain(2, reused), Addr(12));
+  ASSERT_EQ(Obtain(3, reused), Addr(13));
+
+  pool.Release(Addr(12));
+  ASSERT_FALSE(pool.InUse(Addr(12)));
+  ASSERT_EQ(Obtain(4, reused), Addr(12));
+  ASSERT_FALSE(reused);
+
+  // the pinned address is never taken back
+  for(llarp_time_t now = 5; now < 20; ++now)
+    ASSERT_FALSE(Obtain(now, reused) == Addr(11));
+
+  // nothing left to take back once everything is pinned
+  pool.Pin(Addr(10));
+  pool.Pin(Addr(12));
+  pool.Pin(Addr(13));
+  huint32_t ip{0};
+  ASSERT_FALSE(pool.Obtain(30, ip, reused));
+}
+
+TEST_F(TestNetIPPool, VisitsOnlyIdleAddresses)
+{
+  bool reused = false;
+  for(uint32_t idx = 10; idx <= 13; ++idx)
+    Obtain(idx, reused);
+  pool.Pin(Addr(10));
+  pool.Touch(Addr(11), 100);
+
+  std::vector< huint32_t > idle;
+  pool.ForEachIdle(50,
+                   [&](huint32_t ip, llarp_time_t) { idle.push_back(ip); });
+  // pinned and recently active addresses are left out
+  ASSERT_EQ(idle, std::vector< huint32_t >({Addr(12), Addr(13)}));
+}
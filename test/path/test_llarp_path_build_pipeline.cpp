@@ -0,0 +1,70 @@
+#include <path/build_pipeline.hpp>
+
+#include <util/logic.hpp>
+#include <util/time.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using llarp::path::BuildPipeline;
+
+struct BuildPipelineTest : public ::testing::Test
+{
+  llarp::Logic logic;
+  llarp_threadpool* worker = nullptr;
+
+  void
+  SetUp()
+  {
+    worker = llarp_init_threadpool(2, "test-build-pipeline");
+    llarp_threadpool_start(worker);
+  }
+
+  void
+  TearDown()
+  {
+    llarp_threadpool_stop(worker);
+    llarp_free_threadpool(&worker);
+  }
+};
+
+TEST_F(BuildPipelineTest, BatchesUntilLogicRuns)
+{
+  BuildPipeline pipeline(&logic, worker);
+  std::atomic< size_t > ran;
+  ran.store(0);
+
+  for(size_t idx = 0; idx < 10; ++idx)
+    pipeline.Queue([&ran]() { ++ran; });
+  // nothing goes to the workers until the logic thread gets around to it
+  ASSERT_EQ(pipeline.Pending(), 10u);
+  ASSERT_EQ(ran.load(), 0u);
+
+  logic.tick(llarp::time_now_ms());
+  ASSERT_EQ(pipeline.Pending(), 0u);
+  llarp_threadpool_join(worker);
+  ASSERT_EQ(ran.load(), 10u);
+  ASSERT_EQ(pipeline.InFlight(), 0u);
+}
+
+TEST_F(BuildPipelineTest, FlushesFullBatch)
+{
+  BuildPipeline pipeline(&logic, worker);
+  std::atomic< size_t > ran;
+  ran.store(0);
+
+  const size_t num = BuildPipeline::MaxBatch + 5;
+  for(size_t idx = 0; idx < num; ++idx)
+    pipeline.Queue([&ran]() { ++ran; });
+  // a full batch went out without waiting for the logic thread
+  ASSERT_EQ(pipeline.Pending(), 5u);
+  logic.tick(llarp::time_now_ms());
+  llarp_threadpool_join(worker);
+  ASSERT_EQ(ran.load(), num);
+
+  const auto status = pipeline.ExtractStatus().get();
+  ASSERT_EQ(status["batches"], 2u);
+  ASSERT_EQ(status["jobs"], num);
+  ASSERT_EQ(status["largestBatch"], BuildPipeline::MaxBatch);
+}
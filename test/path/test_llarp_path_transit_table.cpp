@@ -0,0 +1,84 @@
+#include <path/transit_table.hpp>
+
+#include <path/path.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+using llarp::PathID_t;
+using llarp::RouterID;
+using llarp::path::TransitHop;
+using llarp::path::TransitHopTable;
+
+static std::shared_ptr< TransitHop >
+MakeHop(byte_t downstream)
+{
+  auto hop = std::make_shared< TransitHop >();
+  hop->info.txID.Randomize();
+  hop->info.rxID.Randomize();
+  hop->info.downstream.Fill(downstream);
+  return hop;
+}
+
+TEST(TransitHopTable, FindsByEitherID)
+{
+  TransitHopTable table;
+  std::vector< std::shared_ptr< TransitHop > > hops;
+  // enough to make every shard grow a few times
+  for(size_t idx = 0; idx < 1000; ++idx)
+  {
+    auto hop = MakeHop(idx % 256);
+    table.Put(hop->info.txID, hop);
+    table.Put(hop->info.rxID, hop);
+    hops.push_back(hop);
+  }
+  ASSERT_EQ(table.Size(), 2000u);
+
+  auto any = [](const TransitHop&) { return true; };
+  for(const auto& hop : hops)
+  {
+    ASSERT_EQ(table.Find(hop->info.txID, any), hop.get());
+    ASSERT_EQ(table.Find(hop->info.rxID, any), hop.get());
+  }
+  PathID_t unknown;
+  unknown.Randomize();
+  ASSERT_FALSE(table.Has(unknown, any));
+
+  // drop every other hop, the rest must still be found past the holes
+  for(size_t idx = 0; idx < hops.size(); idx += 2)
+  {
+    ASSERT_TRUE(table.Remove(hops[idx]->info.txID, hops[idx].get()));
+    ASSERT_TRUE(table.Remove(hops[idx]->info.rxID, hops[idx].get()));
+    ASSERT_FALSE(table.Remove(hops[idx]->info.rxID, hops[idx].get()));
+  }
+  ASSERT_EQ(table.Size(), 1000u);
+  for(size_t idx = 0; idx < hops.size(); ++idx)
+  {
+    const TransitHop* expect = idx % 2 ? hops[idx].get() : nullptr;
+    ASSERT_EQ(table.Find(hops[idx]->info.txID, any), expect);
+    ASSERT_EQ(table.Find(hops[idx]->info.rxID, any), expect);
+  }
+}
+
+TEST(TransitHopTable, SharedIDPicksByCheck)
+{
+  TransitHopTable table;
+  auto first  = MakeHop(1);
+  auto second = MakeHop(2);
+  second->info.txID = first->info.txID;
+  table.Put(first->info.txID, first);
+  table.Put(second->info.txID, second);
+
+  const RouterID two(second->info.downstream);
+  auto fromTwo = [&two](const TransitHop& hop) {
+    return hop.info.downstream == two;
+  };
+  ASSERT_EQ(table.Find(first->info.txID, fromTwo), second.get());
+
+  ASSERT_TRUE(table.Remove(first->info.txID, second.get()));
+  ASSERT_FALSE(table.Has(first->info.txID, fromTwo));
+  auto any = [](const TransitHop&) { return true; };
+  ASSERT_EQ(table.Find(first->info.txID, any), first.get());
+}
@@ -0,0 +1,116 @@
+#include <router/outbound_queue.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using llarp::OutboundQueue;
+using llarp::PacketBuffer;
+
+static PacketBuffer
+MakePacket(size_t sz, byte_t tag)
+{
+  PacketBuffer pkt = PacketBuffer::Alloc(sz);
+  std::fill_n(pkt.data(), pkt.size(), tag);
+  return pkt;
+}
+
+struct OutboundQueueTest : public ::testing::Test
+{
+  OutboundQueue q;
+  std::vector< byte_t > sent;
+  bool accept = true;
+
+  OutboundQueue::SendFunc
+  Sender()
+  {
+    return [&](const llarp_buffer_t& buf) -> bool {
+      if(!accept)
+        return false;
+      sent.push_back(buf.base[0]);
+      return true;
+    };
+  }
+};
+
+TEST_F(OutboundQueueTest, ControlGoesFirst)
+{
+  ASSERT_TRUE(q.Push(MakePacket(100, 'b'), llarp::eLinkBulk, 0));
+  ASSERT_TRUE(q.Push(MakePacket(100, 'c'), llarp::eLinkControl, 0));
+  ASSERT_TRUE(q.Push(MakePacket(100, 'B'), llarp::eLinkBulk, 0));
+  ASSERT_EQ(q.Bytes(), 300u);
+  ASSERT_EQ(q.Pump(Sender(), 0), 3u);
+  ASSERT_EQ(sent, std::vector< byte_t >({'c', 'b', 'B'}));
+  ASSERT_TRUE(q.Empty());
+}
+
+TEST_F(OutboundQueueTest, KeepsWhatTheSessionRefuses)
+{
+  ASSERT_TRUE(q.Push(MakePacket(100, 'a'), llarp::eLinkControl, 0));
+  accept = false;
+  ASSERT_EQ(q.Pump(Sender(), 0), 0u);
+  ASSERT_FALSE(q.Empty());
+  accept = true;
+  ASSERT_EQ(q.Pump(Sender(), 0), 1u);
+  ASSERT_TRUE(q.Empty());
+}
+
+TEST_F(OutboundQueueTest, ByteLimit)
+{
+  const size_t sz  = 1000;
+  const size_t num = OutboundQueue::BulkByteLimit / sz;
+  for(size_t idx = 0; idx < num; ++idx)
+    ASSERT_TRUE(q.Push(MakePacket(sz, 'b'), llarp::eLinkBulk, 0));
+  ASSERT_TRUE(q.Congested());
+  // bulk is full but control has its own budget
+  ASSERT_FALSE(q.Push(MakePacket(sz, 'b'), llarp::eLinkBulk, 0));
+  ASSERT_TRUE(q.Push(MakePacket(sz, 'c'), llarp::eLinkControl, 0));
+}
+
+TEST_F(OutboundQueueTest, CoDelShedsStaleBulk)
+{
+  const size_t num = 64;
+  for(size_t idx = 0; idx < num; ++idx)
+  {
+    ASSERT_TRUE(q.Push(MakePacket(1000, 'b'), llarp::eLinkBulk, 0));
+    ASSERT_TRUE(q.Push(MakePacket(1000, 'c'), llarp::eLinkControl, 0));
+  }
+  // the session only takes one message per pump and everything has been
+  // sitting around far longer than the target
+  llarp_time_t now = 1000;
+  size_t pumps     = 0;
+  while(!q.Empty())
+  {
+    bool once = true;
+    q.Pump(
+        [&](const llarp_buffer_t& buf) -> bool {
+          if(!once)
+            return false;
+          once = false;
+          sent.push_back(buf.base[0]);
+          return true;
+        },
+        now);
+    now += OutboundQueue::Interval / 4;
+    ++pumps;
+  }
+  const size_t control = std::count(sent.begin(), sent.end(), 'c');
+  const size_t bulk    = std::count(sent.begin(), sent.end(), 'b');
+  // control is never dropped, bulk is
+  ASSERT_EQ(control, num);
+  ASSERT_LT(bulk, num);
+  ASSERT_GT(bulk, 0u);
+}
+
+TEST_F(OutboundQueueTest, CoDelLeavesFreshTrafficAlone)
+{
+  llarp_time_t now = 1000;
+  for(size_t idx = 0; idx < 256; ++idx)
+  {
+    ASSERT_TRUE(q.Push(MakePacket(1000, 'b'), llarp::eLinkBulk, now));
+    ASSERT_EQ(q.Pump(Sender(), now + 1), 1u);
+    now += 2;
+  }
+  ASSERT_EQ(sent.size(), 256u);
+}
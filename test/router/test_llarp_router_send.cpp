@@ -0,0 +1,301 @@
+#include <router/router.hpp>
+
+#include <link/server.hpp>
+#include <link/session.hpp>
+#include <messages/discard.hpp>
+#include <util/logic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using llarp::ILinkLayer;
+using llarp::ILinkSession;
+
+struct FakeSession : public ILinkSession
+{
+  ILinkLayer* link = nullptr;
+  bool established = true;
+  bool accept      = true;
+  size_t backlog   = 0;
+  size_t sent      = 0;
+
+  void
+  OnLinkEstablished(ILinkLayer*) override
+  {
+  }
+
+  void
+  Pump() override
+  {
+  }
+
+  void
+  Tick(llarp_time_t) override
+  {
+  }
+
+  bool
+  SendMessageBuffer(const llarp_buffer_t&) override
+  {
+    if(!accept)
+      return false;
+    ++sent;
+    return true;
+  }
+
+  void
+  Start() override
+  {
+  }
+
+  void
+  Close() override
+  {
+  }
+
+  bool
+  SendKeepAlive() override
+  {
+    return true;
+  }
+
+  bool
+  IsEstablished() override
+  {
+    return established;
+  }
+
+  bool
+  TimedOut(llarp_time_t) const override
+  {
+    return false;
+  }
+
+  llarp::PubKey
+  GetPubKey() const override
+  {
+    return {};
+  }
+
+  llarp::Addr
+  GetRemoteEndpoint() const override
+  {
+    return {};
+  }
+
+  llarp::RouterContact
+  GetRemoteRC() const override
+  {
+    return {};
+  }
+
+  size_t
+  SendQueueBacklog() const override
+  {
+    return backlog;
+  }
+
+  ILinkLayer*
+  GetLinkLayer() const override
+  {
+    return link;
+  }
+
+  bool
+  RenegotiateSession() override
+  {
+    return true;
+  }
+
+  bool
+  ShouldPing() const override
+  {
+    return false;
+  }
+
+  llarp::util::StatusObject
+  ExtractStatus() const override
+  {
+    return {};
+  }
+};
+
+struct FakeLink : public ILinkLayer
+{
+  const std::string name;
+  const uint16_t rank;
+
+  FakeLink(const llarp::SecretKey& key, std::string n, uint16_t r)
+      : ILinkLayer(key, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                   nullptr)
+      , name(std::move(n))
+      , rank(r)
+  {
+  }
+
+  std::shared_ptr< FakeSession >
+  AddSession(const llarp::RouterID& remote)
+  {
+    auto session  = std::make_shared< FakeSession >();
+    session->link = this;
+    m_AuthedLinks.emplace(remote, session);
+    return session;
+  }
+
+  void
+  RemoveSessions(const llarp::RouterID& remote)
+  {
+    m_AuthedLinks.erase(remote);
+  }
+
+  llarp::Crypto*
+  OurCrypto() override
+  {
+    return nullptr;
+  }
+
+  std::shared_ptr< ILinkSession >
+  NewOutboundSession(const llarp::RouterContact&,
+                     const llarp::AddressInfo&) override
+  {
+    return nullptr;
+  }
+
+  void
+  RecvFrom(const llarp::Addr&, const void*, size_t) override
+  {
+  }
+
+  const char*
+  Name() const override
+  {
+    return name.c_str();
+  }
+
+  uint16_t
+  Rank() const override
+  {
+    return rank;
+  }
+
+  bool
+  KeyGen(llarp::SecretKey&) override
+  {
+    return true;
+  }
+};
+
+struct RouterSendTest : public ::testing::Test
+{
+  llarp::Logic logic;
+  llarp::Router r;
+  llarp::SecretKey key;
+  llarp::RouterID remote;
+  FakeLink* link;
+  llarp::DiscardMessage msg;
+
+  RouterSendTest() : r(nullptr, nullptr, &logic)
+  {
+    remote.Randomize();
+    link = new FakeLink(key, "fake", 1);
+    r.outboundLinks.emplace(link);
+  }
+
+  size_t
+  Queued()
+  {
+    auto itr = r.outboundMessageQueue.find(remote);
+    if(itr == r.outboundMessageQueue.end())
+      return 0;
+    return itr->second.Empty() ? 0 : itr->second.Bytes();
+  }
+};
+
+TEST_F(RouterSendTest, ViaUsesCachedSession)
+{
+  auto session = link->AddSession(remote);
+  std::weak_ptr< ILinkSession > cached;
+  // the first send looks the session up and caches it
+  ASSERT_TRUE(r.SendToOrQueueVia(cached, remote, &msg));
+  ASSERT_EQ(cached.lock(), session);
+  // later sends go straight to it, even once the link forgot it
+  link->RemoveSessions(remote);
+  ASSERT_TRUE(r.SendToOrQueueVia(cached, remote, &msg));
+  ASSERT_EQ(session->sent, 2u);
+  ASSERT_EQ(Queued(), 0u);
+}
+
+TEST_F(RouterSendTest, ViaQueuesBehindBacklog)
+{
+  auto session = link->AddSession(remote);
+  std::weak_ptr< ILinkSession > cached(session);
+  session->accept = false;
+  // the session is backed up so the message is queued
+  ASSERT_TRUE(r.SendToOrQueueVia(cached, remote, &msg));
+  ASSERT_EQ(session->sent, 0u);
+  ASSERT_EQ(cached.lock(), nullptr);
+  const size_t queued = Queued();
+  ASSERT_GT(queued, 0u);
+  // the session takes messages again but the queued one has to go first
+  session->accept = true;
+  cached          = session;
+  ASSERT_TRUE(r.SendToOrQueueVia(cached, remote, &msg));
+  ASSERT_EQ(session->sent, 0u);
+  ASSERT_EQ(Queued(), 2 * queued);
+  // flushing the queue sends both
+  r.FlushOutbound();
+  ASSERT_EQ(session->sent, 2u);
+  ASSERT_EQ(Queued(), 0u);
+}
+
+TEST_F(RouterSendTest, IndexesEstablishedSessions)
+{
+  // nothing to index yet, and the miss is remembered
+  ASSERT_EQ(r.GetBestSession(remote), nullptr);
+  ASSERT_TRUE(r.m_SessionIndex[remote].none);
+  auto session = link->AddSession(remote);
+  ASSERT_EQ(r.GetBestSession(remote), nullptr);
+  // establishing a session indexes it
+  ASSERT_EQ(r.IndexBestSession(remote), session);
+  ASSERT_FALSE(r.m_SessionIndex[remote].none);
+  ASSERT_EQ(r.GetBestSession(remote), session);
+  // the miss is looked up again once its entry is old
+  llarp::RouterID other;
+  other.Randomize();
+  ASSERT_EQ(r.GetBestSession(other), nullptr);
+  auto otherSession              = link->AddSession(other);
+  r.m_SessionIndex[other].ranked = 0;
+  ASSERT_EQ(r.GetBestSession(other), otherSession);
+}
+
+TEST_F(RouterSendTest, IndexDropsClosedSessions)
+{
+  auto first     = link->AddSession(remote);
+  auto second    = link->AddSession(remote);
+  first->backlog = 1;
+  ASSERT_EQ(r.GetBestSession(remote), second);
+  // the indexed session closes while the other stays open
+  link->RemoveSessions(remote);
+  second.reset();
+  link->AddSession(remote)->backlog = 5;
+  ASSERT_EQ(r.GetBestSession(remote)->SendQueueBacklog(), 5u);
+}
+
+TEST_F(RouterSendTest, IndexRanksBusySessionsAgain)
+{
+  auto first      = link->AddSession(remote);
+  auto second     = link->AddSession(remote);
+  second->backlog = 1;
+  ASSERT_EQ(r.GetBestSession(remote), first);
+  // a busy session stays picked until its entry is old
+  first->backlog = 10;
+  ASSERT_EQ(r.GetBestSession(remote), first);
+  r.m_SessionIndex[remote].ranked = 0;
+  ASSERT_EQ(r.GetBestSession(remote), second);
+  // an idle one is kept however old its entry
+  second->backlog                 = 0;
+  r.m_SessionIndex[remote].ranked = 0;
+  first->backlog                  = 0;
+  ASSERT_EQ(r.GetBestSession(remote), second);
+}
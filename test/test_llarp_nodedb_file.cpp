@@ -0,0 +1,308 @@
+#include <gtest/gtest.h>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <nodedb.hpp>
+#include <nodedb_file.hpp>
+#include <util/threadpool.h>
+
+#include <test_util.hpp>
+
+#include <fstream>
+#include <set>
+
+struct NodeDBFileTest : public ::testing::Test
+{
+  NodeDBFileTest()
+      : file(fs::temp_directory_path() / llarp::test::randFilename())
+      , index(file.string() + ".idx")
+      , fileGuard(file)
+      , indexGuard(index)
+  {
+  }
+
+  llarp::RouterContact
+  MakeRC()
+  {
+    llarp::SecretKey sign;
+    llarp::SecretKey encr;
+    crypto.identity_keygen(sign);
+    crypto.encryption_keygen(encr);
+    llarp::RouterContact rc;
+    rc.pubkey = sign.toPublic();
+    rc.enckey = encr.toPublic();
+    EXPECT_TRUE(rc.Sign(&crypto, sign));
+    return rc;
+  }
+
+  static llarp::RouterID
+  ID(const llarp::RouterContact &rc)
+  {
+    return rc.pubkey.as_array();
+  }
+
+  llarp::sodium::CryptoLibSodium crypto;
+  const fs::path file;
+  const fs::path index;
+  llarp::test::FileGuard fileGuard;
+  llarp::test::FileGuard indexGuard;
+};
+
+TEST_F(NodeDBFileTest, PutGetReopen)
+{
+  std::vector< llarp::RouterContact > rcs;
+  {
+    llarp::NodeDBFile db;
+    ASSERT_TRUE(db.Open(file));
+    for(size_t idx = 0; idx < 5; ++idx)
+    {
+      rcs.emplace_back(MakeRC());
+      ASSERT_TRUE(db.Put(rcs.back()));
+    }
+    ASSERT_EQ(db.Size(), 5u);
+    ASSERT_EQ(db.Unindexed(), 5u);
+  }
+  // closing wrote the index, nothing is left to read on open
+  llarp::NodeDBFile db;
+  ASSERT_TRUE(db.Open(file));
+  ASSERT_EQ(db.Size(), 5u);
+  ASSERT_EQ(db.Unindexed(), 0u);
+  for(const auto &rc : rcs)
+  {
+    llarp::RouterContact got;
+    ASSERT_TRUE(db.Get(ID(rc), got));
+    ASSERT_EQ(got, rc);
+  }
+  ASSERT_FALSE(db.Has(ID(MakeRC())));
+}
+
+TEST_F(NodeDBFileTest, ReplaceAndRemove)
+{
+  llarp::NodeDBFile db;
+  ASSERT_TRUE(db.Open(file));
+  auto a = MakeRC();
+  auto b = MakeRC();
+  ASSERT_TRUE(db.Put(a));
+  ASSERT_TRUE(db.Put(b));
+  ASSERT_TRUE(db.Checkpoint());
+  ASSERT_EQ(db.Wasted(), 0u);
+
+  a.last_updated += 1000;
+  ASSERT_TRUE(db.Put(a));
+  ASSERT_TRUE(db.Remove(ID(b)));
+  ASSERT_FALSE(db.Remove(ID(b)));
+  ASSERT_EQ(db.Size(), 1u);
+  ASSERT_GT(db.Wasted(), 0u);
+
+  llarp::RouterContact got;
+  ASSERT_TRUE(db.Get(ID(a), got));
+  ASSERT_EQ(got.last_updated, a.last_updated);
+  ASSERT_FALSE(db.Get(ID(b), got));
+
+  // removals made after the index was written are read back on open
+  db.Close();
+  ASSERT_TRUE(db.Open(file));
+  ASSERT_EQ(db.Size(), 1u);
+  ASSERT_FALSE(db.Has(ID(b)));
+  ASSERT_TRUE(db.Get(ID(a), got));
+  ASSERT_EQ(got.last_updated, a.last_updated);
+}
+
+TEST_F(NodeDBFileTest, TornWriteIgnored)
+{
+  auto rc = MakeRC();
+  {
+    llarp::NodeDBFile db;
+    ASSERT_TRUE(db.Open(file));
+    ASSERT_TRUE(db.Put(rc));
+  }
+  fs::remove(index);
+  {
+    std::ofstream f(file.string(), std::ios::binary | std::ios::app);
+    f << "half a record";
+  }
+  llarp::NodeDBFile db;
+  ASSERT_TRUE(db.Open(file));
+  ASSERT_EQ(db.Size(), 1u);
+  ASSERT_TRUE(db.Has(ID(rc)));
+  // the next record goes where the torn one was
+  auto other = MakeRC();
+  ASSERT_TRUE(db.Put(other));
+  db.Close();
+  fs::remove(index);
+  ASSERT_TRUE(db.Open(file));
+  ASSERT_EQ(db.Size(), 2u);
+  llarp::RouterContact got;
+  ASSERT_TRUE(db.Get(ID(other), got));
+  ASSERT_EQ(got, other);
+}
+
+TEST_F(NodeDBFileTest, Compact)
+{
+  llarp::NodeDBFile db;
+  ASSERT_TRUE(db.Open(file));
+  auto keep = MakeRC();
+  ASSERT_TRUE(db.Put(keep));
+  auto churn = MakeRC();
+  while(!db.ShouldCompact())
+    ASSERT_TRUE(db.Put(churn));
+  ASSERT_TRUE(db.Remove(ID(churn)));
+  const auto before = fs::file_size(file);
+
+  ASSERT_TRUE(db.Compact());
+  ASSERT_EQ(db.Wasted(), 0u);
+  ASSERT_EQ(db.Size(), 1u);
+  ASSERT_LT(fs::file_size(file), before);
+  llarp::RouterContact got;
+  ASSERT_TRUE(db.Get(ID(keep), got));
+  ASSERT_EQ(got, keep);
+  ASSERT_FALSE(db.Has(ID(churn)));
+
+  db.Close();
+  ASSERT_TRUE(db.Open(file));
+  ASSERT_EQ(db.Size(), 1u);
+  ASSERT_TRUE(db.Get(ID(keep), got));
+}
+
+TEST_F(NodeDBFileTest, GetFollowsAppends)
+{
+  llarp::NodeDBFile db;
+  ASSERT_TRUE(db.Open(file));
+  // each record lands past what the last lookup mapped
+  for(size_t idx = 0; idx < 20; ++idx)
+  {
+    auto rc = MakeRC();
+    ASSERT_TRUE(db.Put(rc));
+    llarp::RouterContact got;
+    ASSERT_TRUE(db.Get(ID(rc), got));
+    ASSERT_EQ(got, rc);
+  }
+}
+
+TEST_F(NodeDBFileTest, RandomKeyOnlyPicksLive)
+{
+  llarp::NodeDBFile db;
+  ASSERT_TRUE(db.Open(file));
+  llarp::RouterID pk;
+  ASSERT_FALSE(db.RandomKey(pk));
+  std::vector< llarp::RouterContact > rcs;
+  for(size_t idx = 0; idx < 8; ++idx)
+  {
+    rcs.emplace_back(MakeRC());
+    ASSERT_TRUE(db.Put(rcs.back()));
+  }
+  ASSERT_TRUE(db.Checkpoint());
+  // replace some indexed rcs, remove others and add new ones after the
+  // index was written
+  std::set< llarp::RouterID > live;
+  for(size_t idx = 0; idx < rcs.size(); ++idx)
+  {
+    if(idx % 3 == 0)
+    {
+      ASSERT_TRUE(db.Remove(ID(rcs[idx])));
+      continue;
+    }
+    if(idx % 3 == 1)
+      ASSERT_TRUE(db.Put(rcs[idx]));
+    live.insert(ID(rcs[idx]));
+  }
+  auto added = MakeRC();
+  ASSERT_TRUE(db.Put(added));
+  live.insert(ID(added));
+  ASSERT_EQ(db.Size(), live.size());
+
+  std::set< llarp::RouterID > seen;
+  for(size_t idx = 0; idx < 1000; ++idx)
+  {
+    ASSERT_TRUE(db.RandomKey(pk));
+    ASSERT_EQ(live.count(pk), 1u);
+    seen.insert(pk);
+  }
+  ASSERT_EQ(seen, live);
+}
+
+TEST_F(NodeDBFileTest, NodeDBDecodesLazily)
+{
+  auto rc = MakeRC();
+  {
+    llarp_nodedb nodedb(&crypto, nullptr);
+    ASSERT_EQ(nodedb.load_file(file.string().c_str()), 0);
+    ASSERT_TRUE(nodedb.Insert(rc));
+  }
+  llarp_nodedb nodedb(&crypto, nullptr);
+  ASSERT_EQ(nodedb.load_file(file.string().c_str()), 1);
+  ASSERT_EQ(nodedb.num_loaded(), 1u);
+  ASSERT_TRUE(nodedb.entries.empty());
+  ASSERT_TRUE(nodedb.Has(ID(rc)));
+
+  llarp::RouterContact got;
+  ASSERT_TRUE(nodedb.Get(ID(rc), got));
+  ASSERT_EQ(got, rc);
+  ASSERT_EQ(nodedb.entries.size(), 1u);
+}
+
+TEST_F(NodeDBFileTest, NodeDBDecodesStoreOnDiskThread)
+{
+  std::vector< llarp::RouterContact > rcs;
+  {
+    llarp_nodedb nodedb(&crypto, nullptr);
+    ASSERT_EQ(nodedb.load_file(file.string().c_str()), 0);
+    for(size_t idx = 0; idx < 3; ++idx)
+    {
+      rcs.emplace_back(MakeRC());
+      ASSERT_TRUE(nodedb.Insert(rcs.back()));
+    }
+  }
+  llarp_threadpool *disk = llarp_init_same_process_threadpool();
+  llarp_nodedb nodedb(&crypto, disk);
+  ASSERT_EQ(nodedb.load_file(file.string().c_str()), 3);
+  size_t visited = 0;
+  nodedb.visit([&](const llarp::RouterContact &) -> bool {
+    ++visited;
+    return true;
+  });
+  // nothing decoded by the walk itself, it is queued for the disk thread
+  ASSERT_EQ(visited, 0u);
+  ASSERT_TRUE(nodedb.entries.empty());
+  ASSERT_EQ(disk->size(), 1u);
+
+  llarp_threadpool_tick(disk);
+  nodedb.visit([&](const llarp::RouterContact &) -> bool {
+    ++visited;
+    return true;
+  });
+  ASSERT_EQ(visited, rcs.size());
+  // decoded once, walking again queues nothing
+  ASSERT_EQ(disk->size(), 0u);
+  llarp_free_threadpool(&disk);
+}
+
+TEST_F(NodeDBFileTest, NodeDBSelectsWithoutDecodingStore)
+{
+  {
+    llarp_nodedb nodedb(&crypto, nullptr);
+    ASSERT_EQ(nodedb.load_file(file.string().c_str()), 0);
+    for(size_t idx = 0; idx < 2; ++idx)
+      ASSERT_TRUE(nodedb.Insert(MakeRC()));
+  }
+  llarp_threadpool *disk = llarp_init_same_process_threadpool();
+  {
+    llarp_nodedb nodedb(&crypto, disk);
+    ASSERT_EQ(nodedb.load_file(file.string().c_str()), 2);
+    // too few routers for an exit, nothing is decoded to find that out
+    llarp::RouterContact rc;
+    ASSERT_FALSE(nodedb.select_random_exit(rc));
+    ASSERT_TRUE(nodedb.entries.empty());
+    ASSERT_EQ(disk->size(), 0u);
+
+    for(size_t idx = 0; idx < 20; ++idx)
+      ASSERT_TRUE(nodedb.Insert(MakeRC()));
+    nodedb.entries.clear();
+    nodedb.storeDecoded = false;
+    // none of these can be hops, a few are verified and the rest of the
+    // store is left to the disk thread
+    ASSERT_FALSE(nodedb.select_random_hop(rc, rc, 1));
+    ASSERT_LT(nodedb.entries.size(), nodedb.num_loaded());
+    ASSERT_EQ(disk->size(), 1u);
+  }
+  llarp_free_threadpool(&disk);
+}
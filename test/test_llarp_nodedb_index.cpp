@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <nodedb_index.hpp>
+
+#include <map>
+#include <set>
+
+struct SelectionIndexTest : public ::testing::Test
+{
+  static llarp::RouterContact
+  MakeRC(bool hop, bool exit)
+  {
+    llarp::RouterContact rc;
+    rc.pubkey.Randomize();
+    if(hop)
+      rc.addrs.emplace_back();
+    if(exit)
+      rc.exits.emplace_back();
+    return rc;
+  }
+
+  static llarp::RouterID
+  ID(const llarp::RouterContact &rc)
+  {
+    return rc.pubkey.as_array();
+  }
+
+  llarp::SelectionIndex index;
+};
+
+TEST_F(SelectionIndexTest, KeepsSetsSeparate)
+{
+  const auto hop  = MakeRC(true, false);
+  const auto exit = MakeRC(true, true);
+  const auto none = MakeRC(false, false);
+  index.Put(hop);
+  index.Put(exit);
+  index.Put(none);
+  ASSERT_EQ(index.NumHops(), 2u);
+  ASSERT_EQ(index.NumExits(), 1u);
+
+  llarp::RouterContact got;
+  for(size_t idx = 0; idx < 16; ++idx)
+  {
+    ASSERT_TRUE(index.RandomExit(got));
+    ASSERT_EQ(got, exit);
+    ASSERT_TRUE(index.RandomHop(1, got, nullptr));
+    ASSERT_NE(got, none);
+  }
+
+  // no longer an exit after being replaced
+  auto replaced = exit;
+  replaced.exits.clear();
+  index.Put(replaced);
+  ASSERT_EQ(index.NumHops(), 2u);
+  ASSERT_EQ(index.NumExits(), 0u);
+  ASSERT_FALSE(index.RandomExit(got));
+}
+
+TEST_F(SelectionIndexTest, SwapRemove)
+{
+  std::vector< llarp::RouterContact > rcs;
+  for(size_t idx = 0; idx < 8; ++idx)
+  {
+    rcs.emplace_back(MakeRC(true, false));
+    index.Put(rcs.back());
+  }
+  ASSERT_TRUE(index.Remove(ID(rcs[2])));
+  ASSERT_FALSE(index.Remove(ID(rcs[2])));
+  ASSERT_TRUE(index.Remove(ID(rcs[7])));
+  ASSERT_EQ(index.NumHops(), 6u);
+
+  // everything left is still reachable and the removed ones are gone
+  std::set< llarp::RouterID > seen;
+  llarp::RouterContact got;
+  for(size_t idx = 0; idx < 512; ++idx)
+  {
+    ASSERT_TRUE(index.RandomHop(1, got, nullptr));
+    seen.insert(ID(got));
+  }
+  ASSERT_EQ(seen.size(), 6u);
+  ASSERT_EQ(seen.count(ID(rcs[2])), 0u);
+  ASSERT_EQ(seen.count(ID(rcs[7])), 0u);
+}
+
+TEST_F(SelectionIndexTest, FilterAndWeight)
+{
+  const auto wanted   = MakeRC(true, false);
+  const auto unwanted = MakeRC(true, false);
+  const auto excluded = MakeRC(true, false);
+  index.Put(wanted);
+  index.Put(unwanted);
+  index.Put(excluded);
+
+  auto accept = [&](const llarp::RouterContact &rc) -> bool {
+    return rc != excluded;
+  };
+  auto weight = [&](const llarp::RouterID &r) -> double {
+    return r == ID(unwanted) ? 0.1 : 1.0;
+  };
+  std::map< llarp::RouterID, size_t > picks;
+  llarp::RouterContact got;
+  for(size_t idx = 0; idx < 1000; ++idx)
+  {
+    ASSERT_TRUE(index.RandomHop(1, got, accept, weight));
+    ++picks[ID(got)];
+  }
+  ASSERT_EQ(picks.count(ID(excluded)), 0u);
+  ASSERT_GT(picks[ID(wanted)], picks[ID(unwanted)] * 3);
+
+  // nothing passes the filter
+  ASSERT_FALSE(index.RandomHop(
+      1, got, [](const llarp::RouterContact &) { return false; }));
+}
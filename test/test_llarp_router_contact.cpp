@@ -2,10 +2,16 @@
 
 #include <crypto/crypto.hpp>
 #include <crypto/crypto_libsodium.hpp>
+#include <crypto/mock_crypto.hpp>
 #include <router_contact.hpp>
+#include <util/threadpool.h>
+
+#include <future>
 
 static const byte_t DEF_VALUE[] = "unittest";
 
+using namespace ::testing;
+
 struct RCTest : public ::testing::Test
 {
   using RC_t     = llarp::RouterContact;
@@ -21,6 +27,20 @@ struct RCTest : public ::testing::Test
     llarp::NetID::DefaultValue() = oldval;
   }
 
+  RC_t
+  MakeRC()
+  {
+    RC_t rc;
+    SecKey_t encr;
+    SecKey_t sign;
+    crypto.encryption_keygen(encr);
+    crypto.identity_keygen(sign);
+    rc.enckey = encr.toPublic();
+    rc.pubkey = sign.toPublic();
+    EXPECT_TRUE(rc.Sign(&crypto, sign));
+    return rc;
+  }
+
   llarp::sodium::CryptoLibSodium crypto;
   const llarp::NetID oldval;
 };
@@ -42,3 +62,51 @@ TEST_F(RCTest, TestSignVerify)
   ASSERT_TRUE(rc.Sign(&crypto, sign));
   ASSERT_TRUE(rc.Verify(&crypto, llarp::time_now_ms()));
 }
+
+TEST_F(RCTest, VerifyIsCached)
+{
+  const auto now = llarp::time_now_ms();
+  RC_t rc        = MakeRC();
+  llarp::test::MockCrypto mock;
+  EXPECT_CALL(mock, shorthash(_, _))
+      .WillRepeatedly(
+          Invoke([&](llarp::ShortHash &result, const llarp_buffer_t &buf) {
+            return crypto.shorthash(result, buf);
+          }));
+
+  EXPECT_CALL(mock, verify(_, _, _)).WillOnce(Return(true));
+  ASSERT_TRUE(rc.Verify(&mock, now));
+  ASSERT_TRUE(rc.Verify(&mock, now));
+
+  // anything signed differently is checked again, failures are kept too
+  rc.signature.Randomize();
+  EXPECT_CALL(mock, verify(_, _, _)).WillOnce(Return(false));
+  ASSERT_FALSE(rc.Verify(&mock, now));
+  ASSERT_FALSE(rc.Verify(&mock, now));
+}
+
+TEST_F(RCTest, VerifyMany)
+{
+  std::vector< RC_t > rcs;
+  for(size_t idx = 0; idx < 200; ++idx)
+  {
+    rcs.emplace_back(MakeRC());
+    if(idx % 3 == 0)
+      rcs.back().last_updated += 1;
+  }
+  llarp_threadpool *worker = llarp_init_threadpool(2, "verify");
+  llarp_threadpool_start(worker);
+  std::promise< std::vector< uint8_t > > result;
+  llarp::VerifyRouterContacts(
+      &crypto, worker, rcs, llarp::time_now_ms(),
+      [&](std::vector< RC_t > verified, std::vector< uint8_t > valid) {
+        EXPECT_EQ(verified, rcs);
+        result.set_value(std::move(valid));
+      });
+  const auto valid = result.get_future().get();
+  llarp_threadpool_stop(worker);
+  llarp_free_threadpool(&worker);
+  ASSERT_EQ(valid.size(), rcs.size());
+  for(size_t idx = 0; idx < rcs.size(); ++idx)
+    ASSERT_EQ(bool(valid[idx]), idx % 3 != 0) << idx;
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <util/async_logger.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace llarp;
+
+struct CollectingStream : public ILogStream
+{
+  struct Line
+  {
+    LogLevel lvl;
+    std::thread::id tid;
+    std::string msg;
+  };
+
+  std::mutex mutex;
+  std::vector< Line > lines;
+  std::vector< std::thread::id > prefixes;
+  llarp_time_t ticked = 0;
+
+  void
+  PreLog(std::stringstream&, LogLevel, const char*, int, std::thread::id tid,
+         absl::Time) const override
+  {
+    const_cast< CollectingStream* >(this)->prefixes.push_back(tid);
+  }
+
+  void
+  Print(LogLevel lvl, const char*, const std::string& msg) override
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    lines.push_back({lvl, prefixes.back(), msg});
+  }
+
+  void
+  PostLog(std::stringstream&) const override
+  {
+  }
+
+  void
+  Tick(llarp_time_t now) override
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    ticked = now;
+  }
+};
+
+struct AsyncLoggerTest : public ::testing::Test
+{
+  AsyncLoggerTest()
+  {
+    auto s = std::make_unique< CollectingStream >();
+    sink   = s.get();
+    stream = std::make_unique< AsyncLogStream >(std::move(s), 4);
+  }
+
+  CollectingStream* sink;
+  std::unique_ptr< AsyncLogStream > stream;
+};
+
+TEST_F(AsyncLoggerTest, KeepsOrderAndOrigin)
+{
+  std::thread::id other;
+  stream->Log(eLogInfo, "test", 1, "first");
+  std::thread t([&]() {
+    other = std::this_thread::get_id();
+    stream->Log(eLogWarn, "test", 2, "second");
+  });
+  t.join();
+  stream->Log(eLogError, "test", 3, "third");
+  ASSERT_TRUE(sink->lines.empty());
+
+  stream->Stop();
+  ASSERT_EQ(sink->lines.size(), 3u);
+  ASSERT_EQ(sink->lines[0].msg, "first");
+  ASSERT_EQ(sink->lines[1].msg, "second");
+  ASSERT_EQ(sink->lines[2].msg, "third");
+  ASSERT_EQ(sink->lines[0].tid, std::this_thread::get_id());
+  ASSERT_EQ(sink->lines[1].tid, other);
+  ASSERT_EQ(sink->lines[1].lvl, eLogWarn);
+  ASSERT_EQ(stream->Dropped(), 0u);
+}
+
+TEST_F(AsyncLoggerTest, DropsWhenFull)
+{
+  for(int idx = 0; idx < 10; ++idx)
+    stream->Log(eLogInfo, "test", idx, std::to_string(idx));
+  ASSERT_EQ(stream->Dropped(), 6u);
+
+  stream->Stop();
+  // the lines that fit and a warning about the rest
+  ASSERT_EQ(sink->lines.size(), 5u);
+  ASSERT_EQ(sink->lines[3].msg, "3");
+  ASSERT_EQ(sink->lines[4].lvl, eLogWarn);
+}
+
+TEST_F(AsyncLoggerTest, WritesInBackground)
+{
+  stream->Start();
+  stream->Log(eLogInfo, "test", 1, "line");
+  stream->Tick(42);
+  bool done = false;
+  for(int tries = 0; tries < 100 && !done; ++tries)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::lock_guard< std::mutex > lock(sink->mutex);
+    done = sink->lines.size() == 1 && sink->ticked == 42;
+  }
+  ASSERT_TRUE(done);
+  stream->Stop();
+}
+
+TEST_F(AsyncLoggerTest, WrapOnce)
+{
+  ILogStream_ptr wrapped = AsyncLogStream::Wrap(std::move(stream));
+  ILogStream* ptr        = wrapped.get();
+  ASSERT_EQ(AsyncLogStream::Wrap(std::move(wrapped)).get(), ptr);
+}
@@ -0,0 +1,68 @@
+#include <util/job.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+
+using llarp::thread::Job;
+
+TEST(Job, Empty)
+{
+  Job job;
+  ASSERT_FALSE(job);
+  Job null(nullptr);
+  ASSERT_FALSE(null);
+}
+
+TEST(Job, SmallCallableIsInline)
+{
+  auto counter = std::make_shared< int >(0);
+  auto func    = [counter]() { ++*counter; };
+  static_assert(Job::FitsInline< decltype(func) >(), "should fit");
+
+  Job job(func);
+  ASSERT_TRUE(job);
+  job();
+  ASSERT_EQ(*counter, 1);
+
+  Job copy(job);
+  copy();
+  ASSERT_EQ(*counter, 2);
+
+  Job moved(std::move(job));
+  ASSERT_FALSE(job);
+  moved();
+  ASSERT_EQ(*counter, 3);
+  // func, copy and moved each hold a reference, job gave its up
+  ASSERT_EQ(counter.use_count(), 4);
+}
+
+TEST(Job, LargeCallableOnHeap)
+{
+  auto counter = std::make_shared< int >(0);
+  std::array< char, 2 * Job::InlineSize > big{};
+  auto func = [counter, big]() { *counter += big.size(); };
+  static_assert(!Job::FitsInline< decltype(func) >(), "should not fit");
+
+  Job job(func);
+  Job copy;
+  copy = job;
+  job();
+  copy();
+  ASSERT_EQ(*counter, int(4 * Job::InlineSize));
+}
+
+TEST(Job, DestroysCallable)
+{
+  auto counter = std::make_shared< int >(0);
+  {
+    Job job([counter]() {});
+    ASSERT_EQ(counter.use_count(), 2);
+    job.Reset();
+    ASSERT_EQ(counter.use_count(), 1);
+    job = [counter]() {};
+    ASSERT_EQ(counter.use_count(), 2);
+  }
+  ASSERT_EQ(counter.use_count(), 1);
+}
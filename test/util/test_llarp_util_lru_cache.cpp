@@ -0,0 +1,51 @@
+#include <util/lru_cache.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using llarp::util::LRUCache;
+
+TEST(LRUCache, EvictsLeastRecentlyUsed)
+{
+  LRUCache< int, std::string > cache(3);
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  cache.Put(3, "three");
+  ASSERT_EQ(cache.Size(), 3u);
+
+  // 1 becomes the most recent, so 2 goes first
+  ASSERT_NE(cache.Get(1), nullptr);
+  cache.Put(4, "four");
+  ASSERT_EQ(cache.Size(), 3u);
+  ASSERT_EQ(cache.Evicted(), 1u);
+  ASSERT_FALSE(cache.Contains(2));
+  ASSERT_EQ(*cache.Get(1), "one");
+  ASSERT_EQ(cache.Oldest()->first, 3);
+
+  // peeking does not save 3
+  ASSERT_NE(cache.Peek(3), nullptr);
+  cache.Put(5, "five");
+  ASSERT_FALSE(cache.Contains(3));
+}
+
+TEST(LRUCache, PutReplaces)
+{
+  LRUCache< int, int > cache(2);
+  cache.Put(1, 10);
+  cache.Put(2, 20);
+  cache.Put(1, 11);
+  ASSERT_EQ(cache.Size(), 2u);
+  ASSERT_EQ(cache.Evicted(), 0u);
+  ASSERT_EQ(*cache.Peek(1), 11);
+  ASSERT_EQ(cache.Oldest()->first, 2);
+
+  ASSERT_TRUE(cache.Erase(2));
+  ASSERT_FALSE(cache.Erase(2));
+  ASSERT_EQ(cache.Get(2), nullptr);
+  ASSERT_EQ(cache.Size(), 1u);
+
+  cache.Clear();
+  ASSERT_EQ(cache.Size(), 0u);
+  ASSERT_EQ(cache.Oldest(), nullptr);
+}
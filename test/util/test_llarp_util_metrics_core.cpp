@@ -109,6 +109,91 @@ using CollectorTestTypes = ::testing::Types< DoubleCollector, IntCollector >;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(MetricsCore, CollectorTest, CollectorTestTypes);
 
+TEST(MetricsCore, CollectorThreads)
+{
+  IntCollector intCollector(METRIC_A);
+  DoubleCollector doubleCollector(METRIC_B);
+
+  // more threads than shards, so some of them share
+  std::vector< std::thread > threads;
+  for(int i = 0; i < 16; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      for(int j = 0; j < 1000; ++j)
+      {
+        intCollector.tick(i);
+        doubleCollector.tick(i);
+      }
+    });
+  }
+  for(auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  for(const Record &record : {intCollector.loadAndClear(),
+                              doubleCollector.loadAndClear()})
+  {
+    ASSERT_EQ(16000u, record.count());
+    ASSERT_EQ(120000, record.total());
+    ASSERT_EQ(0, record.min());
+    ASSERT_EQ(15, record.max());
+  }
+  ASSERT_EQ(0u, intCollector.load().count());
+  ASSERT_EQ(0u, doubleCollector.load().count());
+}
+
+TEST(MetricsCore, HistogramCollector)
+{
+  HistogramCollector collector(METRIC_A);
+
+  Record empty = collector.load().record();
+  ASSERT_EQ(0u, empty.count());
+  ASSERT_FALSE(empty.quantiles());
+
+  // 1..1000, with one far out tail
+  for(int i = 1; i <= 1000; ++i)
+  {
+    collector.tick(i);
+  }
+  collector.tick(1e6);
+
+  Histogram histogram = collector.loadAndClear();
+  Record record       = histogram.record();
+  ASSERT_EQ(1001u, record.count());
+  ASSERT_EQ(1, record.min());
+  ASSERT_EQ(1e6, record.max());
+  ASSERT_TRUE(record.quantiles());
+
+  // buckets are at most 1/16th wide
+  const Record::Quantiles &quantiles = *record.quantiles();
+  ASSERT_NEAR(501, quantiles[0], 501 / 16.0);
+  ASSERT_NEAR(901, quantiles[1], 901 / 16.0);
+  ASSERT_NEAR(991, quantiles[2], 991 / 16.0);
+  ASSERT_NEAR(1000, quantiles[3], 1000 / 16.0);
+
+  ASSERT_EQ(0u, collector.load().record().count());
+
+  // values out of range land in the end buckets
+  collector.tick(0);
+  collector.tick(-1);
+  collector.tick(1e300);
+  histogram.merge(collector.load());
+  ASSERT_EQ(1004u, histogram.record().count());
+  ASSERT_EQ(1e300, histogram.quantile(1));
+  ASSERT_EQ(-1, histogram.quantile(0));
+}
+
+TEST(MetricsCore, HistogramBuckets)
+{
+  for(double value = 1e-5; value < 1e13; value *= 1.1)
+  {
+    const size_t bucket = Histogram::bucket(value);
+    ASSERT_LE(Histogram::bucketLow(bucket), value);
+    ASSERT_GT(Histogram::bucketLow(bucket + 1), value);
+  }
+}
+
 TEST(MetricsCore, Registry)
 {
   Registry registry;
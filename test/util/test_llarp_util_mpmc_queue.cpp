@@ -0,0 +1,73 @@
+#include <util/mpmc_queue.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using llarp::thread::MPMCQueue;
+
+TEST(MPMCQueue, FifoAndFull)
+{
+  MPMCQueue< int > queue(5);
+  // rounded up to a power of two
+  ASSERT_EQ(queue.capacity(), 8u);
+  ASSERT_TRUE(queue.empty());
+
+  for(int idx = 0; idx < 8; ++idx)
+    ASSERT_TRUE(queue.tryPush(idx));
+  int item = 8;
+  ASSERT_FALSE(queue.tryPush(item));
+
+  for(int idx = 0; idx < 8; ++idx)
+  {
+    ASSERT_TRUE(queue.tryPop(item));
+    ASSERT_EQ(item, idx);
+  }
+  ASSERT_FALSE(queue.tryPop(item));
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(MPMCQueue, ManyProducersManyConsumers)
+{
+  static constexpr size_t threads   = 4;
+  static constexpr size_t perThread = 10000;
+
+  MPMCQueue< size_t > queue(64);
+  std::atomic_size_t popped{0};
+  std::atomic_size_t sum{0};
+  std::vector< std::thread > workers;
+
+  for(size_t t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&, t]() {
+      for(size_t idx = 0; idx < perThread; ++idx)
+      {
+        size_t item = (t * perThread) + idx + 1;
+        while(!queue.tryPush(item))
+          std::this_thread::yield();
+      }
+    });
+    workers.emplace_back([&]() {
+      size_t item;
+      while(popped.load() < threads * perThread)
+      {
+        if(queue.tryPop(item))
+        {
+          sum += item;
+          ++popped;
+        }
+        else
+          std::this_thread::yield();
+      }
+    });
+  }
+  for(auto& worker : workers)
+    worker.join();
+
+  const size_t total = threads * perThread;
+  ASSERT_EQ(popped.load(), total);
+  ASSERT_EQ(sum.load(), (total * (total + 1)) / 2);
+  ASSERT_TRUE(queue.empty());
+}
@@ -0,0 +1,141 @@
+#include <util/packet_buffer.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+using llarp::PacketBuffer;
+using llarp::PacketPool;
+
+TEST(PacketBuffer, AllocAndRecycle)
+{
+  auto& pool = PacketPool::Instance();
+  {
+    PacketBuffer pkt = PacketBuffer::Alloc(100);
+    ASSERT_FALSE(pkt.IsEmpty());
+    ASSERT_EQ(pkt.size(), 100u);
+    ASSERT_EQ(pkt.Capacity(), PacketPool::SmallBlockSize);
+  }
+  const size_t allocated = pool.Allocated();
+  const size_t available = pool.Available();
+  // reusing the freed block does not carve a new slab
+  for(size_t idx = 0; idx < 100; ++idx)
+  {
+    PacketBuffer pkt = PacketBuffer::Alloc();
+    ASSERT_FALSE(pkt.IsEmpty());
+    ASSERT_EQ(pool.Available(), available - 1);
+  }
+  ASSERT_EQ(pool.Allocated(), allocated);
+  ASSERT_EQ(pool.Available(), available);
+}
+
+TEST(PacketBuffer, ThreadCachesGoBackToThePool)
+{
+  auto& pool        = PacketPool::Instance();
+  const size_t used = pool.Allocated() - pool.Available();
+  std::vector< std::thread > threads;
+  for(size_t idx = 0; idx < 4; ++idx)
+  {
+    threads.emplace_back([]() {
+      std::vector< PacketBuffer > pkts;
+      for(size_t round = 0; round < 10; ++round)
+      {
+        for(size_t n = 0; n < 3 * PacketPool::CacheBatch; ++n)
+          pkts.emplace_back(PacketBuffer::Alloc());
+        pkts.clear();
+      }
+    });
+  }
+  for(auto& thread : threads)
+    thread.join();
+  // every block the threads freed was handed back when they exited
+  ASSERT_EQ(pool.Allocated() - pool.Available(), used);
+}
+
+TEST(PacketBuffer, TooBig)
+{
+  ASSERT_TRUE(PacketBuffer::Alloc(PacketPool::BlockSize + 1).IsEmpty());
+}
+
+TEST(PacketBuffer, SizeClasses)
+{
+  auto& big   = PacketPool::Instance();
+  auto* small = PacketPool::ForSize(1);
+  ASSERT_NE(small, nullptr);
+  ASSERT_EQ(small->BlockBytes(), PacketPool::SmallBlockSize);
+  ASSERT_EQ(PacketPool::ForSize(PacketPool::SmallBlockSize), small);
+  ASSERT_EQ(PacketPool::ForSize(PacketPool::SmallBlockSize + 1), &big);
+  ASSERT_EQ(PacketPool::ForSize(PacketPool::BlockSize), &big);
+  ASSERT_EQ(PacketPool::ForSize(PacketPool::BlockSize + 1), nullptr);
+
+  // a small packet only takes a small block
+  const size_t bigAvailable   = big.Available();
+  const size_t smallAvailable = small->Available();
+  {
+    PacketBuffer pkt = PacketBuffer::Alloc(1500);
+    ASSERT_EQ(pkt.Capacity(), PacketPool::SmallBlockSize);
+    ASSERT_EQ(big.Available(), bigAvailable);
+    ASSERT_LT(small->Available(), small->Allocated());
+  }
+  ASSERT_EQ(big.Available(), bigAvailable);
+  ASSERT_GE(small->Available(), smallAvailable);
+
+  PacketBuffer pkt = PacketBuffer::Alloc(PacketPool::SmallBlockSize + 1);
+  ASSERT_EQ(pkt.Capacity(), PacketPool::BlockSize);
+}
+
+TEST(PacketBuffer, CopiesShareTheBlock)
+{
+  const char data[] = "onion";
+  auto& pool        = *PacketPool::ForSize(sizeof(data));
+  PacketBuffer pkt  = PacketBuffer::Copy(llarp_buffer_t(data, sizeof(data)));
+  ASSERT_EQ(pkt.size(), sizeof(data));
+  ASSERT_EQ(memcmp(pkt.data(), data, sizeof(data)), 0);
+  const size_t available = pool.Available();
+  {
+    PacketBuffer other = pkt;
+    ASSERT_EQ(other.data(), pkt.data());
+    other.data()[0] = 'O';
+    ASSERT_EQ(pkt.data()[0], 'O');
+    pkt.Clear();
+    ASSERT_TRUE(pkt.IsEmpty());
+    // still held by other
+    ASSERT_EQ(pool.Available(), available);
+  }
+  ASSERT_EQ(pool.Available(), available + 1);
+}
+
+TEST(PacketBuffer, SliceOrCopy)
+{
+  PacketBuffer pkt = PacketBuffer::Alloc(64);
+  std::fill_n(pkt.data(), pkt.size(), 0xaa);
+
+  // inside our block, shared
+  PacketBuffer slice = pkt.SliceOrCopy(llarp_buffer_t(pkt.data() + 16, 32));
+  ASSERT_EQ(slice.data(), pkt.data() + 16);
+  ASSERT_EQ(slice.size(), 32u);
+  ASSERT_EQ(slice.Capacity(), PacketPool::SmallBlockSize - 16);
+  ASSERT_TRUE(slice.Resize(48));
+  ASSERT_FALSE(slice.Resize(PacketPool::SmallBlockSize));
+
+  // somewhere else, copied
+  std::array< byte_t, 32 > other;
+  other.fill(0xbb);
+  PacketBuffer copy = pkt.SliceOrCopy(llarp_buffer_t(other));
+  ASSERT_NE(copy.data(), other.data());
+  ASSERT_EQ(copy.size(), other.size());
+  ASSERT_EQ(memcmp(copy.data(), other.data(), other.size()), 0);
+}
+
+TEST(PacketBuffer, BEncode)
+{
+  const char data[] = "abc";
+  PacketBuffer pkt  = PacketBuffer::Copy(llarp_buffer_t(data, 3));
+  std::array< byte_t, 16 > tmp;
+  llarp_buffer_t buf(tmp);
+  ASSERT_TRUE(pkt.BEncode(&buf));
+  ASSERT_EQ(buf.cur - buf.base, 5);
+  ASSERT_EQ(memcmp(tmp.data(), "3:abc", 5), 0);
+}
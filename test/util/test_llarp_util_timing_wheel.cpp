@@ -0,0 +1,81 @@
+#include <util/timing_wheel.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+using llarp::util::TimingWheel;
+
+TEST(TimingWheel, HandsBackWhenDue)
+{
+  TimingWheel< int > wheel(10, 1000);
+  wheel.Add(1050, 1);
+  wheel.Add(1005, 2);
+  // already due, comes out on the next tick
+  wheel.Add(500, 3);
+  ASSERT_EQ(wheel.Size(), 3u);
+
+  std::vector< int > out;
+  auto collect = [&out](int&& item) { out.push_back(item); };
+
+  wheel.Advance(1009, collect);
+  ASSERT_TRUE(out.empty());
+  wheel.Advance(1010, collect);
+  ASSERT_EQ(out, std::vector< int >({2, 3}));
+  wheel.Advance(1049, collect);
+  ASSERT_EQ(out.size(), 2u);
+  wheel.Advance(1050, collect);
+  ASSERT_EQ(out, std::vector< int >({2, 3, 1}));
+  ASSERT_EQ(wheel.Size(), 0u);
+}
+
+TEST(TimingWheel, CascadesAndOverflows)
+{
+  // 4 slots a level over 2 levels, so anything 16 ticks out overflows
+  TimingWheel< llarp_time_t, 2, 2 > wheel(1, 0);
+  std::mt19937 rng(42);
+  std::multimap< llarp_time_t, llarp_time_t > expect;
+  for(size_t idx = 0; idx < 500; ++idx)
+  {
+    const llarp_time_t at = 1 + rng() % 200;
+    wheel.Add(at, at);
+    expect.emplace(at, at);
+  }
+
+  llarp_time_t now = 0;
+  while(!expect.empty())
+  {
+    now += 1 + rng() % 7;
+    std::vector< llarp_time_t > out;
+    wheel.Advance(now, [&out](llarp_time_t&& at) { out.push_back(at); });
+    // never early, never late by more than a tick and in order of due time
+    std::vector< llarp_time_t > due;
+    while(!expect.empty() && expect.begin()->first <= now)
+    {
+      due.push_back(expect.begin()->first);
+      expect.erase(expect.begin());
+    }
+    ASSERT_EQ(out, due) << now;
+    ASSERT_EQ(wheel.Size(), expect.size());
+  }
+}
+
+TEST(TimingWheel, AddWhileAdvancing)
+{
+  TimingWheel< int > wheel(100, 0);
+  wheel.Add(100, 1);
+  size_t seen = 0;
+  wheel.Advance(1000, [&](int&& item) {
+    ++seen;
+    // push it back out, it must not come out of this same advance
+    wheel.Add(5000, std::move(item));
+  });
+  ASSERT_EQ(seen, 1u);
+  ASSERT_EQ(wheel.Size(), 1u);
+  wheel.Advance(4999, [&](int&&) { ++seen; });
+  ASSERT_EQ(seen, 1u);
+  wheel.Advance(5000, [&](int&&) { ++seen; });
+  ASSERT_EQ(seen, 2u);
+}